@@ -15,6 +15,8 @@ limitations under the License. */
 #include "paddle/fluid/distributed/service/communicator.h"
 
 #include <google/protobuf/text_format.h>
+#include <algorithm>
+#include <cmath>
 
 #include "gflags/gflags.h"
 #include "paddle/fluid/distributed/service/brpc_ps_client.h"
@@ -36,6 +38,49 @@ inline double GetCurrentUS() {
   return 1e+6 * time.tv_sec + time.tv_usec;
 }
 
+inline float MaxAbs(const float *x, int64_t n) {
+  float res = 0.f;
+  for (int64_t i = 0; i < n; ++i) {
+    res = std::max(res, std::fabs(x[i]));
+  }
+  return res;
+}
+
+void SelectGeoSparseDelta(const float *latest, float *old, int64_t width,
+                          const std::vector<int64_t> &ids, float coefficient,
+                          float threshold, float *values,
+                          std::vector<int64_t> *send_ids,
+                          std::vector<float *> *send_values,
+                          std::vector<int64_t> *pending_ids) {
+  auto cpu_ctx = paddle::platform::CPUDeviceContext();
+  auto blas =
+      paddle::operators::math::GetBlas<platform::CPUDeviceContext, float>(
+          cpu_ctx);
+  for (size_t j = 0; j < ids.size(); ++j) {
+    float *value = values + j * width;
+    float *old_value = old + ids[j] * width;
+    blas.VSUB(width, latest + ids[j] * width, old_value, value);
+    blas.SCAL(width, coefficient, value);
+    if (threshold > 0 && MaxAbs(value, width) < threshold) {
+      pending_ids->push_back(ids[j]);
+      continue;
+    }
+    blas.VADD(width, old_value, value, old_value);
+    send_ids->push_back(ids[j]);
+    send_values->push_back(value);
+  }
+}
+
+std::vector<std::pair<size_t, size_t>> SplitGeoSendChunks(size_t num,
+                                                          int chunk_size) {
+  size_t size = chunk_size > 0 ? static_cast<size_t>(chunk_size) : num;
+  std::vector<std::pair<size_t, size_t>> chunks;
+  for (size_t begin = 0; begin < num; begin += size) {
+    chunks.emplace_back(begin, std::min(begin + size, num));
+  }
+  return chunks;
+}
+
 Communicator::Communicator() {}
 
 void Communicator::init_gflag(const std::string &gflags) {
@@ -883,6 +928,12 @@ void GeoCommunicator::InitParams(const RecvCtxMap &recv_varname_to_ctx) {
     auto &table_id = ctx.table_id;
     auto param = varname.substr(0, varname.size() - 5);
     InitSparse(param, table_id);
+
+    auto height = recv_scope_->FindVar(param)->Get<LoDTensor>().dims()[0];
+    for (auto &splited_var : ctx.splited_varnames) {
+      sparse_id_bitmaps_[splited_var].assign(height, false);
+      sparse_pending_ids_[splited_var].clear();
+    }
   }
   return;
 }
@@ -1015,15 +1066,34 @@ std::vector<int64_t> GeoCommunicator::MergeSparseIds(
     const std::string &send_varname) {
   platform::RecordEvent record_event("GeoCommunicator->MergeSparseIds");
   size_t merge_num = 0, wait_times = 0;
-  std::unordered_set<int64_t> sparse_ids;
+  auto &bitmap = sparse_id_bitmaps_.at(send_varname);
+  std::vector<int64_t> res;
+  // the rows kept back by the last SendSparse go out with this round
+  auto &pending = sparse_pending_ids_.at(send_varname);
+  for (auto id : pending) {
+    if (!bitmap[id]) {
+      bitmap[id] = true;
+      res.push_back(id);
+    }
+  }
+  pending.clear();
   while (merge_num < static_cast<size_t>(max_merge_var_num_)) {
     VLOG(3) << "Merge Number of " << send_varname << " = " << merge_num;
     if (sparse_id_queues_.at(send_varname)->Size() > 0) {
       wait_times = 0;
       std::shared_ptr<std::vector<int64_t>> pop_ids =
           sparse_id_queues_.at(send_varname)->Pop();
-      for (size_t j = 0; j < pop_ids->size(); j++) {
-        sparse_ids.insert(pop_ids->at(j));
+      for (auto id : *pop_ids) {
+        PADDLE_ENFORCE_LT(
+            static_cast<size_t>(id), bitmap.size(),
+            platform::errors::OutOfRange(
+                "The id %d of %s is out of the range of the param, the "
+                "height of the param is %d.",
+                id, send_varname, bitmap.size()));
+        if (!bitmap[id]) {
+          bitmap[id] = true;
+          res.push_back(id);
+        }
       }
       merge_num += 1;
       VLOG(3) << "sparse_id_queues_(" << send_varname << ") pushed";
@@ -1037,8 +1107,9 @@ std::vector<int64_t> GeoCommunicator::MergeSparseIds(
       continue;
     }
   }
-  std::vector<int64_t> res;
-  res.assign(sparse_ids.begin(), sparse_ids.end());
+  for (auto id : res) {
+    bitmap[id] = false;
+  }
   return res;
 }
 
@@ -1076,38 +1147,51 @@ void GeoCommunicator::SendSparse(const std::string &varname,
   t_delta->set_rows(sparse_ids);
   t_delta->set_height(t_latest.dims()[0]);
 
-  auto blas =
-      paddle::operators::math::GetBlas<platform::CPUDeviceContext, float>(
-          cpu_ctx);
   float coefficient = 1.0 / static_cast<float>(trainers_);
 
+  // The rows whose delta is lower than the threshold are not sent and their
+  // old values are not updated. They are kept pending and merged into the
+  // ids of the next round, so the delta keeps accumulating on the trainer
+  // until it is large enough to be sent.
+  const float threshold = FLAGS_communicator_geo_delta_threshold;
+  std::vector<int64_t> send_ids;
   std::vector<float *> push_g_vec;
-  for (auto j = 0; j < static_cast<int>(sparse_ids.size()); ++j) {
-    blas.VSUB(dims1, t_latest.data<float>() + sparse_ids[j] * dims1,
-              t_old->data<float>() + sparse_ids[j] * dims1,
-              t_value + j * dims1);
-    blas.SCAL(dims1, coefficient, t_value + j * dims1);
-    blas.VADD(dims1, t_old->data<float>() + sparse_ids[j] * dims1,
-              t_value + j * dims1,
-              t_old->data<float>() + sparse_ids[j] * dims1);
-    push_g_vec.push_back(t_value + j * dims1);
+  send_ids.reserve(sparse_ids.size());
+  push_g_vec.reserve(sparse_ids.size());
+  SelectGeoSparseDelta(t_latest.data<float>(), t_old->data<float>(), dims1,
+                       sparse_ids, coefficient, threshold, t_value, &send_ids,
+                       &push_g_vec, &sparse_pending_ids_.at(varname));
+
+  // stream the rows in bounded requests, so a large delta does not become
+  // one huge message
+  std::vector<std::future<int32_t>> status;
+  for (auto &chunk : SplitGeoSendChunks(
+           send_ids.size(), FLAGS_communicator_geo_send_chunk_size)) {
+    size_t begin = chunk.first;
+    size_t num = chunk.second - chunk.first;
+    ++_async_call_num;
+    DownpourBrpcClosure *closure =
+        new DownpourBrpcClosure(1, [this](void *done) {
+          int ret = 0;
+          auto *closure = (DownpourBrpcClosure *)done;  // NOLINT
+          if (closure->check_response(0, PS_PUSH_SPARSE_TABLE) != 0) {
+            ret = -1;
+          }
+          closure->set_promise_value(ret);
+          --_async_call_num;
+        });
+    status.push_back(_worker_ptr->push_sparse_raw_gradient_partial(
+        table_id, (const uint64_t *)send_ids.data() + begin,
+        (const float **)push_g_vec.data() + begin, num, closure, ep_idx));
+  }
+  for (auto &s : status) {
+    s.wait();
   }
 
-  ++_async_call_num;
-  DownpourBrpcClosure *closure = new DownpourBrpcClosure(1, [this](void *done) {
-    int ret = 0;
-    auto *closure = (DownpourBrpcClosure *)done;  // NOLINT
-    if (closure->check_response(0, PS_PUSH_SPARSE_TABLE) != 0) {
-      ret = -1;
-    }
-    closure->set_promise_value(ret);
-    --_async_call_num;
-  });
-  auto status = _worker_ptr->push_sparse_raw_gradient_partial(
-      table_id, (const uint64_t *)sparse_ids.data(),
-      (const float **)push_g_vec.data(), sparse_ids.size(), closure, ep_idx);
-  status.wait();
-
+  VLOG(1) << "Send Sparse " << varname << ", " << send_ids.size() << " of "
+          << sparse_ids.size() << " rows are sent in " << status.size()
+          << " requests, the others are lower than the threshold " << threshold
+          << " and kept pending";
   VLOG(1) << "Finish Send Sparse " << varname
           << ", ids.size = " << sparse_ids.size() << ", table_id: " << table_id;
   return;
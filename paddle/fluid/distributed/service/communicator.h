@@ -51,6 +51,8 @@ struct CommContext;
 }  // namespace paddle
 
 DECLARE_bool(communicator_is_sgd_optimizer);
+DECLARE_double(communicator_geo_delta_threshold);
+DECLARE_int32(communicator_geo_send_chunk_size);
 
 namespace paddle {
 namespace distributed {
@@ -190,6 +192,22 @@ inline void MergeVars(const std::string &var_name,
   }
 }
 
+// Puts the deltas (latest - old) * coefficient of the rows of ids into
+// values, which is [ids.size(), width]. The rows whose max abs delta reaches
+// threshold are added to old and appended to send_ids and send_values. The
+// others are appended to pending_ids, old is left as it is for them.
+void SelectGeoSparseDelta(const float *latest, float *old, int64_t width,
+                          const std::vector<int64_t> &ids, float coefficient,
+                          float threshold, float *values,
+                          std::vector<int64_t> *send_ids,
+                          std::vector<float *> *send_values,
+                          std::vector<int64_t> *pending_ids);
+
+// The [begin, end) of the requests which send num rows, at most chunk_size
+// rows each, or all in one request when chunk_size <= 0.
+std::vector<std::pair<size_t, size_t>> SplitGeoSendChunks(size_t num,
+                                                          int chunk_size);
+
 using RpcCtxMap = std::unordered_map<std::string, CommContext>;
 using RecvCtxMap = std::unordered_map<uint64_t, std::vector<std::string>>;
 using SparseValue = std::unordered_map<int64_t, std::vector<float>>;
@@ -559,6 +577,13 @@ class GeoCommunicator : public AsyncCommunicator {
       std::string,
       std::shared_ptr<BlockingQueue<std::shared_ptr<std::vector<int64_t>>>>>
       sparse_id_queues_;
+
+  // bitmap of the rows merged by MergeSparseIds, one for each splited var,
+  // it is cleared after every merge
+  std::unordered_map<std::string, std::vector<bool>> sparse_id_bitmaps_;
+  // the rows whose delta was lower than the threshold in the last round,
+  // merged into the ids of the next one
+  std::unordered_map<std::string, std::vector<int64_t>> sparse_pending_ids_;
 };
 
 }  // namespace distributed
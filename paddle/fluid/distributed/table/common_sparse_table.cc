@@ -201,9 +201,9 @@ int64_t LoadFromText(const std::string& valuepath, const std::string& metapath,
 }
 
 int32_t CommonSparseTable::initialize() {
-  _shards_task_pool.resize(task_pool_size_);
-  for (int i = 0; i < _shards_task_pool.size(); ++i) {
-    _shards_task_pool[i].reset(new ::ThreadPool(1));
+  shard_locks_.resize(local_shard_num_);
+  for (int i = 0; i < local_shard_num_; ++i) {
+    shard_locks_[i].reset(new std::mutex());
   }
 
   sync = _config.common().sync();
@@ -243,9 +243,9 @@ int32_t CommonSparseTable::initialize_recorder() { return 0; }
 
 int32_t CommonSparseTable::initialize_value() {
   auto common = _config.common();
-  shard_values_.reserve(task_pool_size_);
+  shard_values_.reserve(local_shard_num_);
 
-  for (int x = 0; x < task_pool_size_; ++x) {
+  for (int x = 0; x < local_shard_num_; ++x) {
     auto shard = std::make_shared<ValueBlock>(
         value_names_, value_dims_, value_offsets_, value_idx_,
         initializer_attrs_, common.entry());
@@ -312,7 +312,7 @@ int32_t CommonSparseTable::load(const std::string& path,
                                 const std::string& param) {
   rwlock_->WRLock();
   VLOG(3) << "sparse table load with " << path << " with meta " << param;
-  LoadFromText(path, param, _shard_idx, _shard_num, task_pool_size_,
+  LoadFromText(path, param, _shard_idx, _shard_num, local_shard_num_,
                &shard_values_);
   rwlock_->UNLock();
   return 0;
@@ -340,7 +340,7 @@ int32_t CommonSparseTable::save(const std::string& dirname,
   std::unique_ptr<std::ofstream> value_out(new std::ofstream(value_));
 
   int64_t total_ins = 0;
-  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
+  for (int shard_id = 0; shard_id < local_shard_num_; ++shard_id) {
     // save values
     total_ins += SaveToText(value_out.get(), shard_values_[shard_id], mode);
   }
@@ -378,6 +378,7 @@ std::pair<int64_t, int64_t> CommonSparseTable::print_table_stat() {
 
 int32_t CommonSparseTable::pour() {
   rwlock_->RDLock();
+  std::lock_guard<std::mutex> lock(reservoir_lock_);
 
   std::vector<float> values;
   std::vector<uint64_t> keys;
@@ -399,41 +400,38 @@ int32_t CommonSparseTable::pour() {
   return 0;
 }
 
+void CommonSparseTable::bucket_by_shard(
+    const uint64_t* keys, size_t num,
+    std::vector<std::vector<uint64_t>>* offset_bucket) {
+  offset_bucket->resize(local_shard_num_);
+  for (size_t x = 0; x < num; ++x) {
+    auto y = keys[x] % local_shard_num_;
+    offset_bucket->at(y).push_back(x);
+  }
+}
+
 int32_t CommonSparseTable::pull_sparse(float* pull_values, const uint64_t* keys,
                                        size_t num) {
   rwlock_->RDLock();
 
   std::vector<std::vector<uint64_t>> offset_bucket;
-  offset_bucket.resize(task_pool_size_);
-
-  for (int x = 0; x < num; ++x) {
-    auto y = keys[x] % task_pool_size_;
-    offset_bucket[y].push_back(x);
-  }
-
-  std::vector<std::future<int>> tasks(task_pool_size_);
-
-  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
-    tasks[shard_id] = _shards_task_pool[shard_id]->enqueue(
-        [this, shard_id, &keys, &offset_bucket, &pull_values]() -> int {
-          auto& block = shard_values_[shard_id];
-          auto& offsets = offset_bucket[shard_id];
-
-          for (int i = 0; i < offsets.size(); ++i) {
-            auto offset = offsets[i];
-            auto id = keys[offset];
-            auto* value = block->Init(id);
-            std::copy_n(value + param_offset_, param_dim_,
-                        pull_values + param_dim_ * offset);
-          }
-
-          return 0;
-        });
+  bucket_by_shard(keys, num, &offset_bucket);
+
+  for (int shard_id = 0; shard_id < local_shard_num_; ++shard_id) {
+    auto& offsets = offset_bucket[shard_id];
+    if (offsets.empty()) continue;
+
+    std::lock_guard<std::mutex> lock(*shard_locks_[shard_id]);
+    auto& block = shard_values_[shard_id];
+    for (size_t i = 0; i < offsets.size(); ++i) {
+      auto offset = offsets[i];
+      auto id = keys[offset];
+      auto* value = block->Init(id);
+      std::copy_n(value + param_offset_, param_dim_,
+                  pull_values + param_dim_ * offset);
+    }
   }
 
-  for (size_t shard_id = 0; shard_id < tasks.size(); ++shard_id) {
-    tasks[shard_id].wait();
-  }
   rwlock_->UNLock();
   return 0;
 }
@@ -441,29 +439,19 @@ int32_t CommonSparseTable::pull_sparse(float* pull_values, const uint64_t* keys,
 int32_t CommonSparseTable::_push_sparse(const uint64_t* keys,
                                         const float* values, size_t num) {
   rwlock_->RDLock();
-  std::vector<std::vector<uint64_t>> offset_bucket;
-  offset_bucket.resize(task_pool_size_);
 
-  for (int x = 0; x < num; ++x) {
-    auto y = keys[x] % task_pool_size_;
-    offset_bucket[y].push_back(x);
-  }
+  std::vector<std::vector<uint64_t>> offset_bucket;
+  bucket_by_shard(keys, num, &offset_bucket);
 
-  std::vector<std::future<int>> tasks(task_pool_size_);
+  for (int shard_id = 0; shard_id < local_shard_num_; ++shard_id) {
+    auto& offsets = offset_bucket[shard_id];
+    if (offsets.empty()) continue;
 
-  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
-    tasks[shard_id] = _shards_task_pool[shard_id]->enqueue(
-        [this, shard_id, &keys, &values, num, &offset_bucket]() -> int {
-          auto& offsets = offset_bucket[shard_id];
-          optimizer_->update(keys, values, num, offsets,
-                             shard_values_[shard_id].get());
-          return 0;
-        });
+    std::lock_guard<std::mutex> lock(*shard_locks_[shard_id]);
+    optimizer_->update(keys, values, num, offsets,
+                       shard_values_[shard_id].get());
   }
 
-  for (size_t shard_id = 0; shard_id < tasks.size(); ++shard_id) {
-    tasks[shard_id].wait();
-  }
   rwlock_->UNLock();
   return 0;
 }
@@ -471,22 +459,18 @@ int32_t CommonSparseTable::_push_sparse(const uint64_t* keys,
 int32_t CommonSparseTable::push_sparse(const uint64_t* keys,
                                        const float* values, size_t num) {
   if (sync) {
-    std::future<int> task =
-        _shards_task_pool[0]->enqueue([this, &keys, &values, num]() -> int {
-          for (int x = 0; x < num; ++x) {
-            auto id = keys[x];
-            auto has = pull_reservoir_.find(id);
-
-            if (has == pull_reservoir_.end()) {
-              pull_reservoir_[id] = ReservoirValue<float>(param_dim_);
-            }
-
-            auto& reservoir = pull_reservoir_[id];
-            reservoir.add(values + x * param_dim_, param_dim_);
-          }
-          return 0;
-        });
-    task.wait();
+    std::lock_guard<std::mutex> lock(reservoir_lock_);
+    for (size_t x = 0; x < num; ++x) {
+      auto id = keys[x];
+      auto has = pull_reservoir_.find(id);
+
+      if (has == pull_reservoir_.end()) {
+        pull_reservoir_[id] = ReservoirValue<float>(param_dim_);
+      }
+
+      auto& reservoir = pull_reservoir_[id];
+      reservoir.add(values + x * param_dim_, param_dim_);
+    }
   } else {
     _push_sparse(keys, values, num);
   }
@@ -499,36 +483,24 @@ int32_t CommonSparseTable::push_sparse_param(const uint64_t* keys,
   rwlock_->RDLock();
 
   std::vector<std::vector<uint64_t>> offset_bucket;
-  offset_bucket.resize(task_pool_size_);
-
-  for (int x = 0; x < num; ++x) {
-    auto y = keys[x] % task_pool_size_;
-    offset_bucket[y].push_back(x);
-  }
-
-  std::vector<std::future<int>> tasks(task_pool_size_);
-
-  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
-    tasks[shard_id] = _shards_task_pool[shard_id]->enqueue(
-        [this, shard_id, &keys, &offset_bucket, &values]() -> int {
-          auto& block = shard_values_[shard_id];
-          auto& offsets = offset_bucket[shard_id];
-
-          for (int i = 0; i < offsets.size(); ++i) {
-            auto offset = offsets[i];
-            auto id = keys[offset];
-            auto* value = block->Init(id, false);
-            std::copy_n(values + param_dim_ * offset, param_dim_,
-                        value + param_offset_);
-            block->SetEntry(id, true);
-          }
-          return 0;
-        });
+  bucket_by_shard(keys, num, &offset_bucket);
+
+  for (int shard_id = 0; shard_id < local_shard_num_; ++shard_id) {
+    auto& offsets = offset_bucket[shard_id];
+    if (offsets.empty()) continue;
+
+    std::lock_guard<std::mutex> lock(*shard_locks_[shard_id]);
+    auto& block = shard_values_[shard_id];
+    for (size_t i = 0; i < offsets.size(); ++i) {
+      auto offset = offsets[i];
+      auto id = keys[offset];
+      auto* value = block->Init(id, false);
+      std::copy_n(values + param_dim_ * offset, param_dim_,
+                  value + param_offset_);
+      block->SetEntry(id, true);
+    }
   }
 
-  for (size_t shard_id = 0; shard_id < tasks.size(); ++shard_id) {
-    tasks[shard_id].wait();
-  }
   rwlock_->UNLock();
   return 0;
 }
@@ -540,9 +512,9 @@ int32_t CommonSparseTable::shrink(const std::string& param) {
   int threshold = std::stoi(param);
   VLOG(3) << "sparse table shrink: " << threshold;
 
-  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
+  for (int shard_id = 0; shard_id < local_shard_num_; ++shard_id) {
     // shrink
-    VLOG(4) << shard_id << " " << task_pool_size_ << " begin shrink";
+    VLOG(4) << shard_id << " " << local_shard_num_ << " begin shrink";
     shard_values_[shard_id]->Shrink(threshold);
   }
   rwlock_->UNLock();
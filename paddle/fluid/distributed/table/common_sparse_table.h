@@ -14,7 +14,6 @@
 
 #pragma once
 
-#include <ThreadPool.h>
 #include <assert.h>
 #include <pthread.h>
 #include <memory>
@@ -82,9 +81,18 @@ class CommonSparseTable : public SparseTable {
   virtual int32_t _push_sparse(const uint64_t* keys, const float* values,
                                size_t num);
 
+  // group the offsets of keys by the shard they belong to
+  void bucket_by_shard(const uint64_t* keys, size_t num,
+                       std::vector<std::vector<uint64_t>>* offset_bucket);
+
  private:
-  const int task_pool_size_ = 11;
-  std::vector<std::shared_ptr<::ThreadPool>> _shards_task_pool;
+  // The rows are split into local shards by id % local_shard_num_. Each
+  // shard is guarded by its own lock, and the request threads read and
+  // update the rows directly. It is a prime, so the ids of one pserver,
+  // which share the same id % _shard_num, still spread over all shards.
+  const int local_shard_num_ = 31;
+  std::vector<std::unique_ptr<std::mutex>> shard_locks_;
+  std::mutex reservoir_lock_;
 
   bool sync = false;
   int param_dim_ = 0;
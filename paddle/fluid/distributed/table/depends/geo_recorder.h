@@ -14,10 +14,8 @@
 
 #pragma once
 
-#include <ThreadPool.h>
-#include <functional>
-#include <future>  // NOLINT
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -27,34 +25,36 @@
 namespace paddle {
 namespace distributed {
 
+// The rows updated since the last pull of one trainer. It is only touched
+// for a short time by push and pull, so a mutex is cheaper than a dedicated
+// thread for every trainer.
 class ConcurrentSet {
  public:
-  ConcurrentSet() : pool_(new ::ThreadPool(1)) {}
+  ConcurrentSet() {}
   ~ConcurrentSet() {}
 
-  std::future<void> Update(const std::vector<uint64_t>& rows) {
-    auto task = [this, rows] {
-      for (auto row : rows) {
-        set_.insert(row);
-      }
-    };
-    return pool_->enqueue(std::move(task));
+  void Update(const std::vector<uint64_t>& rows) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    set_.insert(rows.begin(), rows.end());
   }
 
-  std::future<void> GetAndClear(std::vector<uint64_t>* result) {
-    auto task = [this, &result] {
-      result->clear();
-      for (auto& id : set_) {
-        result->push_back(id);
-      }
-      set_.clear();
-    };
-    return pool_->enqueue(std::move(task));
+  void GetAndClear(std::vector<uint64_t>* result) {
+    std::unordered_set<uint64_t> rows;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      rows.swap(set_);
+    }
+    result->assign(rows.begin(), rows.end());
+  }
+
+  size_t Size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return set_.size();
   }
 
  private:
   std::unordered_set<uint64_t> set_;
-  std::unique_ptr<::ThreadPool> pool_{nullptr};
+  mutable std::mutex mutex_;
 };
 
 class GeoRecorder {
@@ -70,19 +70,19 @@ class GeoRecorder {
 
   void Update(const std::vector<uint64_t>& update_rows) {
     VLOG(3) << " row size: " << update_rows.size();
-
-    std::vector<std::future<void>> fs;
     for (auto& set : trainer_rows_) {
-      fs.push_back(set->Update(update_rows));
-    }
-    for (auto& f : fs) {
-      f.wait();
+      set->Update(update_rows);
     }
   }
 
   void GetAndClear(uint32_t trainer_id, std::vector<uint64_t>* result) {
     VLOG(3) << "GetAndClear for trainer: " << trainer_id;
-    trainer_rows_.at(trainer_id)->GetAndClear(result).wait();
+    trainer_rows_.at(trainer_id)->GetAndClear(result);
+  }
+
+  // the number of rows waiting to be pulled by the trainer
+  size_t Size(uint32_t trainer_id) const {
+    return trainer_rows_.at(trainer_id)->Size();
   }
 
  private:
@@ -0,0 +1,88 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/service/communicator.h"
+
+namespace paddle {
+namespace distributed {
+
+TEST(GeoCommunicator, SelectGeoSparseDelta) {
+  const int64_t width = 2;
+  const float coefficient = 0.5f;
+  // 4 rows, the trainer changed rows 0, 1 and 3
+  std::vector<float> old = {0, 0, 1, 1, 2, 2, 3, 3};
+  std::vector<float> latest = {0.1, 0, 1, 1.01, 2, 2, 5, 3};
+  std::vector<int64_t> ids = {0, 1, 3};
+  std::vector<float> values(ids.size() * width);
+
+  std::vector<int64_t> send_ids, pending_ids;
+  std::vector<float *> send_values;
+  SelectGeoSparseDelta(latest.data(), old.data(), width, ids, coefficient,
+                       0.04f, values.data(), &send_ids, &send_values,
+                       &pending_ids);
+  // row 1 changes 0.005 after scaling, lower than the threshold
+  EXPECT_EQ(send_ids, std::vector<int64_t>({0, 3}));
+  EXPECT_EQ(pending_ids, std::vector<int64_t>({1}));
+  ASSERT_EQ(send_values.size(), 2UL);
+  EXPECT_NEAR(send_values[0][0], 0.05f, 1e-6);
+  EXPECT_NEAR(send_values[1][0], 1.f, 1e-6);
+  // the old values of the sent rows move, those of the pending row do not
+  EXPECT_NEAR(old[0], 0.05f, 1e-6);
+  EXPECT_NEAR(old[6], 4.f, 1e-6);
+  EXPECT_NEAR(old[3], 1.f, 1e-6);
+
+  // The pending row is merged into the next round, where its delta has
+  // accumulated to the threshold.
+  latest[3] = 1.1f;
+  ids = {2};
+  ids.insert(ids.end(), pending_ids.begin(), pending_ids.end());
+  send_ids.clear();
+  send_values.clear();
+  pending_ids.clear();
+  SelectGeoSparseDelta(latest.data(), old.data(), width, ids, coefficient,
+                       0.04f, values.data(), &send_ids, &send_values,
+                       &pending_ids);
+  EXPECT_EQ(send_ids, std::vector<int64_t>({1}));
+  EXPECT_EQ(pending_ids, std::vector<int64_t>({2}));
+  EXPECT_NEAR(send_values[0][1], 0.05f, 1e-6);
+  EXPECT_NEAR(old[3], 1.05f, 1e-6);
+
+  // no threshold, every row is sent
+  send_ids.clear();
+  send_values.clear();
+  pending_ids.clear();
+  SelectGeoSparseDelta(latest.data(), old.data(), width, {0, 1, 2, 3},
+                       coefficient, 0.f, values.data(), &send_ids,
+                       &send_values, &pending_ids);
+  EXPECT_EQ(send_ids.size(), 4UL);
+  EXPECT_TRUE(pending_ids.empty());
+}
+
+TEST(GeoCommunicator, SplitGeoSendChunks) {
+  using Chunks = std::vector<std::pair<size_t, size_t>>;
+  EXPECT_EQ(SplitGeoSendChunks(10, 0), Chunks({{0, 10}}));
+  EXPECT_EQ(SplitGeoSendChunks(10, -1), Chunks({{0, 10}}));
+  EXPECT_EQ(SplitGeoSendChunks(10, 4), Chunks({{0, 4}, {4, 8}, {8, 10}}));
+  EXPECT_EQ(SplitGeoSendChunks(8, 4), Chunks({{0, 4}, {4, 8}}));
+  EXPECT_EQ(SplitGeoSendChunks(3, 100), Chunks({{0, 3}}));
+  EXPECT_TRUE(SplitGeoSendChunks(0, 4).empty());
+  EXPECT_TRUE(SplitGeoSendChunks(0, 0).empty());
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -15,6 +15,7 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <algorithm>
 #include <string>
 #include <thread>  // NOLINT
 
@@ -115,5 +116,36 @@ TEST(SparseGeoTable, SSUM) {
   }
 }
 
+TEST(GeoRecorder, Update) {
+  int trainers = 3;
+  GeoRecorder recorder(trainers);
+
+  std::shared_ptr<::ThreadPool> pool_ =
+      std::make_shared<::ThreadPool>(trainers);
+  std::vector<std::future<void>> task_status;
+  for (int i = 0; i < trainers; i++) {
+    auto task = [&recorder, i] {
+      recorder.Update({0, 1, 2, static_cast<uint64_t>(10 + i)});
+    };
+    task_status.push_back(pool_->enqueue(std::move(task)));
+  }
+  for (auto &status : task_status) {
+    status.wait();
+  }
+
+  // every trainer gets the rows updated by all the trainers, only once
+  std::vector<uint64_t> ids;
+  recorder.GetAndClear(0, &ids);
+  std::sort(ids.begin(), ids.end());
+  std::vector<uint64_t> expect_ids = {0, 1, 2, 10, 11, 12};
+  ASSERT_EQ(ids, expect_ids);
+  ASSERT_EQ(recorder.Size(0), 0UL);
+  ASSERT_EQ(recorder.Size(1), expect_ids.size());
+
+  recorder.Update({1});
+  recorder.GetAndClear(0, &ids);
+  ASSERT_EQ(ids, std::vector<uint64_t>({1}));
+}
+
 }  // namespace distributed
 }  // namespace paddle
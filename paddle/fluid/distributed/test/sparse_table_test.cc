@@ -15,6 +15,7 @@ limitations under the License. */
 #include <ThreadPool.h>
 
 #include <unistd.h>
+#include <chrono>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
@@ -209,5 +210,61 @@ TEST(CommonSparseTable, Adam) {
   }
 }
 
+// CommonSparseTable + SSUM, pushed and pulled by many request threads
+TEST(CommonSparseTable, MultiThread) {
+  int emb_dim = 8;
+  int push_times = 20;
+  uint64_t key_num = 1000;
+
+  std::vector<uint64_t> keys(key_num);
+  for (uint64_t i = 0; i < key_num; ++i) {
+    keys[i] = i;
+  }
+  std::vector<float> grads(key_num * emb_dim, 1.0);
+
+  for (int threads : {1, 2, 4, 8}) {
+    TableParameter table_config;
+    table_config.set_table_class("CommonSparseTable");
+    FsClientParameter fs_config;
+    std::unique_ptr<Table> table(new CommonSparseTable());
+    TableAccessorParameter *accessor_config = table_config.mutable_accessor();
+    accessor_config->set_accessor_class("CommMergeAccessor");
+    CommonAccessorParameter *common_config = table_config.mutable_common();
+    common_config->set_name("sum");
+    common_config->set_table_name("multi_thread_test_table");
+    common_config->set_trainer_num(threads);
+    common_config->add_params("Param");
+    common_config->add_dims(emb_dim);
+    common_config->add_initializers("fill_constant&0.0");
+    auto ret = table->initialize(table_config, fs_config);
+    ASSERT_EQ(ret, 0);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; ++i) {
+      workers.emplace_back([&] {
+        std::vector<float> pulls(key_num * emb_dim);
+        for (int t = 0; t < push_times; ++t) {
+          table->pull_sparse(pulls.data(), keys.data(), key_num);
+          table->push_sparse(keys.data(), grads.data(), key_num);
+        }
+      });
+    }
+    for (auto &worker : workers) {
+      worker.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    LOG(INFO) << threads << " threads: "
+              << std::chrono::duration<double, std::milli>(end - start).count()
+              << " ms for " << threads * push_times << " pull and push";
+
+    std::vector<float> pull_values(key_num * emb_dim);
+    table->pull_sparse(pull_values.data(), keys.data(), key_num);
+    for (size_t i = 0; i < pull_values.size(); ++i) {
+      ASSERT_FLOAT_EQ(pull_values[i], threads * push_times);
+    }
+  }
+}
+
 }  // namespace distributed
 }  // namespace paddle
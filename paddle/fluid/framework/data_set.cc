@@ -13,6 +13,11 @@
  *     limitations under the License. */
 
 #include "paddle/fluid/framework/data_set.h"
+#include <xxhash.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <deque>
+#include <random>
 #include "google/protobuf/text_format.h"
 #include "paddle/fluid/framework/data_feed_factory.h"
 #include "paddle/fluid/framework/io/fs.h"
@@ -28,6 +33,92 @@ USE_INT_STAT(STAT_total_feasign_num_in_mem);
 namespace paddle {
 namespace framework {
 
+namespace {
+
+// the vectors shorter than this are shuffled by a single thread
+constexpr size_t kMinParallelShuffleSize = 1 << 16;
+
+// Run fn(i) for i in [0, num) on num threads.
+template <typename Func>
+void ParallelRun(int num, Func fn) {
+  std::vector<std::thread> threads;
+  threads.reserve(num);
+  for (int i = 0; i < num; ++i) {
+    threads.emplace_back(fn, i);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+// Shuffle *data with thread_num threads. The indices of every chunk are
+// scattered to thread_num buckets at random, each bucket is shuffled by
+// Fisher-Yates, and the records are then moved to the positions given by
+// the concatenated buckets. This gives a uniformly random permutation, as a
+// sequential shuffle does.
+template <typename T>
+void ParallelShuffle(std::vector<T>* data, int thread_num,
+                     std::default_random_engine* engine) {
+  size_t n = data->size();
+  if (thread_num <= 1 || n < kMinParallelShuffleSize) {
+    std::shuffle(data->begin(), data->end(), *engine);
+    return;
+  }
+  // the engine of the calling thread seeds one engine per task
+  std::vector<uint64_t> seeds(2 * thread_num);
+  for (auto& seed : seeds) {
+    seed = (*engine)();
+  }
+
+  std::vector<std::vector<std::vector<size_t>>> buckets(
+      thread_num, std::vector<std::vector<size_t>>(thread_num));
+  size_t chunk = (n + thread_num - 1) / thread_num;
+  ParallelRun(thread_num, [&](int tid) {
+    std::default_random_engine e(seeds[tid]);
+    std::uniform_int_distribution<int> dist(0, thread_num - 1);
+    size_t begin = std::min(n, tid * chunk);
+    size_t end = std::min(n, begin + chunk);
+    for (auto& bucket : buckets[tid]) {
+      bucket.reserve((end - begin) / thread_num + 1);
+    }
+    for (size_t i = begin; i < end; ++i) {
+      buckets[tid][dist(e)].push_back(i);
+    }
+  });
+
+  std::vector<size_t> offsets(thread_num + 1, 0);
+  for (int b = 0; b < thread_num; ++b) {
+    size_t size = 0;
+    for (int tid = 0; tid < thread_num; ++tid) {
+      size += buckets[tid][b].size();
+    }
+    offsets[b + 1] = offsets[b] + size;
+  }
+  std::vector<size_t> perm(n);
+  ParallelRun(thread_num, [&](int b) {
+    auto out = perm.begin() + offsets[b];
+    for (int tid = 0; tid < thread_num; ++tid) {
+      auto& bucket = buckets[tid][b];
+      out = std::copy(bucket.begin(), bucket.end(), out);
+      std::vector<size_t>().swap(bucket);
+    }
+    std::default_random_engine e(seeds[thread_num + b]);
+    std::shuffle(perm.begin() + offsets[b], perm.begin() + offsets[b + 1], e);
+  });
+
+  std::vector<T> shuffled(n);
+  ParallelRun(thread_num, [&](int tid) {
+    size_t begin = std::min(n, tid * chunk);
+    size_t end = std::min(n, begin + chunk);
+    for (size_t i = begin; i < end; ++i) {
+      shuffled[i] = std::move((*data)[perm[i]]);
+    }
+  });
+  data->swap(shuffled);
+}
+
+}  // namespace
+
 // constructor
 template <typename T>
 DatasetImpl<T>::DatasetImpl() {
@@ -348,7 +439,7 @@ void DatasetImpl<T>::LocalShuffle() {
   input_channel_->Close();
   std::vector<T> data;
   input_channel_->ReadAll(data);
-  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
+  ParallelShuffle(&data, thread_num_, &fleet_ptr->LocalRandomEngine());
   input_channel_->Open();
   input_channel_->Write(std::move(data));
   data.clear();
@@ -367,95 +458,99 @@ void DatasetImpl<T>::GlobalShuffle(int thread_num) {
   platform::Timer timeline;
   timeline.Start();
   auto fleet_ptr = FleetWrapper::GetInstance();
+  ShuffleToClients(thread_num, [fleet_ptr](int client_id,
+                                           const std::string& msg) {
+    return fleet_ptr->SendClientToClientMsg(0, client_id, msg);
+  });
+  timeline.Pause();
+  VLOG(3) << "DatasetImpl<T>::GlobalShuffle() end, cost time="
+          << timeline.ElapsedSec() << " seconds";
+#endif
+}
 
+template <typename T>
+void DatasetImpl<T>::ShuffleToClients(
+    int thread_num,
+    const std::function<std::future<int32_t>(int, const std::string&)>&
+        send_fn) {
   if (!input_channel_ || input_channel_->Size() == 0) {
-    VLOG(3) << "DatasetImpl<T>::GlobalShuffle() end, no data to shuffle";
+    VLOG(3) << "DatasetImpl<T>::ShuffleToClients() end, no data to shuffle";
     return;
   }
+  if (thread_num == -1) {
+    thread_num = thread_num_;
+  }
+  auto fleet_ptr = FleetWrapper::GetInstance();
 
   // local shuffle
   input_channel_->Close();
   std::vector<T> data;
   input_channel_->ReadAll(data);
-  std::shuffle(data.begin(), data.end(), fleet_ptr->LocalRandomEngine());
-  input_channel_->Open();
-  input_channel_->Write(std::move(data));
-  data.clear();
-  data.shrink_to_fit();
-
-  input_channel_->Close();
-  input_channel_->SetBlockSize(fleet_send_batch_size_);
-  VLOG(3) << "DatasetImpl<T>::GlobalShuffle() input_channel_ size "
-          << input_channel_->Size();
-
-  auto get_client_id = [this, fleet_ptr](const T& data) -> size_t {
-    if (!this->merge_by_insid_) {
-      return fleet_ptr->LocalRandomEngine()() % this->trainer_num_;
-    } else {
-      return XXH64(data.ins_id_.data(), data.ins_id_.length(), 0) %
-             this->trainer_num_;
-    }
-  };
+  ParallelShuffle(&data, thread_num, &fleet_ptr->LocalRandomEngine());
+  input_channel_->Clear();
+  VLOG(3) << "DatasetImpl<T>::ShuffleToClients() data size " << data.size();
 
-  auto global_shuffle_func = [this, get_client_id]() {
-    auto fleet_ptr = FleetWrapper::GetInstance();
-    std::vector<T> data;
-    while (this->input_channel_->Read(data)) {
-      std::vector<paddle::framework::BinaryArchive> ars(this->trainer_num_);
-      for (auto& t : data) {
-        auto client_id = get_client_id(t);
-        ars[client_id] << t;
-      }
-      std::vector<std::future<int32_t>> total_status;
-      std::vector<int> send_index(this->trainer_num_);
-      for (int i = 0; i < this->trainer_num_; ++i) {
-        send_index[i] = i;
-      }
-      std::shuffle(send_index.begin(), send_index.end(),
-                   fleet_ptr->LocalRandomEngine());
-      for (int index = 0; index < this->trainer_num_; ++index) {
-        int i = send_index[index];
-        if (ars[i].Length() == 0) {
-          continue;
-        }
-        std::string msg(ars[i].Buffer(), ars[i].Length());
-        auto ret = fleet_ptr->SendClientToClientMsg(0, i, msg);
-        total_status.push_back(std::move(ret));
+  std::vector<uint64_t> seeds(thread_num);
+  for (auto& seed : seeds) {
+    seed = fleet_ptr->LocalRandomEngine()();
+  }
+  size_t chunk = (data.size() + thread_num - 1) / thread_num;
+  // Every thread serializes its records into one bucket per trainer and
+  // sends a bucket once it holds fleet_send_batch_size_ records. At most
+  // trainer_num_ sends of a thread are in flight, so that serializing the
+  // next buckets overlaps with the sends instead of waiting for them.
+  auto global_shuffle_func = [&](int tid) {
+    std::default_random_engine engine(seeds[tid]);
+    std::vector<paddle::framework::BinaryArchive> ars(trainer_num_);
+    std::vector<int64_t> counts(trainer_num_, 0);
+    std::deque<std::future<int32_t>> inflight;
+    auto send = [&](int client_id) {
+      std::string msg(ars[client_id].Buffer(), ars[client_id].Length());
+      ars[client_id].Clear();
+      counts[client_id] = 0;
+      if (inflight.size() >= static_cast<size_t>(trainer_num_)) {
+        inflight.front().wait();
+        inflight.pop_front();
       }
-      for (auto& t : total_status) {
-        t.wait();
+      inflight.push_back(send_fn(client_id, msg));
+    };
+
+    size_t begin = std::min(data.size(), tid * chunk);
+    size_t end = std::min(data.size(), begin + chunk);
+    for (size_t i = begin; i < end; ++i) {
+      auto& t = data[i];
+      size_t client_id =
+          merge_by_insid_
+              ? XXH64(t.ins_id_.data(), t.ins_id_.length(), 0) % trainer_num_
+              : engine() % trainer_num_;
+      ars[client_id] << t;
+      if (++counts[client_id] >= fleet_send_batch_size_) {
+        send(client_id);
       }
-      ars.clear();
-      ars.shrink_to_fit();
-      data.clear();
-      data.shrink_to_fit();
+      t = T();
       // currently we find bottleneck is server not able to handle large data
       // in time, so we can remove this sleep and set fleet_send_batch_size to
       // 1024, and set server thread to 24.
-      if (fleet_send_sleep_seconds_ != 0) {
-        sleep(this->fleet_send_sleep_seconds_);
+      if (fleet_send_sleep_seconds_ != 0 &&
+          (i - begin + 1) % fleet_send_batch_size_ == 0) {
+        std::this_thread::sleep_for(
+            std::chrono::seconds(fleet_send_sleep_seconds_));
+      }
+    }
+    for (int client_id = 0; client_id < trainer_num_; ++client_id) {
+      if (counts[client_id] > 0) {
+        send(client_id);
       }
     }
+    for (auto& f : inflight) {
+      f.wait();
+    }
   };
 
-  std::vector<std::thread> global_shuffle_threads;
-  if (thread_num == -1) {
-    thread_num = thread_num_;
-  }
   VLOG(3) << "start global shuffle threads, num = " << thread_num;
-  for (int i = 0; i < thread_num; ++i) {
-    global_shuffle_threads.push_back(std::thread(global_shuffle_func));
-  }
-  for (std::thread& t : global_shuffle_threads) {
-    t.join();
-  }
-  global_shuffle_threads.clear();
-  global_shuffle_threads.shrink_to_fit();
-  input_channel_->Clear();
-  timeline.Pause();
-  VLOG(3) << "DatasetImpl<T>::GlobalShuffle() end, cost time="
-          << timeline.ElapsedSec() << " seconds";
-#endif
+  ParallelRun(thread_num, global_shuffle_func);
+  data.clear();
+  data.shrink_to_fit();
 }
 
 template <typename T>
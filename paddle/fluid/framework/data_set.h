@@ -16,6 +16,8 @@
 
 #include <ThreadPool.h>
 #include <fstream>
+#include <functional>
+#include <future>  // NOLINT
 #include <memory>
 #include <mutex>  // NOLINT
 #include <set>
@@ -203,6 +205,13 @@ class DatasetImpl : public Dataset {
   virtual void ReleaseMemory();
   virtual void LocalShuffle();
   virtual void GlobalShuffle(int thread_num = -1);
+  // Send the records of the input channel to the trainers as GlobalShuffle
+  // does, but through send_fn(client_id, msg), which hands a serialized batch
+  // to ReceiveFromClient of that trainer. GlobalShuffle sends them by fleet.
+  virtual void ShuffleToClients(
+      int thread_num,
+      const std::function<std::future<int32_t>(int, const std::string&)>&
+          send_fn);
   virtual void SlotsShuffle(const std::set<std::string>& slots_to_replace) {}
   virtual const std::vector<T>& GetSlotsOriginalData() {
     return slots_shuffle_original_data_;
@@ -0,0 +1,152 @@
+//   Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/data_set.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <future>  // NOLINT
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+// Stands in for one trainer of a global shuffle.
+class ShuffleTestDataset : public DatasetImpl<Record> {
+ public:
+  using DatasetImpl<Record>::ReceiveFromClient;
+};
+
+static std::vector<Record> MakeRecords(size_t begin, size_t end) {
+  std::vector<Record> records(end - begin);
+  for (size_t i = begin; i < end; ++i) {
+    auto& rec = records[i - begin];
+    rec.ins_id_ = std::to_string(i);
+    rec.uint64_feasigns_.emplace_back(FeatureFeasign(), 0);
+    rec.uint64_feasigns_.back().sign().uint64_feasign_ = i;
+  }
+  return records;
+}
+
+static void CheckRecords(const std::vector<Record>& records, size_t num) {
+  ASSERT_EQ(records.size(), num);
+  std::vector<bool> seen(num, false);
+  for (auto& rec : records) {
+    ASSERT_EQ(rec.uint64_feasigns_.size(), 1UL);
+    uint64_t id = rec.uint64_feasigns_[0].sign().uint64_feasign_;
+    ASSERT_LT(id, num);
+    EXPECT_FALSE(seen[id]);
+    EXPECT_EQ(rec.ins_id_, std::to_string(id));
+    seen[id] = true;
+  }
+}
+
+TEST(DatasetImpl, LocalShuffle) {
+  const size_t num = 1 << 20;
+  ShuffleTestDataset dataset;
+  dataset.SetThreadNum(8);
+  dataset.CreateChannel();
+  auto channel = dataset.GetInputChannel();
+  channel->Open();
+  channel->Write(MakeRecords(0, num));
+  channel->Close();
+
+  auto start = std::chrono::steady_clock::now();
+  dataset.LocalShuffle();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << "LocalShuffle of " << num << " records: " << seconds << " s";
+
+  std::vector<Record> records;
+  channel->ReadAll(records);
+  CheckRecords(records, num);
+  size_t fixed = 0;
+  for (size_t i = 0; i < num; ++i) {
+    fixed += records[i].uint64_feasigns_[0].sign().uint64_feasign_ == i;
+  }
+  EXPECT_LT(fixed, num / 100);
+}
+
+TEST(DatasetImpl, ShuffleToClients) {
+  const int trainer_num = 4;
+  const size_t num_per_trainer = 1 << 18;
+  std::vector<std::unique_ptr<ShuffleTestDataset>> trainers;
+  for (int i = 0; i < trainer_num; ++i) {
+    trainers.emplace_back(new ShuffleTestDataset());
+    auto& dataset = trainers.back();
+    dataset->SetThreadNum(4);
+    dataset->SetTrainerNum(trainer_num);
+    dataset->SetChannelNum(2);
+    dataset->SetFleetSendBatchSize(1024);
+    dataset->CreateChannel();
+    auto channel = dataset->GetInputChannel();
+    channel->Open();
+    channel->Write(
+        MakeRecords(i * num_per_trainer, (i + 1) * num_per_trainer));
+    channel->Close();
+  }
+
+  // Deliver the batches in place of fleet, as the trainers would receive
+  // them on their client-to-client message handler.
+  auto send_fn = [&](int client_id,
+                     const std::string& msg) -> std::future<int32_t> {
+    return std::async(std::launch::async, [&trainers, client_id, msg] {
+      return trainers[client_id]->ReceiveFromClient(0, 0, msg);
+    });
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto& dataset : trainers) {
+    threads.emplace_back([&dataset, &send_fn] {
+      dataset->ShuffleToClients(-1, send_fn);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << "ShuffleToClients of " << trainer_num * num_per_trainer
+            << " records over " << trainer_num << " trainers: " << seconds
+            << " s";
+
+  std::vector<Record> records;
+  for (auto& dataset : trainers) {
+    EXPECT_EQ(dataset->GetInputChannel()->Size(), 0UL);
+    size_t received = 0;
+    for (auto& channel : dataset->GetMultiOutputChannel()) {
+      std::vector<Record> part;
+      channel->Close();
+      channel->ReadAll(part);
+      received += part.size();
+      std::move(part.begin(), part.end(), std::back_inserter(records));
+    }
+    // each trainer gets about a quarter of the records
+    EXPECT_GT(received, num_per_trainer * 9 / 10);
+    EXPECT_LT(received, num_per_trainer * 11 / 10);
+  }
+  CheckRecords(records, trainer_num * num_per_trainer);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -33,6 +33,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/framework/trainer_desc.pb.h"
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/operators/reader/blocking_queue.h"
@@ -165,6 +166,8 @@ class DeviceWorker {
   virtual void SetRootScope(Scope* root_scope);
   virtual void SetDataFeed(DataFeed* data_feed);
   virtual void SetWorkerNum(int num) {}
+  // the scope holding the params replicated to the NUMA node of the worker
+  virtual void SetNumaNodeScope(Scope* node_scope) {}
   virtual void CacheProgram(const ProgramDesc& main_program) {}
   virtual void ProduceTasks() {}
   virtual void GetXpuOpIndex() {}
@@ -251,20 +254,39 @@ class HogwildWorker : public CPUWorkerBase {
   virtual void PrintFetchVars();
   virtual void CreateDeviceResource(const ProgramDesc& main_prog);
   virtual void BindingDataFeedMemory();
+  virtual void SetNumaNodeScope(Scope* node_scope) { node_scope_ = node_scope; }
   template <typename T>
   void SetZero(LoDTensor* tensor, LoDTensor* root_tensor, int tensor_dim);
 
  protected:
   void CreateThreadOperators(const ProgramDesc& program);
   void CreateThreadScope(const ProgramDesc& program);
+  // bind the calling thread as configured by numa_config and binding_cpu
+  void BindThread();
+  // resolve skip_ops_ and group the remaining ops into stages of
+  // independent ops, done once after the thread operators are created
+  void CreateRunPlan();
+  // run the ops of one batch in thread_scope_ as planned by CreateRunPlan
+  void RunPlan();
 
   std::vector<std::string> op_names_;
   std::vector<OperatorBase*> ops_;
+  // ops_ without the skipped ones, in program order
+  std::vector<OperatorBase*> run_ops_;
+  std::vector<std::string> run_op_names_;
+  // run_ops_ grouped by dependency level, the ops of a stage neither read
+  // nor write the outputs of each other
+  std::vector<std::vector<OperatorBase*>> op_stages_;
+  RunPlanConfig run_plan_config_;
+  std::unique_ptr<ThreadPool> op_pool_;
   bool thread_barrier_;
   // Scope* thread_scope_;
   HogwildWorkerParameter param_;
   std::vector<std::string> skip_ops_;
   std::map<std::string, int> stat_var_name_map_;
+  NumaConfig numa_config_;
+  bool binding_cpu_ = false;
+  Scope* node_scope_ = nullptr;
 };
 
 class DownpourWorker : public HogwildWorker {
@@ -315,8 +337,6 @@ class DownpourWorker : public HogwildWorker {
   std::map<uint64_t, std::vector<std::string>> dense_grad_names_;
   float scale_datanorm_;
   std::vector<::std::future<int32_t>> push_dense_status_;
-  // skipped ops
-  std::vector<std::string> skip_ops_;
   // just save the value in param_ for easy access
   std::map<uint64_t, std::string> label_var_name_;
   std::map<uint64_t, std::vector<std::string>> dense_value_names_;
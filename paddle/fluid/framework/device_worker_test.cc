@@ -15,11 +15,112 @@
 #include "paddle/fluid/framework/device_worker.h"
 
 #include <gtest/gtest.h>
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 
 namespace paddle {
 namespace framework {
+
+class PlanTestOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "inputs of the test op").AsDuplicable();
+    AddOutput("Out", "output of the test op");
+    AddComment("Test op for the run plan of HogwildWorker.");
+  }
+};
+
+class PlanTestKernelOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(framework::InferShapeContext* ctx) const override {}
+};
+
+// sums its inputs and then does some arithmetic on every element, so that
+// running the ops concurrently pays off
+class PlanTestWorkOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(framework::InferShapeContext* ctx) const override {
+    ctx->SetOutputDim("Out", ctx->GetInputsDim("X")[0]);
+  }
+};
+
+template <typename T>
+class PlanTestWorkKernel : public OpKernel<T> {
+ public:
+  void Compute(const ExecutionContext& ctx) const override {
+    auto xs = ctx.MultiInput<LoDTensor>("X");
+    auto* out = ctx.Output<LoDTensor>("Out");
+    out->Resize(xs[0]->dims());
+    T* out_data = out->mutable_data<T>(ctx.GetPlace());
+    for (int64_t i = 0; i < out->numel(); ++i) {
+      T value = 0;
+      for (auto* x : xs) value += x->data<T>()[i];
+      for (int r = 0; r < 2000; ++r) {
+        value = value * static_cast<T>(0.999) + static_cast<T>(0.001);
+      }
+      out_data[i] = value;
+    }
+  }
+};
+
+class PlanTestBaseOp : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+
+ private:
+  void RunImpl(const Scope& scope,
+               const platform::Place& place) const override {}
+};
+
+class TestHogwildWorker : public HogwildWorker {
+ public:
+  void CreatePlan(const ProgramDesc& program,
+                  const std::vector<std::string>& skip_ops,
+                  const RunPlanConfig& config = RunPlanConfig()) {
+    skip_ops_ = skip_ops;
+    run_plan_config_ = config;
+    CreateThreadOperators(program);
+  }
+
+  void RunBatch(Scope* scope) {
+    thread_scope_ = scope;
+    place_ = platform::CPUPlace();
+    RunPlan();
+  }
+
+  void Bind() { BindThread(); }
+
+  const std::vector<std::string>& RunOpNames() const { return run_op_names_; }
+
+  std::vector<std::vector<std::string>> StageOutputs() const {
+    std::vector<std::vector<std::string>> stages;
+    for (auto& stage : op_stages_) {
+      stages.emplace_back();
+      for (auto* op : stage) {
+        stages.back().push_back(op->Output("Out"));
+      }
+    }
+    return stages;
+  }
+};
 TEST(LodTensor, PrintLodTensor) {
   LoDTensor tensor1;
   tensor1.Resize({2});
@@ -74,5 +175,171 @@ TEST(LodTensor, CheckValidOutput) {
   ASSERT_TRUE(CheckValidOutput(&tensor, 2));
 }
 
+static void AppendPlanTestOp(ProgramDesc* program, const std::string& type,
+                             const std::vector<std::string>& inputs,
+                             const std::string& output) {
+  auto* op = program->MutableBlock(0)->AppendOp();
+  op->SetType(type);
+  op->SetInput("X", inputs);
+  op->SetOutput("Out", {output});
+}
+
+TEST(HogwildWorker, CreateRunPlan) {
+  ProgramDesc program;
+  AppendPlanTestOp(&program, "plan_test_skipped_op", {"a"}, "s");
+  AppendPlanTestOp(&program, "plan_test_kernel_op", {"a"}, "b");
+  AppendPlanTestOp(&program, "plan_test_kernel_op", {"a"}, "c");
+  AppendPlanTestOp(&program, "plan_test_kernel_op", {"b", "c"}, "d");
+  // overwrites an input of the former stage
+  AppendPlanTestOp(&program, "plan_test_kernel_op", {"d"}, "a");
+  AppendPlanTestOp(&program, "plan_test_kernel_op", {"b"}, "e");
+  AppendPlanTestOp(&program, "plan_test_base_op", {"e"}, "f");
+  AppendPlanTestOp(&program, "plan_test_kernel_op", {"c"}, "g");
+
+  TestHogwildWorker worker;
+  worker.SetDeviceIndex(0);
+  worker.CreatePlan(program, {"skipped"});
+  ASSERT_EQ(worker.RunOpNames().size(), 7UL);
+  EXPECT_EQ(worker.RunOpNames()[0], "plan_test_kernel_op");
+
+  std::vector<std::vector<std::string>> expected = {
+      {"b", "c"}, {"d", "e"}, {"a"}, {"f"}, {"g"}};
+  EXPECT_EQ(worker.StageOutputs(), expected);
+}
+
+// Compares the examples/s of the serial op loop and the run plan running the
+// independent branches of the program concurrently.
+TEST(HogwildWorker, RunPlanThroughput) {
+  const int num_branches = 4;
+  const int batch_size = 256;
+  const int num_batches = 20;
+  ProgramDesc program;
+  std::vector<std::string> branches;
+  for (int i = 0; i < num_branches; ++i) {
+    branches.push_back("branch_" + std::to_string(i));
+    AppendPlanTestOp(&program, "plan_test_work_op", {"x"}, branches.back());
+  }
+  AppendPlanTestOp(&program, "plan_test_work_op", branches, "y");
+
+  auto run = [&](int op_thread_num, std::vector<float>* y) {
+    RunPlanConfig config;
+    config.set_cache_runtime_context(true);
+    config.set_op_thread_num(op_thread_num);
+    Scope scope;
+    auto* x = scope.Var("x")->GetMutable<LoDTensor>();
+    x->Resize({batch_size, 1});
+    float* x_data = x->mutable_data<float>(platform::CPUPlace());
+    for (int i = 0; i < batch_size; ++i) x_data[i] = i * 0.01f;
+    for (auto& name : branches) scope.Var(name)->GetMutable<LoDTensor>();
+    auto* out = scope.Var("y")->GetMutable<LoDTensor>();
+
+    TestHogwildWorker worker;
+    worker.SetDeviceIndex(0);
+    worker.CreatePlan(program, {}, config);
+    worker.RunBatch(&scope);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_batches; ++i) {
+      worker.RunBatch(&scope);
+    }
+    std::chrono::duration<double> seconds =
+        std::chrono::steady_clock::now() - start;
+    y->assign(out->data<float>(), out->data<float>() + out->numel());
+    return batch_size * num_batches / seconds.count();
+  };
+
+  std::vector<float> serial_y, plan_y;
+  double serial = run(1, &serial_y);
+  double plan = run(num_branches, &plan_y);
+  ASSERT_EQ(serial_y.size(), static_cast<size_t>(batch_size));
+  EXPECT_EQ(serial_y, plan_y);
+  LOG(INFO) << "serial op loop: " << serial << " examples/s, run plan with "
+            << num_branches << " op threads: " << plan << " examples/s";
+}
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// The cpus the calling thread may run on.
+static std::vector<int> CurrentThreadCpus() {
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  std::vector<int> cpus;
+  if (sched_getaffinity(0, sizeof(mask), &mask) != 0) return cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &mask)) cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+TEST(HogwildWorker, NumaPlacement) {
+  const int num_nodes = platform::NumaNodeCount();
+  // The cpus out of the cpuset of the test are never bound.
+  const std::vector<int> allowed = CurrentThreadCpus();
+  auto allowed_of = [&](const std::vector<int>& cpus) {
+    std::vector<int> result;
+    for (int cpu : cpus) {
+      if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+        result.push_back(cpu);
+      }
+    }
+    return result;
+  };
+  TrainerDesc desc;
+  desc.mutable_numa_config()->set_enable(true);
+  for (bool binding_cpu : {false, true}) {
+    desc.set_binding_cpu(binding_cpu);
+    for (int tid = 0; tid < 2 * num_nodes; ++tid) {
+      TestHogwildWorker worker;
+      worker.Initialize(desc);
+      worker.SetDeviceIndex(tid);
+      std::vector<int> cpus;
+      int mode = -1;
+      unsigned long nodemask = 0;  // NOLINT
+      std::thread thread([&] {
+        worker.Bind();
+        cpus = CurrentThreadCpus();
+#ifdef SYS_get_mempolicy
+        if (syscall(SYS_get_mempolicy, &mode, &nodemask,
+                    sizeof(nodemask) * 8, nullptr, 0) != 0) {
+          mode = -1;
+        }
+#endif
+      });
+      thread.join();
+
+      // The workers are spread over the nodes round-robin, and then over the
+      // cpus of their nodes with binding_cpu.
+      int node = tid % num_nodes;
+      auto node_cpus = platform::NumaNodeCpus(node);
+      std::vector<int> expected =
+          binding_cpu ? allowed_of({node_cpus[(tid / num_nodes) %
+                                              node_cpus.size()]})
+                      : allowed_of(node_cpus);
+      if (!expected.empty()) {
+        EXPECT_EQ(cpus, expected) << "worker " << tid;
+      }
+      if (num_nodes > 1 && mode >= 0) {
+        // MPOL_PREFERRED
+        EXPECT_EQ(mode, 1) << "worker " << tid;
+        EXPECT_EQ(nodemask, 1UL << node) << "worker " << tid;
+      }
+    }
+  }
+}
+#endif
+
 }  // namespace framework
 }  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(plan_test_kernel_op,
+                             paddle::framework::PlanTestKernelOp,
+                             paddle::framework::PlanTestOpMaker);
+REGISTER_OP_WITHOUT_GRADIENT(plan_test_skipped_op,
+                             paddle::framework::PlanTestKernelOp,
+                             paddle::framework::PlanTestOpMaker);
+REGISTER_OP_WITHOUT_GRADIENT(plan_test_work_op,
+                             paddle::framework::PlanTestWorkOp,
+                             paddle::framework::PlanTestOpMaker);
+REGISTER_OP_CPU_KERNEL(plan_test_work_op,
+                       paddle::framework::PlanTestWorkKernel<float>);
+REGISTER_OP_WITHOUT_GRADIENT(plan_test_base_op,
+                             paddle::framework::PlanTestBaseOp,
+                             paddle::framework::PlanTestOpMaker);
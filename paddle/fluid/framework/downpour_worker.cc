@@ -76,6 +76,7 @@ void DownpourWorker::Initialize(const TrainerDesc& desc) {
   for (int i = 0; i < param_.skip_ops_size(); ++i) {
     skip_ops_[i] = param_.skip_ops(i);
   }
+  run_plan_config_ = desc.run_plan_config();
 
   for (int i = 0; i < param_.stat_var_names_size(); ++i) {
     stat_var_name_map_[param_.stat_var_names(i)] = 1;
@@ -443,19 +444,7 @@ void DownpourWorker::TrainFilesWithProfiler() {
   platform::SetNumThreads(1);
   device_reader_->Start();
   std::vector<double> op_total_time;
-  std::vector<std::string> op_name;
-  for (auto& op : ops_) {
-    bool need_skip = false;
-    for (auto t = 0u; t < skip_ops_.size(); ++t) {
-      if (op->Type().find(skip_ops_[t]) != std::string::npos) {
-        need_skip = true;
-        break;
-      }
-    }
-    if (!need_skip) {
-      op_name.push_back(op->Type());
-    }
-  }
+  std::vector<std::string>& op_name = run_op_names_;
 
   VLOG(3) << "op name size: " << op_name.size();
   op_total_time.resize(op_name.size());
@@ -536,24 +525,15 @@ void DownpourWorker::TrainFilesWithProfiler() {
     }
     VLOG(3) << "Fill sparse value for all sparse table done.";
 
-    int run_op_idx = 0;
-    for (auto& op : ops_) {
-      bool need_skip = false;
-      for (auto t = 0u; t < skip_ops_.size(); ++t) {
-        if (op->Type().find(skip_ops_[t]) != std::string::npos) {
-          need_skip = true;
-          break;
-        }
-      }
-      if (!need_skip) {
-        timeline.Start();
-        VLOG(3) << "Going to run op " << op_name[run_op_idx];
-        op->Run(*thread_scope_, place_);
-        VLOG(3) << "Op " << op_name[run_op_idx] << " Finished";
-        timeline.Pause();
-        op_total_time[run_op_idx++] += timeline.ElapsedSec();
-        total_time += timeline.ElapsedSec();
-      }
+    // The ops run one by one here to time each of them.
+    for (size_t run_op_idx = 0; run_op_idx < run_ops_.size(); ++run_op_idx) {
+      timeline.Start();
+      VLOG(3) << "Going to run op " << op_name[run_op_idx];
+      run_ops_[run_op_idx]->Run(*thread_scope_, place_);
+      VLOG(3) << "Op " << op_name[run_op_idx] << " Finished";
+      timeline.Pause();
+      op_total_time[run_op_idx] += timeline.ElapsedSec();
+      total_time += timeline.ElapsedSec();
     }
 
     // check inf and nan
@@ -775,61 +755,50 @@ void DownpourWorker::TrainFiles() {
     VLOG(3) << "fill sparse value for all sparse table done.";
 
     // do computation here
-    for (auto& op : ops_) {
-      bool need_skip = false;
-      for (auto t = 0u; t < skip_ops_.size(); ++t) {
-        if (op->Type().find(skip_ops_[t]) != std::string::npos) {
-          need_skip = true;
-          break;
-        }
-      }
-      if (!need_skip) {
 #ifdef PADDLE_WITH_PSLIB
-        try {
-          op->Run(*thread_scope_, place_);
-        } catch (std::exception& e) {
-          fprintf(stderr, "error message: %s\n", e.what());
-          auto& ins_id_vec = device_reader_->GetInsIdVec();
-          size_t batch_size = device_reader_->GetCurBatchSize();
-          std::string s = "";
-          for (auto& ins_id : ins_id_vec) {
-            if (s != "") s += ",";
-            s += ins_id;
-          }
-          fprintf(stderr, "batch_size: %zu, ins_ids_vec: %s\n", batch_size,
-                  s.c_str());
-          s = "";
-          for (auto& param : all_param_) {
-            Variable* var = thread_scope_->FindVar(param);
-            if (var == nullptr) {
-              continue;
-            }
-            Tensor* tensor = nullptr;
-            int64_t len = 0;
-            if (var->IsType<framework::LoDTensor>()) {
-              tensor = var->GetMutable<LoDTensor>();
-              len = tensor->numel();
-            } else if (var->IsType<SelectedRows>()) {
-              auto selected_rows = var->GetMutable<SelectedRows>();
-              tensor = selected_rows->mutable_value();
-              len = tensor->numel();
-            }
-            if (!tensor->IsInitialized()) {
-              continue;
-            }
-            s += param + ":" + std::to_string(len) + ":";
-            s += PrintLodTensor(tensor, 0, len);
-            fprintf(stderr, "%s\n", s.c_str());
-            fflush(stderr);
-            s = "";
-          }
-          throw e;
+    try {
+      RunPlan();
+    } catch (std::exception& e) {
+      fprintf(stderr, "error message: %s\n", e.what());
+      auto& ins_id_vec = device_reader_->GetInsIdVec();
+      size_t batch_size = device_reader_->GetCurBatchSize();
+      std::string s = "";
+      for (auto& ins_id : ins_id_vec) {
+        if (s != "") s += ",";
+        s += ins_id;
+      }
+      fprintf(stderr, "batch_size: %zu, ins_ids_vec: %s\n", batch_size,
+              s.c_str());
+      s = "";
+      for (auto& param : all_param_) {
+        Variable* var = thread_scope_->FindVar(param);
+        if (var == nullptr) {
+          continue;
         }
-#else
-        op->Run(*thread_scope_, place_);
-#endif
+        Tensor* tensor = nullptr;
+        int64_t len = 0;
+        if (var->IsType<framework::LoDTensor>()) {
+          tensor = var->GetMutable<LoDTensor>();
+          len = tensor->numel();
+        } else if (var->IsType<SelectedRows>()) {
+          auto selected_rows = var->GetMutable<SelectedRows>();
+          tensor = selected_rows->mutable_value();
+          len = tensor->numel();
+        }
+        if (!tensor->IsInitialized()) {
+          continue;
+        }
+        s += param + ":" + std::to_string(len) + ":";
+        s += PrintLodTensor(tensor, 0, len);
+        fprintf(stderr, "%s\n", s.c_str());
+        fflush(stderr);
+        s = "";
       }
+      throw e;
     }
+#else
+    RunPlan();
+#endif
 
     // check inf and nan
     for (std::string& var_name : check_nan_var_names_) {
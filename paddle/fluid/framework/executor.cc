@@ -13,6 +13,7 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/executor.h"
+#include <algorithm>
 #include <memory>
 #include "paddle/fluid/framework/feed_fetch_method.h"
 #include "paddle/fluid/framework/trainer_desc.pb.h"
@@ -377,6 +378,26 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
   return ctx;
 }
 
+std::shared_ptr<ExecutorPrepareContext> PreparedBlockCache::Get(
+    const ProgramDesc& program, int block_id,
+    const std::vector<std::string>& skip_ref_cnt_vars) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto ops = program.Block(block_id).AllOps();
+  bool hit = ctx_ != nullptr && &ctx_->prog_ == &program &&
+             ctx_->block_id_ == static_cast<size_t>(block_id) &&
+             op_descs_.size() == ops.size() &&
+             std::equal(ops.begin(), ops.end(), op_descs_.begin()) &&
+             skip_ref_cnt_vars_ == skip_ref_cnt_vars;
+  if (!hit) {
+    VLOG(3) << "Prepare block " << block_id << " with " << ops.size()
+            << " ops";
+    ctx_ = Executor::Prepare(program, block_id, skip_ref_cnt_vars);
+    op_descs_.assign(ops.begin(), ops.end());
+    skip_ref_cnt_vars_ = skip_ref_cnt_vars;
+  }
+  return ctx_;
+}
+
 std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     const ProgramDesc& program, const std::vector<int>& block_ids,
     const std::vector<std::vector<std::string>>& skip_ref_cnt_vars,
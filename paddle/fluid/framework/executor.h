@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -146,5 +147,22 @@ class Executor {
   const platform::Place place_;
 };
 
+// Keeps the ExecutorPrepareContext of the sub-block run by a control flow op,
+// e.g. while and recurrent, so that the ops of the block are not created
+// again every time the control flow op runs. The context is prepared again
+// only when the ops of the block change.
+class PreparedBlockCache {
+ public:
+  std::shared_ptr<ExecutorPrepareContext> Get(
+      const ProgramDesc& program, int block_id,
+      const std::vector<std::string>& skip_ref_cnt_vars);
+
+ private:
+  std::mutex mutex_;
+  std::shared_ptr<ExecutorPrepareContext> ctx_;
+  std::vector<const OpDesc*> op_descs_;
+  std::vector<std::string> skip_ref_cnt_vars_;
+};
+
 }  // namespace framework
 }  // namespace paddle
@@ -29,6 +29,8 @@ limitations under the License. */
 #include "paddle/fluid/framework/fleet/fleet_wrapper.h"
 
 #include "glog/logging.h"
+#include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+#include "paddle/fluid/framework/fleet/metrics.h"
 #include "paddle/fluid/framework/op_registry.h"
 
 namespace paddle {
@@ -1521,6 +1523,33 @@ std::default_random_engine& FleetWrapper::LocalRandomEngine() {
   return r.engine;
 }
 
+double FleetWrapper::GetGlobalAuc(const Scope& scope,
+                                  const std::string& stat_pos,
+                                  const std::string& stat_neg) {
+  const Variable* pos_var = scope.FindVar(stat_pos);
+  const Variable* neg_var = scope.FindVar(stat_neg);
+  PADDLE_ENFORCE_NOT_NULL(
+      pos_var, platform::errors::NotFound("Variable %s is not found in scope.",
+                                          stat_pos));
+  PADDLE_ENFORCE_NOT_NULL(
+      neg_var, platform::errors::NotFound("Variable %s is not found in scope.",
+                                          stat_neg));
+  const auto& pos_tensor = pos_var->Get<LoDTensor>();
+  const auto& neg_tensor = neg_var->Get<LoDTensor>();
+  PADDLE_ENFORCE_EQ(
+      pos_tensor.numel(), neg_tensor.numel(),
+      platform::errors::InvalidArgument(
+          "The stat_pos and stat_neg of auc must be of the same size, but got "
+          "%d and %d.",
+          pos_tensor.numel(), neg_tensor.numel()));
+  AucAccumulator accumulator(static_cast<int>(pos_tensor.numel()) - 1);
+  accumulator.AddHistograms(pos_tensor.data<int64_t>(),
+                            neg_tensor.data<int64_t>());
+  accumulator.Merge();
+  accumulator.MergeRanks(GlooWrapper::GetInstance().get());
+  return accumulator.auc();
+}
+
 int32_t FleetWrapper::CopyTable(const uint64_t src_table_id,
                                 const uint64_t dest_table_id) {
 #ifdef PADDLE_WITH_PSLIB
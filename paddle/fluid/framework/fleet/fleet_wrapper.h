@@ -330,6 +330,10 @@ class FleetWrapper {
   }
   // this performs better than rand_r, especially large data
   std::default_random_engine& LocalRandomEngine();
+  // Sums the global histograms of the auc op, the tensors stat_pos and
+  // stat_neg in scope, of all the trainers through gloo and returns their auc.
+  double GetGlobalAuc(const Scope& scope, const std::string& stat_pos,
+                      const std::string& stat_neg);
 
 #ifdef PADDLE_WITH_PSLIB
   static std::shared_ptr<paddle::distributed::PSlib> pslib_ptr_;
@@ -312,6 +312,15 @@ void GlooWrapper::Init() {
       context_ = std::move(context);
       break;
     }
+    case GlooStoreType::FILE_STORE: {
+      auto context = std::make_shared<gloo::rendezvous::Context>(rank_, size_);
+      context->setTimeout(run_timeout_);
+      gloo::rendezvous::FileStore local_store(file_path_);
+      gloo::rendezvous::PrefixStore prefix_store(prefix_, local_store);
+      context->connectFullMesh(prefix_store, dev);
+      context_ = std::move(context);
+      break;
+    }
     default:
       LOG(ERROR) << "unknown store type " << store_type_;
       exit(-1);
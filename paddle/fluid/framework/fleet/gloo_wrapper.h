@@ -108,7 +108,7 @@ class ParallelConnectContext : public gloo::rendezvous::Context {
 namespace paddle {
 namespace framework {
 
-enum GlooStoreType { HDFS, HTTP };
+enum GlooStoreType { HDFS, HTTP, FILE_STORE };
 
 class GlooWrapper {
  public:
@@ -155,6 +155,13 @@ class GlooWrapper {
     http_scope_ = scope;
   }
 
+  // Rendezvous through a directory shared by all ranks, e.g. for the
+  // processes on one machine.
+  void SetFileStore(const std::string& path) {
+    store_type_ = GlooStoreType::FILE_STORE;
+    file_path_ = path;
+  }
+
   void Barrier() {
     CHECK_EQ(is_initialized_, true);
 #ifdef PADDLE_WITH_GLOO
@@ -218,6 +225,23 @@ class GlooWrapper {
     return std::move(ret);
   }
 
+  // Gathers input of every rank in the order of rank, all the inputs must be
+  // of the same size.
+  template <typename T>
+  std::vector<T> AllGatherVector(std::vector<T>& input) {  // NOLINT
+    CHECK_EQ(is_initialized_, true);
+    std::vector<T> ret(input.size() * size_, T());
+#ifdef PADDLE_WITH_GLOO
+    gloo::AllgatherOptions opts(context_);
+    opts.setInput(input.data(), input.size());
+    opts.setOutput(ret.data(), ret.size());
+    gloo::allgather(opts);
+#else
+    LOG(WARNING) << "AllGatherVector does nothing when WITH_GLOO=OFF";
+#endif
+    return ret;
+  }
+
  protected:
   bool is_initialized_ = false;
 #ifdef PADDLE_WITH_GLOO
@@ -238,6 +262,8 @@ class GlooWrapper {
   // configs for http store
   int http_port_;
   std::string http_scope_;
+  // configs for file store
+  std::string file_path_;
 };
 
 }  // namespace framework
@@ -0,0 +1,208 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/fleet/metrics.h"
+
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+
+namespace paddle {
+namespace framework {
+
+static uint64_t NextAccumulatorId() {
+  static std::atomic<uint64_t> next_id(0);
+  return next_id++;
+}
+
+AucAccumulator::AucAccumulator(int num_thresholds)
+    : num_thresholds_(num_thresholds),
+      num_buckets_(num_thresholds + 1),
+      id_(NextAccumulatorId()),
+      stat_pos_(num_buckets_, 0),
+      stat_neg_(num_buckets_, 0) {
+  PADDLE_ENFORCE_GE(num_thresholds, 1,
+                    platform::errors::InvalidArgument(
+                        "The num_thresholds of AucAccumulator must be at "
+                        "least 1, but got %d.",
+                        num_thresholds));
+}
+
+AucAccumulator::~AucAccumulator() {}
+
+AucAccumulator* AucAccumulator::ForOp(const std::string& name,
+                                      int num_thresholds) {
+  static std::mutex mutex;
+  static std::map<std::pair<std::string, int>,
+                  std::unique_ptr<AucAccumulator>>
+      accumulators;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& accumulator = accumulators[std::make_pair(name, num_thresholds)];
+  if (accumulator == nullptr) {
+    accumulator.reset(new AucAccumulator(num_thresholds));
+  }
+  return accumulator.get();
+}
+
+// The shards of a thread are found by the ids of their accumulators, which
+// are never reused, so the entries of the destroyed accumulators are never
+// looked up again.
+AucAccumulator::Shard* AucAccumulator::LocalShard() {
+  static thread_local std::unordered_map<uint64_t, Shard*> local_shards;
+  auto it = local_shards.find(id_);
+  if (it != local_shards.end()) {
+    return it->second;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  shards_.emplace_back(new Shard(num_buckets_));
+  Shard* shard = shards_.back().get();
+  local_shards[id_] = shard;
+  return shard;
+}
+
+void AucAccumulator::AddHistograms(const int64_t* stat_pos,
+                                   const int64_t* stat_neg) {
+  Shard* shard = LocalShard();
+  for (int i = 0; i < num_buckets_; ++i) {
+    Increase(&shard->pos[i], stat_pos[i]);
+    Increase(&shard->neg[i], stat_neg[i]);
+  }
+}
+
+void AucAccumulator::FlushLocal(int64_t* stat_pos, int64_t* stat_neg) {
+  Shard* shard = LocalShard();
+  std::lock_guard<std::mutex> lock(flush_mutex_);
+  for (int i = 0; i < num_buckets_; ++i) {
+    int64_t pos = shard->pos[i].load(std::memory_order_relaxed);
+    int64_t neg = shard->neg[i].load(std::memory_order_relaxed);
+    stat_pos[i] += pos - shard->flushed_pos[i];
+    stat_neg[i] += neg - shard->flushed_neg[i];
+    shard->flushed_pos[i] = pos;
+    shard->flushed_neg[i] = neg;
+  }
+}
+
+void AucAccumulator::Merge() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::fill(stat_pos_.begin(), stat_pos_.end(), 0);
+  std::fill(stat_neg_.begin(), stat_neg_.end(), 0);
+  abserr_ = sqrerr_ = pred_ = 0;
+  for (auto& shard : shards_) {
+    for (int i = 0; i < num_buckets_; ++i) {
+      stat_pos_[i] += shard->pos[i].load(std::memory_order_relaxed);
+      stat_neg_[i] += shard->neg[i].load(std::memory_order_relaxed);
+    }
+    abserr_ += shard->abserr.load(std::memory_order_relaxed);
+    sqrerr_ += shard->sqrerr.load(std::memory_order_relaxed);
+    pred_ += shard->pred.load(std::memory_order_relaxed);
+  }
+  Compute();
+}
+
+// The histograms of the ranks are summed by allreduce, or by gathering the
+// non-empty buckets of every rank as (bucket, pos, neg) when that moves less
+// data. All the ranks see the same numbers of non-empty buckets, so they
+// agree on the way.
+void AucAccumulator::MergeRanks(GlooWrapper* gloo) {
+  if (!gloo->IsInitialized() || gloo->Size() <= 1) {
+    return;
+  }
+  std::vector<double> sums = {abserr_, sqrerr_, pred_};
+  sums = gloo->AllReduce(sums);
+  abserr_ = sums[0];
+  sqrerr_ = sums[1];
+  pred_ = sums[2];
+
+  int64_t nonzero = 0;
+  for (int i = 0; i < num_buckets_; ++i) {
+    nonzero += stat_pos_[i] != 0 || stat_neg_[i] != 0;
+  }
+  std::vector<int64_t> nonzeros = gloo->AllGather(nonzero);
+  int64_t max_nonzero = *std::max_element(nonzeros.begin(), nonzeros.end());
+  // A ring allreduce sends and receives about twice the two histograms.
+  int64_t sparse_size = 3 * max_nonzero * gloo->Size();
+  int64_t dense_size = 4 * static_cast<int64_t>(num_buckets_);
+  if (sparse_size >= dense_size) {
+    stat_pos_ = gloo->AllReduce(stat_pos_);
+    stat_neg_ = gloo->AllReduce(stat_neg_);
+  } else if (max_nonzero > 0) {
+    std::vector<int64_t> send(3 * max_nonzero, -1);
+    int64_t k = 0;
+    for (int i = 0; i < num_buckets_; ++i) {
+      if (stat_pos_[i] != 0 || stat_neg_[i] != 0) {
+        send[k++] = i;
+        send[k++] = stat_pos_[i];
+        send[k++] = stat_neg_[i];
+      }
+    }
+    std::vector<int64_t> recv = gloo->AllGatherVector(send);
+    std::fill(stat_pos_.begin(), stat_pos_.end(), 0);
+    std::fill(stat_neg_.begin(), stat_neg_.end(), 0);
+    for (size_t j = 0; j < recv.size(); j += 3) {
+      // the paddings of the ranks of fewer buckets
+      if (recv[j] < 0) continue;
+      stat_pos_[recv[j]] += recv[j + 1];
+      stat_neg_[recv[j]] += recv[j + 2];
+    }
+  }
+  Compute();
+}
+
+void AucAccumulator::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& shard : shards_) {
+    for (int i = 0; i < num_buckets_; ++i) {
+      shard->pos[i].store(0, std::memory_order_relaxed);
+      shard->neg[i].store(0, std::memory_order_relaxed);
+    }
+    std::fill(shard->flushed_pos.begin(), shard->flushed_pos.end(), 0);
+    std::fill(shard->flushed_neg.begin(), shard->flushed_neg.end(), 0);
+    shard->abserr.store(0, std::memory_order_relaxed);
+    shard->sqrerr.store(0, std::memory_order_relaxed);
+    shard->pred.store(0, std::memory_order_relaxed);
+  }
+  std::fill(stat_pos_.begin(), stat_pos_.end(), 0);
+  std::fill(stat_neg_.begin(), stat_neg_.end(), 0);
+  abserr_ = sqrerr_ = pred_ = 0;
+  Compute();
+}
+
+void AucAccumulator::Compute() {
+  double area = 0;
+  double tot_pos = 0;
+  double tot_neg = 0;
+  for (int i = num_thresholds_; i >= 0; --i) {
+    double new_pos = tot_pos + stat_pos_[i];
+    double new_neg = tot_neg + stat_neg_[i];
+    area += (new_neg - tot_neg) * (tot_pos + new_pos) / 2;
+    tot_pos = new_pos;
+    tot_neg = new_neg;
+  }
+  auc_ = tot_pos > 0 && tot_neg > 0 ? area / tot_pos / tot_neg : 0.5;
+
+  size_ = tot_pos + tot_neg;
+  if (size_ > 0) {
+    mae_ = abserr_ / size_;
+    rmse_ = std::sqrt(sqrerr_ / size_);
+    actual_ctr_ = tot_pos / size_;
+    predicted_ctr_ = pred_ / size_;
+  } else {
+    mae_ = rmse_ = actual_ctr_ = predicted_ctr_ = 0;
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
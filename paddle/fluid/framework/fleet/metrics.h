@@ -0,0 +1,239 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+class GlooWrapper;
+
+namespace detail {
+
+constexpr size_t kAucBlockSize = 256;
+
+// Fills the buckets of the predictions predict[i * stride] of a block and
+// returns how many of them are out of [0, 1], whose buckets are 0. The loop
+// has no branch, so it vectorizes.
+template <typename T>
+inline int AucBuckets(const T* predict, int64_t stride, size_t size,
+                      int num_thresholds, uint32_t* buckets) {
+  int invalid = 0;
+  for (size_t i = 0; i < size; ++i) {
+    T x = predict[i * stride];
+    bool valid = x >= 0 && x <= 1;
+    invalid += !valid;
+    T bucket = (valid ? x : static_cast<T>(0)) * num_thresholds;
+    buckets[i] = static_cast<uint32_t>(bucket);
+  }
+  return invalid;
+}
+
+inline void EnforceValidPredict(int invalid) {
+  PADDLE_ENFORCE_EQ(invalid, 0,
+                    platform::errors::PreconditionNotMet(
+                        "The predict data must be in [0, 1], but %d of them "
+                        "are not.",
+                        invalid));
+}
+
+}  // namespace detail
+
+/*
+ * Adds the instances to the histograms of the auc op, of num_thresholds + 1
+ * buckets. The prediction of instance i is predict[i * stride], its label is
+ * positive when label[i] > 0, negative when label[i] == 0 and ignored
+ * otherwise.
+ */
+template <typename T>
+void AddAucInstances(const T* predict, int64_t stride, const int64_t* label,
+                     size_t size, int num_thresholds, int64_t* stat_pos,
+                     int64_t* stat_neg) {
+  uint32_t buckets[detail::kAucBlockSize];
+  for (size_t begin = 0; begin < size; begin += detail::kAucBlockSize) {
+    size_t n = std::min(detail::kAucBlockSize, size - begin);
+    detail::EnforceValidPredict(detail::AucBuckets(
+        predict + begin * stride, stride, n, num_thresholds, buckets));
+    // No branch on the labels, which mispredicts on every other instance.
+    const int64_t* block_label = label + begin;
+    for (size_t i = 0; i < n; ++i) {
+      stat_pos[buckets[i]] += block_label[i] > 0;
+      stat_neg[buckets[i]] += block_label[i] == 0;
+    }
+  }
+}
+
+/*
+ * \brief The AUC and the CTR metrics of the instances added by many threads.
+ *
+ * Every thread adds to histograms of its own without any lock. Merge sums
+ * those of all the threads into the statistics, and can run while the other
+ * threads keep adding, e.g. to report the AUC every batch. MergeRanks then
+ * sums the statistics of all the trainers, exchanging only the non-empty
+ * buckets when there are few of them.
+ */
+class AucAccumulator {
+ public:
+  explicit AucAccumulator(int num_thresholds);
+  ~AucAccumulator();
+
+  // The accumulator of the auc ops whose StatPosOut is name, shared by the
+  // threads running them.
+  static AucAccumulator* ForOp(const std::string& name, int num_thresholds);
+
+  // Adds the instances like AddAucInstances.
+  template <typename T>
+  void Add(const T* predict, int64_t stride, const int64_t* label,
+           size_t size);
+
+  // Adds histograms of num_buckets() buckets, e.g. those of the auc op. They
+  // only count in the auc, actual_ctr and size.
+  void AddHistograms(const int64_t* stat_pos, const int64_t* stat_neg);
+
+  // Adds what the calling thread has added since its last flush to the
+  // histograms stat_pos and stat_neg of num_buckets() buckets, e.g. the
+  // persistable stats of the auc op. The flushes of the threads are
+  // serialized, the adds are not.
+  void FlushLocal(int64_t* stat_pos, int64_t* stat_neg);
+
+  // Sums the histograms of all the threads into the statistics below. The
+  // statistics are read by the thread which merges.
+  void Merge();
+
+  // Sums the merged statistics of all the ranks of gloo. Every rank must
+  // call it.
+  void MergeRanks(GlooWrapper* gloo);
+
+  // Clears the histograms of all the threads and the statistics. No thread
+  // may add at the same time.
+  void Reset();
+
+  int num_buckets() const { return num_buckets_; }
+  const std::vector<int64_t>& stat_pos() const { return stat_pos_; }
+  const std::vector<int64_t>& stat_neg() const { return stat_neg_; }
+
+  // The metrics of the merged statistics. The auc is 0.5 when all the
+  // instances are of one class.
+  double auc() const { return auc_; }
+  double mae() const { return mae_; }
+  double rmse() const { return rmse_; }
+  double actual_ctr() const { return actual_ctr_; }
+  double predicted_ctr() const { return predicted_ctr_; }
+  double size() const { return size_; }
+
+ private:
+  // The histograms of a thread. Only the thread writes them, with relaxed
+  // atomic stores, which are plain stores, so Merge can read them anytime.
+  struct Shard {
+    explicit Shard(int num_buckets)
+        : pos(new std::atomic<int64_t>[num_buckets]),
+          neg(new std::atomic<int64_t>[num_buckets]),
+          flushed_pos(num_buckets, 0),
+          flushed_neg(num_buckets, 0) {
+      for (int i = 0; i < num_buckets; ++i) {
+        pos[i].store(0, std::memory_order_relaxed);
+        neg[i].store(0, std::memory_order_relaxed);
+      }
+    }
+
+    std::unique_ptr<std::atomic<int64_t>[]> pos;
+    std::unique_ptr<std::atomic<int64_t>[]> neg;
+    // the counts moved out by FlushLocal, only read by the thread
+    std::vector<int64_t> flushed_pos;
+    std::vector<int64_t> flushed_neg;
+    // the sums of |predict - label|, (predict - label)^2 and predict
+    std::atomic<double> abserr{0};
+    std::atomic<double> sqrerr{0};
+    std::atomic<double> pred{0};
+  };
+
+  static void Increase(std::atomic<int64_t>* counter, int64_t value) {
+    counter->store(counter->load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+  }
+  static void Increase(std::atomic<double>* sum, double value) {
+    sum->store(sum->load(std::memory_order_relaxed) + value,
+               std::memory_order_relaxed);
+  }
+
+  Shard* LocalShard();
+  void Compute();
+
+  const int num_thresholds_;
+  const int num_buckets_;
+  // tells the shards of the accumulators apart in the threads
+  const uint64_t id_;
+
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  // serializes the writes of FlushLocal to the histograms
+  std::mutex flush_mutex_;
+
+  std::vector<int64_t> stat_pos_;
+  std::vector<int64_t> stat_neg_;
+  double abserr_ = 0;
+  double sqrerr_ = 0;
+  double pred_ = 0;
+
+  double auc_ = 0.5;
+  double mae_ = 0;
+  double rmse_ = 0;
+  double actual_ctr_ = 0;
+  double predicted_ctr_ = 0;
+  double size_ = 0;
+};
+
+template <typename T>
+void AucAccumulator::Add(const T* predict, int64_t stride, const int64_t* label,
+                         size_t size) {
+  Shard* shard = LocalShard();
+  uint32_t buckets[detail::kAucBlockSize];
+  double abserr = 0, sqrerr = 0, pred = 0;
+  for (size_t begin = 0; begin < size; begin += detail::kAucBlockSize) {
+    size_t n = std::min(detail::kAucBlockSize, size - begin);
+    const T* block_predict = predict + begin * stride;
+    const int64_t* block_label = label + begin;
+    detail::EnforceValidPredict(detail::AucBuckets(
+        block_predict, stride, n, num_thresholds_, buckets));
+    for (size_t i = 0; i < n; ++i) {
+      double weight = block_label[i] >= 0;
+      double p = block_predict[i * stride];
+      double error = p - (block_label[i] > 0);
+      abserr += weight * std::fabs(error);
+      sqrerr += weight * error * error;
+      pred += weight * p;
+    }
+    for (size_t i = 0; i < n; ++i) {
+      Increase(&shard->pos[buckets[i]], block_label[i] > 0);
+      Increase(&shard->neg[buckets[i]], block_label[i] == 0);
+    }
+  }
+  Increase(&shard->abserr, abserr);
+  Increase(&shard->sqrerr, sqrerr);
+  Increase(&shard->pred, pred);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,378 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/fleet/metrics.h"
+
+#include <gtest/gtest.h>
+
+#if defined(PADDLE_WITH_GLOO) && !defined(_WIN32) && !defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+
+namespace paddle {
+namespace framework {
+
+// The labels are 0 and 1, with a few -1 to ignore.
+static void RandomInstances(size_t size, int width, std::vector<float>* predict,
+                            std::vector<int64_t>* label) {
+  std::mt19937 rng(size * 7 + width);
+  std::uniform_real_distribution<float> dist(0, 1);
+  predict->resize(size * width);
+  label->resize(size);
+  for (size_t i = 0; i < size; ++i) {
+    for (int j = 0; j < width; ++j) {
+      (*predict)[i * width + j] = dist(rng);
+    }
+    float p = (*predict)[i * width + width - 1];
+    (*label)[i] = i % 17 == 0 ? -1 : (dist(rng) < p ? 1 : 0);
+  }
+  // the bounds of the predictions
+  (*predict)[width - 1] = 0;
+  (*predict)[2 * width - 1] = 1;
+}
+
+static void ReferenceHistograms(const std::vector<float>& predict, int width,
+                                const std::vector<int64_t>& label,
+                                int num_thresholds, std::vector<int64_t>* pos,
+                                std::vector<int64_t>* neg) {
+  pos->assign(num_thresholds + 1, 0);
+  neg->assign(num_thresholds + 1, 0);
+  for (size_t i = 0; i < label.size(); ++i) {
+    float p = predict[i * width + width - 1];
+    uint32_t bin = static_cast<uint32_t>(p * num_thresholds);
+    if (label[i] > 0) {
+      (*pos)[bin] += 1;
+    } else if (label[i] == 0) {
+      (*neg)[bin] += 1;
+    }
+  }
+}
+
+TEST(AddAucInstances, Histograms) {
+  const int num_thresholds = 200;
+  for (int width : {1, 2}) {
+    for (size_t size : {1, 255, 256, 1000}) {
+      std::vector<float> predict;
+      std::vector<int64_t> label;
+      RandomInstances(size, width, &predict, &label);
+      std::vector<int64_t> expected_pos, expected_neg;
+      ReferenceHistograms(predict, width, label, num_thresholds,
+                          &expected_pos, &expected_neg);
+      std::vector<int64_t> pos(num_thresholds + 1, 0);
+      std::vector<int64_t> neg(num_thresholds + 1, 0);
+      AddAucInstances(predict.data() + width - 1, width, label.data(),
+                      label.size(), num_thresholds, pos.data(), neg.data());
+      EXPECT_EQ(pos, expected_pos);
+      EXPECT_EQ(neg, expected_neg);
+    }
+  }
+}
+
+TEST(AddAucInstances, InvalidPredict) {
+  std::vector<int64_t> pos(11, 0), neg(11, 0);
+  std::vector<int64_t> label = {1, 0, 1};
+  for (float invalid : {-0.1f, 1.1f, std::nanf("")}) {
+    std::vector<float> predict = {0.5f, invalid, 0.5f};
+    EXPECT_THROW(AddAucInstances(predict.data(), 1, label.data(), label.size(),
+                                 10, pos.data(), neg.data()),
+                 platform::EnforceNotMet);
+  }
+}
+
+TEST(AucAccumulator, Threads) {
+  const int num_thresholds = 1000;
+  const int num_threads = 4;
+  const size_t size = 10000;
+  std::vector<float> predict;
+  std::vector<int64_t> label;
+  RandomInstances(size, 1, &predict, &label);
+  std::vector<int64_t> expected_pos, expected_neg;
+  ReferenceHistograms(predict, 1, label, num_thresholds, &expected_pos,
+                      &expected_neg);
+
+  AucAccumulator accumulator(num_thresholds);
+  // Merge runs while the threads add, every batch of 100 instances.
+  std::vector<std::thread> threads;
+  const size_t per_thread = size / num_threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t begin = t * per_thread; begin < (t + 1) * per_thread;
+           begin += 100) {
+        accumulator.Add(predict.data() + begin, 1, label.data() + begin, 100);
+      }
+    });
+  }
+  double last_size = 0;
+  for (int i = 0; i < 20; ++i) {
+    accumulator.Merge();
+    EXPECT_GE(accumulator.size(), last_size);
+    EXPECT_LE(accumulator.size(), size);
+    last_size = accumulator.size();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  accumulator.Merge();
+  EXPECT_EQ(accumulator.stat_pos(), expected_pos);
+  EXPECT_EQ(accumulator.stat_neg(), expected_neg);
+
+  double area = 0, tot_pos = 0, tot_neg = 0;
+  double abserr = 0, sqrerr = 0, pred = 0;
+  for (int i = num_thresholds; i >= 0; --i) {
+    area += expected_neg[i] * (2 * tot_pos + expected_pos[i]) / 2;
+    tot_pos += expected_pos[i];
+    tot_neg += expected_neg[i];
+  }
+  for (size_t i = 0; i < size; ++i) {
+    if (label[i] < 0) continue;
+    abserr += std::fabs(predict[i] - label[i]);
+    sqrerr += (predict[i] - label[i]) * (predict[i] - label[i]);
+    pred += predict[i];
+  }
+  double total = tot_pos + tot_neg;
+  EXPECT_NEAR(accumulator.auc(), area / tot_pos / tot_neg, 1e-9);
+  EXPECT_EQ(accumulator.size(), total);
+  EXPECT_NEAR(accumulator.actual_ctr(), tot_pos / total, 1e-9);
+  EXPECT_NEAR(accumulator.mae(), abserr / total, 1e-6);
+  EXPECT_NEAR(accumulator.rmse(), std::sqrt(sqrerr / total), 1e-6);
+  EXPECT_NEAR(accumulator.predicted_ctr(), pred / total, 1e-6);
+
+  // One rank, nothing to exchange.
+  accumulator.MergeRanks(GlooWrapper::GetInstance().get());
+  EXPECT_EQ(accumulator.stat_pos(), expected_pos);
+
+  accumulator.Reset();
+  accumulator.Merge();
+  EXPECT_EQ(accumulator.size(), 0);
+  EXPECT_EQ(accumulator.auc(), 0.5);
+}
+
+TEST(AucAccumulator, AddHistograms) {
+  AucAccumulator accumulator(3);
+  std::vector<int64_t> pos = {0, 1, 2, 3};
+  std::vector<int64_t> neg = {3, 2, 1, 0};
+  accumulator.AddHistograms(pos.data(), neg.data());
+  accumulator.AddHistograms(pos.data(), neg.data());
+  accumulator.Merge();
+  EXPECT_EQ(accumulator.stat_pos(), std::vector<int64_t>({0, 2, 4, 6}));
+  EXPECT_EQ(accumulator.size(), 24);
+  // the trapezoids of the buckets 3 to 0
+  EXPECT_NEAR(accumulator.auc(), (0 + 16 + 44 + 72) / 144.0, 1e-9);
+}
+
+// The auc op run by many threads on the same stats, as the Hogwild threads
+// do.
+TEST(AucAccumulator, FlushLocal) {
+  const int num_thresholds = 1000;
+  const int num_threads = 4;
+  const size_t size = 10000;
+  std::vector<float> predict;
+  std::vector<int64_t> label;
+  RandomInstances(size, 1, &predict, &label);
+  std::vector<int64_t> expected_pos, expected_neg;
+  ReferenceHistograms(predict, 1, label, num_thresholds, &expected_pos,
+                      &expected_neg);
+
+  AucAccumulator* accumulator =
+      AucAccumulator::ForOp("flush_local_stat_pos", num_thresholds);
+  EXPECT_EQ(accumulator,
+            AucAccumulator::ForOp("flush_local_stat_pos", num_thresholds));
+  EXPECT_NE(accumulator, AucAccumulator::ForOp("flush_local_stat_pos", 10));
+  // the stats of the op, which start from a checkpoint
+  std::vector<int64_t> pos(num_thresholds + 1, 1);
+  std::vector<int64_t> neg(num_thresholds + 1, 2);
+  std::vector<std::thread> threads;
+  const size_t per_thread = size / num_threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t] {
+      for (size_t begin = t * per_thread; begin < (t + 1) * per_thread;
+           begin += 100) {
+        accumulator->Add(predict.data() + begin, 1, label.data() + begin, 100);
+        accumulator->FlushLocal(pos.data(), neg.data());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int i = 0; i <= num_thresholds; ++i) {
+    EXPECT_EQ(pos[i], expected_pos[i] + 1) << "at " << i;
+    EXPECT_EQ(neg[i], expected_neg[i] + 2) << "at " << i;
+  }
+  // a batch is flushed once
+  accumulator->Add(predict.data(), 1, label.data(), size);
+  accumulator->FlushLocal(pos.data(), neg.data());
+  accumulator->FlushLocal(pos.data(), neg.data());
+  for (int i = 0; i <= num_thresholds; ++i) {
+    EXPECT_EQ(pos[i], 2 * expected_pos[i] + 1) << "at " << i;
+    EXPECT_EQ(neg[i], 2 * expected_neg[i] + 2) << "at " << i;
+  }
+}
+
+#if defined(PADDLE_WITH_GLOO) && !defined(_WIN32) && !defined(__APPLE__)
+// Every rank runs in a process forked by the test, they meet through a file
+// store in a temporary directory.
+constexpr int kNRanks = 2;
+
+// The histograms of rank 0 and 1 are summed into expected_pos/neg.
+static bool CheckMergeRanks(GlooWrapper* gloo, int num_thresholds,
+                            const std::vector<std::vector<int64_t>>& pos,
+                            const std::vector<std::vector<int64_t>>& neg) {
+  int rank = gloo->Rank();
+  AucAccumulator accumulator(num_thresholds);
+  accumulator.AddHistograms(pos[rank].data(), neg[rank].data());
+  accumulator.Merge();
+  accumulator.MergeRanks(gloo);
+
+  AucAccumulator expected(num_thresholds);
+  for (int r = 0; r < kNRanks; ++r) {
+    expected.AddHistograms(pos[r].data(), neg[r].data());
+  }
+  expected.Merge();
+  return accumulator.stat_pos() == expected.stat_pos() &&
+         accumulator.stat_neg() == expected.stat_neg() &&
+         accumulator.auc() == expected.auc() &&
+         accumulator.size() == expected.size();
+}
+
+static int RunRank(int rank, const std::string& store_path) {
+  GlooWrapper gloo;
+  gloo.SetTimeoutSeconds(60, 60);
+  gloo.SetRank(rank);
+  gloo.SetSize(kNRanks);
+  gloo.SetPrefix("metrics_test");
+  gloo.SetIface("lo");
+  gloo.SetHdfsStore(store_path, "", "");
+  gloo.Init();
+
+  // A few non-empty buckets of 4096, exchanged as (bucket, pos, neg). The
+  // ranks have different numbers of them, and share bucket 7.
+  const int sparse_thresholds = 4095;
+  std::vector<std::vector<int64_t>> pos(
+      kNRanks, std::vector<int64_t>(sparse_thresholds + 1, 0));
+  std::vector<std::vector<int64_t>> neg = pos;
+  for (int r = 0; r < kNRanks; ++r) {
+    pos[r][7] = r + 1;
+    neg[r][7] = 1;
+    pos[r][100 * (r + 1)] = 2;
+  }
+  neg[1][sparse_thresholds] = 5;
+  if (!CheckMergeRanks(&gloo, sparse_thresholds, pos, neg)) return 1;
+
+  // Most buckets are non-empty, the histograms are allreduced.
+  pos = {{1, 0, 0, 2}, {1, 1, 0, 2}};
+  neg = {{0, 1, 1, 0}, {1, 1, 1, 0}};
+  if (!CheckMergeRanks(&gloo, 3, pos, neg)) return 2;
+
+  // No instance at all.
+  pos.assign(kNRanks, std::vector<int64_t>(11, 0));
+  neg = pos;
+  if (!CheckMergeRanks(&gloo, 10, pos, neg)) return 3;
+  return 0;
+}
+
+TEST(AucAccumulator, MergeRanks) {
+  char store_path[] = "/tmp/metrics_test_XXXXXX";
+  ASSERT_NE(mkdtemp(store_path), nullptr);
+
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < kNRanks; ++rank) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      int code = 4;
+      try {
+        code = RunRank(rank, store_path);
+      } catch (...) {
+      }
+      _exit(code);
+    }
+    pids.push_back(pid);
+  }
+
+  for (int rank = 0; rank < kNRanks; ++rank) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pids[rank], &status, 0), pids[rank]);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0) << "rank " << rank << " failed";
+  }
+  EXPECT_EQ(std::system((std::string("rm -rf ") + store_path).c_str()), 0);
+}
+#endif
+
+// The AUC of the batches of CTR training on many threads. The op adds them to
+// the stats shared by the threads, through the accumulator, against the
+// threads adding to histograms of their own with no sharing at all, which
+// bounds what the accumulator costs.
+TEST(AucAccumulator, Benchmark) {
+  const int num_thresholds = 4095;
+  const int num_threads = 8;
+  const size_t batch_size = 512;
+  const int num_batches = 200;
+  std::vector<float> predict;
+  std::vector<int64_t> label;
+  RandomInstances(batch_size, 1, &predict, &label);
+
+  auto run = [&](const std::function<void(int)>& add_batch) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < num_batches; ++i) {
+          add_batch(t);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  };
+
+  std::vector<std::vector<int64_t>> own_pos(
+      num_threads, std::vector<int64_t>(num_thresholds + 1, 0));
+  std::vector<std::vector<int64_t>> own_neg = own_pos;
+  double own_ms = run([&](int t) {
+    AddAucInstances(predict.data(), 1, label.data(), batch_size,
+                    num_thresholds, own_pos[t].data(), own_neg[t].data());
+  });
+  AucAccumulator* accumulator =
+      AucAccumulator::ForOp("benchmark_stat_pos", num_thresholds);
+  std::vector<int64_t> pos(num_thresholds + 1, 0), neg(num_thresholds + 1, 0);
+  double shared_ms = run([&](int) {
+    accumulator->Add(predict.data(), 1, label.data(), batch_size);
+    accumulator->FlushLocal(pos.data(), neg.data());
+  });
+  EXPECT_EQ(pos[0] + neg[0], num_threads * (own_pos[0][0] + own_neg[0][0]));
+  LOG(INFO) << num_threads << " threads add " << num_batches
+            << " batches of " << batch_size << " instances: own histograms "
+            << own_ms << " ms, shared stats through AucAccumulator "
+            << shared_ms << " ms";
+}
+
+}  // namespace framework
+}  // namespace paddle
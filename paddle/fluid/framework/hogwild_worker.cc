@@ -12,6 +12,11 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <exception>
+#include <future>  // NOLINT
+#include <unordered_map>
+
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/device_worker.h"
 #include "paddle/fluid/operators/controlflow/conditional_block_op_helper.h"
@@ -34,6 +39,9 @@ void HogwildWorker::Initialize(const TrainerDesc &desc) {
   }
   use_cvm_ = desc.use_cvm();
   thread_barrier_ = desc.thread_barrier();
+  numa_config_ = desc.numa_config();
+  binding_cpu_ = desc.binding_cpu();
+  run_plan_config_ = desc.run_plan_config();
 
   for (int i = 0; i < param_.stat_var_names_size(); ++i) {
     stat_var_name_map_[param_.stat_var_names(i)] = 1;
@@ -52,6 +60,119 @@ void HogwildWorker::CreateThreadOperators(const ProgramDesc &program) {
   }
   operators::PrepareSafeEagerDeletionOnConditionalOpAndConditionalGradOp(
       program, 0, ops_);
+  CreateRunPlan();
+}
+
+void HogwildWorker::CreateRunPlan() {
+  run_ops_.clear();
+  run_op_names_.clear();
+  for (auto *op : ops_) {
+    bool need_skip = false;
+    for (auto t = 0u; t < skip_ops_.size(); ++t) {
+      if (op->Type().find(skip_ops_[t]) != std::string::npos) {
+        need_skip = true;
+        break;
+      }
+    }
+    if (need_skip) continue;
+    if (run_plan_config_.cache_runtime_context()) {
+      // The variables of the thread scope live as long as the worker, so the
+      // RuntimeContext built by the first batch stays valid.
+      op->SetAttr(kEnableCacheRuntimeContext, true);
+    }
+    run_ops_.push_back(op);
+    run_op_names_.push_back(op->Type());
+  }
+
+  // Level scheduling: an op is placed one stage after the last stage that
+  // writes its inputs or outputs, or reads its outputs. The ops without a
+  // kernel (control flow ops running sub-blocks) and the ops without
+  // outputs (which only have side effects) are barriers.
+  op_stages_.clear();
+  std::unordered_map<std::string, int> write_level;
+  std::unordered_map<std::string, int> read_level;
+  int barrier_level = 0;
+  for (auto *op : run_ops_) {
+    bool is_barrier = dynamic_cast<OperatorWithKernel *>(op) == nullptr ||
+                      op->OutputVars(true).empty();
+    int level = barrier_level;
+    if (is_barrier) {
+      level = static_cast<int>(op_stages_.size());
+    } else {
+      for (auto &name : op->InputVars()) {
+        auto it = write_level.find(name);
+        if (it != write_level.end()) level = std::max(level, it->second + 1);
+      }
+      for (auto &name : op->OutputVars(true)) {
+        auto it = write_level.find(name);
+        if (it != write_level.end()) level = std::max(level, it->second + 1);
+        it = read_level.find(name);
+        if (it != read_level.end()) level = std::max(level, it->second + 1);
+      }
+    }
+    if (level >= static_cast<int>(op_stages_.size())) {
+      op_stages_.resize(level + 1);
+    }
+    op_stages_[level].push_back(op);
+    for (auto &name : op->InputVars()) {
+      auto it = read_level.find(name);
+      read_level[name] =
+          it == read_level.end() ? level : std::max(it->second, level);
+    }
+    for (auto &name : op->OutputVars(true)) {
+      write_level[name] = level;
+    }
+    if (is_barrier) barrier_level = level + 1;
+  }
+
+  int op_thread_num = run_plan_config_.op_thread_num();
+  if (op_thread_num > 1 && op_stages_.size() < run_ops_.size()) {
+    op_pool_.reset(new ThreadPool(op_thread_num - 1));
+  } else {
+    op_pool_.reset();
+  }
+  VLOG(3) << "Thread " << thread_id_ << " runs " << run_ops_.size() << " of "
+          << ops_.size() << " ops in " << op_stages_.size() << " stages";
+}
+
+void HogwildWorker::RunPlan() {
+  if (op_pool_ == nullptr) {
+    for (auto *op : run_ops_) {
+      op->Run(*thread_scope_, place_);
+    }
+    return;
+  }
+  for (auto &stage : op_stages_) {
+    if (stage.size() == 1) {
+      stage[0]->Run(*thread_scope_, place_);
+      continue;
+    }
+    std::vector<std::future<void>> futures;
+    futures.reserve(stage.size() - 1);
+    for (size_t i = 1; i < stage.size(); ++i) {
+      auto *op = stage[i];
+      futures.emplace_back(op_pool_->Run([this, op] {
+        platform::SetNumThreads(1);
+        op->Run(*thread_scope_, place_);
+      }));
+    }
+    // Wait for the whole stage before raising, the pooled ops still use
+    // thread_scope_.
+    std::exception_ptr eptr;
+    try {
+      stage[0]->Run(*thread_scope_, place_);
+    } catch (...) {
+      eptr = std::current_exception();
+    }
+    for (auto &f : futures) {
+      try {
+        f.get();
+      } catch (...) {
+        if (!eptr) eptr = std::current_exception();
+      }
+    }
+    if (eptr) std::rethrow_exception(eptr);
+  }
 }
 
 void HogwildWorker::CreateThreadScope(const ProgramDesc &program) {
@@ -62,7 +183,10 @@ void HogwildWorker::CreateThreadScope(const ProgramDesc &program) {
       platform::errors::NotFound(
           "Root scope should be set before creating thread scope."));
 
-  thread_scope_ = &root_scope_->NewScope();
+  // The params replicated to the NUMA node of this worker shadow those in the
+  // root scope.
+  thread_scope_ = node_scope_ ? &node_scope_->NewScope()
+                              : &root_scope_->NewScope();
 
   for (auto &var : block.AllVars()) {
     all_param_.push_back(var->Name());
@@ -109,19 +233,45 @@ void HogwildWorker::BindingDataFeedMemory() {
 }
 
 void HogwildWorker::CreateDeviceResource(const ProgramDesc &main_prog) {
-  CreateThreadScope(main_prog);
+  if (numa_config_.enable()) {
+    // The tensors of the thread scope are first touched on the NUMA node of
+    // this worker.
+    int node = thread_id_ % platform::NumaNodeCount();
+    platform::RunOnNumaNode(node, [&] { CreateThreadScope(main_prog); });
+  } else {
+    CreateThreadScope(main_prog);
+  }
   CreateThreadOperators(main_prog);
 }
 
+void HogwildWorker::BindThread() {
+  if (!numa_config_.enable() && !binding_cpu_) return;
+  int num_nodes = numa_config_.enable() ? platform::NumaNodeCount() : 1;
+  int node = thread_id_ % num_nodes;
+  std::vector<int> cpus;
+  if (numa_config_.enable()) {
+    cpus = platform::NumaNodeCpus(node);
+  } else {
+    for (int n = 0; n < platform::NumaNodeCount(); ++n) {
+      auto node_cpus = platform::NumaNodeCpus(n);
+      cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+    }
+  }
+  if (binding_cpu_) {
+    cpus = {cpus[(thread_id_ / num_nodes) % cpus.size()]};
+  }
+  if (!platform::BindCurrentThread(cpus, numa_config_.enable() ? node : -1)) {
+    LOG(WARNING) << "Failed to bind the thread of worker " << thread_id_;
+  }
+}
+
 void HogwildWorker::TrainFilesWithProfiler() {
   platform::SetNumThreads(1);
+  BindThread();
   device_reader_->Start();
   std::vector<double> op_total_time;
-  std::vector<std::string> op_name;
-  for (auto &op : ops_) {
-    op_name.push_back(op->Type());
-  }
-  op_total_time.resize(ops_.size());
+  std::vector<std::string> &op_name = run_op_names_;
+  op_total_time.resize(run_ops_.size());
   for (size_t i = 0; i < op_total_time.size(); ++i) {
     op_total_time[i] = 0.0;
   }
@@ -137,19 +287,11 @@ void HogwildWorker::TrainFilesWithProfiler() {
     timeline.Pause();
     read_time += timeline.ElapsedSec();
     total_time += timeline.ElapsedSec();
-    for (size_t i = 0; i < ops_.size(); ++i) {
-      bool need_skip = false;
-      for (auto t = 0u; t < skip_ops_.size(); ++t) {
-        if (ops_[i]->Type().find(skip_ops_[t]) != std::string::npos) {
-          need_skip = true;
-          break;
-        }
-      }
+    // The ops run one by one here to time each of them.
+    for (size_t i = 0; i < run_ops_.size(); ++i) {
       timeline.Start();
       VLOG(3) << "Going to run op " << op_name[i];
-      if (!need_skip) {
-        ops_[i]->Run(*thread_scope_, place_);
-      }
+      run_ops_[i]->Run(*thread_scope_, place_);
       VLOG(3) << "Op " << op_name[i] << " Finished";
       timeline.Pause();
       op_total_time[i] += timeline.ElapsedSec();
@@ -168,7 +310,7 @@ void HogwildWorker::TrainFilesWithProfiler() {
     PrintFetchVars();
     if (thread_id_ == 0) {
       if (batch_cnt > 0 && batch_cnt % 100 == 0) {
-        for (size_t i = 0; i < ops_.size(); ++i) {
+        for (size_t i = 0; i < run_ops_.size(); ++i) {
           fprintf(stderr, "op_name:[%zu][%s], op_mean_time:[%fs]\n", i,
                   op_name[i].c_str(), op_total_time[i] / batch_cnt);
         }
@@ -194,23 +336,13 @@ void HogwildWorker::TrainFilesWithProfiler() {
 
 void HogwildWorker::TrainFiles() {
   platform::SetNumThreads(1);
+  BindThread();
 
   // how to accumulate fetched values here
   device_reader_->Start();
   int cur_batch;
   while ((cur_batch = device_reader_->Next()) > 0) {
-    for (auto &op : ops_) {
-      bool need_skip = false;
-      for (auto t = 0u; t < skip_ops_.size(); ++t) {
-        if (op->Type().find(skip_ops_[t]) != std::string::npos) {
-          need_skip = true;
-          break;
-        }
-      }
-      if (!need_skip) {
-        op->Run(*thread_scope_, place_);
-      }
-    }
+    RunPlan();
 
     PrintFetchVars();
     thread_scope_->DropKids();
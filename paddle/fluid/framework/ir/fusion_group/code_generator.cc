@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/ir/fusion_group/code_generator.h"
 #include "paddle/fluid/framework/ir/fusion_group/code_generator_helper.h"
+#include "paddle/fluid/framework/ir/fusion_group/cpu_resources.h"
 #include "paddle/fluid/framework/ir/fusion_group/cuda_resources.h"
 
 namespace paddle {
@@ -42,11 +43,12 @@ std::string ExtractDataType(const std::vector<Node*>& nodes) {
   return dtype_str;
 }
 
-CodeGenerator::CodeGenerator() {
+CodeGenerator::CodeGenerator(bool use_cpu) : use_cpu_(use_cpu) {
   // Only support elementwise operations now.
   code_templates_.resize(1);
 
-  CodeTemplate elementwise_t(cuda_kernel_template_1d);
+  CodeTemplate elementwise_t(use_cpu ? cpu_kernel_template_1d
+                                     : cuda_kernel_template_1d);
   code_templates_[0] = elementwise_t;
 }
 
@@ -183,6 +185,23 @@ std::string CodeGenerator::Generate(
   for (const auto& type : dtypes) {
     all_dtype.insert(type.second);
   }
+  if (use_cpu_) {
+    PADDLE_ENFORCE_EQ(
+        all_dtype.find("__half"), all_dtype.end(),
+        platform::errors::Unimplemented(
+            "The float16 data type is not supported by fusion_group on CPU."));
+    template_var.Add("arguments",
+                     EmitArguments(input_ids, output_ids,
+                                   intermediate_output_ids, dtypes));
+    std::string predefined_cpu_functions = "";
+    if (all_dtype.find("float") != all_dtype.end()) {
+      predefined_cpu_functions += predefined_cpu_functions_fp32;
+    }
+    if (all_dtype.find("double") != all_dtype.end()) {
+      predefined_cpu_functions += predefined_cpu_functions_fp64;
+    }
+    return predefined_cpu_functions + code_templates_[0].Format(template_var);
+  }
   std::string predefined_cuda_functions = "";
   if (all_dtype.find("float") != all_dtype.end() &&
       all_dtype.find("__half") == all_dtype.end()) {
@@ -300,6 +319,35 @@ std::string CodeGenerator::EmitParameters(
   return ret.str();
 }
 
+std::string CodeGenerator::EmitArguments(
+    const std::set<int>& input_ids, const std::set<int>& output_ids,
+    const std::set<int>& intermediate_ids,
+    const std::unordered_map<int, std::string>& dtypes) const {
+  // The arguments are in the same order as the parameters.
+  std::vector<std::string> args;
+  for (auto id : input_ids) {
+    if (output_ids.find(id) == output_ids.end()) {
+      args.push_back("static_cast<const " + dtypes.at(id) + "*>(args[" +
+                     std::to_string(args.size()) + "])");
+    }
+  }
+  for (auto id : output_ids) {
+    if (intermediate_ids.find(id) == intermediate_ids.end()) {
+      args.push_back("static_cast<" + dtypes.at(id) + "*>(args[" +
+                     std::to_string(args.size()) + "])");
+    }
+  }
+
+  std::stringstream ret;
+  for (size_t i = 0; i < args.size(); ++i) {
+    ret << args[i];
+    if (i != args.size() - 1) {
+      ret << ", ";
+    }
+  }
+  return ret.str();
+}
+
 std::string CodeGenerator::EmitComputeBody(
     const std::vector<OperationExpression>& expressions,
     const std::set<int>& input_ids, const std::set<int>& output_ids,
@@ -317,9 +365,13 @@ std::string CodeGenerator::EmitComputeBody(
   for (auto id : input_ids) {
     if (output_ids.find(id) == output_ids.end() &&
         used.find(id) != used.end()) {
-      load << dtypes.at(id) << " " << TmpName(id) << " = "
-           << "__ldg(&" << VarName(id) << ")"
-           << ";";
+      load << dtypes.at(id) << " " << TmpName(id) << " = ";
+      if (use_cpu_) {
+        load << VarName(id) << ";";
+      } else {
+        load << "__ldg(&" << VarName(id) << ")"
+             << ";";
+      }
     }
   }
   // Store temporal variables to memory.
@@ -32,7 +32,9 @@ class SubGraph;
 
 class CodeGenerator {
  public:
-  CodeGenerator();
+  // Generate the CUDA kernels by default, or the C++ functions compiled by
+  // the host compiler if use_cpu is true.
+  explicit CodeGenerator(bool use_cpu = false);
 
   std::string Generate(std::string func_name,
                        const std::vector<OperationExpression>& expressions);
@@ -57,6 +59,12 @@ class CodeGenerator {
       const std::set<int>& intermediate_ids,
       const std::unordered_map<int, std::string>& dtypes) const;
 
+  // we get the code to unpack the arguments of the generated CPU function
+  std::string EmitArguments(
+      const std::set<int>& input_ids, const std::set<int>& output_ids,
+      const std::set<int>& intermediate_ids,
+      const std::unordered_map<int, std::string>& dtypes) const;
+
   std::string EmitComputeBody(
       const std::vector<OperationExpression>& expressions,
       const std::set<int>& input_ids, const std::set<int>& output_ids,
@@ -67,6 +75,7 @@ class CodeGenerator {
   std::unordered_map<Node*, int> EncodeVarNodes(SubGraph* subgraph);
 
  private:
+  bool use_cpu_{false};
   std::vector<CodeTemplate> code_templates_;
 };
 
@@ -41,18 +41,40 @@ void FusionGroupPass::ApplyImpl(ir::Graph* graph) const {
     //       avaiable.";
     //   return 0;
     // }
+  } else if (!platform::CPUDeviceCode::IsAvailable()) {
+    LOG(WARNING) << "Disable fusion_group on CPU because the host compiler is "
+                    "not available.";
+    return;
+  }
+
+  fusion_group::OperationMap::Init();
+  int num_elementwise_groups = DetectFusionGroup(graph, 0);
+  AddStatis(num_elementwise_groups);
+  LOG(INFO) << "Detect " << num_elementwise_groups
+            << " elementwise fusion groups.";
+}
 
-    fusion_group::OperationMap::Init();
-    int num_elementwise_groups = DetectFusionGroup(graph, 0);
-    AddStatis(num_elementwise_groups);
-    LOG(INFO) << "Detect " << num_elementwise_groups
-              << " elementwise fusion groups.";
+static platform::Place GetPlace(bool use_gpu) {
+  // TODO(liuyiqun): supported different places
+  if (use_gpu) {
+    return platform::CUDAPlace(0);
   }
+  return platform::CPUPlace();
+}
+
+static bool HasFP16(const std::vector<Node*>& nodes) {
+  for (auto* n : nodes) {
+    if (n && n->IsVar() && n->Var() &&
+        n->Var()->GetDataType() == proto::VarType::FP16) {
+      return true;
+    }
+  }
+  return false;
 }
 
 int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
+  bool use_gpu = Get<bool>("use_gpu");
+  platform::Place place = GetPlace(use_gpu);
   int index = platform::DeviceCodePool::Init({place}).size(place);
 
   std::vector<std::vector<Node*>> subgraphs =
@@ -62,6 +84,10 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
   size_t min_subgraph_size = 2;
   bool save_intermediate_out = false;
   for (auto& vec : subgraphs) {
+    // The generated CPU code does not support float16.
+    if (!use_gpu && HasFP16(vec)) {
+      continue;
+    }
     fusion_group::SubGraph subgraph(
         type, "", save_intermediate_out,
         std::unordered_set<Node*>(vec.begin(), vec.end()));
@@ -79,14 +105,24 @@ int FusionGroupPass::DetectFusionGroup(Graph* graph, int type) const {
 }
 
 bool FusionGroupPass::GenerateCode(fusion_group::SubGraph* subgraph) const {
-  fusion_group::CodeGenerator code_generator;
+  bool use_gpu = Get<bool>("use_gpu");
+  fusion_group::CodeGenerator code_generator(!use_gpu);
   std::string code_str = code_generator.Generate(subgraph);
   VLOG(4) << code_str;
 
-  // TODO(liuyiqun): supported different places
-  platform::CUDAPlace place = platform::CUDAPlace(0);
-  std::unique_ptr<platform::CUDADeviceCode> device_code(
-      new platform::CUDADeviceCode(place, subgraph->GetFuncName(), code_str));
+  platform::Place place = GetPlace(use_gpu);
+  std::unique_ptr<platform::DeviceCode> device_code;
+  if (use_gpu) {
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+    device_code.reset(new platform::CUDADeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+#else
+    return false;
+#endif
+  } else {
+    device_code.reset(new platform::CPUDeviceCode(
+        place, subgraph->GetFuncName(), code_str));
+  }
   bool is_compiled = device_code->Compile();
   if (is_compiled) {
     platform::DeviceCodePool& pool = platform::DeviceCodePool::Init({place});
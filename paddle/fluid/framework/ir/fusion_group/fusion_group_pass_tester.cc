@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <gtest/gtest.h>
 #include "paddle/fluid/framework/ir/pass_tester_helper.h"
+#include "paddle/fluid/platform/device_code.h"
 
 namespace paddle {
 namespace framework {
@@ -132,10 +133,11 @@ std::unique_ptr<Graph> BuildElementwiseTreeGraph(bool backward = false) {
 #endif
 }
 
-int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
+int TestMain(std::unique_ptr<Graph> graph, std::string prefix,
+             bool use_gpu = true) {
   // VisualizeGraph(&graph, prefix + ".dot");
   auto pass = PassRegistry::Instance().Get("fusion_group_pass");
-  pass->Set("use_gpu", new bool(true));
+  pass->Set("use_gpu", new bool(use_gpu));
   VLOG(3) << DebugString(graph);
 
   graph.reset(pass->Apply(graph.release()));
@@ -146,6 +148,7 @@ int TestMain(std::unique_ptr<Graph> graph, std::string prefix) {
   return num_fusion_group_ops;
 }
 
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 TEST(FusionGroupPass, elementwise_list) {
   std::unique_ptr<Graph> graph = BuildElementwiseListGraph(true);
   int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_list");
@@ -157,6 +160,17 @@ TEST(FusionGroupPass, elementwise_tree) {
   int num_fusion_group_ops = TestMain(std::move(graph), "elementwise_tree");
   EXPECT_EQ(num_fusion_group_ops, 4);
 }
+#endif
+
+TEST(FusionGroupPass, elementwise_list_cpu) {
+  ASSERT_TRUE(platform::CPUDeviceCode::IsAvailable())
+      << "The host compiler set by FLAGS_fusion_group_cpu_compiler is not "
+         "found.";
+  std::unique_ptr<Graph> graph = BuildElementwiseListGraph(false);
+  int num_fusion_group_ops =
+      TestMain(std::move(graph), "elementwise_list_cpu", false);
+  EXPECT_EQ(num_fusion_group_ops, 1);
+}
 
 }  // namespace ir
 }  // namespace framework
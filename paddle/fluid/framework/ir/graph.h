@@ -17,6 +17,7 @@ limitations under the License. */
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -204,6 +205,8 @@ class Graph {
     }
     nodes_.clear();
     node_set_.clear();
+    op_nodes_by_type_.clear();
+    indexed_op_types_.clear();
     return ret;
   }
 
@@ -215,9 +218,36 @@ class Graph {
     ret.reset(nodes_.at(node).release());
     nodes_.erase(node);
     node_set_.erase(node);
+    UnindexOpNode(node);
     return ret;
   }
 
+  // Returns the operator nodes whose OpDesc is of type `op_type`. The index is
+  // maintained incrementally by AddNode/RemoveNode, so it is shared by all the
+  // passes applied on this graph. Call RefreshOpNodeIndex() first if the type
+  // of some OpDesc may have been changed in place.
+  const std::unordered_set<ir::Node *> &OpNodesOfType(
+      const std::string &op_type) const {
+    static const std::unordered_set<ir::Node *> kEmpty;
+    auto it = op_nodes_by_type_.find(op_type);
+    return it == op_nodes_by_type_.end() ? kEmpty : it->second;
+  }
+
+  // Re-buckets the operator nodes whose OpDesc type was changed in place
+  // (e.g. by OpDesc::SetType) since they were indexed.
+  void RefreshOpNodeIndex() {
+    std::vector<ir::Node *> stale;
+    for (auto &it : indexed_op_types_) {
+      if (it.first->Op()->Type() != it.second) {
+        stale.push_back(it.first);
+      }
+    }
+    for (auto *node : stale) {
+      UnindexOpNode(node);
+      IndexOpNode(node);
+    }
+  }
+
   // NOTE low performance, but simple and secure.
   Node *RetrieveNode(int id) {
     for (auto &node : nodes_) {
@@ -241,6 +271,7 @@ class Graph {
                           "The node to be added already exists."));
     nodes_[node].reset(node);
     node_set_.insert(node);
+    IndexOpNode(node);
     return node;
   }
 
@@ -255,12 +286,35 @@ class Graph {
   std::map<std::string, std::vector<ir::Node *>> InitFromProgram(
       const ProgramDesc &program);
 
+  void IndexOpNode(ir::Node *node) {
+    if (node && node->IsOp() && node->Op()) {
+      const std::string &op_type = node->Op()->Type();
+      op_nodes_by_type_[op_type].insert(node);
+      indexed_op_types_[node] = op_type;
+    }
+  }
+
+  void UnindexOpNode(ir::Node *node) {
+    auto it = indexed_op_types_.find(node);
+    if (it == indexed_op_types_.end()) return;
+    auto bucket = op_nodes_by_type_.find(it->second);
+    if (bucket != op_nodes_by_type_.end()) {
+      bucket->second.erase(node);
+      if (bucket->second.empty()) op_nodes_by_type_.erase(bucket);
+    }
+    indexed_op_types_.erase(it);
+  }
+
   // NOTE: program_ shouldn't be exposed to user.
   const ProgramDesc program_;
   std::map<std::string, boost::any> attrs_;
   std::map<std::string, std::function<void(void)>> attr_dels_;
   std::map<ir::Node *, std::unique_ptr<ir::Node>> nodes_;
   std::unordered_set<ir::Node *> node_set_;
+  // Index of the operator nodes by the type they had when indexed.
+  std::unordered_map<std::string, std::unordered_set<ir::Node *>>
+      op_nodes_by_type_;
+  std::unordered_map<ir::Node *, std::string> indexed_op_types_;
   size_t num_node_created_{0};  // help to generate a unique node id.
 };
 
@@ -77,6 +77,7 @@ void PDPattern::AddEdge(PDNode *a, PDNode *b) {
 
 void GraphPatternDetector::operator()(Graph *graph,
                                       GraphPatternDetector::handle_t handler) {
+  graph->RefreshOpNodeIndex();
   if (!MarkPDNodesInGraph(*graph)) {
     return;
   }
@@ -100,11 +101,30 @@ bool GraphPatternDetector::MarkPDNodesInGraph(const ir::Graph &graph) {
   VLOG(3) << "mark pdnodes in graph";
   if (graph.Nodes().empty()) return false;
 
-  for (auto &node : GraphTraits::DFS(graph)) {
-    for (const auto &pdnode : pattern_.nodes()) {
-      if (pdnode->Tell(&node)) {
-        VLOG(4) << "Node " << node.Name() << " marked as " << pdnode->name();
-        pdnodes2nodes_[pdnode.get()].insert(&node);
+  // The PDNodes hinted with op types only check the candidates fetched from
+  // the op type index of the graph, the others have to check every node.
+  std::vector<PDNode *> unhinted_pdnodes;
+  for (const auto &pdnode : pattern_.nodes()) {
+    std::unordered_set<Node *> candidates;
+    if (!pdnode->CollectCandidates(graph, &candidates)) {
+      unhinted_pdnodes.push_back(pdnode.get());
+      continue;
+    }
+    for (auto *node : candidates) {
+      if (pdnode->Tell(node)) {
+        VLOG(4) << "Node " << node->Name() << " marked as " << pdnode->name();
+        pdnodes2nodes_[pdnode.get()].insert(node);
+      }
+    }
+  }
+
+  if (!unhinted_pdnodes.empty()) {
+    for (auto &node : GraphTraits::DFS(graph)) {
+      for (auto *pdnode : unhinted_pdnodes) {
+        if (pdnode->Tell(&node)) {
+          VLOG(4) << "Node " << node.Name() << " marked as " << pdnode->name();
+          pdnodes2nodes_[pdnode].insert(&node);
+        }
       }
     }
   }
@@ -402,6 +422,7 @@ PDNode *PDNode::assert_is_op() {
 }
 
 PDNode *PDNode::assert_is_op(const std::string &op_type) {
+  AddHint(HintKind::kOpType, {op_type});
   asserts_.emplace_back([op_type](Node *x) {
     return x && x->IsOp() && x->Op()->Type() == op_type;
   });
@@ -455,6 +476,7 @@ PDNode *PDNode::assert_is_op_nth_input(const std::string &op_type,
 PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
                                         const std::string &argument, int nth) {
   assert_is_var();
+  AddHint(HintKind::kOutputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op->IsOp() && op->Op()->Type() == op_type &&
@@ -468,6 +490,7 @@ PDNode *PDNode::assert_is_op_nth_output(const std::string &op_type,
 
 PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
   assert_is_var();
+  AddHint(HintKind::kInputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type &&
@@ -482,6 +505,7 @@ PDNode *PDNode::assert_is_only_input_of_op(const std::string &op_type) {
 
 PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
   assert_is_var();
+  AddHint(HintKind::kOutputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type &&
@@ -496,6 +520,7 @@ PDNode *PDNode::assert_is_only_output_of_op(const std::string &op_type) {
 
 PDNode *PDNode::assert_is_op_output(const std::string &op_type) {
   assert_is_var();
+  AddHint(HintKind::kOutputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type) {
@@ -516,6 +541,7 @@ PDNode *PDNode::assert_is_op_output(const std::string &op_type,
 
 PDNode *PDNode::assert_is_op_input(const std::string &op_type) {
   assert_is_var();
+  AddHint(HintKind::kInputOf, {op_type});
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op->Op()->Type() == op_type) {
@@ -572,6 +598,7 @@ PDNode *PDNode::assert_more(PDNode::teller_t &&teller) {
 }
 
 PDNode *PDNode::assert_is_ops(const std::unordered_set<std::string> &op_types) {
+  AddHint(HintKind::kOpType, op_types);
   asserts_.emplace_back([op_types](Node *x) {
     return x && x->IsOp() && op_types.count(x->Op()->Type());
   });
@@ -598,6 +625,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
     const std::unordered_set<std::string> &op_types,
     const std::string &argument, int nth) {
   assert_is_var();
+  AddHint(HintKind::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op->IsOp() && op_types.count(op->Op()->Type()) &&
@@ -611,6 +639,7 @@ PDNode *PDNode::assert_is_ops_nth_output(
 PDNode *PDNode::assert_is_ops_output(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  AddHint(HintKind::kOutputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->inputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type())) {
@@ -633,6 +662,7 @@ PDNode *PDNode::assert_is_ops_output(
 PDNode *PDNode::assert_is_ops_input(
     const std::unordered_set<std::string> &op_types) {
   assert_is_var();
+  AddHint(HintKind::kInputOf, op_types);
   asserts_.emplace_back([=](Node *x) {
     for (auto *op : x->outputs) {
       if (op && op->IsOp() && op->Op() && op_types.count(op->Op()->Type())) {
@@ -652,6 +682,43 @@ PDNode *PDNode::assert_is_ops_input(
   return this;
 }
 
+bool PDNode::CollectCandidates(const Graph &graph,
+                               std::unordered_set<Node *> *candidates) const {
+  if (teller_ || hints_.empty()) return false;
+
+  // All the assertions must hold, so any hint gives a superset of the told
+  // nodes. Use the one that touches the fewest operators.
+  const std::pair<HintKind, std::unordered_set<std::string>> *best = nullptr;
+  size_t best_num_ops = 0;
+  for (auto &hint : hints_) {
+    size_t num_ops = 0;
+    for (auto &op_type : hint.second) {
+      num_ops += graph.OpNodesOfType(op_type).size();
+    }
+    if (!best || num_ops < best_num_ops) {
+      best = &hint;
+      best_num_ops = num_ops;
+    }
+  }
+
+  for (auto &op_type : best->second) {
+    for (auto *op : graph.OpNodesOfType(op_type)) {
+      switch (best->first) {
+        case HintKind::kOpType:
+          candidates->insert(op);
+          break;
+        case HintKind::kInputOf:
+          candidates->insert(op->inputs.begin(), op->inputs.end());
+          break;
+        case HintKind::kOutputOf:
+          candidates->insert(op->outputs.begin(), op->outputs.end());
+          break;
+      }
+    }
+  }
+  return true;
+}
+
 bool VarLinksToOp(Node *node, const std::string &op_type) {
   for (auto *out : node->outputs) {
     if (out->IsOp() && out->Op()->Type() == op_type) {
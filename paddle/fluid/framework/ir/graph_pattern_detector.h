@@ -81,6 +81,12 @@ struct PDNode {
   bool IsOp() const { return type_ == Type::kOp; }
   bool IsVar() const { return type_ == Type::kVar; }
 
+  // Collect the nodes of `graph` that might be told as this PDNode, using the
+  // op types hinted by the assertions and the op type index of the graph.
+  // Returns false if there is no hint, then every node is a candidate.
+  bool CollectCandidates(const Graph& graph,
+                         std::unordered_set<Node*>* candidates) const;
+
   const std::string& name() const { return name_; }
 
   PDNode& operator=(const PDNode&) = delete;
@@ -177,9 +183,17 @@ struct PDNode {
 
   friend class PDPattern;
 
+  // The nodes told by this PDNode must be an operator of one of the hinted
+  // types, or an input/output var of such an operator.
+  enum class HintKind { kOpType, kInputOf, kOutputOf };
+  void AddHint(HintKind kind, const std::unordered_set<std::string>& op_types) {
+    hints_.emplace_back(kind, op_types);
+  }
+
   // Will removed latter.
   teller_t teller_;
   std::vector<teller_t> asserts_;
+  std::vector<std::pair<HintKind, std::unordered_set<std::string>>> hints_;
   PDPattern* pattern_;
   std::string name_;
   Type type_;
@@ -14,6 +14,8 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>  // NOLINT
+
 #include "paddle/fluid/framework/ir/graph_pattern_detector.h"
 
 namespace paddle {
@@ -203,6 +205,111 @@ TEST(GraphPatternDetector, IntermediateCheck) {
   ASSERT_EQ(count, 1);
 }
 
+// Build a program with `num_layers` of mul -> elementwise_add -> relu.
+void BuildLargeProgram(ProgramDesc* program, int num_layers) {
+  auto* block = program->MutableBlock(0);
+  std::string x = "x";
+  block->Var(x);
+  for (int i = 0; i < num_layers; ++i) {
+    std::string suffix = std::to_string(i);
+    for (auto name : {"w_", "b_"}) {
+      block->Var(name + suffix)->SetPersistable(true);
+    }
+    for (auto name : {"mul_out_", "add_out_", "relu_out_"}) {
+      block->Var(name + suffix);
+    }
+
+    auto* mul = block->AppendOp();
+    mul->SetType("mul");
+    mul->SetInput("X", {x});
+    mul->SetInput("Y", {"w_" + suffix});
+    mul->SetOutput("Out", {"mul_out_" + suffix});
+
+    auto* add = block->AppendOp();
+    add->SetType("elementwise_add");
+    add->SetInput("X", {"mul_out_" + suffix});
+    add->SetInput("Y", {"b_" + suffix});
+    add->SetOutput("Out", {"add_out_" + suffix});
+
+    auto* relu = block->AppendOp();
+    relu->SetType("relu");
+    relu->SetInput("X", {"add_out_" + suffix});
+    relu->SetOutput("Out", {"relu_out_" + suffix});
+    x = "relu_out_" + suffix;
+  }
+}
+
+// Detect op0 -> var -> op1 in the graph, and return the number of matches.
+// With use_hints = false, the same conditions are expressed by assert_more,
+// so every node of the graph has to be checked.
+int DetectOpPair(Graph* graph, const std::string& op0, const std::string& op1,
+                 bool use_hints) {
+  GraphPatternDetector detector;
+  auto* pattern = detector.mutable_pattern();
+  PDNode* x0 = pattern->NewNode("op0");
+  PDNode* v = pattern->NewNode("var");
+  PDNode* x1 = pattern->NewNode("op1");
+  if (use_hints) {
+    x0->assert_is_op(op0);
+    v->assert_is_op_output(op0)->assert_is_op_input(op1);
+    x1->assert_is_op(op1);
+  } else {
+    auto is_op = [](const std::string& type) {
+      return [type](Node* x) { return x->IsOp() && x->Op()->Type() == type; };
+    };
+    x0->assert_more(is_op(op0));
+    v->assert_is_var()->assert_more([op0, op1](Node* x) {
+      return !x->inputs.empty() && x->inputs[0]->IsOp() &&
+             x->inputs[0]->Op()->Type() == op0 && !x->outputs.empty() &&
+             x->outputs[0]->IsOp() && x->outputs[0]->Op()->Type() == op1;
+    });
+    x1->assert_more(is_op(op1));
+  }
+  v->AsInput();
+  v->LinksFrom({x0}).LinksTo({x1});
+
+  int count = 0;
+  detector(graph, [&](const GraphPatternDetector::subgraph_t& subgraph,
+                      Graph* g) { ++count; });
+  return count;
+}
+
+TEST(GraphPatternDetector, IndexedMatchingOnLargeGraph) {
+  const int num_layers = 20000;
+  ProgramDesc program;
+  BuildLargeProgram(&program, num_layers);
+  Graph graph(program);
+
+  // A pipeline of passes, most of which find nothing in this graph.
+  const std::vector<std::pair<std::string, std::string>> op_pairs = {
+      {"mul", "elementwise_add"},   {"elementwise_add", "relu"},
+      {"conv2d", "batch_norm"},     {"conv2d", "elementwise_add"},
+      {"matmul", "elementwise_add"}, {"transpose2", "reshape2"},
+      {"lookup_table", "sum"},      {"relu", "mul"}};
+
+  for (bool use_hints : {false, true}) {
+    std::vector<int> counts;
+    auto start = std::chrono::steady_clock::now();
+    for (auto& op_pair : op_pairs) {
+      counts.push_back(
+          DetectOpPair(&graph, op_pair.first, op_pair.second, use_hints));
+    }
+    auto elapsed = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    LOG(INFO) << (use_hints ? "indexed" : "full scan") << " matching of "
+              << op_pairs.size() << " patterns on " << graph.Nodes().size()
+              << " nodes costs " << elapsed << " ms";
+
+    EXPECT_EQ(counts[0], num_layers);
+    EXPECT_EQ(counts[1], num_layers);
+    EXPECT_EQ(counts[7], num_layers - 1);
+    for (size_t i = 2; i < 7; ++i) {
+      EXPECT_EQ(counts[i], 0);
+    }
+  }
+}
+
 }  // namespace ir
 }  // namespace framework
 }  // namespace paddle
@@ -248,6 +248,37 @@ TEST(GraphTest, TestException) {
   ASSERT_TRUE(not_met_exception);
 }
 
+TEST(GraphTest, OpNodesOfType) {
+  ProgramDesc prog;
+  for (auto type : {"mul", "elementwise_add", "mul"}) {
+    auto *op = prog.MutableBlock(0)->AppendOp();
+    op->SetType(type);
+  }
+
+  ir::Graph g(prog);
+  ASSERT_EQ(g.OpNodesOfType("mul").size(), 2UL);
+  ASSERT_EQ(g.OpNodesOfType("elementwise_add").size(), 1UL);
+  ASSERT_EQ(g.OpNodesOfType("relu").size(), 0UL);
+
+  // The index follows the nodes added and removed.
+  OpDesc relu_desc;
+  relu_desc.SetType("relu");
+  ir::Node *relu = g.CreateOpNode(&relu_desc);
+  ASSERT_EQ(g.OpNodesOfType("relu").size(), 1UL);
+  g.RemoveNode(relu);
+  ASSERT_EQ(g.OpNodesOfType("relu").size(), 0UL);
+
+  // The nodes whose type is changed in place are re-bucketed on refresh.
+  ir::Node *add = *g.OpNodesOfType("elementwise_add").begin();
+  add->Op()->SetType("relu");
+  g.RefreshOpNodeIndex();
+  ASSERT_EQ(g.OpNodesOfType("elementwise_add").size(), 0UL);
+  ASSERT_EQ(g.OpNodesOfType("relu").size(), 1UL);
+
+  auto nodes = g.ReleaseNodes();
+  ASSERT_EQ(g.OpNodesOfType("mul").size(), 0UL);
+}
+
 TEST(GraphTest, TestAttrCopy) {
   ProgramDesc prog;
   ir::Graph src_g(prog);
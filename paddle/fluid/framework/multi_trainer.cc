@@ -13,8 +13,11 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include <string>
+#include <unordered_set>
 #include "paddle/fluid/framework/device_worker_factory.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/trainer.h"
+#include "paddle/fluid/platform/cpu_helper.h"
 
 #if defined PADDLE_WITH_PSCORE
 #include "paddle/fluid/distributed/service/communicator.h"
@@ -32,6 +35,7 @@ void MultiTrainer::Initialize(const TrainerDesc& trainer_desc,
   mpi_rank_ = trainer_desc.mpi_rank();
   mpi_size_ = trainer_desc.mpi_size();
   dump_file_num_ = trainer_desc.dump_file_num();
+  numa_config_ = trainer_desc.numa_config();
 
   for (int i = 0; i < trainer_desc.downpour_param().stat_var_names_size();
        i++) {
@@ -98,13 +102,65 @@ void MultiTrainer::InitDumpEnv() {
   }
 }
 
+void MultiTrainer::ReplicateParamsToNumaNodes(
+    const ProgramDesc& main_program) {
+  node_scopes_.clear();
+  if (!numa_config_.enable() || numa_config_.replicated_params_size() == 0) {
+    return;
+  }
+  // Each node would train its own copy of a replicated param that is written.
+  std::unordered_set<std::string> replicated(
+      numa_config_.replicated_params().begin(),
+      numa_config_.replicated_params().end());
+  for (size_t i = 0; i < main_program.Size(); ++i) {
+    for (auto* op : main_program.Block(i).AllOps()) {
+      for (auto& name : op->OutputArgumentNames()) {
+        PADDLE_ENFORCE_EQ(
+            replicated.count(name), 0,
+            platform::errors::InvalidArgument(
+                "The param %s replicated to the NUMA nodes must be read-only, "
+                "but it is written by the %s op.",
+                name, op->Type()));
+      }
+    }
+  }
+  for (int node = 0; node < platform::NumaNodeCount(); ++node) {
+    Scope* node_scope = &root_scope_->NewScope();
+    // The replicas are first touched on the node by the copy.
+    platform::RunOnNumaNode(node, [&] {
+      for (auto& name : numa_config_.replicated_params()) {
+        auto* root_var = root_scope_->FindVar(name);
+        PADDLE_ENFORCE_EQ(
+            root_var && root_var->IsType<LoDTensor>() &&
+                root_var->Get<LoDTensor>().IsInitialized(),
+            true, platform::errors::NotFound(
+                      "The param %s to replicate to the NUMA nodes is not an "
+                      "initialized LoDTensor in the root scope.",
+                      name));
+        auto& root_tensor = root_var->Get<LoDTensor>();
+        auto* replica = node_scope->Var(name)->GetMutable<LoDTensor>();
+        TensorCopySync(root_tensor, platform::CPUPlace(), replica);
+        replica->set_lod(root_tensor.lod());
+      }
+    });
+    node_scopes_.push_back(node_scope);
+  }
+  VLOG(3) << "replicate " << numa_config_.replicated_params_size()
+          << " params to " << node_scopes_.size() << " NUMA nodes";
+}
+
 // call only after all resources are set in current trainer
 void MultiTrainer::InitTrainerEnv(const ProgramDesc& main_program,
                                   const platform::Place& place) {
+  ReplicateParamsToNumaNodes(main_program);
   for (int i = 0; i < thread_num_; ++i) {
     workers_[i]->SetPlace(place);
     workers_[i]->SetReaderPlace(place);
     workers_[i]->SetRootScope(root_scope_);
+    if (!node_scopes_.empty()) {
+      // The same as the node the worker thread is bound to.
+      workers_[i]->SetNumaNodeScope(node_scopes_[i % node_scopes_.size()]);
+    }
     workers_[i]->CreateDeviceResource(main_program);  // Program
     workers_[i]->BindingDataFeedMemory();
     workers_[i]->CacheProgram(main_program);
@@ -142,6 +198,7 @@ void MultiTrainer::Finalize() {
   if (need_dump_field_ || need_dump_param_) {
     FinalizeDumpEnv();
   }
+  node_scopes_.clear();
   root_scope_->DropKids();
 }
 
@@ -14,8 +14,19 @@
 
 #include "paddle/fluid/framework/save_load_util.h"
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <fstream>
+#include <mutex>  // NOLINT
+#include <unordered_map>
 
+#include "paddle/fluid/framework/threadpool.h"
 #include "paddle/fluid/imperative/layer.h"
 
 namespace paddle {
@@ -110,8 +121,7 @@ void ReadReserveBuffer(std::istream& istre) {
   delete[] reserve_buffer;
 }
 
-bool SaveStaticNameListToDisk(
-    const std::string& file_name,
+static std::map<std::string, Tensor*> GetStaticNameListTensors(
     const std::vector<std::string>& vec_tensor_name_list, const Scope& scope) {
   std::map<std::string, Tensor*> map_tensor;
 
@@ -133,7 +143,21 @@ bool SaveStaticNameListToDisk(
     map_tensor[vec_tensor_name_list[i]] = tensor;
   }
 
-  return SaveTensorToDisk(file_name, map_tensor);
+  return map_tensor;
+}
+
+bool SaveStaticNameListToDisk(
+    const std::string& file_name,
+    const std::vector<std::string>& vec_tensor_name_list, const Scope& scope) {
+  return SaveTensorToDisk(
+      file_name, GetStaticNameListTensors(vec_tensor_name_list, scope));
+}
+
+std::future<void> SaveStaticNameListToDiskAsync(
+    const std::string& file_name,
+    const std::vector<std::string>& vec_tensor_name_list, const Scope& scope) {
+  return SaveTensorToDiskAsync(
+      file_name, GetStaticNameListTensors(vec_tensor_name_list, scope));
 }
 
 bool SaveDygraphVarBaseListToDisk(
@@ -244,15 +268,8 @@ bool LoadStaticNameListFromDisk(
   return true;
 }
 
-bool SaveTensorToDisk(const std::string& file_name,
-                      const std::map<std::string, Tensor*>& map_tensor) {
-  MkDirRecursively(DirName(file_name).c_str());
-
-  std::ofstream fout(file_name, std::ios::binary);
-  PADDLE_ENFORCE_EQ(
-      fout.is_open(), true,
-      platform::errors::Unavailable("File (%s) open failed.", file_name));
-
+static void WriteTensorsToStream(
+    std::ostream& fout, const std::map<std::string, Tensor*>& map_tensor) {
   // first 256 byte for reserve for fulture upgrade
   char* kReserveBuffer = new char[model_file_reserve_size];
   fout.write(kReserveBuffer, sizeof(char) * model_file_reserve_size);
@@ -309,6 +326,18 @@ bool SaveTensorToDisk(const std::string& file_name,
     fout.write(static_cast<const char*>(data_ptr),
                static_cast<std::streamsize>(data_size));
   }
+}
+
+bool SaveTensorToDisk(const std::string& file_name,
+                      const std::map<std::string, Tensor*>& map_tensor) {
+  MkDirRecursively(DirName(file_name).c_str());
+
+  std::ofstream fout(file_name, std::ios::binary);
+  PADDLE_ENFORCE_EQ(
+      fout.is_open(), true,
+      platform::errors::Unavailable("File (%s) open failed.", file_name));
+
+  WriteTensorsToStream(fout, map_tensor);
 
   if (!fout) {
     PADDLE_THROW(platform::errors::Unavailable(
@@ -321,6 +350,109 @@ bool SaveTensorToDisk(const std::string& file_name,
   return true;
 }
 
+// Write to a temporary file which is synced and then renamed, so that
+// `file_name` is either the old or the complete new checkpoint.
+static void WriteTensorsToFileSynced(
+    const std::string& file_name,
+    const std::map<std::string, Tensor*>& map_tensor) {
+  static std::atomic<uint64_t> tmp_file_id{0};
+  MkDirRecursively(DirName(file_name).c_str());
+  std::string tmp_file_name =
+      file_name + ".tmp" + std::to_string(tmp_file_id++);
+
+  std::ofstream fout(tmp_file_name, std::ios::binary);
+  PADDLE_ENFORCE_EQ(
+      fout.is_open(), true,
+      platform::errors::Unavailable("File (%s) open failed.", tmp_file_name));
+  // The temporary file is removed on any error, `file_name` is untouched.
+  try {
+    WriteTensorsToStream(fout, map_tensor);
+    fout.close();
+    if (!fout) {
+      PADDLE_THROW(platform::errors::Unavailable(
+          "Model save failed, error when writing data into model file [%s].",
+          tmp_file_name));
+    }
+
+#ifndef _WIN32
+    int fd = open(tmp_file_name.c_str(), O_RDONLY);
+    PADDLE_ENFORCE_NE(fd, -1, platform::errors::Unavailable(
+                                  "File (%s) open failed.", tmp_file_name));
+    int ret = fsync(fd);
+    close(fd);
+    PADDLE_ENFORCE_EQ(ret, 0, platform::errors::Unavailable(
+                                  "File (%s) sync failed.", tmp_file_name));
+#else
+    // rename does not replace the existing file on Windows.
+    std::remove(file_name.c_str());
+#endif
+    PADDLE_ENFORCE_EQ(std::rename(tmp_file_name.c_str(), file_name.c_str()),
+                      0, platform::errors::Unavailable(
+                             "Rename file (%s) to (%s) failed.",
+                             tmp_file_name, file_name));
+  } catch (...) {
+    if (fout.is_open()) {
+      fout.close();
+    }
+    std::remove(tmp_file_name.c_str());
+    throw;
+  }
+}
+
+std::future<void> SaveTensorToDiskAsync(
+    const std::string& file_name,
+    const std::map<std::string, Tensor*>& map_tensor) {
+  // The snapshot is a plain copy, taken before the training thread updates
+  // the tensors in place again.
+  auto snapshot = std::make_shared<std::map<std::string, Tensor>>();
+  for (auto& item : map_tensor) {
+    TensorCopySync(*item.second, platform::CPUPlace(),
+                   &(*snapshot)[item.first]);
+  }
+
+  // The writes to the same file are chained, each waits for the previous
+  // one, so that an older snapshot never replaces a newer one.
+  static std::mutex pending_writes_mutex;
+  static std::unordered_map<std::string, std::shared_future<void>>
+      pending_writes;
+  auto done = std::make_shared<std::promise<void>>();
+  std::shared_future<void> previous;
+  {
+    std::lock_guard<std::mutex> guard(pending_writes_mutex);
+    for (auto it = pending_writes.begin(); it != pending_writes.end();) {
+      if (it->second.wait_for(std::chrono::seconds(0)) ==
+          std::future_status::ready) {
+        it = pending_writes.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    auto& last = pending_writes[file_name];
+    previous = last;
+    last = done->get_future().share();
+  }
+
+  return ThreadPoolIO::GetInstanceIO()->Run(
+      [file_name, snapshot, previous, done] {
+        if (previous.valid()) {
+          previous.wait();
+        }
+        std::map<std::string, Tensor*> map_snapshot;
+        for (auto& item : *snapshot) {
+          map_snapshot[item.first] = &item.second;
+        }
+        try {
+          WriteTensorsToFileSynced(file_name, map_snapshot);
+        } catch (...) {
+          done->set_value();
+          throw;
+        }
+        done->set_value();
+        VLOG(3) << "Saved " << map_snapshot.size() << " tensors to "
+                << file_name;
+      });
+}
+
 bool LoadTensorFromDisk(
     const std::string& file_name,
     std::map<std::string, std::shared_ptr<Tensor>>* map_tensor) {
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <fstream>
+#include <future>  // NOLINT
 #include <iostream>
 #include <map>
 #include <memory>
@@ -48,6 +49,19 @@ LoadDygraphVarBaseListFromDisk(const std::string& file_name);
 bool SaveTensorToDisk(const std::string& file_name,
                       const std::map<std::string, Tensor*>& map_tensor);
 
+// Snapshot the tensors on the calling thread, then write, fsync and rename
+// them to `file_name` on the IO thread pool. The tensors can be updated as
+// soon as this returns. The returned future waits for the file to be
+// written and rethrows the error if any. The saves to the same file are
+// written in the order of the calls.
+std::future<void> SaveTensorToDiskAsync(
+    const std::string& file_name,
+    const std::map<std::string, Tensor*>& map_tensor);
+
+std::future<void> SaveStaticNameListToDiskAsync(
+    const std::string& file_name,
+    const std::vector<std::string>& vec_tensor_name_list, const Scope& scope);
+
 bool LoadTensorFromDisk(
     const std::string& file_name,
     std::map<std::string, std::shared_ptr<Tensor>>* map_tensor);
@@ -14,6 +14,12 @@
 #include <stdlib.h>
 #include <time.h>
 
+#ifndef _WIN32
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/save_load_util.h"
 
@@ -71,5 +77,96 @@ TEST(test_save_load_util, test_save_load) {
     ASSERT_EQ(ptr_2[i], ptr_2_new[i]);
   }
 }
+
+TEST(test_save_load_util, test_save_async) {
+  auto cpu_place = platform::CPUPlace();
+  Tensor tensor;
+  tensor.Resize({1000, 1000});
+  auto src_data = tensor.mutable_data<float>(cpu_place);
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    src_data[i] = static_cast<float>(i % 1000);
+  }
+
+  std::map<std::string, Tensor*> map_tensor;
+  map_tensor["t"] = &tensor;
+  auto future = SaveTensorToDiskAsync("test_async_1", map_tensor);
+
+  // The snapshot is taken before returning, so the update is not saved.
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    src_data[i] = -1.0f;
+  }
+  future.get();
+
+  std::map<std::string, std::shared_ptr<Tensor>> load_map_tensor;
+  LoadTensorFromDisk("test_async_1", &load_map_tensor);
+  ASSERT_TRUE(load_map_tensor.find("t") != load_map_tensor.end());
+  auto new_tensor = load_map_tensor["t"];
+  ASSERT_EQ(new_tensor->dims(), tensor.dims());
+  float* ptr_new = new_tensor->data<float>();
+  for (int64_t i = 0; i < new_tensor->numel(); ++i) {
+    ASSERT_EQ(ptr_new[i], static_cast<float>(i % 1000));
+  }
+}
+
+TEST(test_save_load_util, test_save_async_order) {
+  Tensor tensor;
+  tensor.Resize({1000, 100});
+  auto src_data = tensor.mutable_data<float>(platform::CPUPlace());
+  std::map<std::string, Tensor*> map_tensor;
+  map_tensor["t"] = &tensor;
+
+  // The last save to the same file wins, however the writes are scheduled.
+  const int num_saves = 8;
+  std::vector<std::future<void>> futures;
+  for (int k = 0; k < num_saves; ++k) {
+    for (int64_t i = 0; i < tensor.numel(); ++i) {
+      src_data[i] = static_cast<float>(k);
+    }
+    futures.push_back(SaveTensorToDiskAsync("test_async_order", map_tensor));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+
+  std::map<std::string, std::shared_ptr<Tensor>> load_map_tensor;
+  LoadTensorFromDisk("test_async_order", &load_map_tensor);
+  auto new_tensor = load_map_tensor["t"];
+  ASSERT_EQ(new_tensor->dims(), tensor.dims());
+  float* ptr_new = new_tensor->data<float>();
+  for (int64_t i = 0; i < new_tensor->numel(); ++i) {
+    ASSERT_EQ(ptr_new[i], static_cast<float>(num_saves - 1));
+  }
+}
+
+#ifndef _WIN32
+TEST(test_save_load_util, test_save_async_error) {
+  Tensor tensor;
+  tensor.Resize({10, 10});
+  auto src_data = tensor.mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    src_data[i] = static_cast<float>(i);
+  }
+  std::map<std::string, Tensor*> map_tensor;
+  map_tensor["t"] = &tensor;
+
+  // The temporary file can not be renamed to a directory, and is removed.
+  const std::string dir_name = "test_async_error_dir";
+  ASSERT_EQ(mkdir(dir_name.c_str(), 0755), 0);
+  auto future = SaveTensorToDiskAsync(dir_name, map_tensor);
+  EXPECT_THROW(future.get(), platform::EnforceNotMet);
+
+  DIR* dir = opendir(".");
+  ASSERT_NE(dir, nullptr);
+  const std::string tmp_prefix = dir_name + ".tmp";
+  while (struct dirent* entry = readdir(dir)) {
+    EXPECT_NE(std::string(entry->d_name).compare(0, tmp_prefix.size(),
+                                                 tmp_prefix),
+              0)
+        << entry->d_name << " is left";
+  }
+  closedir(dir);
+  rmdir(dir_name.c_str());
+}
+#endif
 }  // namespace framework
 }  // namespace paddle
@@ -110,11 +110,16 @@ class MultiTrainer : public TrainerBase {
   virtual std::string GetDumpPath(int tid);
 
  protected:
+  void ReplicateParamsToNumaNodes(const ProgramDesc& main_program);
+
   int thread_num_;
   std::vector<std::thread> threads_;
   std::vector<DataFeed*> readers_;
   std::vector<std::shared_ptr<DeviceWorker>> workers_;
   std::vector<std::string> need_merge_var_names_;
+  NumaConfig numa_config_;
+  // the scopes holding the params replicated to each NUMA node
+  std::vector<Scope*> node_scopes_;
 
   int mpi_rank_;
   int mpi_size_;
@@ -15,13 +15,140 @@
 #include "paddle/fluid/framework/trainer.h"
 #include <gtest/gtest.h>
 
+#if defined _WIN32 || defined __APPLE__
+#else
+#define _LINUX
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "paddle/fluid/platform/cpu_helper.h"
+
 namespace paddle {
 namespace framework {
-TEST() {
-  // create multi trainer
-  // create hogwild device worker
-  // create dataset
-  // train for a while
+
+#ifdef _LINUX
+// The NUMA node of the page at addr, -1 if it is unknown.
+static int NumaNodeOfAddress(const void* addr) {
+#ifdef SYS_get_mempolicy
+  // MPOL_F_NODE | MPOL_F_ADDR in <numaif.h>
+  const unsigned long kFlags = 3;  // NOLINT
+  int node = -1;
+  if (syscall(SYS_get_mempolicy, &node, nullptr, 0, addr, kFlags) == 0) {
+    return node;
+  }
+#endif
+  return -1;
+}
+
+static TrainerDesc NumaTrainerDesc(int thread_num) {
+  TrainerDesc desc;
+  desc.set_class_name("MultiTrainer");
+  desc.set_device_worker_name("HogwildWorker");
+  desc.set_thread_num(thread_num);
+  desc.mutable_numa_config()->set_enable(true);
+  desc.mutable_numa_config()->add_replicated_params("w");
+  return desc;
 }
+
+static std::shared_ptr<MultiSlotDataset> CreateDataset(int thread_num) {
+  std::string str;
+  str += "name: \"MultiSlotDataFeed\"\nbatch_size: 2\nmulti_slot_desc {\n";
+  str += "slots {\nname: \"words\"\ntype: \"uint64\"\nis_dense: false\n";
+  str += "is_used: true\n}\nslots {\nname: \"label\"\ntype: \"uint64\"\n";
+  str += "is_dense: false\nis_used: true\n}\n}\n";
+  std::shared_ptr<MultiSlotDataset> dataset =
+      std::make_shared<MultiSlotDataset>();
+  dataset->SetFileList(std::vector<std::string>());
+  dataset->SetThreadNum(thread_num);
+  dataset->SetTrainerNum(1);
+  dataset->SetDataFeedDesc(str);
+  dataset->CreateReaders();
+  return dataset;
+}
+
+TEST(MultiTrainer, NumaReplicatedParams) {
+  const int thread_num = 4;
+  TrainerDesc desc = NumaTrainerDesc(thread_num);
+  auto dataset = CreateDataset(thread_num);
+
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("w")->SetPersistable(true);
+  block->Var("words");
+  block->Var("label");
+
+  Scope root_scope;
+  auto* w = root_scope.Var("w")->GetMutable<LoDTensor>();
+  w->Resize({64, 16});
+  float* w_data = w->mutable_data<float>(platform::CPUPlace());
+  for (int64_t i = 0; i < w->numel(); ++i) w_data[i] = i * 0.5f;
+
+  auto trainer = std::make_shared<MultiTrainer>();
+  trainer->SetScope(&root_scope);
+  trainer->Initialize(desc, dataset.get());
+  trainer->InitTrainerEnv(program, platform::CPUPlace());
+
+  const int num_nodes = platform::NumaNodeCount();
+  for (int i = 0; i < thread_num; ++i) {
+    // The worker threads are spread over the nodes round-robin, and the
+    // thread scope of a worker is a child of the scope of its node.
+    Scope* thread_scope = trainer->GetWorkerScope(i);
+    const Scope* node_scope = thread_scope->parent();
+    ASSERT_NE(node_scope, &root_scope);
+    ASSERT_EQ(node_scope->parent(), &root_scope);
+    if (i >= num_nodes) {
+      EXPECT_EQ(node_scope, trainer->GetWorkerScope(i - num_nodes)->parent());
+    } else if (i > 0) {
+      EXPECT_NE(node_scope, trainer->GetWorkerScope(i - 1)->parent());
+    }
+
+    // The worker sees the replica of its node, which is a copy of the root
+    // param in its own memory.
+    auto* replica_var = thread_scope->FindVar("w");
+    ASSERT_EQ(replica_var, node_scope->FindLocalVar("w"));
+    auto& replica = replica_var->Get<LoDTensor>();
+    ASSERT_EQ(replica.dims(), w->dims());
+    EXPECT_NE(replica.data<float>(), w_data);
+    for (int64_t j = 0; j < w->numel(); ++j) {
+      ASSERT_EQ(replica.data<float>()[j], w_data[j]);
+    }
+    int node = NumaNodeOfAddress(replica.data<float>());
+    if (num_nodes > 1 && node >= 0) {
+      EXPECT_EQ(node, i % num_nodes);
+    }
+  }
+  trainer->Finalize();
 }
+
+TEST(MultiTrainer, NumaReplicatedParamWritten) {
+  const int thread_num = 2;
+  TrainerDesc desc = NumaTrainerDesc(thread_num);
+  auto dataset = CreateDataset(thread_num);
+
+  // The replicas would diverge if an op, e.g. an optimizer op, wrote one.
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("w")->SetPersistable(true);
+  block->Var("w@GRAD");
+  auto* op = block->AppendOp();
+  op->SetType("sgd");
+  op->SetInput("Param", {"w"});
+  op->SetInput("Grad", {"w@GRAD"});
+  op->SetOutput("ParamOut", {"w"});
+
+  Scope root_scope;
+  auto* w = root_scope.Var("w")->GetMutable<LoDTensor>();
+  w->Resize({4, 4});
+  w->mutable_data<float>(platform::CPUPlace());
+
+  auto trainer = std::make_shared<MultiTrainer>();
+  trainer->SetScope(&root_scope);
+  trainer->Initialize(desc, dataset.get());
+  EXPECT_THROW(trainer->InitTrainerEnv(program, platform::CPUPlace()),
+               platform::EnforceNotMet);
 }
+#endif
+
+}  // namespace framework
+}  // namespace paddle
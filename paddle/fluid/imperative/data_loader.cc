@@ -57,18 +57,19 @@ void EraseLoadProcessPIDs(int64_t key) {
 // clear mmap fds on signal handler, make sure mmap clear will be called
 // on signal handling and no need to register mmap clear up handler on
 // python side. If shared memory is not used Clear() will do nothing.
-#define SIGNAL_HANDLE(SIGNAL)                               \
-  do {                                                      \
-    memory::allocation::MemoryMapFdSet::Instance().Clear(); \
-    struct sigaction sa;                                    \
-    sa.sa_handler = SIG_DFL;                                \
-    sa.sa_flags = 0;                                        \
-    if (sigemptyset(&sa.sa_mask) != 0 ||                    \
-        sigaction(SIGNAL, &sa, nullptr) != 0) {             \
-      _exit(EXIT_FAILURE);                                  \
-    } else {                                                \
-      raise(SIGNAL);                                        \
-    }                                                       \
+#define SIGNAL_HANDLE(SIGNAL)                                        \
+  do {                                                               \
+    memory::allocation::MemoryMapFdSet::Instance().Clear();          \
+    memory::allocation::MemoryMapAllocationPool::Instance().Clear(); \
+    struct sigaction sa;                                             \
+    sa.sa_handler = SIG_DFL;                                         \
+    sa.sa_flags = 0;                                                 \
+    if (sigemptyset(&sa.sa_mask) != 0 ||                             \
+        sigaction(SIGNAL, &sa, nullptr) != 0) {                      \
+      _exit(EXIT_FAILURE);                                           \
+    } else {                                                         \
+      raise(SIGNAL);                                                 \
+    }                                                                \
   } while (0)
 
 #define REGISTER_SIGNAL_HANDLER(SIGNAL, HANDLER_NAME)             \
@@ -0,0 +1,253 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if defined(PADDLE_WITH_GLOO)
+#include "paddle/fluid/imperative/gloo_context.h"
+
+#include <gloo/allgather.h>
+#include <gloo/allreduce.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/place.h"
+#include "paddle/fluid/string/string_helper.h"
+
+namespace paddle {
+namespace imperative {
+
+template <typename T>
+static void GlooAllReduce(const std::shared_ptr<gloo::Context> &context,
+                          const T *src, T *dst, size_t count) {
+  gloo::AllreduceOptions opts(context);
+  opts.setInput(const_cast<T *>(src), count);
+  opts.setOutput(dst, count);
+  opts.setReduceFunction(
+      static_cast<void (*)(void *, const void *, const void *, size_t)>(
+          &gloo::sum<T>));
+  gloo::allreduce(opts);
+}
+
+template <typename T>
+static void GlooAllGather(const std::shared_ptr<gloo::Context> &context,
+                          const T *src, size_t count, T *dst) {
+  gloo::AllgatherOptions opts(context);
+  opts.setInput(const_cast<T *>(src), count);
+  opts.setOutput(dst, count * context->size);
+  gloo::allgather(opts);
+}
+
+void GLOOParallelContext::Init() {
+  auto *gloo_wrapper = framework::GlooWrapper::GetInstance().get();
+  PADDLE_ENFORCE_EQ(
+      gloo_wrapper->IsInitialized(), true,
+      platform::errors::PreconditionNotMet(
+          "You must initialize the gloo environment first to use it."));
+  PADDLE_ENFORCE_EQ(gloo_wrapper->Size(), strategy_.nranks_,
+                    platform::errors::InvalidArgument(
+                        "The gloo environment has %d ranks, but the parallel "
+                        "strategy expects %d ranks.",
+                        gloo_wrapper->Size(), strategy_.nranks_));
+  PADDLE_ENFORCE_EQ(gloo_wrapper->Rank(), strategy_.local_rank_,
+                    platform::errors::InvalidArgument(
+                        "The gloo environment has rank %d, but the parallel "
+                        "strategy expects rank %d.",
+                        gloo_wrapper->Rank(), strategy_.local_rank_));
+  context_ = gloo_wrapper->GetContext();
+  VLOG(0) << "init GLOO context nranks: " << strategy_.nranks_
+          << " local rank: " << strategy_.local_rank_;
+}
+
+void GLOOParallelContext::AllReduce(const framework::Tensor &src,
+                                    framework::Tensor *dst) {
+  PADDLE_ENFORCE_EQ(platform::is_cpu_place(src.place()), true,
+                    platform::errors::Unimplemented(
+                        "GLOO only supports allreducing the tensors on CPU, "
+                        "but got place (%s).",
+                        src.place()));
+  auto dtype = src.type();
+  size_t numel = static_cast<size_t>(src.numel());
+  // The inputs can be the outputs, gloo reduces in place then.
+  const void *src_ptr = src.data<void>();
+  dst->Resize(src.dims());
+  void *dst_ptr = dst->mutable_data(src.place(), dtype);
+
+  switch (dtype) {
+    case framework::proto::VarType::FP32:
+      GlooAllReduce(context_, static_cast<const float *>(src_ptr),
+                    static_cast<float *>(dst_ptr), numel);
+      break;
+    case framework::proto::VarType::FP64:
+      GlooAllReduce(context_, static_cast<const double *>(src_ptr),
+                    static_cast<double *>(dst_ptr), numel);
+      break;
+    case framework::proto::VarType::INT32:
+      GlooAllReduce(context_, static_cast<const int *>(src_ptr),
+                    static_cast<int *>(dst_ptr), numel);
+      break;
+    case framework::proto::VarType::INT64:
+      GlooAllReduce(context_, static_cast<const int64_t *>(src_ptr),
+                    static_cast<int64_t *>(dst_ptr), numel);
+      break;
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Data type (%s) is not supported when GLOO allreduces tensors.",
+          framework::DataTypeToString(dtype)));
+  }
+}
+
+// Like the SelectedRows allreduce of NCCL, the rows and the values of all
+// ranks are concatenated in the order of rank. gloo only gathers the same
+// number of elements from each rank, so the rows of every rank are padded to
+// the largest rows number before they are gathered.
+void GLOOParallelContext::AllReduce(const framework::SelectedRows &src,
+                                    framework::SelectedRows *dst) {
+  VLOG(3) << "SelectedRows AllReduce start";
+  const auto &src_tensor = src.value();
+  PADDLE_ENFORCE_EQ(platform::is_cpu_place(src_tensor.place()), true,
+                    platform::errors::Unimplemented(
+                        "GLOO only supports allreducing the selected rows on "
+                        "CPU, but got place (%s).",
+                        src_tensor.place()));
+  auto place = src_tensor.place();
+  auto dtype = src_tensor.type();
+  int nranks = strategy_.nranks_;
+
+  // 1. Gather rows number from all workers.
+  int64_t src_rows_num = static_cast<int64_t>(src.rows().size());
+  std::vector<int64_t> rows_num(nranks, 0);
+  GlooAllGather(context_, &src_rows_num, 1, rows_num.data());
+  int64_t max_rows_num = *std::max_element(rows_num.begin(), rows_num.end());
+  int64_t total_rows_num = 0;
+  for (auto num : rows_num) {
+    total_rows_num += num;
+  }
+  VLOG(3) << "Gather rows: " << string::join_strings(rows_num, ',')
+          << ", total rows number: " << total_rows_num
+          << ", height: " << src.height();
+
+  auto dims = src_tensor.dims();
+  int64_t feature_size =
+      framework::product(framework::slice_ddim(dims, 1, dims.size()));
+  size_t row_bytes = feature_size * framework::SizeOfType(dtype);
+
+  // 2. Gather the padded rows and values.
+  std::vector<int64_t> send_rows(max_rows_num, 0);
+  std::copy(src.rows().begin(), src.rows().end(), send_rows.begin());
+  std::vector<int64_t> recv_rows(max_rows_num * nranks);
+  std::vector<uint8_t> send_values(max_rows_num * row_bytes, 0);
+  if (src_rows_num > 0) {
+    std::memcpy(send_values.data(), src_tensor.data<void>(),
+                src_rows_num * row_bytes);
+  }
+  std::vector<uint8_t> recv_values(send_values.size() * nranks);
+  if (max_rows_num > 0) {
+    GlooAllGather(context_, send_rows.data(), send_rows.size(),
+                  recv_rows.data());
+    if (row_bytes > 0) {
+      GlooAllGather(context_, send_values.data(), send_values.size(),
+                    recv_values.data());
+    }
+  }
+
+  // 3. Drop the paddings. src is not used from here on, so it is fine that
+  // dst is src.
+  int64_t height = src.height();
+  dst->set_height(height);
+  auto *dst_rows = dst->mutable_rows();
+  dst_rows->resize(total_rows_num);
+  dims[0] = total_rows_num;
+  auto *dst_tensor = dst->mutable_value();
+  dst_tensor->Resize(dims);
+  auto *dst_values =
+      static_cast<uint8_t *>(dst_tensor->mutable_data(place, dtype));
+  int64_t row_offset = 0;
+  for (int i = 0; i < nranks; ++i) {
+    std::copy(recv_rows.begin() + i * max_rows_num,
+              recv_rows.begin() + i * max_rows_num + rows_num[i],
+              dst_rows->begin() + row_offset);
+    if (rows_num[i] > 0) {
+      std::memcpy(dst_values + row_offset * row_bytes,
+                  recv_values.data() + i * max_rows_num * row_bytes,
+                  rows_num[i] * row_bytes);
+    }
+    row_offset += rows_num[i];
+  }
+}
+
+void GLOOParallelContext::AllReduceByStream(const framework::Variable &src,
+                                            framework::Variable *dst,
+                                            int ring_id, bool use_calc_stream) {
+  CheckRingId(ring_id);
+  PADDLE_ENFORCE_NOT_NULL(
+      context_, platform::errors::PreconditionNotMet(
+                    "GLOOParallelContext must be initialized before "
+                    "allreducing."));
+  if (src.IsType<framework::LoDTensor>()) {
+    if (!dst->IsType<framework::LoDTensor>()) {
+      dst->Clear();
+    }
+    AllReduce(src.Get<framework::LoDTensor>(),
+              dst->GetMutable<framework::LoDTensor>());
+  } else if (src.IsType<framework::SelectedRows>()) {
+    if (&src != dst && !dst->IsType<framework::SelectedRows>()) {
+      dst->Clear();
+    }
+    AllReduce(src.Get<framework::SelectedRows>(),
+              dst->GetMutable<framework::SelectedRows>());
+  } else {
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "Unsupported variable type %s for imperative allreduce, only "
+        "LoDTensor and SelectedRows are supported.",
+        platform::demangle(framework::ToTypeName(src.Type()))));
+  }
+}
+
+paddle::platform::DeviceContext *GLOOParallelContext::GetDeviceContext(
+    int ring_id) {
+  CheckRingId(ring_id);
+  // The concat, split and div of the groups run on the CPU device context.
+  return platform::DeviceContextPool::Instance().Get(place_);
+}
+
+void GLOOParallelContext::WaitCompute(int ring_id) {
+  // CPU computes synchronously, nothing to wait for.
+  CheckRingId(ring_id);
+}
+
+void GLOOParallelContext::WaitComm(int ring_id) {
+  // gloo communicates synchronously, nothing to wait for.
+  CheckRingId(ring_id);
+}
+
+void GLOOParallelContext::CheckRingId(int ring_id) const {
+  PADDLE_ENFORCE_GE(ring_id, 0,
+                    platform::errors::OutOfRange(
+                        "Ring id expected >= 0, but got %d", ring_id));
+  PADDLE_ENFORCE_LT(
+      ring_id, strategy_.nrings_,
+      platform::errors::OutOfRange("Ring id expected < nrings,"
+                                   "but got ring id = %d, nrings = %d",
+                                   ring_id, strategy_.nrings_));
+}
+
+}  //  namespace imperative
+}  //  namespace paddle
+#endif
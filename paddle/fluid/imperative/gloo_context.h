@@ -0,0 +1,72 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#if defined(PADDLE_WITH_GLOO)
+#include <memory>
+
+#include "paddle/fluid/imperative/parallel_context.h"
+
+namespace gloo {
+class Context;
+}  // namespace gloo
+
+namespace paddle {
+namespace framework {
+class SelectedRows;
+class Tensor;
+}  // namespace framework
+
+namespace imperative {
+
+// The parallel context of the multi-process CPU training in dynamic graph
+// mode. It communicates through the context of framework::GlooWrapper, which
+// must be initialized before Init() is called.
+class GLOOParallelContext : public ParallelContext {
+ public:
+  explicit GLOOParallelContext(const ParallelStrategy& strategy,
+                               const platform::Place& place)
+      : ParallelContext(strategy, place) {}
+
+  ~GLOOParallelContext() override = default;
+
+  void Init() override;
+
+  // The allreduce of gloo blocks until it is finished, so use_calc_stream
+  // makes no difference.
+  void AllReduceByStream(const framework::Variable& src,
+                         framework::Variable* dst, int ring_id,
+                         bool use_calc_stream) override;
+
+  paddle::platform::DeviceContext* GetDeviceContext(int ring_id) override;
+
+  void WaitCompute(int ring_id) override;
+
+  void WaitComm(int ring_id) override;
+
+ private:
+  void AllReduce(const framework::Tensor& src, framework::Tensor* dst);
+
+  void AllReduce(const framework::SelectedRows& src,
+                 framework::SelectedRows* dst);
+
+  void CheckRingId(int ring_id) const;
+
+  std::shared_ptr<gloo::Context> context_{nullptr};
+};
+
+}  //  namespace imperative
+}  //  namespace paddle
+
+#endif
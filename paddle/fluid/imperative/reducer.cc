@@ -28,7 +28,7 @@ namespace paddle {
 namespace imperative {
 
 #if defined(PADDLE_WITH_NCCL) || defined(PADDLE_WITH_RCCL) || \
-    defined(PADDLE_WITH_XPU_BKCL)
+    defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
 // div the nranks
 void Group::DivNRanks(const platform::DeviceContext &context, int64_t nranks) {
   framework::Tensor *tensor =
@@ -301,7 +301,7 @@ Reducer::Reducer(const std::vector<std::shared_ptr<imperative::VarBase>> &vars,
   VLOG(3) << "Start construct the Reducer ...";
   nrings_ = parallel_ctx->GetNRings();
   nranks_ = parallel_ctx->GetNRanks();
-#ifdef PADDLE_WITH_XPU_BKCL
+#if defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
   comm_pool_.reset(new ::ThreadPool(1));
   comm_op_count_ = 0;
 #endif
@@ -640,6 +640,8 @@ void Reducer::MarkVarReady(const size_t var_index, const bool is_used_var) {
 
 // TODO(liuyuhui): If BKCL support non-blocking communication, it should be
 // fixed as same as multi gpus card trainging.
+// NOTE: the allreduce of gloo blocks as well, so the groups of CPU training
+// are reduced in comm_pool_ too.
 void Reducer::MarkGroupReady(size_t group_index) {
   if (group_index > next_group_) {
     VLOG(3) << "It will adjust the order of group in next batch automatically";
@@ -657,29 +659,44 @@ void Reducer::MarkGroupReady(size_t group_index) {
     // so we expose WaitCompute() interface and call
     // it here.
     parallel_ctx_->WaitCompute(run_order);
-#ifdef PADDLE_WITH_XPU_BKCL
-    {
-      std::lock_guard<std::mutex> lock(mutex_);
-      comm_op_count_ += 1;  // lock
-    }
-    // TODO(liuyuhui): Add try catch to deal with exception later,
-    // otherwise the main thread will continue to run when an exception is
-    // thrown in comm_pool_.
-    comm_pool_->enqueue([&] {
-      auto dev_id = BOOST_GET_CONST(platform::XPUPlace, place_).device;
-      platform::SetXPUDeviceId(dev_id);
-      FusedAllReduceSchedule(run_order, group);
+#if defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
+    if (platform::is_xpu_place(place_) || platform::is_cpu_place(place_)) {
       {
         std::lock_guard<std::mutex> lock(mutex_);
-        comm_op_count_ -= 1;  // lock
-        cv_.notify_all();
+        comm_op_count_ += 1;  // lock
       }
-    });
-#elif defined(PADDLE_WITH_RCCL) || defined(PADDLE_WITH_NCCL)
+      // NOTE: run_order is a loop variable, so capture it by value.
+      comm_pool_->enqueue([this, run_order, &group] {
+#ifdef PADDLE_WITH_XPU_BKCL
+        if (platform::is_xpu_place(place_)) {
+          auto dev_id = BOOST_GET_CONST(platform::XPUPlace, place_).device;
+          platform::SetXPUDeviceId(dev_id);
+        }
+#endif
+        std::exception_ptr exception = nullptr;
+        try {
+          FusedAllReduceSchedule(run_order, group);
+        } catch (...) {
+          exception = std::current_exception();
+        }
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (exception != nullptr && comm_exception_ == nullptr) {
+            comm_exception_ = exception;
+          }
+          comm_op_count_ -= 1;  // lock
+          cv_.notify_all();
+        }
+      });
+      continue;
+    }
+#endif
+#if defined(PADDLE_WITH_RCCL) || defined(PADDLE_WITH_NCCL)
     FusedAllReduceSchedule(run_order, group);
 #else
     PADDLE_THROW(platform::errors::PreconditionNotMet(
-        "Not compiled with BKCL or NCCL."));
+        "Not compiled with BKCL, NCCL or GLOO for allreduce on place (%s).",
+        place_));
 #endif
   }
 }
@@ -749,10 +766,15 @@ std::vector<std::vector<size_t>> Reducer::RebuildGruops() {
 
 void Reducer::FinalizeBackward() {
   all_group_ready_ = false;
-#ifdef PADDLE_WITH_XPU_BKCL
+#if defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
   {
     std::unique_lock<std::mutex> lock(mutex_);
     cv_.wait(lock, [&] { return comm_op_count_ == 0; });
+    if (comm_exception_ != nullptr) {
+      auto exception = comm_exception_;
+      comm_exception_ = nullptr;
+      std::rethrow_exception(exception);
+    }
   }
 #endif
   // Must prevent compute_stream_ starting until all comm streams have finished
@@ -15,6 +15,7 @@
 #pragma once
 #include <ThreadPool.h>
 #include <algorithm>
+#include <exception>
 #include <iostream>
 #include <map>
 #include <memory>
@@ -48,7 +49,7 @@ namespace paddle {
 namespace imperative {
 
 #if defined(PADDLE_WITH_NCCL) || defined(PADDLE_WITH_RCCL) || \
-    defined(PADDLE_WITH_XPU_BKCL)
+    defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
 
 template <typename T>
 struct DivNRanksFunctor {
@@ -189,12 +190,16 @@ class Reducer {
   bool has_marked_unused_vars_{false};
   bool find_unused_vars_{false};
   bool all_group_ready_{false};
-#ifdef PADDLE_WITH_XPU_BKCL
-  // comm_pool_ is used for scheduling allreduce in multi Kunlun cards training.
+#if defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
+  // comm_pool_ is used for scheduling allreduce in multi Kunlun cards and
+  // multi CPU processes training, whose allreduce blocks the caller. The
+  // groups are reduced in comm_pool_ while backward goes on.
   std::unique_ptr<::ThreadPool> comm_pool_{nullptr};
   uint32_t comm_op_count_;
   std::mutex mutex_;
   std::condition_variable cv_;
+  // the first exception thrown in comm_pool_, rethrown in FinalizeBackward
+  std::exception_ptr comm_exception_{nullptr};
 #endif
 };
 
@@ -0,0 +1,170 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/selected_rows.h"
+#include "paddle/fluid/imperative/gloo_context.h"
+#include "paddle/fluid/imperative/reducer.h"
+#include "paddle/fluid/platform/gloo_context.h"
+
+namespace framework = paddle::framework;
+namespace imperative = paddle::imperative;
+namespace platform = paddle::platform;
+
+// The gloo environment is a singleton, so every rank runs in a process forked
+// by the test. The ranks meet through a file store in a temporary directory.
+constexpr int kNRanks = 2;
+
+static bool Near(float x, float y) { return std::abs(x - y) < 1e-6; }
+
+// Reduce the gradients the way the Reducer does: concat a group of them into
+// one buffer, divide it by nranks, allreduce and split it back.
+static bool TestDenseGroup(imperative::GLOOParallelContext* ctx, int rank) {
+  platform::CPUPlace place;
+  std::vector<framework::LoDTensor> grads(3);
+  imperative::Group group;
+  for (size_t i = 0; i < grads.size(); ++i) {
+    int64_t len = 10 * (i + 1);
+    float* data =
+        grads[i].mutable_data<float>(framework::make_ddim({len}), place);
+    for (int64_t j = 0; j < len; ++j) {
+      data[j] = static_cast<float>((rank + 1) * j);
+    }
+    framework::Tensor tmp;
+    tmp.ShareDataWith(grads[i]);
+    group.dense_tensors_.push_back(std::move(tmp));
+    group.all_length_ += len;
+    group.dtype_ = grads[i].type();
+  }
+
+  auto* dev_ctx = ctx->GetDeviceContext(0);
+  group.dense_contents_.GetMutable<framework::LoDTensor>()
+      ->Resize(framework::make_ddim({group.all_length_}))
+      .mutable_data(place, group.dtype_);
+  group.ConcatTensors(*dev_ctx);
+  group.DivNRanks(*dev_ctx, kNRanks);
+  ctx->AllReduceByStream(group.dense_contents_, &group.dense_contents_, 0,
+                         false);
+  group.SplitTensors(*dev_ctx);
+
+  // mean of (rank + 1) * j over the ranks
+  float scale = (kNRanks + 1) / 2.0f;
+  for (auto& grad : grads) {
+    const float* data = grad.data<float>();
+    for (int64_t j = 0; j < grad.numel(); ++j) {
+      if (!Near(data[j], scale * j)) return false;
+    }
+  }
+  return true;
+}
+
+// Rank r holds r + 1 rows, so the rows gathered from the ranks differ in
+// number.
+static bool TestSelectedRows(imperative::GLOOParallelContext* ctx, int rank) {
+  platform::CPUPlace place;
+  const int64_t width = 4;
+  framework::Variable var;
+  auto* rows = var.GetMutable<framework::SelectedRows>();
+  rows->set_height(100);
+  std::vector<int64_t> row_ids;
+  for (int i = 0; i <= rank; ++i) {
+    row_ids.push_back(rank * 10 + i);
+  }
+  rows->set_rows(row_ids);
+  float* value = rows->mutable_value()->mutable_data<float>(
+      framework::make_ddim({static_cast<int64_t>(row_ids.size()), width}),
+      place);
+  for (int64_t i = 0; i < rows->value().numel(); ++i) {
+    value[i] = static_cast<float>(rank * 100 + i);
+  }
+
+  ctx->AllReduceByStream(var, &var, 0, false);
+
+  const auto& result = var.Get<framework::SelectedRows>();
+  int64_t total_rows = kNRanks * (kNRanks + 1) / 2;
+  if (result.height() != 100) return false;
+  if (static_cast<int64_t>(result.rows().size()) != total_rows) return false;
+  if (result.value().dims()[0] != total_rows) return false;
+  const float* result_value = result.value().data<float>();
+  int64_t offset = 0;
+  for (int r = 0; r < kNRanks; ++r) {
+    for (int i = 0; i <= r; ++i, ++offset) {
+      if (result.rows()[offset] != r * 10 + i) return false;
+      for (int64_t j = 0; j < width; ++j) {
+        float expected = static_cast<float>(r * 100 + i * width + j);
+        if (!Near(result_value[offset * width + j], expected)) return false;
+      }
+    }
+  }
+  return true;
+}
+
+static int RunRank(int rank, const std::string& store_path) {
+  platform::GlooParallelStrategy gloo_strategy;
+  gloo_strategy.rank = rank;
+  gloo_strategy.rank_num = kNRanks;
+  gloo_strategy.iface = "lo";
+  gloo_strategy.init_seconds = 60;
+  gloo_strategy.run_seconds = 60;
+  gloo_strategy.store_path = store_path;
+  platform::GlooParallelContext gloo_ctx(gloo_strategy);
+  gloo_ctx.Init();
+
+  imperative::ParallelStrategy strategy;
+  strategy.nranks_ = kNRanks;
+  strategy.local_rank_ = rank;
+  imperative::GLOOParallelContext ctx(strategy, platform::CPUPlace());
+  ctx.Init();
+
+  if (!TestDenseGroup(&ctx, rank)) return 1;
+  if (!TestSelectedRows(&ctx, rank)) return 2;
+  return 0;
+}
+
+TEST(GLOOParallelContext, AllReduce) {
+  char store_path[] = "/tmp/gloo_context_test_XXXXXX";
+  ASSERT_NE(mkdtemp(store_path), nullptr);
+
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < kNRanks; ++rank) {
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      int code = 3;
+      try {
+        code = RunRank(rank, store_path);
+      } catch (...) {
+      }
+      _exit(code);
+    }
+    pids.push_back(pid);
+  }
+
+  for (int rank = 0; rank < kNRanks; ++rank) {
+    int status = 0;
+    ASSERT_EQ(waitpid(pids[rank], &status, 0), pids[rank]);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0) << "rank " << rank << " failed";
+  }
+  EXPECT_EQ(std::system((std::string("rm -rf ") + store_path).c_str()), 0);
+}
@@ -23,6 +23,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <string>
@@ -48,6 +49,28 @@ using VarQuantScale =
     std::unordered_map<std::string, std::pair<bool, framework::LoDTensor>>;
 #endif
 
+// A tensor planned in the memory arena of the predictor. The size grows with
+// the batch size by the power of the number of the dynamic dims.
+struct MemoryBlock {
+  std::string name;
+  // sizes[k] is the bytes of the tensors with k dynamic dims at batch 1.
+  std::vector<size_t> sizes;
+  // The bytes the tensor took in the former runs, the block does not shrink
+  // below it.
+  size_t min_size{0};
+  std::pair<int, int> lifetime;
+
+  size_t Size(int batch_size) const {
+    size_t size = min_size;
+    size_t scale = 1;
+    for (auto& s : sizes) {
+      size = std::max(size, s * scale);
+      scale *= batch_size;
+    }
+    return size;
+  }
+};
+
 /*
  * The argument definition of both Pass and PassManagers.
  *
@@ -60,6 +83,7 @@ struct Argument {
   using unique_ptr_t = std::unique_ptr<void, std::function<void(void*)>>;
   using fusion_statis_t = std::unordered_map<std::string, int>;
   using input_shape_t = std::map<std::string, std::vector<int>>;
+  using memory_blocks_t = std::vector<MemoryBlock>;
 
   bool Has(const std::string& key) const { return valid_fields_.count(key); }
   // If we set the model using config.SetModelBuffer,
@@ -230,6 +254,10 @@ struct Argument {
   // optimization relays on the sort algorithm.
   DECL_ARGUMENT_FIELD(memory_optim_sort_kind, MemoryOptimSortKind, int);
 
+  // The reused tensors, their offsets in the memory arena are planned by the
+  // predictor according to the batch size.
+  DECL_ARGUMENT_FIELD(memory_blocks, MemoryBlocks, memory_blocks_t);
+
   // The program transformed by IR analysis phase.
   DECL_ARGUMENT_UNIQUE_FIELD(ir_analyzed_program, IrAnalyzedProgram,
                              framework::proto::ProgramDesc);
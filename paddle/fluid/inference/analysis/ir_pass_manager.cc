@@ -185,6 +185,9 @@ void IRPassManager::CreatePasses(Argument *argument,
                 new int(argument->cpu_math_library_num_threads()));
     }
     disable_logs_ = argument->disable_logs();
+    if (pass_name == "fusion_group_pass") {
+      pass->Set("use_gpu", new bool(argument->use_gpu()));
+    }
     if (pass_name == "fc_fuse_pass") {
       pass->Set("use_gpu", new bool(argument->use_gpu()));
       bool fc_mkldnn_pass = 0;
@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
 
+#include <algorithm>
+#include <limits>
 #include <string>
 #include <utility>
 
@@ -90,7 +92,8 @@ void MemoryOptimizePass::CollectLifeCycle(
 }
 
 void MemoryOptimizePass::CollectVarMemorySize(
-    space_table_t* space_table) const {
+    space_table_t* space_table,
+    std::unordered_map<std::string, int>* dynamic_dims) const {
   const int fake_batch_size = 1;
 
   auto valid_var = [&](framework::ir::Node* node) -> bool {
@@ -131,8 +134,15 @@ void MemoryOptimizePass::CollectVarMemorySize(
       // Parameters will not be reused.
       if (node->Var()->Persistable()) continue;
       auto shape = node->Var()->GetShape();
+      int num_dynamic_dims = 0;
       for (auto& v : shape) {
-        if (v < 0) v = fake_batch_size;
+        if (v < 0) {
+          v = fake_batch_size;
+          ++num_dynamic_dims;
+        }
+      }
+      if (dynamic_dims) {
+        (*dynamic_dims)[node->Var()->Name()] = num_dynamic_dims;
       }
 
       int size = std::accumulate(shape.begin(), shape.end(), 1,
@@ -272,6 +282,103 @@ void UpdateOpDescsByReuse(
   }
 }
 
+// The vars in one cluster share the same tensor, so they make one block.
+void CollectMemoryBlocks(
+    const std::unordered_map<std::string, std::pair<int, int>>& lifecycles,
+    const space_table_t& space_table,
+    const std::unordered_map<std::string, int>& dynamic_dims,
+    const std::unordered_map<std::string, std::string>& node2cluster,
+    Argument::memory_blocks_t* blocks) {
+  std::unordered_map<std::string, MemoryBlock> cluster_blocks;
+  for (auto& item : node2cluster) {
+    auto& var = item.first;
+    auto& lifetime = lifecycles.at(var);
+    auto iter = cluster_blocks.find(item.second);
+    if (iter == cluster_blocks.end()) {
+      iter = cluster_blocks.emplace(item.second, MemoryBlock()).first;
+      iter->second.name = item.second;
+      iter->second.lifetime = lifetime;
+    }
+    auto& block = iter->second;
+    block.lifetime.first = std::min(block.lifetime.first, lifetime.first);
+    block.lifetime.second = std::max(block.lifetime.second, lifetime.second);
+    auto iter_dims = dynamic_dims.find(var);
+    size_t k = iter_dims == dynamic_dims.end() ? 0 : iter_dims->second;
+    if (block.sizes.size() <= k) block.sizes.resize(k + 1, 0);
+    block.sizes[k] = std::max(block.sizes[k], space_table.at(var));
+  }
+  for (auto& item : cluster_blocks) {
+    // The feed vars are filled by the users, keep them out of the arena.
+    if (item.second.lifetime.second == std::numeric_limits<int>::max()) {
+      continue;
+    }
+    blocks->push_back(item.second);
+  }
+}
+
+size_t MemoryOptimizePass::PlanOffsets(
+    const Argument::memory_blocks_t& blocks, int batch_size,
+    std::unordered_map<std::string, size_t>* offsets) {
+  const size_t alignment = 64;
+  struct Placed {
+    size_t offset;
+    size_t size;
+    std::pair<int, int> lifetime;
+  };
+  auto overlap = [](std::pair<int, int> a, std::pair<int, int> b) -> bool {
+    return b.second >= a.first && a.second >= b.first;
+  };
+
+  // Place the large blocks first, each one goes to the smallest gap that it
+  // fits in among the placed blocks alive at the same time.
+  std::vector<std::pair<size_t, const MemoryBlock*>> sorted_blocks;
+  sorted_blocks.reserve(blocks.size());
+  for (auto& block : blocks) {
+    size_t size = (block.Size(batch_size) + alignment - 1) / alignment *
+                  alignment;
+    sorted_blocks.emplace_back(size, &block);
+  }
+  std::stable_sort(sorted_blocks.begin(), sorted_blocks.end(),
+                   [](const std::pair<size_t, const MemoryBlock*>& a,
+                      const std::pair<size_t, const MemoryBlock*>& b) {
+                     return a.first > b.first;
+                   });
+
+  std::vector<Placed> placed;
+  size_t arena_size = 0;
+  for (auto& item : sorted_blocks) {
+    size_t size = item.first;
+    auto& lifetime = item.second->lifetime;
+    std::vector<const Placed*> alive;
+    for (auto& p : placed) {
+      if (overlap(p.lifetime, lifetime)) alive.push_back(&p);
+    }
+    std::sort(alive.begin(), alive.end(),
+              [](const Placed* a, const Placed* b) {
+                return a->offset < b->offset;
+              });
+
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t end = 0;
+    for (auto* p : alive) {
+      if (p->offset >= end + size && p->offset - end < best_gap) {
+        best_gap = p->offset - end;
+        best_offset = end;
+      }
+      end = std::max(end, p->offset + p->size);
+    }
+    if (best_gap == std::numeric_limits<size_t>::max()) {
+      best_offset = end;
+    }
+
+    placed.push_back(Placed{best_offset, size, lifetime});
+    (*offsets)[item.second->name] = best_offset;
+    arena_size = std::max(arena_size, best_offset + size);
+  }
+  return arena_size;
+}
+
 std::string MemoryOptimizePass::repr() const { return "memory optimize pass"; }
 
 void MemoryOptimizePass::RunImpl(Argument* argument) {
@@ -294,10 +401,16 @@ void MemoryOptimizePass::RunImpl(Argument* argument) {
   std::unordered_map<std::string, std::string> node2cluster;
   std::unordered_map<std::string, int> cluster_size;
 
+  std::unordered_map<std::string, int> dynamic_dims;
+  Argument::memory_blocks_t memory_blocks;
+
   CollectLifeCycle(&lifecycles, sort_kind);
-  CollectVarMemorySize(&space_table);
+  CollectVarMemorySize(&space_table, &dynamic_dims);
   MakeSimpleReusePlan(lifecycles, space_table, &node2cluster, &cluster_size);
   UpdateOpDescsByReuse(graph_, node2cluster, sort_kind);
+  CollectMemoryBlocks(lifecycles, space_table, dynamic_dims, node2cluster,
+                      &memory_blocks);
+  argument->SetMemoryBlocks(memory_blocks);
   return;
 }
 
@@ -44,6 +44,8 @@ namespace analysis {
 * name of var and the value in the table represents the current name of var.
 * 3. Perform reuse plan: Replace all var's name in the model according to the
 * mapping table.
+* 4. Collect the memory blocks of the reused vars, the predictor places them
+* in one arena by PlanOffsets.
 */
 class MemoryOptimizePass : public AnalysisPass {
  public:
@@ -52,6 +54,13 @@ class MemoryOptimizePass : public AnalysisPass {
 
   virtual ~MemoryOptimizePass() = default;
 
+  // Assign the offsets of the blocks in one arena for the batch size, the
+  // blocks whose lifetimes overlap do not overlap in the arena. Returns the
+  // size of the arena.
+  static size_t PlanOffsets(const Argument::memory_blocks_t &blocks,
+                            int batch_size,
+                            std::unordered_map<std::string, size_t> *offsets);
+
  protected:
   void RunImpl(Argument *argument) override;
 
@@ -60,7 +69,9 @@ class MemoryOptimizePass : public AnalysisPass {
       std::unordered_map<std::string, lifecycle_t> *lifecycles,
       int sort_kind) const;
 
-  void CollectVarMemorySize(space_table_t *space_table) const;
+  void CollectVarMemorySize(
+      space_table_t *space_table,
+      std::unordered_map<std::string, int> *dynamic_dims = nullptr) const;
 
  public:
   std::string repr() const override;
@@ -0,0 +1,177 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+namespace {
+
+MemoryBlock MakeBlock(const std::string& name, std::vector<size_t> sizes,
+                      int begin, int end) {
+  MemoryBlock block;
+  block.name = name;
+  block.sizes = std::move(sizes);
+  block.lifetime = std::make_pair(begin, end);
+  return block;
+}
+
+size_t Aligned(size_t size) { return (size + 63) / 64 * 64; }
+
+// The blocks alive at the same time must not share memory.
+void CheckPlan(const Argument::memory_blocks_t& blocks, int batch_size,
+               const std::unordered_map<std::string, size_t>& offsets,
+               size_t arena_size) {
+  ASSERT_EQ(offsets.size(), blocks.size());
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    auto& a = blocks[i];
+    size_t a_begin = offsets.at(a.name);
+    size_t a_end = a_begin + a.Size(batch_size);
+    EXPECT_EQ(a_begin % 64, 0UL);
+    EXPECT_LE(a_end, arena_size);
+    for (size_t j = i + 1; j < blocks.size(); ++j) {
+      auto& b = blocks[j];
+      if (a.lifetime.second < b.lifetime.first ||
+          b.lifetime.second < a.lifetime.first) {
+        continue;
+      }
+      size_t b_begin = offsets.at(b.name);
+      size_t b_end = b_begin + b.Size(batch_size);
+      EXPECT_TRUE(a_end <= b_begin || b_end <= a_begin)
+          << a.name << " [" << a_begin << ", " << a_end << ") overlaps "
+          << b.name << " [" << b_begin << ", " << b_end << ")";
+    }
+  }
+}
+
+}  // namespace
+
+TEST(MemoryOptimizePass, plan_overlapping_lifetimes) {
+  Argument::memory_blocks_t blocks = {MakeBlock("a", {1000}, 0, 4),
+                                      MakeBlock("b", {100}, 1, 3),
+                                      MakeBlock("c", {10}, 2, 5)};
+  std::unordered_map<std::string, size_t> offsets;
+  size_t arena_size = MemoryOptimizePass::PlanOffsets(blocks, 1, &offsets);
+  CheckPlan(blocks, 1, offsets, arena_size);
+  EXPECT_EQ(arena_size, Aligned(1000) + Aligned(100) + Aligned(10));
+}
+
+TEST(MemoryOptimizePass, plan_disjoint_lifetimes) {
+  Argument::memory_blocks_t blocks = {MakeBlock("a", {1000}, 0, 1),
+                                      MakeBlock("b", {100}, 2, 3),
+                                      MakeBlock("c", {500}, 4, 5)};
+  std::unordered_map<std::string, size_t> offsets;
+  size_t arena_size = MemoryOptimizePass::PlanOffsets(blocks, 1, &offsets);
+  CheckPlan(blocks, 1, offsets, arena_size);
+  EXPECT_EQ(arena_size, Aligned(1000));
+  EXPECT_EQ(offsets.at("a"), 0UL);
+  EXPECT_EQ(offsets.at("b"), 0UL);
+  EXPECT_EQ(offsets.at("c"), 0UL);
+}
+
+TEST(MemoryOptimizePass, plan_gap) {
+  // b ends before c starts, so c goes to the gap b leaves between a and d.
+  Argument::memory_blocks_t blocks = {
+      MakeBlock("a", {256}, 0, 9), MakeBlock("b", {192}, 0, 3),
+      MakeBlock("d", {128}, 0, 9), MakeBlock("c", {64}, 5, 9)};
+  std::unordered_map<std::string, size_t> offsets;
+  size_t arena_size = MemoryOptimizePass::PlanOffsets(blocks, 1, &offsets);
+  CheckPlan(blocks, 1, offsets, arena_size);
+  EXPECT_EQ(arena_size, 256UL + 192 + 128);
+  EXPECT_EQ(offsets.at("c"), offsets.at("b"));
+}
+
+TEST(MemoryOptimizePass, dynamic_dims) {
+  // The tensors of [-1, 4], [-1, -1, 2] and [-1, -1, -1] floats.
+  MemoryBlock block = MakeBlock("a", {0, 16, 8, 4}, 0, 1);
+  EXPECT_EQ(block.Size(1), 16UL);
+  EXPECT_EQ(block.Size(2), 32UL);
+  EXPECT_EQ(block.Size(4), 256UL);
+  EXPECT_EQ(block.Size(8), 2048UL);
+  block.min_size = 4096;
+  EXPECT_EQ(block.Size(8), 4096UL);
+  EXPECT_EQ(block.Size(16), 16384UL);
+
+  // A block without dynamic dims does not grow with the batch size.
+  MemoryBlock fixed = MakeBlock("b", {100}, 0, 1);
+  EXPECT_EQ(fixed.Size(1), 100UL);
+  EXPECT_EQ(fixed.Size(64), 100UL);
+
+  Argument::memory_blocks_t blocks = {block, fixed,
+                                      MakeBlock("c", {0, 64}, 1, 2)};
+  for (int batch_size : {1, 3, 16, 32}) {
+    std::unordered_map<std::string, size_t> offsets;
+    size_t arena_size =
+        MemoryOptimizePass::PlanOffsets(blocks, batch_size, &offsets);
+    CheckPlan(blocks, batch_size, offsets, arena_size);
+  }
+}
+
+TEST(MemoryOptimizePass, plan_peak_memory) {
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> time(0, 199);
+  std::uniform_int_distribution<int> length(1, 20);
+  std::uniform_int_distribution<size_t> bytes(1, 1 << 20);
+  std::uniform_int_distribution<int> num_dims(0, 2);
+
+  Argument::memory_blocks_t blocks;
+  for (int i = 0; i < 300; ++i) {
+    int begin = time(rng);
+    std::vector<size_t> sizes(num_dims(rng) + 1, 0);
+    sizes.back() = bytes(rng);
+    blocks.push_back(MakeBlock("block_" + std::to_string(i), sizes, begin,
+                               begin + length(rng)));
+  }
+
+  for (int batch_size : {1, 4}) {
+    std::unordered_map<std::string, size_t> offsets;
+    size_t arena_size =
+        MemoryOptimizePass::PlanOffsets(blocks, batch_size, &offsets);
+    CheckPlan(blocks, batch_size, offsets, arena_size);
+
+    // No plan is smaller than the blocks alive at the busiest time, and the
+    // allocator would be called once per block without the arena.
+    size_t total_size = 0;
+    std::vector<size_t> alive(256, 0);
+    for (auto& block : blocks) {
+      size_t size = Aligned(block.Size(batch_size));
+      total_size += size;
+      for (int t = block.lifetime.first; t <= block.lifetime.second; ++t) {
+        alive[t] += size;
+      }
+    }
+    size_t peak_size = *std::max_element(alive.begin(), alive.end());
+    LOG(INFO) << "batch size " << batch_size << ": arena " << arena_size
+              << " bytes in 1 allocation, the busiest time " << peak_size
+              << " bytes, " << total_size << " bytes in " << blocks.size()
+              << " allocations without reuse";
+    EXPECT_GE(arena_size, peak_size);
+    EXPECT_LE(arena_size, total_size);
+    EXPECT_LE(arena_size, peak_size * 2);
+  }
+}
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
@@ -122,6 +122,8 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(memory_pool_init_size_mb_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(use_optim_program_cache_);
+  CP_MEMBER(use_cpu_fusion_group_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -421,6 +423,27 @@ void AnalysisConfig::Update() {
 #endif
   }
 
+  if (use_cpu_fusion_group_ && !use_gpu() && !use_xpu()) {
+#if !defined(__APPLE__) && !defined(_WIN32)
+    if (!enable_ir_optim_) {
+      LOG(ERROR) << "EnableCpuFusionGroup() only works when IR optimization "
+                    "is enabled.";
+    } else {
+      // fusion_group_pass works on the elementwise ops left by the other
+      // fuse passes, and runtime_context_cache_pass should be the last.
+      const auto &passes = pass_builder()->AllPasses();
+      if (std::find(passes.begin(), passes.end(), "fusion_group_pass") ==
+          passes.end()) {
+        auto it = std::find(passes.begin(), passes.end(),
+                            "runtime_context_cache_pass");
+        pass_builder()->InsertPass(it - passes.begin(), "fusion_group_pass");
+      }
+    }
+#else
+    LOG(ERROR) << "EnableCpuFusionGroup() is not supported on this platform.";
+#endif
+  }
+
 #ifdef PADDLE_WITH_MKLDNN
   // Do not optimize when mkldnn is on
   if (enable_memory_optim_ && !use_mkldnn_) {
@@ -486,6 +509,7 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << use_cpu_fusion_group_;
 
   ss << use_mkldnn_;
   ss << mkldnn_cache_capacity_;
@@ -554,6 +578,23 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableOptimProgramCache(bool x) {
+  use_optim_program_cache_ = x;
+}
+
+bool AnalysisConfig::optim_program_cache_enabled() const {
+  return use_optim_program_cache_;
+}
+
+void AnalysisConfig::EnableCpuFusionGroup(bool x) {
+  use_cpu_fusion_group_ = x;
+  Update();
+}
+
+bool AnalysisConfig::cpu_fusion_group_enabled() const {
+  return use_cpu_fusion_group_;
+}
+
 void AnalysisConfig::SetModelBuffer(const char *prog_buffer,
                                     size_t prog_buffer_size,
                                     const char *param_buffer,
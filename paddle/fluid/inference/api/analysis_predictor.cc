@@ -15,10 +15,14 @@
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
 #include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <fstream>
 #include <memory>
 #include <set>
+#include <sstream>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include "paddle/fluid/extension/include/ext_op_meta_info.h"
@@ -37,6 +41,7 @@
 #include "paddle/fluid/inference/utils/singleton.h"
 #include "paddle/fluid/memory/memcpy.h"
 #include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/gpu_info.h"
 #include "paddle/fluid/platform/place.h"
@@ -223,12 +228,19 @@ bool AnalysisPredictor::PrepareProgram(
     // If config_.ir_optim() is False, parameters is loaded in LoadParameters(),
     // still need to create other persistable variables.
     // So in both case, create persistable variables at first.
-    executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+    std::string cache_entry = GetOptimProgramCacheEntry();
+    if (!cache_entry.empty() && LoadOptimProgramCache(cache_entry)) {
+      LOG(INFO) << "Load the optimized program from " << cache_entry;
+      optim_program_cache_hit_ = true;
+    } else {
+      executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
 
-    // if enable_ir_optim_ is false,
-    // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc) will
-    // not be executed.
-    OptimizeInferenceProgram();
+      // if enable_ir_optim_ is false,
+      // the analysis pass(op fuse, graph analysis, trt subgraph, mkldnn etc)
+      // will not be executed.
+      OptimizeInferenceProgram();
+      if (!cache_entry.empty()) SaveOptimProgramCache(cache_entry);
+    }
   } else {
     // If the program is passed from external, no need to optimize it, this
     // logic is used in the clone scenario.
@@ -369,6 +381,13 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
     LOG(ERROR) << "fail to set feed";
     return false;
   }
+  if (!memory_blocks_.empty()) {
+    int batch = 0;
+    for (auto &input : inputs) {
+      if (!input.shape.empty()) batch = std::max(batch, input.shape[0]);
+    }
+    PrepareMemoryArena(batch);
+  }
 
   // Run the inference program
   // if share variables, we need not create variables
@@ -407,6 +426,71 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
   return true;
 }
 
+namespace {
+// A slice of the memory arena, it keeps the arena alive.
+class ArenaAllocation : public memory::Allocation {
+ public:
+  ArenaAllocation(const std::shared_ptr<memory::Allocation> &arena,
+                  size_t offset, size_t size)
+      : Allocation(static_cast<uint8_t *>(arena->ptr()) + offset, size,
+                   arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> arena_;
+};
+}  // namespace
+
+void AnalysisPredictor::PrepareMemoryArena(int batch_size) {
+  framework::Scope *scope = sub_scope_ ? sub_scope_ : scope_.get();
+  // The tensors that outgrew their slots in the last run got their memory
+  // from the allocator, enlarge their blocks and replan to take them back.
+  bool outgrown = false;
+  for (auto &block : memory_blocks_) {
+    auto iter = arena_slices_.find(block.name);
+    if (iter == arena_slices_.end()) continue;
+    auto *var = scope->FindVar(block.name);
+    if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+    auto &tensor = var->Get<framework::LoDTensor>();
+    if (!tensor.IsInitialized() || tensor.Holder().get() == iter->second) {
+      continue;
+    }
+    // The tensors sharing the data of others keep their slots.
+    size_t size = tensor.numel() * framework::SizeOfType(tensor.type());
+    if (size <= iter->second->size()) continue;
+    block.min_size = std::max(block.min_size, size);
+    outgrown = true;
+  }
+
+  int bucket = 1;
+  while (bucket < batch_size) bucket <<= 1;
+  if (outgrown) bucket = std::max(bucket, arena_batch_size_);
+  if (!outgrown && bucket <= arena_batch_size_) return;
+
+  std::unordered_map<std::string, size_t> offsets;
+  size_t arena_size = inference::analysis::MemoryOptimizePass::PlanOffsets(
+      memory_blocks_, bucket, &offsets);
+  memory_arena_ = memory::AllocShared(place_, arena_size);
+  arena_batch_size_ = bucket;
+  arena_slices_.clear();
+
+  size_t total_size = 0;
+  for (auto &block : memory_blocks_) {
+    auto *var = scope->FindVar(block.name);
+    if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+    size_t size = block.Size(bucket);
+    auto slice = std::make_shared<ArenaAllocation>(
+        memory_arena_, offsets.at(block.name), size);
+    arena_slices_[block.name] = slice.get();
+    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    tensor->clear();
+    tensor->ResetHolder(std::move(slice));
+    total_size += size;
+  }
+  VLOG(3) << "Memory arena for batch size " << bucket << ": " << arena_size
+          << " bytes, " << total_size << " bytes without overlapping.";
+}
+
 bool AnalysisPredictor::SetFeed(const std::vector<PaddleTensor> &inputs,
                                 framework::Scope *scope) {
   VLOG(3) << "Predictor::set_feed";
@@ -591,6 +675,9 @@ void AnalysisPredictor::OptimizeInferenceProgram() {
   ARGUMENT_CHECK_FIELD((&argument_), ir_analyzed_program);
   inference_program_.reset(
       new framework::ProgramDesc(argument_.ir_analyzed_program()));
+  if (platform::is_cpu_place(place_) && argument_.Has("memory_blocks")) {
+    memory_blocks_ = argument_.memory_blocks();
+  }
   // The config and argument take a lot of storage,
   // when the predictor settings are complete, we release these stores.
   argument_.PartiallyRelease();
@@ -859,6 +946,16 @@ bool AnalysisPredictor::ZeroCopyRun() {
     MkldnnPreSet(shape_vector);
   }
 #endif
+  if (!memory_blocks_.empty()) {
+    int batch = 0;
+    for (auto *feed : feeds_) {
+      auto *var = sub_scope_->FindVar(feed->Output("Out")[0]);
+      if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+      auto &dims = var->Get<framework::LoDTensor>().dims();
+      if (dims.size() > 0) batch = std::max(batch, static_cast<int>(dims[0]));
+    }
+    PrepareMemoryArena(batch);
+  }
 
   executor_->Run();
   // Fix TensorArray reuse not cleaned bug.
@@ -928,6 +1025,10 @@ bool AnalysisPredictor::LoadProgramDesc() {
 }
 
 bool AnalysisPredictor::LoadParameters() {
+  return LoadParameters(config_.params_file());
+}
+
+bool AnalysisPredictor::LoadParameters(const std::string &params_file) {
   PADDLE_ENFORCE_NOT_NULL(inference_program_.get(),
                           platform::errors::PreconditionNotMet(
                               "The inference program should be loaded first."));
@@ -952,7 +1053,7 @@ bool AnalysisPredictor::LoadParameters() {
       new_var->SetLoDLevel(var->GetLoDLevel());
       new_var->SetPersistable(true);
 
-      if (!config_.params_file().empty()) {
+      if (!params_file.empty()) {
         params.push_back(new_var->Name());
       } else {
         // append_op
@@ -965,14 +1066,14 @@ bool AnalysisPredictor::LoadParameters() {
     }
   }
 
-  if (!config_.params_file().empty()) {
+  if (!params_file.empty()) {
     // sort paramlist to have consistent ordering
     std::sort(params.begin(), params.end());
     // append just the load_combine op
     framework::OpDesc *op = load_block->AppendOp();
     op->SetType("load_combine");
     op->SetOutput("Out", params);
-    op->SetAttr("file_path", {config_.params_file()});
+    op->SetAttr("file_path", {params_file});
     op->CheckAttrs();
   }
 
@@ -985,6 +1086,178 @@ bool AnalysisPredictor::LoadParameters() {
   return true;
 }
 
+namespace {
+// Combine the hash of the file content into seed.
+void HashFile(const std::string &path, size_t *seed) {
+  std::ifstream fin(path, std::ios::in | std::ios::binary);
+  PADDLE_ENFORCE_EQ(
+      static_cast<bool>(fin.is_open()), true,
+      platform::errors::NotFound(
+          "Cannot open file %s, please confirm whether the file is normal.",
+          path));
+  std::string chunk(1 << 20, ' ');
+  while (fin) {
+    fin.read(&chunk[0], chunk.size());
+    auto size = static_cast<size_t>(fin.gcount());
+    *seed = *seed * 31 + std::hash<std::string>()(chunk.substr(0, size));
+  }
+}
+
+// The memory blocks planned by memory_optimize_pass are saved with the
+// optimized program, one block per line.
+bool WriteMemoryBlocks(const std::string &path,
+                       const Argument::memory_blocks_t &blocks) {
+  std::ofstream fout(path);
+  fout << blocks.size() << "\n";
+  for (auto &block : blocks) {
+    fout << block.name << " " << block.lifetime.first << " "
+         << block.lifetime.second << " " << block.min_size << " "
+         << block.sizes.size();
+    for (auto size : block.sizes) fout << " " << size;
+    fout << "\n";
+  }
+  fout.close();
+  return static_cast<bool>(fout);
+}
+
+bool ReadMemoryBlocks(const std::string &path,
+                      Argument::memory_blocks_t *blocks) {
+  std::ifstream fin(path);
+  size_t num_blocks = 0;
+  if (!(fin >> num_blocks)) return false;
+  blocks->resize(num_blocks);
+  for (auto &block : *blocks) {
+    size_t num_sizes = 0;
+    fin >> block.name >> block.lifetime.first >> block.lifetime.second >>
+        block.min_size >> num_sizes;
+    block.sizes.resize(num_sizes);
+    for (auto &size : block.sizes) fin >> size;
+  }
+  return static_cast<bool>(fin);
+}
+}  // namespace
+
+std::string AnalysisPredictor::GetOptimProgramCacheEntry() {
+  if (!config_.optim_program_cache_enabled() || !config_.ir_optim() ||
+      config_.tensorrt_engine_enabled() || config_.lite_engine_enabled() ||
+      config_.mkldnn_quantizer_enabled()) {
+    return "";
+  }
+
+  std::string cache_dir = config_.opt_cache_dir_;
+  if (cache_dir.empty()) {
+    if (config_.model_from_memory()) {
+      LOG(WARNING) << "The model is loaded from memory, set the optimization "
+                      "cache directory to cache the optimized program.";
+      return "";
+    }
+    cache_dir = inference::analysis::GetOrCreateModelOptCacheDir(
+        config_.model_dir().empty()
+            ? inference::analysis::GetDirRoot(config_.prog_file())
+            : config_.model_dir());
+  } else if (!inference::analysis::PathExists(cache_dir)) {
+    PADDLE_ENFORCE_NE(MKDIR(cache_dir.c_str()), -1,
+                      platform::errors::PreconditionNotMet(
+                          "Can not create optimize cache directory: %s, Make "
+                          "sure you have permission to write",
+                          cache_dir));
+  }
+
+  // The program is already loaded, hash the params files. The version and
+  // commit of Paddle are hashed too, since the passes change between them.
+  size_t key = std::hash<std::string>()(config_.SerializeInfoCache());
+  key = key * 31 + std::hash<std::string>()(paddle::get_version());
+  key = key * 31 + std::hash<std::string>()(
+                       inference_program_->Proto()->SerializeAsString());
+  if (config_.model_from_memory()) {
+    key = key * 31 + std::hash<std::string>()(config_.params_file());
+  } else if (!config_.params_file().empty()) {
+    HashFile(config_.params_file(), &key);
+  } else {
+    std::vector<std::string> params;
+    for (auto *var : inference_program_->Block(0).AllVars()) {
+      if (IsPersistable(var)) params.push_back(var->Name());
+    }
+    std::sort(params.begin(), params.end());
+    for (auto &param : params) {
+      HashFile(config_.model_dir() + "/" + param, &key);
+    }
+  }
+  for (auto &pass : config_.pass_builder()->AllPasses()) {
+    key = key * 31 + std::hash<std::string>()(pass);
+  }
+  // The passes and kernels may choose different paths on different ISAs.
+  std::string isa = platform::MayIUse(platform::avx512f)
+                        ? "avx512f"
+                        : platform::MayIUse(platform::avx2)
+                              ? "avx2"
+                              : platform::MayIUse(platform::avx) ? "avx"
+                                                                 : "isa";
+  key = key * 31 + std::hash<std::string>()(isa);
+
+  if (cache_dir.back() != '/') cache_dir += "/";
+  return cache_dir + "optim_program_" + std::to_string(key);
+}
+
+bool AnalysisPredictor::LoadOptimProgramCache(const std::string &entry) {
+  std::string model_file = entry + "/model";
+  std::string params_file = entry + "/params";
+  if (!inference::analysis::PathExists(model_file) ||
+      !inference::analysis::PathExists(params_file)) {
+    return false;
+  }
+
+  std::ifstream fin(model_file, std::ios::in | std::ios::binary);
+  std::stringstream buffer;
+  buffer << fin.rdbuf();
+  framework::proto::ProgramDesc proto;
+  if (!fin.is_open() || !proto.ParseFromString(buffer.str())) {
+    LOG(WARNING) << "Failed to parse the cached program " << model_file;
+    return false;
+  }
+  // The memory arena is planned from the blocks saved with the program, as
+  // memory_optimize_pass is not run again.
+  std::string blocks_file = entry + "/memory_blocks";
+  Argument::memory_blocks_t memory_blocks;
+  if (inference::analysis::PathExists(blocks_file) &&
+      !ReadMemoryBlocks(blocks_file, &memory_blocks)) {
+    LOG(WARNING) << "Failed to parse the cached memory blocks " << blocks_file;
+    return false;
+  }
+  inference_program_.reset(new framework::ProgramDesc(proto));
+  executor_->CreateVariables(*inference_program_, 0, true, sub_scope_);
+  if (!LoadParameters(params_file)) return false;
+  if (platform::is_cpu_place(place_)) {
+    memory_blocks_ = std::move(memory_blocks);
+  }
+  return true;
+}
+
+void AnalysisPredictor::SaveOptimProgramCache(const std::string &entry) {
+  // Save into a temporary directory and rename it, so that the predictors in
+  // other processes never see a partial entry.
+  auto stamp =
+      std::chrono::high_resolution_clock::now().time_since_epoch().count();
+  std::string tmp = entry + ".tmp" + std::to_string(stamp) + "_" +
+                    std::to_string(predictor_id_);
+  if (MKDIR(tmp.c_str()) == -1) {
+    LOG(WARNING) << "Can not create the optimize cache directory " << tmp;
+    return;
+  }
+  SaveOptimModel(tmp);
+  if ((!memory_blocks_.empty() &&
+       !WriteMemoryBlocks(tmp + "/memory_blocks", memory_blocks_)) ||
+      std::rename(tmp.c_str(), entry.c_str()) != 0) {
+    // Failed to write, or another predictor has saved the same entry.
+    std::remove((tmp + "/model").c_str());
+    std::remove((tmp + "/params").c_str());
+    std::remove((tmp + "/memory_blocks").c_str());
+    std::remove(tmp.c_str());
+    return;
+  }
+  LOG(INFO) << "Save the optimized program to " << entry;
+}
+
 uint64_t AnalysisPredictor::TryShrinkMemory() {
   ClearIntermediateTensor();
   return paddle::memory::Release(place_);
@@ -1093,6 +1366,7 @@ std::unique_ptr<PaddlePredictor> AnalysisPredictor::Clone() {
   std::lock_guard<std::mutex> lk(clone_mutex_);
   auto *x = new AnalysisPredictor(config_);
   x->Init(scope_, inference_program_);
+  x->memory_blocks_ = memory_blocks_;
   return std::unique_ptr<PaddlePredictor>(x);
 }
 
@@ -17,6 +17,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/framework/op_compatible_info.h"
@@ -25,6 +26,7 @@
 #include "paddle/fluid/inference/api/details/reset_tensor_array.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/string/printf.h"
 #ifdef PADDLE_WITH_TESTING
 #include <gtest/gtest.h>
@@ -291,6 +293,36 @@ class AnalysisPredictor : public PaddlePredictor {
   /// \return Whether the function executed successfully
   ///
   bool LoadParameters();
+  ///
+  /// \brief Load model parameters from the combined params file.
+  ///
+  /// \param[in] params_file the combined params file, the separated params in
+  /// the model directory are loaded if it is empty
+  /// \return Whether the function executed successfully
+  ///
+  bool LoadParameters(const std::string &params_file);
+  ///
+  /// \brief Get the entry of the optimized program cache for this predictor.
+  ///
+  /// The entry is keyed by the hash of the model files, the config, the IR
+  /// passes and the CPU ISA.
+  ///
+  /// \return The entry directory, empty if the program should not be cached
+  ///
+  std::string GetOptimProgramCacheEntry();
+  ///
+  /// \brief Load the optimized program and params from the cache entry.
+  ///
+  /// \param[in] entry the cache entry directory
+  /// \return Whether the cache is hit
+  ///
+  bool LoadOptimProgramCache(const std::string &entry);
+  ///
+  /// \brief Save the optimized program and params to the cache entry.
+  ///
+  /// \param[in] entry the cache entry directory
+  ///
+  void SaveOptimProgramCache(const std::string &entry);
 
   ///
   /// \brief Prepare input data, only used in Run()
@@ -347,6 +379,18 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   void MkldnnPostReset();
 
+  ///
+  /// \brief Place the tensors reused by the memory optimization in one arena.
+  ///
+  /// The offsets are planned for the batch size rounded up to a power of 2,
+  /// they are replanned when a larger batch comes. The tensors that outgrew
+  /// their slots in the last run got memory from the allocator, their blocks
+  /// are enlarged to the sizes they took and replanned into the arena.
+  ///
+  /// \param[in] batch_size the batch size of the inputs
+  ///
+  void PrepareMemoryArena(int batch_size);
+
 #if PADDLE_WITH_TENSORRT
   ///
   /// \brief save calibration table
@@ -371,6 +415,8 @@ class AnalysisPredictor : public PaddlePredictor {
   FRIEND_TEST(AnalysisPredictor, analysis_off);
   FRIEND_TEST(AnalysisPredictor, analysis_on);
   FRIEND_TEST(AnalysisPredictor, with_gpu);
+  FRIEND_TEST(AnalysisPredictor, memory_arena);
+  FRIEND_TEST(AnalysisPredictor, optim_program_cache);
 #endif
 
  private:
@@ -410,6 +456,14 @@ class AnalysisPredictor : public PaddlePredictor {
   const size_t max_shape_collect_count_{1000};
   int need_collect_var_shapes_{-1};  // -1 for default, 0 for false, 1 for true.
   std::vector<std::map<std::string, std::vector<int>>> batch_var_shapes_;
+  // The memory arena of the reused tensors, only used on CPU.
+  Argument::memory_blocks_t memory_blocks_;
+  std::shared_ptr<memory::Allocation> memory_arena_;
+  // The slices of the arena given to the tensors of the blocks.
+  std::unordered_map<std::string, const memory::Allocation *> arena_slices_;
+  int arena_batch_size_{0};
+  // Whether the optimized program is loaded from the cache.
+  bool optim_program_cache_hit_{false};
   int predictor_id_;
 
  private:
@@ -15,9 +15,12 @@
 #include "paddle/fluid/inference/api/analysis_predictor.h"
 #include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
 #include <thread>  // NOLINT
 #include "paddle/fluid/framework/ir/pass.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/tests/api/tester_helper.h"
@@ -195,6 +198,176 @@ TEST(AnalysisPredictor, Clone) {
   }
 }
 
+TEST(AnalysisPredictor, optim_program_cache) {
+  const std::string cache_dir = FLAGS_dirname + "/_optim_program_cache_test";
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.SwitchIrOptim(true);
+  config.EnableOptimProgramCache();
+  config.SetOptimCacheDir(cache_dir);
+  config.EnableMemoryOptim();
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  // Removes the entry and then the cache directory, which fails if anything
+  // else is left in it.
+  auto remove_cache = [&](const std::string& entry) {
+    std::remove((entry + "/model").c_str());
+    std::remove((entry + "/params").c_str());
+    std::remove((entry + "/memory_blocks").c_str());
+    std::remove(entry.c_str());
+    return std::remove(cache_dir.c_str());
+  };
+
+  // The first predictor optimizes the program and saves it, the second one
+  // loads it from the cache, with the memory arena planned by the first one.
+  std::vector<PaddleTensor> outputs, cached_outputs;
+  std::string program, cached_program, entry;
+  std::vector<std::string> block_names;
+  {
+    auto _predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    auto* predictor = static_cast<AnalysisPredictor*>(_predictor.get());
+    entry = predictor->GetOptimProgramCacheEntry();
+    ASSERT_FALSE(entry.empty());
+    if (predictor->optim_program_cache_hit_) {
+      // Left by a former run, start over with an empty cache.
+      ASSERT_EQ(remove_cache(entry), 0);
+      _predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+      predictor = static_cast<AnalysisPredictor*>(_predictor.get());
+    }
+    EXPECT_FALSE(predictor->optim_program_cache_hit_);
+    ASSERT_TRUE(inference::analysis::PathExists(entry + "/model"));
+    ASSERT_TRUE(inference::analysis::PathExists(entry + "/params"));
+    program = predictor->GetSerializedProgram();
+    for (auto& block : predictor->memory_blocks_) {
+      block_names.push_back(block.name);
+    }
+    ASSERT_FALSE(block_names.empty());
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  }
+  {
+    auto _predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+    auto* predictor = static_cast<AnalysisPredictor*>(_predictor.get());
+    EXPECT_EQ(predictor->GetOptimProgramCacheEntry(), entry);
+    EXPECT_TRUE(predictor->optim_program_cache_hit_);
+    cached_program = predictor->GetSerializedProgram();
+    std::vector<std::string> cached_block_names;
+    for (auto& block : predictor->memory_blocks_) {
+      cached_block_names.push_back(block.name);
+    }
+    EXPECT_EQ(cached_block_names, block_names);
+    ASSERT_TRUE(predictor->Run(inputs, &cached_outputs));
+    EXPECT_NE(predictor->memory_arena_.get(), nullptr);
+  }
+  EXPECT_EQ(remove_cache(entry), 0);
+  ASSERT_EQ(program, cached_program);
+  inference::CompareResult(outputs, cached_outputs);
+}
+
+TEST(AnalysisPredictor, memory_arena) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  config.SwitchIrOptim(true);
+  config.EnableMemoryOptim();
+
+  auto _predictor = CreatePaddlePredictor<AnalysisConfig>(config);
+  auto* predictor = static_cast<AnalysisPredictor*>(_predictor.get());
+  ASSERT_FALSE(predictor->memory_blocks_.empty());
+
+  int64_t data[4] = {1, 2, 3, 4};
+  PaddleTensor tensor;
+  tensor.shape = std::vector<int>({4, 1});
+  tensor.data.Reset(data, sizeof(data));
+  tensor.dtype = PaddleDType::INT64;
+  std::vector<PaddleTensor> inputs(4, tensor);
+
+  auto naive_predictor =
+      CreatePaddlePredictor<NativeConfig>(config.ToNativeConfig());
+  std::vector<PaddleTensor> naive_outputs;
+  ASSERT_TRUE(naive_predictor->Run(inputs, &naive_outputs));
+
+  // The holders of the tensors of the blocks, and the number of the tensors
+  // that do not fit in their slots.
+  auto holders = [&](int* outgrown) {
+    std::vector<const memory::Allocation*> result;
+    *outgrown = 0;
+    for (auto& block : predictor->memory_blocks_) {
+      auto* var = predictor->sub_scope_->FindVar(block.name);
+      if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+      auto& t = var->Get<framework::LoDTensor>();
+      result.push_back(t.Holder().get());
+      auto iter = predictor->arena_slices_.find(block.name);
+      if (t.IsInitialized() && iter != predictor->arena_slices_.end() &&
+          t.Holder().get() != iter->second &&
+          t.numel() * framework::SizeOfType(t.type()) > iter->second->size()) {
+        ++(*outgrown);
+      }
+    }
+    return result;
+  };
+
+  std::vector<PaddleTensor> outputs;
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  inference::CompareTensor(outputs.front(), naive_outputs.front());
+  int outgrown = 0;
+  auto first_holders = holders(&outgrown);
+  EXPECT_EQ(outgrown, 0);
+  auto* arena = predictor->memory_arena_.get();
+  ASSERT_NE(arena, nullptr);
+
+  // The blocks alive at the same time do not share memory, so the arena is
+  // at most all the aligned blocks together.
+  size_t total_size = 0;
+  for (auto& block : predictor->memory_blocks_) {
+    total_size += (block.Size(predictor->arena_batch_size_) + 63) / 64 * 64;
+  }
+  std::unordered_map<std::string, size_t> offsets;
+  size_t arena_size = inference::analysis::MemoryOptimizePass::PlanOffsets(
+      predictor->memory_blocks_, predictor->arena_batch_size_, &offsets);
+  LOG(INFO) << "memory arena: " << arena_size << " bytes for "
+            << predictor->memory_blocks_.size() << " blocks of " << total_size
+            << " bytes";
+  EXPECT_LE(arena_size, total_size);
+  EXPECT_GE(arena->size(), arena_size);
+
+  // The later runs of the same batch size do not allocate the tensors again.
+  for (int i = 0; i < 5; ++i) {
+    ASSERT_TRUE(predictor->Run(inputs, &outputs));
+    inference::CompareTensor(outputs.front(), naive_outputs.front());
+    EXPECT_EQ(predictor->memory_arena_.get(), arena);
+    EXPECT_EQ(holders(&outgrown), first_holders);
+  }
+
+  // Shrink the blocks, the tensors outgrow their slots in the next run and
+  // are planned back into the arena in the run after it.
+  for (auto& block : predictor->memory_blocks_) {
+    block.sizes.assign(1, 1);
+    block.min_size = 0;
+  }
+  predictor->arena_batch_size_ = 0;
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  inference::CompareTensor(outputs.front(), naive_outputs.front());
+  holders(&outgrown);
+  EXPECT_GT(outgrown, 0);
+
+  ASSERT_TRUE(predictor->Run(inputs, &outputs));
+  inference::CompareTensor(outputs.front(), naive_outputs.front());
+  holders(&outgrown);
+  EXPECT_EQ(outgrown, 0);
+  size_t grown_size = 0;
+  for (auto& block : predictor->memory_blocks_) {
+    grown_size = std::max(grown_size, block.min_size);
+  }
+  EXPECT_GT(grown_size, 1UL);
+}
+
 // This function is not released yet, will fail on some machine.
 // TODO(Superjomn) Turn on it latter.
 /*
@@ -510,6 +683,30 @@ TEST(AnalysisPredictor, bf16_pass_strategy) {
   passStrategy.EnableMkldnnBfloat16();
 }
 
+#if !defined(__APPLE__) && !defined(_WIN32)
+TEST(AnalysisPredictor, cpu_fusion_group_pass_strategy) {
+  AnalysisConfig config;
+  config.SetModel(FLAGS_dirname);
+  config.DisableGpu();
+  auto count = [&config] {
+    const auto& passes = config.pass_builder()->AllPasses();
+    return std::count(passes.begin(), passes.end(), "fusion_group_pass");
+  };
+  // The pass compiles code with the host compiler, so it is off by default.
+  ASSERT_EQ(config.cpu_fusion_group_enabled(), false);
+  ASSERT_EQ(count(), 0);
+
+  config.EnableCpuFusionGroup();
+  ASSERT_EQ(count(), 1);
+  const auto& passes = config.pass_builder()->AllPasses();
+  ASSERT_EQ(passes.back(), "runtime_context_cache_pass");
+  ASSERT_EQ(passes[passes.size() - 2], "fusion_group_pass");
+
+  config.EnableMemoryOptim();
+  ASSERT_EQ(count(), 1);
+}
+#endif
+
 }  // namespace paddle
 
 namespace paddle_infer {
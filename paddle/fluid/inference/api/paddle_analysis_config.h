@@ -524,6 +524,37 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Turn on the cache of the optimized program. The optimized program
+  /// and params are saved in the optimization cache directory, and loaded
+  /// directly by the next predictor with the same model, config, CPU ISA and
+  /// Paddle version. The TensorRT, Lite and MKLDNN quantizer paths are not cached.
+  ///
+  /// \param x Whether to cache the optimized program.
+  ///
+  void EnableOptimProgramCache(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the optimized program is cached.
+  ///
+  /// \return bool Whether the optimized program is cached.
+  ///
+  bool optim_program_cache_enabled() const;
+
+  ///
+  /// \brief Turn on fusion_group_pass on CPU. It compiles the fused
+  /// elementwise ops with the host compiler set by
+  /// FLAGS_fusion_group_cpu_compiler when the predictor is created.
+  ///
+  /// \param x Whether to run fusion_group_pass on CPU.
+  ///
+  void EnableCpuFusionGroup(bool x = true);
+  ///
+  /// \brief A boolean state telling whether fusion_group_pass runs on CPU.
+  ///
+  /// \return bool Whether fusion_group_pass runs on CPU.
+  ///
+  bool cpu_fusion_group_enabled() const;
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -629,6 +660,9 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool use_optim_program_cache_{false};
+
+  bool use_cpu_fusion_group_{false};
 
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
@@ -175,6 +175,8 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
   // not be damaged by smaller ones.
   passes_.assign({"simplify_with_basic_ops_pass",  //
                   "layer_norm_fuse_pass",
+                  "embedding_eltwise_layernorm_fuse_pass",  //
+                  "multihead_matmul_fuse_pass_v2",          //
                   "attention_lstm_fuse_pass",       //
                   "seqconv_eltadd_relu_fuse_pass",  //
                   // "seqpool_concat_fuse_pass",    //
@@ -191,6 +193,10 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
                   "flatten2_matmul_fuse_pass",               //
                   "map_matmul_to_mul_pass",                  //
                   "fc_fuse_pass",                            //
+                  "fc_elementwise_layernorm_fuse_pass",      //
+                  // only fuses graphs already handled by the embedding and
+                  // multihead fuse passes above.
+                  "skip_layernorm_fuse_pass",                //
                   "repeated_fc_relu_fuse_pass",              //
                   "squared_mat_sub_fuse_pass",               //
                   "conv_bn_fuse_pass",                       //
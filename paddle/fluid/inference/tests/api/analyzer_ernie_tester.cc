@@ -177,13 +177,19 @@ TEST(Analyzer_Ernie, fuse_statis) {
   auto fuse_statis = GetFuseStatis(
       static_cast<AnalysisPredictor *>(predictor.get()), &num_ops);
   ASSERT_TRUE(fuse_statis.count("fc_fuse"));
+  ASSERT_TRUE(fuse_statis.count("multihead_matmul_fuse_v2"));
+  ASSERT_TRUE(fuse_statis.count("embedding_eltwise_layernorm_fuse"));
   LOG(INFO) << "num_ops: " << num_ops;
+  // The q, k and v projections of every layer are fused into multihead_matmul
+  // before fc_fuse_pass runs.
   if (FLAGS_ernie_large) {
-    ASSERT_EQ(fuse_statis.at("fc_fuse"), 146);
-    EXPECT_EQ(num_ops, 859);
-  } else {
+    ASSERT_EQ(fuse_statis.at("multihead_matmul_fuse_v2"), 24);
     ASSERT_EQ(fuse_statis.at("fc_fuse"), 74);
-    EXPECT_EQ(num_ops, 295);
+    EXPECT_EQ(num_ops, 398);
+  } else {
+    ASSERT_EQ(fuse_statis.at("multihead_matmul_fuse_v2"), 12);
+    ASSERT_EQ(fuse_statis.at("fc_fuse"), 38);
+    EXPECT_EQ(num_ops, 62);
   }
 }
 
@@ -19,17 +19,58 @@
 #include <fcntl.h>
 #include <stdlib.h>
 #include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
 #include <random>
 #include <string>
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "paddle/fluid/platform/enforce.h"
 
+DEFINE_bool(use_shm_pool, false,
+            "Whether to recycle the shared memory segments through which "
+            "the DataLoader workers transfer tensors to the main process.");
+DEFINE_uint64(shm_pool_max_mb, 64,
+              "The max size in MB of the shared memory segments kept by the "
+              "pool of each DataLoader worker.");
+
 namespace paddle {
 namespace memory {
 namespace allocation {
 
+namespace {
+
+// The header of a pooled segment, shared by the writer and reader processes.
+struct SegmentHeader {
+  // Set by the writer when handing out the segment, and reset by the reader
+  // when releasing it.
+  std::atomic<int32_t> in_use;
+  // Set by the writer when it exits, then the segment is unlinked by whoever
+  // sees it both closed and not in use.
+  std::atomic<int32_t> closed;
+};
+
+static_assert(sizeof(SegmentHeader) <= kMemoryMapSegmentHeaderSize,
+              "The header of the pooled segment is too large.");
+
+inline SegmentHeader *GetSegmentHeader(void *base) {
+  return reinterpret_cast<SegmentHeader *>(base);
+}
+
+// Power of 2, no smaller than a page.
+size_t GetSegmentSizeClass(size_t size) {
+  size_t size_class = 4096;
+  while (size_class < size) size_class <<= 1;
+  return size_class;
+}
+
+}  // namespace
+
 MemoryMapWriterAllocation::~MemoryMapWriterAllocation() {
+  // The pooled segment stays mapped until MemoryMapAllocationPool::Clear.
+  if (pooled_) return;
   PADDLE_ENFORCE_NE(
       munmap(this->ptr(), this->size()), -1,
       platform::errors::Unavailable("could not unmap the shared memory file %s",
@@ -37,6 +78,27 @@ MemoryMapWriterAllocation::~MemoryMapWriterAllocation() {
 }
 
 MemoryMapReaderAllocation::~MemoryMapReaderAllocation() {
+  if (pooled_) {
+    // Hand the segment back to the writer, or unlink it if the writer has
+    // exited. The name stays in MemoryMapFdSet while the writer may reuse
+    // the segment, so that it is still unlinked by MemoryMapFdSet::Clear if
+    // the writer is killed before it unlinks its free segments.
+    void *base = static_cast<uint8_t *>(this->ptr()) -
+                 kMemoryMapSegmentHeaderSize;
+    auto *header = GetSegmentHeader(base);
+    if (header->closed.load()) {
+      MemoryMapFdSet::Instance().Remove(this->ipc_name());
+      shm_unlink(this->ipc_name().c_str());
+    }
+    header->in_use.store(0);
+    PADDLE_ENFORCE_NE(
+        munmap(base, this->size() + kMemoryMapSegmentHeaderSize), -1,
+        platform::errors::Unavailable(
+            "could not unmap the shared memory file %s", this->ipc_name()));
+    VLOG(3) << "~MemoryMapReaderAllocation: release pooled "
+            << this->ipc_name();
+    return;
+  }
   PADDLE_ENFORCE_NE(
       munmap(this->ptr(), this->size()), -1,
       platform::errors::Unavailable("could not unmap the shared memory file %s",
@@ -64,6 +126,10 @@ std::string GetIPCName() {
 
 std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
     size_t size) {
+  if (FLAGS_use_shm_pool) {
+    return MemoryMapAllocationPool::Instance().Allocate(size);
+  }
+
   const std::string &ipc_name = GetIPCName();
   int flags = O_RDWR | O_CREAT;
 
@@ -85,7 +151,24 @@ std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
 }
 
 std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
-    const std::string &ipc_name, size_t size) {
+    const std::string &ipc_name, size_t size, bool pooled) {
+  if (pooled) {
+    // The header of the pooled segment is written on release.
+    int fd = shm_open(ipc_name.c_str(), O_RDWR, 0644);
+    PADDLE_ENFORCE_NE(
+        fd, -1, platform::errors::Unavailable("File descriptor %s open failed",
+                                              ipc_name.c_str()));
+    void *base = mmap(NULL, size + kMemoryMapSegmentHeaderSize,
+                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    PADDLE_ENFORCE_NE(base, MAP_FAILED,
+                      platform::errors::Unavailable(
+                          "Memory map failed when rebuild shared memory."));
+    close(fd);
+    return std::make_shared<MemoryMapReaderAllocation>(
+        static_cast<uint8_t *>(base) + kMemoryMapSegmentHeaderSize, size,
+        ipc_name, true);
+  }
+
   int fd = shm_open(ipc_name.c_str(), O_RDONLY, 0644);
   PADDLE_ENFORCE_NE(
       fd, -1, platform::errors::Unavailable("File descriptor %s open failed",
@@ -99,6 +182,120 @@ std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
   return std::make_shared<MemoryMapReaderAllocation>(ptr, size, ipc_name);
 }
 
+MemoryMapAllocationPool &MemoryMapAllocationPool::Instance() {  // NOLINT
+  static MemoryMapAllocationPool pool;
+  return pool;
+}
+
+std::shared_ptr<MemoryMapWriterAllocation> MemoryMapAllocationPool::Allocate(
+    size_t size) {
+  size_t size_class = GetSegmentSizeClass(size);
+  std::lock_guard<std::mutex> guard(mtx_);
+  if (pid_ != getpid()) {
+    // The segments inherited by a forked child belong to the parent.
+    segments_.clear();
+    total_bytes_ = 0;
+    pid_ = getpid();
+  }
+
+  // Only the writer sets in_use, under mtx_, so a free segment can not be
+  // taken by others between the check and the set.
+  auto &segments = segments_[size_class];
+  for (auto &segment : segments) {
+    auto *header = GetSegmentHeader(segment.base);
+    if (header->in_use.load() == 0) {
+      header->in_use.store(1);
+      VLOG(4) << "MemoryMapAllocationPool: reuse " << segment.ipc_name;
+      return std::make_shared<MemoryMapWriterAllocation>(
+          static_cast<uint8_t *>(segment.base) + kMemoryMapSegmentHeaderSize,
+          size, segment.ipc_name, true);
+    }
+  }
+
+  size_t segment_size = size_class + kMemoryMapSegmentHeaderSize;
+  size_t max_bytes = FLAGS_shm_pool_max_mb << 20;
+  if (total_bytes_ + segment_size > max_bytes) {
+    ReleaseFreeSegments(max_bytes > segment_size ? max_bytes - segment_size
+                                                 : 0);
+  }
+
+  const std::string &ipc_name = GetIPCName();
+  int fd = shm_open(ipc_name.c_str(), O_RDWR | O_CREAT, 0644);
+  PADDLE_ENFORCE_NE(
+      fd, -1, platform::errors::Unavailable("File descriptor %s open failed",
+                                            ipc_name.c_str()));
+  PADDLE_ENFORCE_EQ(ftruncate(fd, segment_size), 0,
+                    platform::errors::Unavailable(
+                        "Fruncate a file to a specified length failed!"));
+  void *base =
+      mmap(NULL, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  PADDLE_ENFORCE_NE(base, MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Memory map failed when create shared memory."));
+  close(fd);
+
+  auto *header = new (base) SegmentHeader();
+  header->in_use.store(1);
+  header->closed.store(0);
+  segments.push_back(Segment{ipc_name, base, segment_size});
+  total_bytes_ += segment_size;
+  VLOG(3) << "MemoryMapAllocationPool: create " << ipc_name << " of "
+          << segment_size << " bytes, pool size: " << total_bytes_;
+
+  return std::make_shared<MemoryMapWriterAllocation>(
+      static_cast<uint8_t *>(base) + kMemoryMapSegmentHeaderSize, size,
+      ipc_name, true);
+}
+
+void MemoryMapAllocationPool::ReleaseFreeSegments(size_t max_bytes) {
+  for (auto it = segments_.begin();
+       it != segments_.end() && total_bytes_ > max_bytes; ++it) {
+    auto &segments = it->second;
+    for (size_t i = 0; i < segments.size() && total_bytes_ > max_bytes;) {
+      auto &segment = segments[i];
+      if (GetSegmentHeader(segment.base)->in_use.load() != 0) {
+        ++i;
+        continue;
+      }
+      shm_unlink(segment.ipc_name.c_str());
+      munmap(segment.base, segment.size);
+      total_bytes_ -= segment.size;
+      segments[i] = segments.back();
+      segments.pop_back();
+    }
+  }
+}
+
+void MemoryMapAllocationPool::Clear() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  if (pid_ != getpid()) {
+    segments_.clear();
+    total_bytes_ = 0;
+    return;
+  }
+  for (auto &item : segments_) {
+    for (auto &segment : item.second) {
+      auto *header = GetSegmentHeader(segment.base);
+      header->closed.store(1);
+      if (header->in_use.load() == 0) {
+        shm_unlink(segment.ipc_name.c_str());
+      }
+      munmap(segment.base, segment.size);
+    }
+  }
+  VLOG(3) << "PID: " << getpid() << ", MemoryMapAllocationPool: clear "
+          << total_bytes_ << " bytes";
+  segments_.clear();
+  total_bytes_ = 0;
+}
+
+size_t MemoryMapAllocationPool::Size() {
+  std::lock_guard<std::mutex> guard(mtx_);
+  return total_bytes_;
+}
+
+MemoryMapAllocationPool::~MemoryMapAllocationPool() { Clear(); }
+
 MemoryMapFdSet &MemoryMapFdSet::Instance() {  // NOLINT
   static MemoryMapFdSet set;
   return set;
@@ -16,11 +16,14 @@
 
 #ifndef _WIN32
 
+#include <sys/types.h>
+#include <map>
 #include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "paddle/fluid/memory/allocation/allocator.h"
 
@@ -28,41 +31,100 @@ namespace paddle {
 namespace memory {
 namespace allocation {
 
+// NOTE: A pooled allocation lives in a shared memory segment recycled by
+// MemoryMapAllocationPool. The segment starts with a header, and the data
+// follows at the offset kMemoryMapSegmentHeaderSize.
+constexpr size_t kMemoryMapSegmentHeaderSize = 64;
+
 class MemoryMapWriterAllocation : public Allocation {
  public:
   explicit MemoryMapWriterAllocation(void *ptr, size_t size,
-                                     std::string ipc_name)
+                                     std::string ipc_name, bool pooled = false)
       : Allocation(ptr, size, platform::CPUPlace()),
-        ipc_name_(std::move(ipc_name)) {}
+        ipc_name_(std::move(ipc_name)),
+        pooled_(pooled) {}
 
   inline const std::string &ipc_name() const { return ipc_name_; }
 
+  inline bool pooled() const { return pooled_; }
+
   ~MemoryMapWriterAllocation() override;
 
  private:
   std::string ipc_name_;
+  bool pooled_;
 };
 
 class MemoryMapReaderAllocation : public Allocation {
  public:
   explicit MemoryMapReaderAllocation(void *ptr, size_t size,
-                                     std::string ipc_name)
+                                     std::string ipc_name, bool pooled = false)
       : Allocation(ptr, size, platform::CPUPlace()),
-        ipc_name_(std::move(ipc_name)) {}
+        ipc_name_(std::move(ipc_name)),
+        pooled_(pooled) {}
 
   inline const std::string &ipc_name() const { return ipc_name_; }
 
+  inline bool pooled() const { return pooled_; }
+
   ~MemoryMapReaderAllocation() override;
 
  private:
   std::string ipc_name_;
+  bool pooled_;
 };
 
+// Allocate from MemoryMapAllocationPool if FLAGS_use_shm_pool is set,
+// otherwise create a new shared memory file for the allocation.
 std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
     size_t size);
 
 std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
-    const std::string &ipc_name, size_t size);
+    const std::string &ipc_name, size_t size, bool pooled = false);
+
+// The shared memory segments of a writer process (e.g. a DataLoader worker),
+// grouped by size class. When the reader process releases its
+// MemoryMapReaderAllocation, the segment is marked free in its header instead
+// of being unlinked, and the writer hands it out again for the next tensor of
+// the same size class, which saves the shm_open/ftruncate/mmap/munmap calls
+// and the page faults on fresh pages. The reader keeps the names of the
+// pooled segments in its MemoryMapFdSet, so the segments of a writer that is
+// killed are still unlinked when the reader exits. The pool is off by
+// default, and holds at most FLAGS_shm_pool_max_mb of free segments.
+class MemoryMapAllocationPool {
+ public:
+  static MemoryMapAllocationPool &Instance();  // NOLINT
+
+  std::shared_ptr<MemoryMapWriterAllocation> Allocate(size_t size);
+
+  // Unmap all the segments. The segments still used by the reader process
+  // are unlinked by the reader when it releases them. Called when the
+  // writer process exits.
+  void Clear();
+
+  size_t Size();
+
+  ~MemoryMapAllocationPool();
+
+ private:
+  struct Segment {
+    std::string ipc_name;
+    void *base;
+    size_t size;
+  };
+
+  MemoryMapAllocationPool() = default;
+
+  // Unlink and unmap the free segments, until the pool holds at most
+  // `max_bytes`.
+  void ReleaseFreeSegments(size_t max_bytes);
+
+  std::map<size_t, std::vector<Segment>> segments_;
+  size_t total_bytes_{0};
+  // The process that creates the segments.
+  pid_t pid_{-1};
+  std::mutex mtx_;
+};
 
 class MemoryMapFdSet {
  public:
@@ -16,8 +16,19 @@
 
 #include "paddle/fluid/memory/allocation/mmap_allocator.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>  // NOLINT
+#include <csignal>
+#include <cstring>
+
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 
+DECLARE_bool(use_shm_pool);
+
 namespace paddle {
 namespace memory {
 namespace allocation {
@@ -36,13 +47,180 @@ TEST(MemoryMapAllocation, test_allocation_base) {
   pid_t fpid = fork();
   if (fpid == 0) {
     // 4. rebuild reader holder
-    auto mmap_reader_holder =
-        RebuildMemoryMapReaderAllocation(ipc_name, data_size);
-    auto* reader_ptr = static_cast<int32_t*>(mmap_reader_holder->ptr());
-    for (int32_t i = 0; i < 1024; ++i) {
-      ASSERT_EQ(reader_ptr[i], i);
+    bool equal = true;
+    {
+      auto mmap_reader_holder = RebuildMemoryMapReaderAllocation(
+          ipc_name, data_size, mmap_writer_holder->pooled());
+      auto* reader_ptr = static_cast<int32_t*>(mmap_reader_holder->ptr());
+      for (int32_t i = 0; i < 1024; ++i) {
+        equal = equal && reader_ptr[i] == i;
+      }
     }
+    _exit(equal ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(fpid, &status, 0), fpid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(MemoryMapAllocationPool, test_reuse) {
+  FLAGS_use_shm_pool = true;
+  MemoryMapAllocationPool::Instance().Clear();
+  size_t data_size = 4UL * 1024;
+  auto writer_holder = AllocateMemoryMapWriterAllocation(data_size);
+  ASSERT_TRUE(writer_holder->pooled());
+  std::string ipc_name = writer_holder->ipc_name();
+  auto* writer_ptr = static_cast<int32_t*>(writer_holder->ptr());
+  for (int32_t i = 0; i < 1024; ++i) {
+    writer_ptr[i] = i;
+  }
+
+  // The segment is not reused until the reader releases it.
+  auto reader_holder =
+      RebuildMemoryMapReaderAllocation(ipc_name, data_size, true);
+  auto* reader_ptr = static_cast<int32_t*>(reader_holder->ptr());
+  for (int32_t i = 0; i < 1024; ++i) {
+    ASSERT_EQ(reader_ptr[i], i);
+  }
+  auto other_holder = AllocateMemoryMapWriterAllocation(data_size);
+  ASSERT_NE(other_holder->ipc_name(), ipc_name);
+
+  // The released segment is reused for the allocations of the same size
+  // class.
+  reader_holder.reset();
+  auto reused_holder = AllocateMemoryMapWriterAllocation(data_size - 128);
+  ASSERT_EQ(reused_holder->ipc_name(), ipc_name);
+  ASSERT_EQ(reused_holder->size(), data_size - 128);
+
+  for (auto* holder : {other_holder.get(), reused_holder.get()}) {
+    RebuildMemoryMapReaderAllocation(holder->ipc_name(), holder->size(), true);
+  }
+  MemoryMapAllocationPool::Instance().Clear();
+  ASSERT_EQ(MemoryMapAllocationPool::Instance().Size(), 0UL);
+}
+
+TEST(MemoryMapAllocationPool, test_killed_writer) {
+  FLAGS_use_shm_pool = true;
+  MemoryMapAllocationPool::Instance().Clear();
+  int to_main[2];
+  int to_worker[2];
+  ASSERT_EQ(pipe(to_main), 0);
+  ASSERT_EQ(pipe(to_worker), 0);
+
+  // The worker pools a segment, and is killed without unlinking it.
+  size_t data_size = 4UL * 1024;
+  pid_t pid = fork();
+  if (pid == 0) {
+    auto holder = AllocateMemoryMapWriterAllocation(data_size);
+    char name[64] = {0};
+    std::strncpy(name, holder->ipc_name().c_str(), sizeof(name) - 1);
+    char ack;
+    if (write(to_main[1], name, sizeof(name)) != sizeof(name) ||
+        read(to_worker[0], &ack, 1) != 1) {
+      _exit(1);
+    }
+    pause();
+    _exit(0);
+  }
+
+  char name[64];
+  ASSERT_EQ(read(to_main[0], name, sizeof(name)),
+            static_cast<ssize_t>(sizeof(name)));
+  std::string ipc_name = name;
+  MemoryMapFdSet::Instance().Insert(ipc_name);
+  RebuildMemoryMapReaderAllocation(ipc_name, data_size, true);
+  char ack = 0;
+  ASSERT_EQ(write(to_worker[1], &ack, 1), 1);
+  kill(pid, SIGKILL);
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+
+  // The released segment is still registered in the main process, and
+  // unlinked when it exits.
+  int fd = shm_open(ipc_name.c_str(), O_RDONLY, 0644);
+  ASSERT_NE(fd, -1);
+  close(fd);
+  MemoryMapFdSet::Instance().Clear();
+  ASSERT_EQ(shm_open(ipc_name.c_str(), O_RDONLY, 0644), -1);
+  for (int fd : {to_main[0], to_main[1], to_worker[0], to_worker[1]}) {
+    close(fd);
+  }
+}
+
+struct BatchMessage {
+  char ipc_name[64];
+  int pooled;
+};
+
+// A forked worker writes `num_batches` batches into shared memory and sends
+// their names through a pipe, at most `prefetch` batches ahead of the main
+// process, as the DataLoader does. Returns the batches per second.
+double TransferBatches(bool use_pool, int num_batches, size_t batch_size,
+                       int prefetch) {
+  FLAGS_use_shm_pool = use_pool;
+  int to_main[2];
+  int to_worker[2];
+  PADDLE_ENFORCE_EQ(pipe(to_main), 0, platform::errors::Unavailable(
+                                          "Failed to create the pipe."));
+  PADDLE_ENFORCE_EQ(pipe(to_worker), 0, platform::errors::Unavailable(
+                                            "Failed to create the pipe."));
+
+  auto start = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid == 0) {
+    for (int i = 0; i < num_batches; ++i) {
+      char ack;
+      if (i >= prefetch && read(to_worker[0], &ack, 1) != 1) _exit(1);
+      auto holder = AllocateMemoryMapWriterAllocation(batch_size);
+      std::memset(holder->ptr(), i & 0xff, batch_size);
+      BatchMessage msg;
+      std::strncpy(msg.ipc_name, holder->ipc_name().c_str(),
+                   sizeof(msg.ipc_name) - 1);
+      msg.ipc_name[sizeof(msg.ipc_name) - 1] = '\0';
+      msg.pooled = holder->pooled();
+      if (write(to_main[1], &msg, sizeof(msg)) != sizeof(msg)) _exit(1);
+    }
+    MemoryMapAllocationPool::Instance().Clear();
+    _exit(0);
+  }
+
+  for (int i = 0; i < num_batches; ++i) {
+    BatchMessage msg;
+    EXPECT_EQ(read(to_main[0], &msg, sizeof(msg)),
+              static_cast<ssize_t>(sizeof(msg)));
+    auto holder = RebuildMemoryMapReaderAllocation(msg.ipc_name, batch_size,
+                                                   msg.pooled != 0);
+    auto* data = static_cast<uint8_t*>(holder->ptr());
+    EXPECT_EQ(data[0], i & 0xff);
+    EXPECT_EQ(data[batch_size - 1], i & 0xff);
+    holder.reset();
+    char ack = 0;
+    EXPECT_EQ(write(to_worker[1], &ack, 1), 1);
+  }
+  int status = 0;
+  waitpid(pid, &status, 0);
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+  auto elapsed = std::chrono::duration<double>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  for (int fd : {to_main[0], to_main[1], to_worker[0], to_worker[1]}) {
+    close(fd);
+  }
+  return num_batches / elapsed;
+}
+
+TEST(MemoryMapAllocationPool, benchmark_batch_transfer) {
+  const int num_batches = 1000;
+  const int prefetch = 4;
+  for (size_t batch_size : {64UL * 1024, 4UL * 1024 * 1024}) {
+    double unpooled = TransferBatches(false, num_batches, batch_size, prefetch);
+    double pooled = TransferBatches(true, num_batches, batch_size, prefetch);
+    LOG(INFO) << "Transfer batches of " << batch_size
+              << " bytes: " << unpooled << " batches/s without the pool, "
+              << pooled << " batches/s with the pool";
   }
+  FLAGS_use_shm_pool = false;
 }
 
 }  // namespace allocation
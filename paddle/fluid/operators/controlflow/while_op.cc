@@ -91,6 +91,14 @@ class WhileOp : public framework::OperatorBase {
     auto step_scopes =
         scope.FindVar(Output(kStepScopes))->GetMutable<StepScopeVar>();
 
+    // In test mode the step scope of the last run is kept in StepScopes and
+    // reused with its variables, which are reset at every iteration anyway.
+    framework::Scope *test_scope = nullptr;
+    if (is_test && step_scopes->size() == 1 &&
+        scope.HasKid(step_scopes->front())) {
+      test_scope = step_scopes->front();
+      step_scopes->clear();
+    }
     if (step_scopes->size() > 0) {
       platform::DeviceContextPool::Instance().Get(dev_place)->Wait();
       for (auto &s : *step_scopes) {
@@ -109,7 +117,7 @@ class WhileOp : public framework::OperatorBase {
     auto &skip_vars = Attr<std::vector<std::string>>(kSkipEagerDeletionVars);
     VLOG(2) << GetSkipEagerDeletionVarsDebugString(skip_vars);
 
-    auto ctx = executor.Prepare(*program, block->ID(), skip_vars);
+    auto ctx = prepared_block_.Get(*program, block->ID(), skip_vars);
     if (!is_test) {
       while (cond_data) {
         auto &current_scope = scope.NewScope();
@@ -144,8 +152,11 @@ class WhileOp : public framework::OperatorBase {
             GetCondData(scope.FindVar(Input(kCondition))->Get<LoDTensor>());
       }
     } else {
-      auto &current_scope = scope.NewScope();
-      executor.CreateVariables(*program, &current_scope, block->ID());
+      if (test_scope == nullptr) {
+        test_scope = &scope.NewScope();
+      }
+      executor.CreateVariables(*program, test_scope, block->ID());
+      auto &current_scope = *test_scope;
       while (cond_data) {
         for (auto &name : current_scope.LocalVarNames()) {
           auto *var = current_scope.Var(name);
@@ -165,9 +176,11 @@ class WhileOp : public framework::OperatorBase {
         cond_data =
             GetCondData(scope.FindVar(Input(kCondition))->Get<LoDTensor>());
       }
-      scope.DeleteScope(&current_scope);
+      step_scopes->push_back(test_scope);
     }
   }
+
+  mutable framework::PreparedBlockCache prepared_block_;
 };
 
 class WhileOpMaker : public framework::OpProtoAndCheckerMaker {
@@ -227,7 +240,7 @@ class WhileGradOp : public framework::OperatorBase {
 
     auto &skip_vars = Attr<std::vector<std::string>>(kSkipEagerDeletionVars);
     VLOG(2) << GetSkipEagerDeletionVarsDebugString(skip_vars);
-    auto ctx = executor.Prepare(*program, block->ID(), skip_vars);
+    auto ctx = prepared_block_.Get(*program, block->ID(), skip_vars);
 
     auto *step_scopes =
         scope.FindVar(Input(kStepScopes))->GetMutable<StepScopeVar>();
@@ -406,6 +419,8 @@ class WhileGradOp : public framework::OperatorBase {
     }
     step_scopes->clear();
   }
+
+  mutable framework::PreparedBlockCache prepared_block_;
 };
 
 template <typename T>
@@ -0,0 +1,117 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+
+USE_NO_KERNEL_OP(while);
+USE_OP(increment);
+USE_OP(less_than);
+
+namespace paddle {
+namespace operators {
+
+using LoDTensor = framework::LoDTensor;
+
+static void AppendIncrement(framework::BlockDesc *block) {
+  auto *op = block->AppendOp();
+  op->SetType("increment");
+  op->SetInput("X", {"i"});
+  op->SetOutput("Out", {"i"});
+  op->SetAttr("step", 1.0f);
+}
+
+// while (i < n) { i += 1; } with the condition updated in the step block.
+static framework::OpDesc *BuildWhileProgram(framework::ProgramDesc *program) {
+  auto *block = program->MutableBlock(0);
+  auto *step_block = program->AppendBlock(*block);
+  AppendIncrement(step_block);
+  auto *less_than = step_block->AppendOp();
+  less_than->SetType("less_than");
+  less_than->SetInput("X", {"i"});
+  less_than->SetInput("Y", {"n"});
+  less_than->SetOutput("Out", {"cond"});
+
+  auto *op = block->AppendOp();
+  op->SetType("while");
+  op->SetInput("X", {"i", "n"});
+  op->SetInput("Condition", {"cond"});
+  op->SetOutput("Out", {"i", "cond"});
+  op->SetOutput("StepScopes", {"step_scopes"});
+  op->SetBlockAttr("sub_block", step_block);
+  op->SetAttr("is_test", true);
+  return op;
+}
+
+static int64_t RunWhile(const framework::OperatorBase &op,
+                        framework::Scope *scope, int64_t n) {
+  platform::CPUPlace place;
+  auto set_scalar = [&](const std::string &name, int64_t value) {
+    auto *t = scope->Var(name)->GetMutable<LoDTensor>();
+    t->mutable_data<int64_t>(framework::make_ddim({1}), place)[0] = value;
+  };
+  set_scalar("i", 0);
+  set_scalar("n", n);
+  auto *cond = scope->Var("cond")->GetMutable<LoDTensor>();
+  cond->mutable_data<bool>(framework::make_ddim({1}), place)[0] = n > 0;
+  scope->Var("step_scopes")->GetMutable<std::vector<framework::Scope *>>();
+
+  op.Run(*scope, place);
+  return scope->FindVar("i")->Get<LoDTensor>().data<int64_t>()[0];
+}
+
+TEST(WhileOp, ReusePreparedBlock) {
+  framework::ProgramDesc program;
+  auto *desc = BuildWhileProgram(&program);
+  auto op = framework::OpRegistry::CreateOp(*desc);
+  framework::Scope scope;
+
+  EXPECT_EQ(RunWhile(*op, &scope, 101), 101);
+  EXPECT_EQ(RunWhile(*op, &scope, 101), 101);
+  EXPECT_EQ(scope.kids().size(), 1UL);
+
+  // The step block is prepared again once its ops change.
+  AppendIncrement(program.MutableBlock(1));
+  EXPECT_EQ(RunWhile(*op, &scope, 101), 102);
+  EXPECT_EQ(scope.kids().size(), 1UL);
+}
+
+TEST(WhileOp, SmallLoopBenchmark) {
+  framework::ProgramDesc program;
+  auto *desc = BuildWhileProgram(&program);
+  auto op = framework::OpRegistry::CreateOp(*desc);
+  framework::Scope scope;
+
+  const int runs = 1000;
+  const int64_t steps = 100;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < runs; ++i) {
+    ASSERT_EQ(RunWhile(*op, &scope, steps), steps);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  LOG(INFO) << runs << " runs of a while loop with " << steps
+            << " steps: " << seconds * 1e6 / runs << " us per run";
+}
+
+}  // namespace operators
+}  // namespace paddle
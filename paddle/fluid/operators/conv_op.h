@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/operators/layout_utils.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/cpu_conv.h"
 #include "paddle/fluid/operators/math/depthwise_conv.h"
 #include "paddle/fluid/operators/math/im2col.h"
 #include "paddle/fluid/operators/math/vol2col.h"
@@ -139,6 +140,30 @@ inline bool IsExpand(const std::vector<int64_t>& filter_dim,
   return !(filter_1 && strides_1 && padding_0 && dilation_1);
 }
 
+// The 2-D convolutions on CPU run on math::CPUConv2DFunctor, which picks
+// among im2col + GEMM, the direct depthwise convolution and Winograd. Returns
+// false on the other devices, which keep the im2col + GEMM below.
+template <typename T>
+inline bool RunCPUConv2D(const platform::CPUDeviceContext& dev_ctx,
+                         const Tensor& input, const Tensor& filter,
+                         const std::vector<int>& strides,
+                         const std::vector<int>& paddings,
+                         const std::vector<int>& dilations, int groups,
+                         Tensor* output) {
+  math::CPUConv2DFunctor<T>()(dev_ctx, input, filter, strides, paddings,
+                              dilations, groups, output);
+  return true;
+}
+
+template <typename T, typename DeviceContext>
+inline bool RunCPUConv2D(const DeviceContext& dev_ctx, const Tensor& input,
+                         const Tensor& filter, const std::vector<int>& strides,
+                         const std::vector<int>& paddings,
+                         const std::vector<int>& dilations, int groups,
+                         Tensor* output) {
+  return false;
+}
+
 // Define Op classes in .h file so that other conv
 // operator implementations can reuse the code.
 class Conv2DOpMaker : public framework::OpProtoAndCheckerMaker {
@@ -266,6 +291,16 @@ class GemmConvKernel : public framework::OpKernel<T> {
 
     auto& dev_ctx = context.template device_context<DeviceContext>();
 
+    if (filter_data_dims.size() == 2 &&
+        RunCPUConv2D<T>(dev_ctx, transformed_input, filter, strides, paddings,
+                        dilations, groups, &transformed_output)) {
+      if (channel_last) {
+        TransToChannelLast<DeviceContext, T>(context, &transformed_output,
+                                             output);
+      }
+      return;
+    }
+
     const int batch_size = static_cast<int>(transformed_input.dims()[0]);
 
     // filter_shape_vec:
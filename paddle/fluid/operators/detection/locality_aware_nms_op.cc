@@ -169,36 +169,32 @@ class LocalityAwareNMSKernel : public framework::OpKernel<T> {
         &sorted_indices, nms_threshold, normalized);
 
     selected_indices->clear();
+    KeptBoxes<T> kept_boxes(normalized);
 
-    while (sorted_indices.size() != 0) {
-      const int idx = sorted_indices.front().second;
+    for (const auto& score_index : sorted_indices) {
+      const int idx = score_index.second;
+      const T* box = bbox_data + idx * box_size;
       bool keep = true;
-      for (size_t k = 0; k < selected_indices->size(); ++k) {
-        if (keep) {
+      // 4: [xmin ymin xmax ymax]
+      if (box_size == 4) {
+        keep = !kept_boxes.Suppresses(box, adaptive_threshold);
+      }
+      // 8: [x1 y1 x2 y2 x3 y3 x4 y4] or 16, 24, 32
+      if (box_size == 8 || box_size == 16 || box_size == 24 ||
+          box_size == 32) {
+        for (size_t k = 0; k < selected_indices->size() && keep; ++k) {
           const int kept_idx = (*selected_indices)[k];
-          T overlap = T(0.);
-          // 4: [xmin ymin xmax ymax]
-          if (box_size == 4) {
-            overlap =
-                JaccardOverlap<T>(bbox_data + idx * box_size,
-                                  bbox_data + kept_idx * box_size, normalized);
-          }
-          // 8: [x1 y1 x2 y2 x3 y3 x4 y4] or 16, 24, 32
-          if (box_size == 8 || box_size == 16 || box_size == 24 ||
-              box_size == 32) {
-            overlap = PolyIoU<T>(bbox_data + idx * box_size,
-                                 bbox_data + kept_idx * box_size, box_size,
-                                 normalized);
-          }
+          T overlap = PolyIoU<T>(box, bbox_data + kept_idx * box_size,
+                                 box_size, normalized);
           keep = overlap <= adaptive_threshold;
-        } else {
-          break;
         }
       }
       if (keep) {
         selected_indices->push_back(idx);
+        if (box_size == 4) {
+          kept_boxes.Add(box);
+        }
       }
-      sorted_indices.erase(sorted_indices.begin());
       if (keep && eta < 1 && adaptive_threshold > 0.5) {
         adaptive_threshold *= eta;
       }
@@ -130,16 +130,19 @@ void NMSMatrix(const Tensor& bbox, const Tensor& scores,
   std::vector<T> iou_matrix((num_pre * (num_pre - 1)) >> 1);
   std::vector<T> iou_max(num_pre);
 
+  // Row i of iou_matrix is the overlaps of box i with the boxes before it in
+  // the order of score.
+  KeptBoxes<T> sorted_boxes(normalized);
+  for (int64_t i = 0; i < num_pre; i++) {
+    sorted_boxes.Add(bbox_ptr + perm[i] * box_size);
+  }
   iou_max[0] = 0.;
   for (int64_t i = 1; i < num_pre; i++) {
+    T* iou_row = iou_matrix.data() + i * (i - 1) / 2;
+    sorted_boxes.Overlaps(bbox_ptr + perm[i] * box_size, i, iou_row);
     T max_iou = 0.;
-    auto idx_a = perm[i];
     for (int64_t j = 0; j < i; j++) {
-      auto idx_b = perm[j];
-      auto iou = JaccardOverlap<T>(bbox_ptr + idx_a * box_size,
-                                   bbox_ptr + idx_b * box_size, normalized);
-      max_iou = std::max(max_iou, iou);
-      iou_matrix[i * (i - 1) / 2 + j] = iou;
+      max_iou = std::max(max_iou, iou_row[j]);
     }
     iou_max[i] = max_iou;
   }
@@ -182,26 +185,36 @@ class MatrixNMSKernel : public framework::OpKernel<T> {
     all_scores.reserve(scores.numel());
     all_classes.reserve(scores.numel());
 
-    size_t num_det = 0;
+    // The classes are suppressed independently in parallel, then their
+    // results are concatenated in the order of class.
     auto class_num = scores.dims()[0];
-    Tensor score_slice;
+    std::vector<std::vector<int>> class_indices(class_num);
+    std::vector<std::vector<T>> class_scores(class_num);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
     for (int64_t c = 0; c < class_num; ++c) {
       if (c == background_label) continue;
-      score_slice = scores.Slice(c, c + 1);
+      Tensor score_slice = scores.Slice(c, c + 1);
       if (use_gaussian) {
         NMSMatrix<T, true>(bboxes, score_slice, score_threshold, post_threshold,
-                           gaussian_sigma, nms_top_k, normalized, &all_indices,
-                           &all_scores);
+                           gaussian_sigma, nms_top_k, normalized,
+                           &class_indices[c], &class_scores[c]);
       } else {
         NMSMatrix<T, false>(bboxes, score_slice, score_threshold,
                             post_threshold, gaussian_sigma, nms_top_k,
-                            normalized, &all_indices, &all_scores);
-      }
-      for (size_t i = 0; i < all_indices.size() - num_det; i++) {
-        all_classes.push_back(static_cast<T>(c));
+                            normalized, &class_indices[c], &class_scores[c]);
       }
-      num_det = all_indices.size();
     }
+    for (int64_t c = 0; c < class_num; ++c) {
+      all_indices.insert(all_indices.end(), class_indices[c].begin(),
+                         class_indices[c].end());
+      all_scores.insert(all_scores.end(), class_scores[c].begin(),
+                        class_scores[c].end());
+      all_classes.insert(all_classes.end(), class_indices[c].size(),
+                         static_cast<T>(c));
+    }
+    size_t num_det = all_indices.size();
 
     if (num_det <= 0) {
       return num_det;
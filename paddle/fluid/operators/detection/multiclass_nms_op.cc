@@ -155,83 +155,56 @@ class MultiClassNMSKernel : public framework::OpKernel<T> {
     selected_indices->clear();
     T adaptive_threshold = nms_threshold;
     const T* bbox_data = bbox.data<T>();
+    KeptBoxes<T> kept_boxes(normalized);
 
-    while (sorted_indices.size() != 0) {
-      const int idx = sorted_indices.front().second;
+    for (const auto& score_index : sorted_indices) {
+      const int idx = score_index.second;
+      const T* box = bbox_data + idx * box_size;
       bool keep = true;
-      for (size_t k = 0; k < selected_indices->size(); ++k) {
-        if (keep) {
+      // 4: [xmin ymin xmax ymax]
+      if (box_size == 4) {
+        keep = !kept_boxes.Suppresses(box, adaptive_threshold);
+      }
+      // 8: [x1 y1 x2 y2 x3 y3 x4 y4] or 16, 24, 32
+      if (box_size == 8 || box_size == 16 || box_size == 24 ||
+          box_size == 32) {
+        for (size_t k = 0; k < selected_indices->size() && keep; ++k) {
           const int kept_idx = (*selected_indices)[k];
-          T overlap = T(0.);
-          // 4: [xmin ymin xmax ymax]
-          if (box_size == 4) {
-            overlap =
-                JaccardOverlap<T>(bbox_data + idx * box_size,
-                                  bbox_data + kept_idx * box_size, normalized);
-          }
-          // 8: [x1 y1 x2 y2 x3 y3 x4 y4] or 16, 24, 32
-          if (box_size == 8 || box_size == 16 || box_size == 24 ||
-              box_size == 32) {
-            overlap = PolyIoU<T>(bbox_data + idx * box_size,
-                                 bbox_data + kept_idx * box_size, box_size,
-                                 normalized);
-          }
+          T overlap = PolyIoU<T>(box, bbox_data + kept_idx * box_size,
+                                 box_size, normalized);
           keep = overlap <= adaptive_threshold;
-        } else {
-          break;
         }
       }
       if (keep) {
         selected_indices->push_back(idx);
+        if (box_size == 4) {
+          kept_boxes.Add(box);
+        }
       }
-      sorted_indices.erase(sorted_indices.begin());
       if (keep && eta < 1 && adaptive_threshold > 0.5) {
         adaptive_threshold *= eta;
       }
     }
   }
 
-  void MultiClassNMS(const framework::ExecutionContext& ctx,
-                     const Tensor& scores, const Tensor& bboxes,
-                     const int scores_size,
-                     std::map<int, std::vector<int>>* indices,
-                     int* num_nmsed_out) const {
-    int64_t background_label = ctx.Attr<int>("background_label");
-    int64_t nms_top_k = ctx.Attr<int>("nms_top_k");
+  // Keeps the keep_top_k highest scored boxes of the classes of an image,
+  // whose NMS results are indices.
+  void KeepTopK(const framework::ExecutionContext& ctx, const Tensor& scores,
+                const int scores_size, std::map<int, std::vector<int>>* indices,
+                int* num_nmsed_out) const {
     int64_t keep_top_k = ctx.Attr<int>("keep_top_k");
-    bool normalized = ctx.Attr<bool>("normalized");
-    T nms_threshold = static_cast<T>(ctx.Attr<float>("nms_threshold"));
-    T nms_eta = static_cast<T>(ctx.Attr<float>("nms_eta"));
-    T score_threshold = static_cast<T>(ctx.Attr<float>("score_threshold"));
     auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
 
     int num_det = 0;
-
-    int64_t class_num = scores_size == 3 ? scores.dims()[0] : scores.dims()[1];
-    Tensor bbox_slice, score_slice;
-    for (int64_t c = 0; c < class_num; ++c) {
-      if (c == background_label) continue;
-      if (scores_size == 3) {
-        score_slice = scores.Slice(c, c + 1);
-        bbox_slice = bboxes;
-      } else {
-        score_slice.Resize({scores.dims()[0], 1});
-        bbox_slice.Resize({scores.dims()[0], 4});
-        SliceOneClass<T>(dev_ctx, scores, c, &score_slice);
-        SliceOneClass<T>(dev_ctx, bboxes, c, &bbox_slice);
-      }
-      NMSFast(bbox_slice, score_slice, score_threshold, nms_threshold, nms_eta,
-              nms_top_k, &((*indices)[c]), normalized);
-      if (scores_size == 2) {
-        std::stable_sort((*indices)[c].begin(), (*indices)[c].end());
-      }
-      num_det += (*indices)[c].size();
+    for (const auto& it : *indices) {
+      num_det += it.second.size();
     }
 
     *num_nmsed_out = num_det;
     const T* scores_data = scores.data<T>();
     if (keep_top_k > -1 && num_det > keep_top_k) {
       const T* sdata;
+      Tensor score_slice;
       std::vector<std::pair<float, std::pair<int, int>>> score_index_pairs;
       for (const auto& it : *indices) {
         int label = it.first;
@@ -337,44 +310,95 @@ class MultiClassNMSKernel : public framework::OpKernel<T> {
     auto score_size = score_dims.size();
     auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
 
-    std::vector<std::map<int, std::vector<int>>> all_indices;
+    int64_t background_label = ctx.Attr<int>("background_label");
+    int64_t nms_top_k = ctx.Attr<int>("nms_top_k");
+    bool normalized = ctx.Attr<bool>("normalized");
+    T nms_threshold = static_cast<T>(ctx.Attr<float>("nms_threshold"));
+    T nms_eta = static_cast<T>(ctx.Attr<float>("nms_eta"));
+    T score_threshold = static_cast<T>(ctx.Attr<float>("score_threshold"));
+
     std::vector<size_t> batch_starts = {0};
     int64_t batch_size = score_dims[0];
     int64_t box_dim = boxes->dims()[2];
     int64_t out_dim = box_dim + 2;
     int num_nmsed_out = 0;
-    Tensor boxes_slice, scores_slice;
     int n = 0;
     if (has_roisnum) {
       n = score_size == 3 ? batch_size : rois_num->numel();
     } else {
       n = score_size == 3 ? batch_size : boxes->lod().back().size() - 1;
     }
+    std::vector<size_t> boxes_lod;
+    if (score_size == 2) {
+      if (has_roisnum) {
+        boxes_lod = GetNmsLodFromRoisNum(rois_num);
+      } else {
+        boxes_lod = boxes->lod().back();
+      }
+    }
+
+    std::vector<std::map<int, std::vector<int>>> all_indices(n);
+    std::vector<Tensor> scores_slices(n), boxes_slices(n);
+    std::vector<bool> has_boxes(n, true);
+    // The NMS of every class of every image is independent, so they run in
+    // parallel. Each of them writes its own entry of all_indices, which are
+    // created here.
+    std::vector<std::pair<int, int64_t>> image_classes;
+    std::vector<std::vector<int>*> class_indices;
     for (int i = 0; i < n; ++i) {
-      std::map<int, std::vector<int>> indices;
       if (score_size == 3) {
-        scores_slice = scores->Slice(i, i + 1);
-        scores_slice.Resize({score_dims[1], score_dims[2]});
-        boxes_slice = boxes->Slice(i, i + 1);
-        boxes_slice.Resize({score_dims[2], box_dim});
+        scores_slices[i] = scores->Slice(i, i + 1);
+        scores_slices[i].Resize({score_dims[1], score_dims[2]});
+        boxes_slices[i] = boxes->Slice(i, i + 1);
+        boxes_slices[i].Resize({score_dims[2], box_dim});
       } else {
-        std::vector<size_t> boxes_lod;
-        if (has_roisnum) {
-          boxes_lod = GetNmsLodFromRoisNum(rois_num);
-        } else {
-          boxes_lod = boxes->lod().back();
-        }
         if (boxes_lod[i] == boxes_lod[i + 1]) {
-          all_indices.push_back(indices);
-          batch_starts.push_back(batch_starts.back());
+          has_boxes[i] = false;
           continue;
         }
-        scores_slice = scores->Slice(boxes_lod[i], boxes_lod[i + 1]);
-        boxes_slice = boxes->Slice(boxes_lod[i], boxes_lod[i + 1]);
+        scores_slices[i] = scores->Slice(boxes_lod[i], boxes_lod[i + 1]);
+        boxes_slices[i] = boxes->Slice(boxes_lod[i], boxes_lod[i + 1]);
+      }
+      int64_t class_num = score_dims[1];
+      for (int64_t c = 0; c < class_num; ++c) {
+        if (c == background_label) continue;
+        image_classes.emplace_back(i, c);
+        class_indices.push_back(&all_indices[i][c]);
+      }
+    }
+
+    int64_t num_image_classes = image_classes.size();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t j = 0; j < num_image_classes; ++j) {
+      const Tensor& scores_slice = scores_slices[image_classes[j].first];
+      const Tensor& boxes_slice = boxes_slices[image_classes[j].first];
+      int64_t c = image_classes[j].second;
+      Tensor bbox_slice, score_slice;
+      if (score_size == 3) {
+        score_slice = scores_slice.Slice(c, c + 1);
+        bbox_slice = boxes_slice;
+      } else {
+        score_slice.Resize({scores_slice.dims()[0], 1});
+        bbox_slice.Resize({scores_slice.dims()[0], 4});
+        SliceOneClass<T>(dev_ctx, scores_slice, c, &score_slice);
+        SliceOneClass<T>(dev_ctx, boxes_slice, c, &bbox_slice);
       }
-      MultiClassNMS(ctx, scores_slice, boxes_slice, score_size, &indices,
-                    &num_nmsed_out);
-      all_indices.push_back(indices);
+      NMSFast(bbox_slice, score_slice, score_threshold, nms_threshold, nms_eta,
+              nms_top_k, class_indices[j], normalized);
+      if (score_size == 2) {
+        std::stable_sort(class_indices[j]->begin(), class_indices[j]->end());
+      }
+    }
+
+    for (int i = 0; i < n; ++i) {
+      if (!has_boxes[i]) {
+        batch_starts.push_back(batch_starts.back());
+        continue;
+      }
+      KeepTopK(ctx, scores_slices[i], score_size, &all_indices[i],
+               &num_nmsed_out);
       batch_starts.push_back(batch_starts.back() + num_nmsed_out);
     }
 
@@ -393,25 +417,11 @@ class MultiClassNMSKernel : public framework::OpKernel<T> {
       int offset = 0;
       int* oindices = nullptr;
       for (int i = 0; i < n; ++i) {
-        if (score_size == 3) {
-          scores_slice = scores->Slice(i, i + 1);
-          boxes_slice = boxes->Slice(i, i + 1);
-          scores_slice.Resize({score_dims[1], score_dims[2]});
-          boxes_slice.Resize({score_dims[2], box_dim});
-          if (return_index) {
+        if (!has_boxes[i]) continue;
+        if (return_index) {
+          if (score_size == 3) {
             offset = i * score_dims[2];
-          }
-        } else {
-          std::vector<size_t> boxes_lod;
-          if (has_roisnum) {
-            boxes_lod = GetNmsLodFromRoisNum(rois_num);
           } else {
-            boxes_lod = boxes->lod().back();
-          }
-          if (boxes_lod[i] == boxes_lod[i + 1]) continue;
-          scores_slice = scores->Slice(boxes_lod[i], boxes_lod[i + 1]);
-          boxes_slice = boxes->Slice(boxes_lod[i], boxes_lod[i + 1]);
-          if (return_index) {
             offset = boxes_lod[i] * score_dims[1];
           }
         }
@@ -425,8 +435,9 @@ class MultiClassNMSKernel : public framework::OpKernel<T> {
                 index->mutable_data<int>({num_kept, 1}, ctx.GetPlace());
             oindices = output_idx + s;
           }
-          MultiClassOutput(dev_ctx, scores_slice, boxes_slice, all_indices[i],
-                           score_dims.size(), &out, oindices, offset);
+          MultiClassOutput(dev_ctx, scores_slices[i], boxes_slices[i],
+                           all_indices[i], score_dims.size(), &out, oindices,
+                           offset);
         }
       }
     }
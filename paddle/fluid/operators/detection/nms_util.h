@@ -84,6 +84,90 @@ static inline T JaccardOverlap(const T* box1, const T* box2,
   }
 }
 
+// The [xmin ymin xmax ymax] boxes kept by NMS, stored coordinate by
+// coordinate so that the overlaps of a box with the kept boxes are computed
+// in SIMD lanes. The overlaps are bit-identical to those of JaccardOverlap
+// unless the compiler contracts the multiply-adds into FMA, which the SSE3
+// and AVX builds do not have.
+template <class T>
+class KeptBoxes {
+ public:
+  explicit KeptBoxes(const bool normalized) : normalized_(normalized) {}
+
+  size_t size() const { return area_.size(); }
+
+  // Only the first 4 values of box are read.
+  void Add(const T* box) {
+    xmin_.push_back(box[0]);
+    ymin_.push_back(box[1]);
+    xmax_.push_back(box[2]);
+    ymax_.push_back(box[3]);
+    area_.push_back(BBoxArea<T>(box, normalized_));
+  }
+
+  // Returns whether box overlaps any kept box by more than threshold. The
+  // kept boxes are checked kBlockSize at a time, and the check stops at the
+  // first block that suppresses box.
+  bool Suppresses(const T* box, const T threshold) const {
+    const T box_area = BBoxArea<T>(box, normalized_);
+    T overlaps[kBlockSize];
+    for (size_t begin = 0; begin < size(); begin += kBlockSize) {
+      size_t end = begin + kBlockSize < size() ? begin + kBlockSize : size();
+      Overlaps(box, box_area, begin, end, overlaps);
+      for (size_t i = 0; i < end - begin; ++i) {
+        // A NaN overlap suppresses box as well.
+        if (!(overlaps[i] <= threshold)) return true;
+      }
+    }
+    return false;
+  }
+
+  // overlaps[i] = JaccardOverlap(box, kept box i) for the first n kept boxes.
+  void Overlaps(const T* box, const size_t n, T* overlaps) const {
+    Overlaps(box, BBoxArea<T>(box, normalized_), 0, n, overlaps);
+  }
+
+ private:
+  static constexpr size_t kBlockSize = 64;
+
+  // The overlaps are computed as in JaccardOverlap, but the disjoint boxes
+  // are zeroed in a second loop. A select of the quotient in the first loop
+  // would keep the compiler from vectorizing it.
+  void Overlaps(const T* box, const T box_area, const size_t begin,
+                const size_t end, T* overlaps) const {
+    const T norm = normalized_ ? static_cast<T>(0.) : static_cast<T>(1.);
+    const T xmin = box[0], ymin = box[1], xmax = box[2], ymax = box[3];
+    const T* kept_xmin = xmin_.data();
+    const T* kept_ymin = ymin_.data();
+    const T* kept_xmax = xmax_.data();
+    const T* kept_ymax = ymax_.data();
+    const T* kept_area = area_.data();
+    for (size_t i = begin; i < end; ++i) {
+      // std::max(a, b) is a < b ? b : a, std::min(a, b) is b < a ? b : a.
+      const T inter_xmin = xmin < kept_xmin[i] ? kept_xmin[i] : xmin;
+      const T inter_ymin = ymin < kept_ymin[i] ? kept_ymin[i] : ymin;
+      const T inter_xmax = kept_xmax[i] < xmax ? kept_xmax[i] : xmax;
+      const T inter_ymax = kept_ymax[i] < ymax ? kept_ymax[i] : ymax;
+      const T inter_w = inter_xmax - inter_xmin + norm;
+      const T inter_h = inter_ymax - inter_ymin + norm;
+      const T inter_area = inter_w * inter_h;
+      overlaps[i - begin] = inter_area / (box_area + kept_area[i] - inter_area);
+    }
+    for (size_t i = begin; i < end; ++i) {
+      const bool disjoint = (kept_xmin[i] > xmax) | (kept_xmax[i] < xmin) |
+                            (kept_ymin[i] > ymax) | (kept_ymax[i] < ymin);
+      overlaps[i - begin] = disjoint ? static_cast<T>(0.) : overlaps[i - begin];
+    }
+  }
+
+  bool normalized_;
+  std::vector<T> xmin_;
+  std::vector<T> ymin_;
+  std::vector<T> xmax_;
+  std::vector<T> ymax_;
+  std::vector<T> area_;
+};
+
 template <class T>
 T PolyIoU(const T* box1, const T* box2, const size_t box_size,
           const bool normalized) {
@@ -145,21 +229,14 @@ framework::Tensor NMS(const platform::DeviceContext& ctx,
   T adaptive_threshold = nms_threshold;
   const T* bbox_data = bbox->data<T>();
   bool normalized = pixel_offset ? false : true;
+  KeptBoxes<T> kept_boxes(normalized);
   while (sorted_indices.size() != 0) {
     int idx = sorted_indices.back().second;
-    bool flag = true;
-    for (int kept_idx : selected_indices) {
-      if (flag) {
-        T overlap =
-            JaccardOverlap<T>(bbox_data + idx * box_size,
-                              bbox_data + kept_idx * box_size, normalized);
-        flag = (overlap <= adaptive_threshold);
-      } else {
-        break;
-      }
-    }
+    bool flag =
+        !kept_boxes.Suppresses(bbox_data + idx * box_size, adaptive_threshold);
     if (flag) {
       selected_indices.push_back(idx);
+      kept_boxes.Add(bbox_data + idx * box_size);
       ++selected_num;
     }
     sorted_indices.erase(sorted_indices.end() - 1);
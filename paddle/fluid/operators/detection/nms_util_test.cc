@@ -0,0 +1,277 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/detection/nms_util.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+
+USE_OP(multiclass_nms);
+USE_OP(matrix_nms);
+
+namespace paddle {
+namespace operators {
+
+// Boxes of every kind KeptBoxes may see: overlapping, nested, identical,
+// touching, disjoint, degenerate (xmax < xmin or zero width) and NaN.
+template <typename T>
+std::vector<std::vector<T>> TestBoxes(const bool normalized, const int n) {
+  std::mt19937 rng(0);
+  const T scale = normalized ? static_cast<T>(1) : static_cast<T>(100);
+  std::uniform_real_distribution<T> coord(0, scale);
+  std::uniform_real_distribution<T> extent(0, scale / 4);
+  const T nan = std::numeric_limits<T>::quiet_NaN();
+  std::vector<std::vector<T>> boxes;
+  for (int i = 0; static_cast<int>(boxes.size()) < n; ++i) {
+    T xmin = coord(rng), ymin = coord(rng);
+    T xmax = xmin + extent(rng), ymax = ymin + extent(rng);
+    switch (i % 10) {
+      case 0:  // identical to the former box
+        if (!boxes.empty()) {
+          boxes.push_back(boxes.back());
+          continue;
+        }
+        break;
+      case 1:  // xmax < xmin
+        std::swap(xmin, xmax);
+        break;
+      case 2:  // zero width and height
+        xmax = xmin;
+        ymax = ymin;
+        break;
+      case 3:  // far from all the others
+        xmin += 3 * scale;
+        xmax += 3 * scale;
+        break;
+      case 4:  // touches the former box
+        if (!boxes.empty()) xmin = boxes.back()[2];
+        break;
+      case 5:
+        xmin = nan;
+        break;
+      case 6:
+        ymax = nan;
+        break;
+      default:
+        break;
+    }
+    boxes.push_back({xmin, ymin, xmax, ymax});
+  }
+  return boxes;
+}
+
+// The overlaps are compared bit by bit, which holds as long as the build does
+// not contract the multiply-adds into FMA (see KeptBoxes).
+template <typename T>
+void TestKeptBoxes(const bool normalized) {
+  auto boxes = TestBoxes<T>(normalized, 150);
+  KeptBoxes<T> kept(normalized);
+  for (auto& box : boxes) kept.Add(box.data());
+  ASSERT_EQ(kept.size(), boxes.size());
+
+  std::vector<T> overlaps(boxes.size());
+  for (auto& box : boxes) {
+    // The partial blocks, one block, and more than two blocks of 64.
+    for (size_t n : {0, 1, 63, 64, 65, 129, 150}) {
+      kept.Overlaps(box.data(), n, overlaps.data());
+      for (size_t i = 0; i < n; ++i) {
+        T expected =
+            JaccardOverlap<T>(box.data(), boxes[i].data(), normalized);
+        EXPECT_EQ(std::memcmp(&overlaps[i], &expected, sizeof(T)), 0)
+            << "box " << i << ": " << overlaps[i] << " vs " << expected;
+      }
+    }
+    for (T threshold : {0., 0.3, 0.7, 1.}) {
+      bool expected = false;
+      for (auto& kept_box : boxes) {
+        T overlap = JaccardOverlap<T>(box.data(), kept_box.data(), normalized);
+        if (!(overlap <= threshold)) expected = true;
+      }
+      EXPECT_EQ(kept.Suppresses(box.data(), threshold), expected);
+    }
+  }
+}
+
+TEST(KeptBoxes, NormalizedFloat) { TestKeptBoxes<float>(true); }
+TEST(KeptBoxes, UnnormalizedFloat) { TestKeptBoxes<float>(false); }
+TEST(KeptBoxes, NormalizedDouble) { TestKeptBoxes<double>(true); }
+TEST(KeptBoxes, UnnormalizedDouble) { TestKeptBoxes<double>(false); }
+
+TEST(KeptBoxes, Empty) {
+  KeptBoxes<float> kept(true);
+  float box[4] = {0.f, 0.f, 1.f, 1.f};
+  EXPECT_FALSE(kept.Suppresses(box, 0.f));
+}
+
+const int kBatchSize = 3, kClassNum = 6, kBoxNum = 300;
+
+// Random boxes of [kBatchSize, kBoxNum, 4] and scores of [kBatchSize,
+// kClassNum, kBoxNum].
+void RandomNMSInputs(std::vector<float>* bboxes, std::vector<float>* scores) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  bboxes->resize(kBatchSize * kBoxNum * 4);
+  for (int i = 0; i < kBatchSize * kBoxNum; ++i) {
+    float x = uniform(rng), y = uniform(rng);
+    (*bboxes)[i * 4] = x;
+    (*bboxes)[i * 4 + 1] = y;
+    (*bboxes)[i * 4 + 2] = x + 0.2f * uniform(rng);
+    (*bboxes)[i * 4 + 3] = y + 0.2f * uniform(rng);
+  }
+  scores->resize(kBatchSize * kClassNum * kBoxNum);
+  for (auto& score : *scores) score = uniform(rng);
+}
+
+// Runs op_type on RandomNMSInputs with num_threads, the outputs are returned
+// by name.
+std::map<std::string, framework::LoDTensor> RunNMSOp(
+    const std::string& op_type, const framework::AttributeMap& attrs,
+    const int num_threads) {
+  std::vector<float> bboxes_data, scores_data;
+  RandomNMSInputs(&bboxes_data, &scores_data);
+  framework::Scope scope;
+  platform::CPUPlace place;
+  auto* bboxes = scope.Var("BBoxes")->GetMutable<framework::LoDTensor>();
+  std::copy(bboxes_data.begin(), bboxes_data.end(),
+            bboxes->mutable_data<float>({kBatchSize, kBoxNum, 4}, place));
+  auto* scores = scope.Var("Scores")->GetMutable<framework::LoDTensor>();
+  std::copy(
+      scores_data.begin(), scores_data.end(),
+      scores->mutable_data<float>({kBatchSize, kClassNum, kBoxNum}, place));
+  scope.Var("Out");
+  scope.Var("Index");
+
+  framework::VariableNameMap outputs = {{"Out", {"Out"}}};
+  if (op_type == "matrix_nms") outputs["Index"] = {"Index"};
+  auto op = framework::OpRegistry::CreateOp(
+      op_type, {{"BBoxes", {"BBoxes"}}, {"Scores", {"Scores"}}}, outputs,
+      attrs);
+  platform::SetNumThreads(num_threads);
+  op->Run(scope, place);
+  platform::SetNumThreads(1);
+
+  std::map<std::string, framework::LoDTensor> results;
+  for (auto& item : outputs) {
+    results[item.first] =
+        scope.FindVar(item.first)->Get<framework::LoDTensor>();
+  }
+  return results;
+}
+
+void ExpectSameTensors(const framework::LoDTensor& a,
+                       const framework::LoDTensor& b) {
+  ASSERT_EQ(a.dims(), b.dims());
+  ASSERT_EQ(a.lod(), b.lod());
+  ASSERT_EQ(a.type(), b.type());
+  EXPECT_EQ(std::memcmp(a.data<void>(), b.data<void>(),
+                        a.numel() * framework::SizeOfType(a.type())),
+            0);
+}
+
+// The greedy NMS of JaccardOverlap, the rows of one image are
+// [label, score, xmin, ymin, xmax, ymax] by class and then by score.
+std::vector<float> ReferenceMultiClassNMS(const float* bboxes,
+                                          const float* scores,
+                                          const int class_num,
+                                          const int box_num,
+                                          const float score_threshold,
+                                          const float nms_threshold) {
+  std::vector<float> rows;
+  for (int c = 1; c < class_num; ++c) {
+    const float* class_scores = scores + c * box_num;
+    std::vector<std::pair<float, int>> sorted;
+    for (int i = 0; i < box_num; ++i) {
+      if (class_scores[i] > score_threshold) {
+        sorted.emplace_back(class_scores[i], i);
+      }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(),
+                     SortScorePairDescend<int>);
+    std::vector<int> kept;
+    for (auto& item : sorted) {
+      const float* box = bboxes + item.second * 4;
+      bool keep = true;
+      for (int k : kept) {
+        if (JaccardOverlap<float>(box, bboxes + k * 4, true) >
+            nms_threshold) {
+          keep = false;
+          break;
+        }
+      }
+      if (!keep) continue;
+      kept.push_back(item.second);
+      rows.insert(rows.end(), {static_cast<float>(c), item.first, box[0],
+                               box[1], box[2], box[3]});
+    }
+  }
+  return rows;
+}
+
+TEST(MultiClassNMS, ParallelMatchesSerial) {
+  framework::AttributeMap attrs;
+  attrs["background_label"] = 0;
+  attrs["score_threshold"] = 0.5f;
+  attrs["nms_top_k"] = -1;
+  attrs["nms_threshold"] = 0.3f;
+  attrs["nms_eta"] = 1.0f;
+  attrs["keep_top_k"] = -1;
+  attrs["normalized"] = true;
+  auto serial = RunNMSOp("multiclass_nms", attrs, 1);
+  auto parallel = RunNMSOp("multiclass_nms", attrs, 4);
+  ExpectSameTensors(serial["Out"], parallel["Out"]);
+
+  std::vector<float> bboxes, scores;
+  RandomNMSInputs(&bboxes, &scores);
+  std::vector<float> expected;
+  for (int i = 0; i < kBatchSize; ++i) {
+    auto rows = ReferenceMultiClassNMS(
+        bboxes.data() + i * kBoxNum * 4,
+        scores.data() + i * kClassNum * kBoxNum, kClassNum, kBoxNum, 0.5f,
+        0.3f);
+    expected.insert(expected.end(), rows.begin(), rows.end());
+  }
+  auto& out = serial["Out"];
+  ASSERT_EQ(static_cast<size_t>(out.numel()), expected.size());
+  EXPECT_EQ(std::memcmp(out.data<float>(), expected.data(),
+                        expected.size() * sizeof(float)),
+            0);
+}
+
+TEST(MatrixNMS, ParallelMatchesSerial) {
+  for (bool use_gaussian : {false, true}) {
+    framework::AttributeMap attrs;
+    attrs["background_label"] = 0;
+    attrs["score_threshold"] = 0.3f;
+    attrs["post_threshold"] = 0.1f;
+    attrs["nms_top_k"] = 200;
+    attrs["keep_top_k"] = 100;
+    attrs["normalized"] = true;
+    attrs["use_gaussian"] = use_gaussian;
+    attrs["gaussian_sigma"] = 2.0f;
+    auto serial = RunNMSOp("matrix_nms", attrs, 1);
+    auto parallel = RunNMSOp("matrix_nms", attrs, 4);
+    ExpectSameTensors(serial["Out"], parallel["Out"]);
+    ExpectSameTensors(serial["Index"], parallel["Index"]);
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -12,8 +12,10 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <cstring>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/platform/errors.h"
 
 namespace paddle {
@@ -149,6 +151,76 @@ Not suggest to use in other case except has same structure as ernie.
   }
 };
 
+template <typename T>
+class EmbeddingEltWiseLayerNormCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& context) const override {
+    auto ids = context.MultiInput<framework::Tensor>("Ids");
+    auto embs = context.MultiInput<framework::Tensor>("Embs");
+    int input_num = static_cast<int>(ids.size());
+
+    auto* bias = context.Input<framework::Tensor>("Bias");
+    auto* scale = context.Input<framework::Tensor>("Scale");
+    auto* out = context.Output<framework::Tensor>("Out");
+
+    auto id0_dims = ids[0]->dims();
+    auto emb0_dims = embs[0]->dims();
+    int batch = id0_dims[0];
+    int seq_len = id0_dims[1];
+    int hidden = emb0_dims[1];
+    int64_t num = static_cast<int64_t>(batch) * seq_len;
+
+    std::vector<const int64_t*> ids_d(input_num);
+    std::vector<const T*> embs_d(input_num);
+    for (int i = 0; i < input_num; ++i) {
+      ids_d[i] = ids[i]->data<int64_t>();
+      embs_d[i] = embs[i]->data<T>();
+      int64_t height = embs[i]->dims()[0];
+      for (int64_t pos = 0; pos < num; ++pos) {
+        PADDLE_ENFORCE_EQ(
+            ids_d[i][pos] >= 0 && ids_d[i][pos] < height, true,
+            platform::errors::InvalidArgument(
+                "The id (%d) of the %d-th Ids should be in [0, %d).",
+                ids_d[i][pos], i, height));
+      }
+    }
+
+    const T* bias_d = bias->data<T>();
+    const T* scale_d = scale->data<T>();
+    T* output_d = out->mutable_data<T>(context.GetPlace());
+    float eps = context.Attr<float>("epsilon");
+
+    // The looked up rows are summed into a temporary buffer, since the jit
+    // layer_norm kernel does not support normalizing in place.
+    framework::Tensor sum;
+    T* sum_d = sum.mutable_data<T>(out->dims(), context.GetPlace());
+
+    auto vadd =
+        jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(
+            hidden);
+    auto layer_norm =
+        jit::KernelFuncs<jit::LayerNormTuple<T>, platform::CPUPlace>::Cache()
+            .At(hidden);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t pos = 0; pos < num; ++pos) {
+      T* sum_pos = sum_d + pos * hidden;
+      for (int i = 0; i < input_num; ++i) {
+        const T* emb_row = embs_d[i] + ids_d[i][pos] * hidden;
+        if (i == 0) {
+          std::memcpy(sum_pos, emb_row, hidden * sizeof(T));
+        } else {
+          vadd(emb_row, sum_pos, sum_pos, hidden);
+        }
+      }
+      T mean, var;
+      layer_norm(sum_pos, output_d + pos * hidden, &mean, &var, scale_d,
+                 bias_d, 1, eps, hidden);
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
@@ -156,3 +228,5 @@ namespace ops = paddle::operators;
 REGISTER_OP_WITHOUT_GRADIENT(fused_embedding_eltwise_layernorm,
                              ops::EmbeddingEltWiseLayerNormOp,
                              ops::EmbeddingEltWiseLayerNormOpMaker);
+REGISTER_OP_CPU_KERNEL(fused_embedding_eltwise_layernorm,
+                       ops::EmbeddingEltWiseLayerNormCPUKernel<float>);
@@ -194,9 +194,10 @@ REGISTER_OPERATOR(fused_embedding_seq_pool_grad,
                   ops::FusedEmbeddingSeqPoolOpGrad,
                   ops::FusedEmbeddingSeqPoolOpGradVarTypeInference);
 
-REGISTER_OP_CPU_KERNEL(fused_embedding_seq_pool,
-                       ops::FusedEmbeddingSeqPoolKernel<float>,
-                       ops::FusedEmbeddingSeqPoolKernel<double>);
+REGISTER_OP_CPU_KERNEL(
+    fused_embedding_seq_pool, ops::FusedEmbeddingSeqPoolKernel<float>,
+    ops::FusedEmbeddingSeqPoolKernel<double>,
+    ops::FusedEmbeddingSeqPoolKernel<paddle::platform::bfloat16>);
 REGISTER_OP_CPU_KERNEL(fused_embedding_seq_pool_grad,
                        ops::FusedEmbeddingSeqPoolGradKernel<float>,
                        ops::FusedEmbeddingSeqPoolGradKernel<double>);
@@ -24,6 +24,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/platform/bfloat16.h"
 
 namespace paddle {
 namespace operators {
@@ -75,7 +76,8 @@ void prepare_csr_data(const std::vector<uint64_t> &offset,
     }
   }
 }
-#else
+#endif
+
 template <typename T>
 struct EmbeddingVSumFunctor {
   void operator()(const framework::ExecutionContext &context,
@@ -114,7 +116,6 @@ struct EmbeddingVSumFunctor {
     }
   }
 };
-#endif
 
 inline int FusedEmbeddingSeqPoolLastDim(const framework::DDim &table_dims,
                                         const framework::DDim &ids_dims) {
@@ -192,6 +193,41 @@ class FusedEmbeddingSeqPoolKernel : public framework::OpKernel<T> {
   }
 };
 
+// There is no sparse BLAS of bfloat16, the bfloat16 tables are pooled by the
+// EmbSeqPool jit kernels, which sum the rows in float.
+template <>
+class FusedEmbeddingSeqPoolKernel<platform::bfloat16>
+    : public framework::OpKernel<platform::bfloat16> {
+ public:
+  void Compute(const framework::ExecutionContext &context) const override {
+    const LoDTensor *ids_t = context.Input<LoDTensor>("Ids");
+    LoDTensor *output_t = context.Output<LoDTensor>("Out");
+    const LoDTensor *table_var = context.Input<LoDTensor>("W");
+    const std::string &combiner_type = context.Attr<std::string>("combiner");
+    PADDLE_ENFORCE_EQ(
+        context.Attr<int64_t>("padding_idx"), kNoPadding,
+        platform::errors::Unimplemented(
+            "The padding_idx of fused_embedding_seq_pool is not supported "
+            "for bfloat16 tables."));
+
+    int64_t last_dim =
+        FusedEmbeddingSeqPoolLastDim(table_var->dims(), ids_t->dims());
+    const auto &ids_lod = ids_t->lod();
+    PADDLE_ENFORCE_EQ(ids_lod.size(), 1UL,
+                      platform::errors::InvalidArgument(
+                          "The LoD level of Input(Ids) should be 1. But "
+                          "received Ids's LoD level = %d.",
+                          ids_lod.size()));
+    int64_t batch_size = ids_lod[0].size() - 1;
+    output_t->Resize({batch_size, last_dim});
+
+    if (combiner_type == "sum") {
+      EmbeddingVSumFunctor<platform::bfloat16> functor;
+      functor(context, table_var, ids_t, output_t);
+    }
+  }
+};
+
 template <typename T>
 class FusedEmbeddingSeqPoolGradKernel : public framework::OpKernel<T> {
  public:
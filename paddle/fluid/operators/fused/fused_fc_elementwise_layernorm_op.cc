@@ -13,6 +13,8 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
 
 namespace paddle {
 namespace operators {
@@ -243,6 +245,89 @@ add_out <= elementwise_add(fc_out, Y)
   }
 };
 
+template <typename T>
+class FusedFCElementwiseLayerNormCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &ctx) const override {
+    auto *x = ctx.Input<framework::Tensor>("X");
+    auto *w = ctx.Input<framework::Tensor>("W");
+    auto *out = ctx.Output<framework::Tensor>("Out");
+
+    auto w_dims = w->dims();
+    int N = w_dims[1];
+    int K = w_dims[0];
+    int M = framework::product(x->dims()) / K;
+
+    const T *x_data = x->data<T>();
+    const T *w_data = w->data<T>();
+    T *out_data = out->mutable_data<T>(ctx.GetPlace());
+
+    auto &dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(dev_ctx);
+    blas.GEMM(false, false, M, N, K, static_cast<T>(1.0), x_data, K, w_data, N,
+              static_cast<T>(0.0), out_data, N);
+
+    auto *y = ctx.Input<framework::Tensor>("Y");
+    auto *bias_0 = ctx.Input<framework::Tensor>("Bias0");
+    auto *bias_1 = ctx.Input<framework::Tensor>("Bias1");
+    auto *scale = ctx.Input<framework::Tensor>("Scale");
+
+    const T *y_data = y->data<T>();
+    const T *bias_0_data = bias_0 ? bias_0->data<T>() : nullptr;
+    const T *bias_1_data = bias_1 ? bias_1->data<T>() : nullptr;
+    const T *scale_data = scale ? scale->data<T>() : nullptr;
+
+    auto *mean = ctx.Output<framework::Tensor>("Mean");
+    auto *variance = ctx.Output<framework::Tensor>("Variance");
+
+    T *mean_data = mean ? mean->mutable_data<T>(ctx.GetPlace()) : nullptr;
+    T *variance_data =
+        variance ? variance->mutable_data<T>(ctx.GetPlace()) : nullptr;
+
+    bool with_relu =
+        (ctx.Attr<std::string>("activation_type") == "relu") ? true : false;
+    float epsilon = ctx.Attr<float>("epsilon");
+
+    // The input of layer_norm is kept in a temporary buffer, since the jit
+    // layer_norm kernel does not support normalizing in place.
+    framework::Tensor add_out;
+    T *add_out_data = add_out.mutable_data<T>({M, N}, ctx.GetPlace());
+
+    auto vadd =
+        jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(N);
+    auto vadd_relu =
+        jit::KernelFuncs<jit::VAddReluTuple<T>, platform::CPUPlace>::Cache()
+            .At(N);
+    auto vrelu =
+        jit::KernelFuncs<jit::VReluTuple<T>, platform::CPUPlace>::Cache().At(N);
+    auto layer_norm =
+        jit::KernelFuncs<jit::LayerNormTuple<T>, platform::CPUPlace>::Cache()
+            .At(N);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < M; ++i) {
+      T *out_i = out_data + static_cast<int64_t>(i) * N;
+      T *add_out_i = add_out_data + static_cast<int64_t>(i) * N;
+      if (bias_0_data) {
+        if (with_relu) {
+          vadd_relu(bias_0_data, out_i, out_i, N);
+        } else {
+          vadd(bias_0_data, out_i, out_i, N);
+        }
+      } else if (with_relu) {
+        vrelu(out_i, out_i, N);
+      }
+      vadd(out_i, y_data + static_cast<int64_t>(i) * N, add_out_i, N);
+
+      T mean_i, variance_i;
+      layer_norm(add_out_i, out_i, mean_data ? mean_data + i : &mean_i,
+                 variance_data ? variance_data + i : &variance_i, scale_data,
+                 bias_1_data, 1, epsilon, N);
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
@@ -252,3 +337,5 @@ REGISTER_OPERATOR(
     ops::FusedFCElementwiseLayerNormOpMaker,
     paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
     paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OP_CPU_KERNEL(fused_fc_elementwise_layernorm,
+                       ops::FusedFCElementwiseLayerNormCPUKernel<float>);
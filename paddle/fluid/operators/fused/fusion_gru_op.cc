@@ -13,14 +13,10 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/fused/fusion_gru_op.h"
-#include <cstring>  // for memcpy
 #include <string>
 #include <vector>
 #include "paddle/fluid/framework/op_version_registry.h"
-#include "paddle/fluid/operators/jit/kernels.h"
-#include "paddle/fluid/operators/math/blas.h"
-#include "paddle/fluid/operators/math/fc.h"
-#include "paddle/fluid/operators/math/sequence2batch.h"
+#include "paddle/fluid/operators/math/packed_rnn.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
 #endif
@@ -238,237 +234,29 @@ more details can refer to GRU op.
 template <typename T>
 class FusionGRUKernel : public framework::OpKernel<T> {
  public:
+  // Both use_seq and the batch mode run the sequences together on the
+  // packed WeightH, which is the batch mode without the reordering.
   void Compute(const framework::ExecutionContext& ctx) const override {
-    if (ctx.Attr<bool>("use_seq")) {
-      SeqCompute(ctx);
-    } else {
-      BatchCompute(ctx);
-    }
-  }
-
-#define INIT_BASE_DEFINES                                     \
-  auto* x = ctx.Input<LoDTensor>("X");                        \
-  auto* wh = ctx.Input<Tensor>("WeightH");                    \
-  auto* xx = ctx.Output<LoDTensor>("XX");                     \
-  auto x_lod = x->lod();                                      \
-  auto x_dims = x->dims(); /* T x M*/                         \
-  auto x_mat_dims = (x_dims.size() == 3 && x_dims[1] == 1)    \
-                        ? framework::flatten_to_2d(x_dims, 1) \
-                        : x_dims;                             \
-  auto wh_dims = wh->dims(); /* D x 3D*/                      \
-  const int total_T = x_mat_dims[0];                          \
-  const int D3 = wh_dims[1]
-
-#define INIT_OTHER_DEFINES                                                   \
-  auto* h0 = ctx.Input<Tensor>("H0");                                        \
-  auto* wx = ctx.Input<Tensor>("WeightX");                                   \
-  auto* bias = ctx.Input<Tensor>("Bias");                                    \
-  auto* hidden_out = ctx.Output<LoDTensor>("Hidden");                        \
-  bool is_reverse = ctx.Attr<bool>("is_reverse");                            \
-  const int M = x_mat_dims[1];                                               \
-  const int D = wh_dims[0];                                                  \
-  const int D2 = D * 2;                                                      \
-  const jit::gru_attr_t attr(                                                \
-      D, jit::to_kerneltype(ctx.Attr<std::string>("gate_activation")),       \
-      jit::to_kerneltype(ctx.Attr<std::string>("activation")));              \
-  jit::gru_t one_step;                                                       \
-  auto ComputeH1 =                                                           \
-      jit::KernelFuncs<jit::GRUH1Tuple<T>, platform::CPUPlace>::Cache().At(  \
-          attr);                                                             \
-  auto ComputeHtPart1 =                                                      \
-      jit::KernelFuncs<jit::GRUHtPart1Tuple<T>, platform::CPUPlace>::Cache() \
-          .At(attr);                                                         \
-  auto ComputeHtPart2 =                                                      \
-      jit::KernelFuncs<jit::GRUHtPart2Tuple<T>, platform::CPUPlace>::Cache() \
-          .At(attr);                                                         \
-  const T* x_data = x->data<T>();                                            \
-  const T* wx_data = wx->data<T>();                                          \
-  const T* wh_data = wh->data<T>();                                          \
-  auto place = ctx.GetPlace();                                               \
-  T* xx_data = xx->mutable_data<T>(place)
-
-  void SeqCompute(const framework::ExecutionContext& ctx) const {
-    using DeviceContext = paddle::platform::CPUDeviceContext;
-    INIT_BASE_DEFINES;
-    INIT_OTHER_DEFINES;
-    const int N = x_lod[0].size() - 1;
-    const T* h0_data = h0 ? h0->data<T>() : nullptr;
-    const T* wh_state_data = wh_data + D * D2;
-    T* hidden_out_data = hidden_out->mutable_data<T>(place);
-    auto blas = math::GetBlas<DeviceContext, T>(ctx);
-
-    auto& dev_ctx = ctx.template device_context<DeviceContext>();
-    math::FCFunctor<DeviceContext, T> fc;
-    fc(dev_ctx, total_T, D3, M, x_data, wx_data, xx_data,
-       bias ? bias->data<T>() : nullptr);
-
-    int xx_offset = D3;
-    int gate_offset = D;
-    if (is_reverse) {
-      const int offset = (total_T - 1) * D;
-      xx_data = xx_data + offset * 3;
-      hidden_out_data = hidden_out_data + offset;
-      xx_offset = -D3;
-      gate_offset = -D;
-    }
-    auto move_step = [&]() {
-      xx_data = xx_data + xx_offset;
-      hidden_out_data = hidden_out_data + gate_offset;
-    };
-    for (int i = 0; i < N; ++i) {
-      int bid = is_reverse ? N - 1 - i : i;
-      int seq_len = x_lod[0][bid + 1] - x_lod[0][bid];
-      const T* prev_hidden_data = nullptr;
-      int tstart = 0;
-      if (h0_data) {
-        prev_hidden_data = h0_data + bid * D;
-      } else {
-        one_step.gates = xx_data;
-        one_step.ht = hidden_out_data;
-        ComputeH1(&one_step, &attr);
-        prev_hidden_data = hidden_out_data;
-        tstart = 1;
-        move_step();
-      }
-      for (int step = tstart; step < seq_len; ++step) {
-        // gemm prev * (Wu + Wr)
-        blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D2, D, static_cast<T>(1),
-                  prev_hidden_data, D, wh_data, D2, static_cast<T>(1), xx_data,
-                  D3);
-        one_step.gates = xx_data;
-        one_step.ht_1 = prev_hidden_data;
-        one_step.ht = hidden_out_data;
-        ComputeHtPart1(&one_step, &attr);
-        // gemm rt * Ws
-        blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D, D, static_cast<T>(1),
-                  hidden_out_data, D, wh_state_data, D, static_cast<T>(1),
-                  xx_data + D2, D3);
-        ComputeHtPart2(&one_step, &attr);
-        // save prev
-        prev_hidden_data = hidden_out_data;
-        move_step();
-      }
-    }
-  }
-
-  void BatchCompute(const framework::ExecutionContext& ctx) const {
     using DeviceContext = paddle::platform::CPUDeviceContext;
-    INIT_BASE_DEFINES;
-    if (x_lod[0].size() == 2) {
-      xx->Resize({total_T, D3});
-      SeqCompute(ctx);
-      return;
-    }
-    INIT_OTHER_DEFINES;
-    auto* reordered_h0 = ctx.Output<Tensor>("ReorderedH0");
-    auto* batched_input = ctx.Output<LoDTensor>("BatchedInput");
-    auto* batched_out = ctx.Output<LoDTensor>("BatchedOut");
-    T* batched_input_data = batched_input->mutable_data<T>(place);
-    T* batched_out_data = batched_out->mutable_data<T>(place);
-    hidden_out->mutable_data<T>(place);
-    auto& dev_ctx = ctx.template device_context<DeviceContext>();
-    auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
-    math::LoDTensor2BatchFunctor<DeviceContext, T> to_batch;
-
-    math::FCFunctor<DeviceContext, T> fc;
-    if (M > D3) {
-      fc(dev_ctx, total_T, D3, M, x_data, wx_data, xx_data,
-         bias ? bias->data<T>() : nullptr);
-      to_batch(dev_ctx, *xx, batched_input, true, is_reverse);
-    } else {
-      to_batch(dev_ctx, *x, xx, true, is_reverse);
-      batched_input->set_lod(xx->lod());
-      fc(dev_ctx, total_T, D3, M, xx_data, wx_data, batched_input_data,
-         bias ? bias->data<T>() : nullptr);
-    }
-
-    auto batched_lod = batched_input->lod();
-    const auto& seq_order = batched_lod[2];
-    const int max_bs = seq_order.size();
-    reordered_h0->Resize({max_bs, D});
-
-    int tstart = 0;
-    T* prev_hidden_data = nullptr;
-    if (h0) {
-      // reorder h0
-      T* reordered_h0_data = reordered_h0->mutable_data<T>(place);
-      const T* h0_data = h0->data<T>();
-      prev_hidden_data = reordered_h0_data;
-      size_t sz = sizeof(T) * D;
-      for (int i = 0; i < max_bs; ++i) {
-        std::memcpy(reordered_h0_data, h0_data + seq_order[i] * D, sz);
-        reordered_h0_data += D;
-      }
-    } else {
-      // compute without h0
-      T* cur_in_data = batched_input_data;
-      T* cur_out_data = batched_out_data;
-      // W: {W_update, W_reset; W_state}
-      for (int i = 0; i < max_bs; ++i) {
-        one_step.gates = cur_in_data;
-        one_step.ht = cur_out_data;
-        ComputeH1(&one_step, &attr);
-        // add offset
-        cur_in_data += D3;
-        cur_out_data += D;
-      }
-      tstart = 1;
-      prev_hidden_data = batched_out_data;
-    }
-    // Then start from next
-    const T* wh_state_data = wh_data + D * D2;
-    const auto& batch_starts = batched_lod[0];
-    const int max_seq_len = batch_starts.size() - 1;
-    batched_input_data = batched_input_data + tstart * max_bs * D3;
-    batched_out_data = batched_out_data + tstart * max_bs * D;
-    for (int step = tstart; step < max_seq_len; ++step) {
-      const int cur_bs = batch_starts[step + 1] - batch_starts[step];
-      // gemm prev * (Wu + Wr)
-      blas.GEMM(CblasNoTrans, CblasNoTrans, cur_bs, D2, D, static_cast<T>(1),
-                prev_hidden_data, D, wh_data, D2, static_cast<T>(1),
-                batched_input_data, D3);
-
-      T* cur_batched_data = batched_input_data;
-      T* cur_out_data = batched_out_data;
-      T* cur_prev_hidden_data = prev_hidden_data;
-      for (int i = 0; i < cur_bs; ++i) {
-        one_step.gates = cur_batched_data;
-        one_step.ht_1 = cur_prev_hidden_data;
-        one_step.ht = cur_out_data;
-        ComputeHtPart1(&one_step, &attr);
-
-        cur_batched_data += D3;
-        cur_prev_hidden_data += D;
-        cur_out_data += D;
-      }
-
-      cur_batched_data = batched_input_data;
-      cur_out_data = batched_out_data;
-      blas.GEMM(CblasNoTrans, CblasNoTrans, cur_bs, D, D, static_cast<T>(1),
-                cur_out_data, D, wh_state_data, D, static_cast<T>(1),
-                cur_batched_data + D2, D3);
-
-      cur_prev_hidden_data = prev_hidden_data;
-      for (int i = 0; i < cur_bs; ++i) {
-        one_step.gates = cur_batched_data;
-        one_step.ht_1 = cur_prev_hidden_data;
-        one_step.ht = cur_out_data;
-        ComputeHtPart2(&one_step, &attr);
-        cur_batched_data += D3;
-        cur_prev_hidden_data += D;
-        cur_out_data += D;
-      }
-      prev_hidden_data = batched_out_data;
-      batched_out_data = cur_out_data;
-      batched_input_data = cur_batched_data;
-    }
+    auto* x = ctx.Input<LoDTensor>("X");
+    auto* h0 = ctx.Input<Tensor>("H0");
+    auto* wx = ctx.Input<Tensor>("WeightX");
+    auto* wh = ctx.Input<Tensor>("WeightH");
+    auto* bias = ctx.Input<Tensor>("Bias");
+    auto* hidden_out = ctx.Output<LoDTensor>("Hidden");
 
-    math::Batch2LoDTensorFunctor<DeviceContext, T> to_seq;
-    batched_out->set_lod(batched_lod);
-    to_seq(dev_ctx, *batched_out, hidden_out);
+    math::PackedRNNAttr attr;
+    attr.cell = math::PackedRNNCell::kGRU;
+    attr.is_reverse = ctx.Attr<bool>("is_reverse");
+    attr.gate_activation = ctx.Attr<std::string>("gate_activation");
+    attr.candidate_activation = ctx.Attr<std::string>("activation");
+    attr.origin_mode = ctx.Attr<bool>("origin_mode");
+    auto* op = dynamic_cast<const FusionGRUOp*>(&ctx.GetOp());
+    math::PackedRNNFunctor<T> rnn;
+    rnn(ctx.template device_context<DeviceContext>(), attr, *x,
+        {math::PackedRNNWeight{wx, wh, bias}},
+        op ? op->packed_weights() : nullptr, h0, nullptr, hidden_out, nullptr);
   }
-#undef INIT_OTHER_DEFINES
-#undef INIT_BASE_DEFINES
 };
 
 }  // namespace operators
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/math/packed_rnn.h"
 
 namespace paddle {
 namespace operators {
@@ -27,9 +28,16 @@ class FusionGRUOp : public framework::OperatorWithKernel {
 
   void InferShape(framework::InferShapeContext* ctx) const override;
 
+  math::PackedRNNWeightCache* packed_weights() const {
+    return &packed_weights_;
+  }
+
  protected:
   framework::OpKernelType GetExpectedKernelType(
       const framework::ExecutionContext& ctx) const override;
+
+ private:
+  mutable math::PackedRNNWeightCache packed_weights_;
 };
 
 class FusionGRUOpMaker : public framework::OpProtoAndCheckerMaker {
@@ -14,10 +14,7 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/fused/fusion_lstm_op.h"
 #include <string>
-#include "paddle/fluid/operators/jit/kernels.h"
-#include "paddle/fluid/operators/math/blas.h"
-#include "paddle/fluid/operators/math/fc.h"
-#include "paddle/fluid/operators/math/sequence2batch.h"
+#include "paddle/fluid/operators/math/packed_rnn.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
 #endif
@@ -262,259 +259,32 @@ This operator fuse the X into LSTM, more details can refer to LSTM op.
 template <typename T>
 class FuisonLSTMKernel : public framework::OpKernel<T> {
  public:
-#define INIT_BASE_DEFINES                                   \
-  using DeviceContext = paddle::platform::CPUDeviceContext; \
-  auto* x = ctx.Input<LoDTensor>("X");                      \
-  auto* h0 = ctx.Input<Tensor>("H0");                       \
-  auto* c0 = ctx.Input<Tensor>("C0");                       \
-  auto* wx = ctx.Input<Tensor>("WeightX");                  \
-  auto* wh = ctx.Input<Tensor>("WeightH");                  \
-  auto* bias = ctx.Input<Tensor>("Bias");                   \
-  auto* xx = ctx.Output<LoDTensor>("XX");                   \
-  auto* hidden_out = ctx.Output<LoDTensor>("Hidden");       \
-  auto* cell_out = ctx.Output<LoDTensor>("Cell");           \
-  bool is_reverse = ctx.Attr<bool>("is_reverse");           \
-  bool use_peepholes = ctx.Attr<bool>("use_peepholes");     \
-  auto x_dims = x->dims();   /* T x M*/                     \
-  auto wh_dims = wh->dims(); /* D x 4D*/                    \
-  const int M = x_dims[1];                                  \
-  const int D = wh_dims[0];                                 \
-  const int D4 = wh_dims[1]
-
-#define INIT_OTHER_DEFINES                                                     \
-  const T* x_data = x->data<T>();                                              \
-  const T* wx_data = wx->data<T>();                                            \
-  const T* wh_data = wh->data<T>();                                            \
-  /* diagonal weight*/                                                         \
-  const T* wp_data = bias->data<T>() + D4;                                     \
-  /* for peephole only*/                                                       \
-  T* checked_cell_data = nullptr;                                              \
-  auto place = ctx.GetPlace();                                                 \
-  if (use_peepholes) {                                                         \
-    /* w_ic * Ct-1, w_fc * Ct-1  ; w_oc * Ct => ih*/                           \
-    auto* checked_cell = ctx.Output<Tensor>("CheckedCell");                    \
-    checked_cell_data = checked_cell->mutable_data<T>(place);                  \
-  }                                                                            \
-  const jit::lstm_attr_t attr(                                                 \
-      D, jit::to_kerneltype(ctx.Attr<std::string>("gate_activation")),         \
-      jit::to_kerneltype(ctx.Attr<std::string>("candidate_activation")),       \
-      jit::to_kerneltype(ctx.Attr<std::string>("cell_activation")),            \
-      use_peepholes);                                                          \
-  jit::lstm_t one_step;                                                        \
-  one_step.wp = wp_data;                                                       \
-  one_step.checked = checked_cell_data;                                        \
-  auto ComputeC1H1 =                                                           \
-      jit::KernelFuncs<jit::LSTMC1H1Tuple<T>, platform::CPUPlace>::Cache().At( \
-          attr);                                                               \
-  auto ComputeCtHt =                                                           \
-      jit::KernelFuncs<jit::LSTMCtHtTuple<T>, platform::CPUPlace>::Cache().At( \
-          attr)
-
-// Wh GEMM
-#define GEMM_WH_ADDON(bs, prev, out)                                           \
-  blas.GEMM(CblasNoTrans, CblasNoTrans, bs, D4, D, static_cast<T>(1), prev, D, \
-            wh_data, D4, static_cast<T>(1), out, D4)
-
-  void SeqCompute(const framework::ExecutionContext& ctx) const {
-    INIT_BASE_DEFINES;
-    INIT_OTHER_DEFINES;
-    auto x_lod = x->lod();
-    const int total_T = x_dims[0];
-    const int N = x_lod[0].size() - 1;
-    const T* h0_data = h0 ? h0->data<T>() : nullptr;
-    const T* c0_data = c0 ? c0->data<T>() : nullptr;
-    T* xx_data = xx->mutable_data<T>(place);
-    T* h_out_data = hidden_out->mutable_data<T>(place);
-    T* c_out_data = cell_out->mutable_data<T>(place);
-    auto blas = math::GetBlas<DeviceContext, T>(ctx);
-
-    auto& dev_ctx = ctx.template device_context<DeviceContext>();
-    math::FCFunctor<DeviceContext, T> fc;
-    fc(dev_ctx, total_T, D4, M, x_data, wx_data, xx_data, bias->data<T>());
-
-    int xx_offset = D4;
-    int gate_offset = D;
-    if (is_reverse) {
-      const int offset = (total_T - 1) * D;
-      xx_data = xx_data + offset * 4;
-      h_out_data = h_out_data + offset;
-      c_out_data = c_out_data + offset;
-      xx_offset = -D4;
-      gate_offset = -D;
-    }
-
-    for (int i = 0; i < N; ++i) {
-      int bid = is_reverse ? N - 1 - i : i;
-      int seq_len = x_lod[0][bid + 1] - x_lod[0][bid];
-      const T* prev_c_data = nullptr;
-      const T* prev_h_data = nullptr;
-      int tstart = 0;
-      if (h0_data) {
-        prev_h_data = h0_data + bid * D;
-        prev_c_data = c0_data + bid * D;
-      } else {
-        one_step.gates = xx_data;
-        one_step.ct = c_out_data;
-        one_step.ht = h_out_data;
-        ComputeC1H1(&one_step, &attr);
-        tstart = 1;
-        // move one step
-        prev_h_data = h_out_data;
-        prev_c_data = c_out_data;
-        xx_data = xx_data + xx_offset;
-        h_out_data = h_out_data + gate_offset;
-        c_out_data = c_out_data + gate_offset;
-      }
-      for (int step = tstart; step < seq_len; ++step) {
-        GEMM_WH_ADDON(1, prev_h_data, xx_data);
-
-        one_step.gates = xx_data;
-        one_step.ct_1 = prev_c_data;
-        one_step.ct = c_out_data;
-        one_step.ht = h_out_data;
-        ComputeCtHt(&one_step, &attr);
-        // move one step
-        prev_h_data = h_out_data;
-        prev_c_data = c_out_data;
-        xx_data = xx_data + xx_offset;
-        h_out_data = h_out_data + gate_offset;
-        c_out_data = c_out_data + gate_offset;
-      }
-    }
-  }
-
-  void BatchCompute(const framework::ExecutionContext& ctx) const {
-    INIT_BASE_DEFINES;
-    if (x->lod()[0].size() == 2) {
-      xx->Resize({x_dims[0], D4});
-      SeqCompute(ctx);
-      return;
-    }
-    INIT_OTHER_DEFINES;
-
-    auto* reordered_h0 = ctx.Output<Tensor>("ReorderedH0");
-    auto* reordered_c0 = ctx.Output<Tensor>("ReorderedC0");
-    auto* batched_input = ctx.Output<LoDTensor>("BatchedInput");
-    auto* batched_c_out = ctx.Output<LoDTensor>("BatchedCell");
-    auto* batched_h_out = ctx.Output<LoDTensor>("BatchedHidden");
-    T* xx_data = xx->mutable_data<T>(place);
-    T* batched_input_data = batched_input->mutable_data<T>(place);
-    T* batched_c_out_data = batched_c_out->mutable_data<T>(place);
-    T* batched_h_out_data = batched_h_out->mutable_data<T>(place);
-    hidden_out->mutable_data<T>(place);
-    cell_out->mutable_data<T>(place);
-
-    math::LoDTensor2BatchFunctor<DeviceContext, T> to_batch;
-    auto& dev_ctx = ctx.template device_context<DeviceContext>();
-    auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
-    math::FCFunctor<DeviceContext, T> fc;
-    if (M > D4) {
-      fc(dev_ctx, x_dims[0], D4, M, x_data, wx_data, xx_data, bias->data<T>());
-      to_batch(dev_ctx, *xx, batched_input, true, is_reverse);
-    } else {
-      to_batch(dev_ctx, *x, xx, true, is_reverse);
-      batched_input->set_lod(xx->lod());
-      fc(dev_ctx, x_dims[0], D4, M, xx_data, wx_data, batched_input_data,
-         bias->data<T>());
-    }
-
-    auto batched_lod = batched_input->lod();
-    const auto& seq_order = batched_lod[2];
-    const int max_bs = seq_order.size();
-    reordered_h0->Resize({max_bs, D});
-    reordered_c0->Resize({max_bs, D});
-
-    int tstart = 0;
-    T* prev_h_data = nullptr;
-    T* prev_c_data = nullptr;
-    if (h0) {
-      // reorder h0, c0
-      T* reordered_h0_data = reordered_h0->mutable_data<T>(place);
-      T* reordered_c0_data = reordered_c0->mutable_data<T>(place);
-      const T* h0_data = h0->data<T>();
-      const T* c0_data = c0->data<T>();
-      prev_h_data = reordered_h0_data;
-      prev_c_data = reordered_c0_data;
-      size_t sz = D;
-      for (int i = 0; i < max_bs; ++i) {
-        blas.VCOPY(sz, h0_data + seq_order[i] * D, reordered_h0_data);
-        blas.VCOPY(sz, c0_data + seq_order[i] * D, reordered_c0_data);
-        reordered_h0_data += D;
-        reordered_c0_data += D;
-      }
-    } else {
-      // compute without h0, c0
-      T* cur_in_data = batched_input_data;
-      T* cur_h_out_data = batched_h_out_data;
-      T* cur_c_out_data = batched_c_out_data;
-      for (int i = 0; i < max_bs; ++i) {
-        one_step.gates = cur_in_data;
-        one_step.ct = cur_c_out_data;
-        one_step.ht = cur_h_out_data;
-        ComputeC1H1(&one_step, &attr);
-
-        cur_in_data += D4;
-        cur_c_out_data += D;
-        cur_h_out_data += D;
-      }
-      tstart = 1;
-      prev_h_data = batched_h_out_data;
-      prev_c_data = batched_c_out_data;
-    }
-
-    // compute kernel part
-    const auto& batch_starts = batched_lod[0];
-    const int max_seq_len = batch_starts.size() - 1;
-    const int offset = tstart * max_bs * D;
-    batched_input_data = batched_input_data + offset * 4;
-    batched_h_out_data = batched_h_out_data + offset;
-    batched_c_out_data = batched_c_out_data + offset;
-    for (int step = tstart; step < max_seq_len; ++step) {
-      const int cur_bs = batch_starts[step + 1] - batch_starts[step];
-      GEMM_WH_ADDON(cur_bs, prev_h_data, batched_input_data);
-      T* cur_in_data = batched_input_data;
-      T* cur_prev_c_data = prev_c_data;
-      T* cur_c_out_data = batched_c_out_data;
-      T* cur_h_out_data = batched_h_out_data;
-      for (int i = 0; i < cur_bs; ++i) {
-        one_step.gates = cur_in_data;
-        one_step.ct_1 = cur_prev_c_data;
-        one_step.ct = cur_c_out_data;
-        one_step.ht = cur_h_out_data;
-        ComputeCtHt(&one_step, &attr);
-
-        // move one batch
-        cur_in_data += D4;
-        cur_prev_c_data += D;
-        cur_c_out_data += D;
-        cur_h_out_data += D;
-      }
-      // move one step
-      prev_c_data = batched_c_out_data;
-      prev_h_data = batched_h_out_data;
-      batched_c_out_data = cur_c_out_data;
-      batched_h_out_data = cur_h_out_data;
-      batched_input_data = cur_in_data;
-    }
-
-    math::Batch2LoDTensorFunctor<DeviceContext, T> to_seq;
-    batched_h_out->set_lod(batched_lod);
-    to_seq(dev_ctx, *batched_h_out, hidden_out);
-    batched_c_out->set_lod(batched_lod);
-    to_seq(dev_ctx, *batched_c_out, cell_out);
-  }
-
+  // Both use_seq and the batch mode run the sequences together on the
+  // packed WeightH, which is the batch mode without the reordering.
   void Compute(const framework::ExecutionContext& ctx) const override {
-    if (ctx.Attr<bool>("use_seq")) {
-      SeqCompute(ctx);
-    } else {
-      BatchCompute(ctx);
-    }
+    using DeviceContext = paddle::platform::CPUDeviceContext;
+    auto* x = ctx.Input<LoDTensor>("X");
+    auto* h0 = ctx.Input<Tensor>("H0");
+    auto* c0 = ctx.Input<Tensor>("C0");
+    auto* wx = ctx.Input<Tensor>("WeightX");
+    auto* wh = ctx.Input<Tensor>("WeightH");
+    auto* bias = ctx.Input<Tensor>("Bias");
+    auto* hidden_out = ctx.Output<LoDTensor>("Hidden");
+    auto* cell_out = ctx.Output<LoDTensor>("Cell");
+
+    math::PackedRNNAttr attr;
+    attr.cell = math::PackedRNNCell::kLSTM;
+    attr.is_reverse = ctx.Attr<bool>("is_reverse");
+    attr.use_peepholes = ctx.Attr<bool>("use_peepholes");
+    attr.gate_activation = ctx.Attr<std::string>("gate_activation");
+    attr.candidate_activation = ctx.Attr<std::string>("candidate_activation");
+    attr.cell_activation = ctx.Attr<std::string>("cell_activation");
+    auto* op = dynamic_cast<const FusionLSTMOp*>(&ctx.GetOp());
+    math::PackedRNNFunctor<T> rnn;
+    rnn(ctx.template device_context<DeviceContext>(), attr, *x,
+        {math::PackedRNNWeight{wx, wh, bias}},
+        op ? op->packed_weights() : nullptr, h0, c0, hidden_out, cell_out);
   }
-
-#undef GEMM_WH_ADDON
-#undef INIT_OTHER_DEFINES
-#undef INIT_BASE_DEFINES
 };
 
 }  // namespace operators
@@ -15,7 +15,7 @@
 #include "paddle/fluid/operators/fused/fusion_seqpool_concat_op.h"
 #include <string>
 #include <vector>
-#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/sequence_pooling.h"
 
 namespace paddle {
 namespace operators {
@@ -73,16 +73,51 @@ void FusionSeqPoolConcatOpMaker::Make() {
                        "(string, default 'SUM') some of the pooling "
                        "pooltype of SequencePoolOp.")
       .SetDefault("SUM")
-      .InEnum({"AVERAGE", "SUM", "SQRT"});
+      .InEnum({"AVERAGE", "SUM", "SQRT", "MAX", "LAST", "FIRST"});
   AddAttr<int>("axis",
                "The axis along which the input tensors will be concatenated. "
                "Only supports concat axis=1 yet.")
       .SetDefault(1);
   AddComment(R"DOC(
-Fusion Sequence Pool of pooltype(sum, average and sqrt) and Concat Operator.
+Fusion Sequence Pool and Concat Operator.
+
+Pools the sequences of every input by pooltype, one of sum, average, sqrt,
+max, last and first, and concats the pooled inputs along axis 1. The
+sequences of all the inputs are pooled in parallel, and the empty ones are 0.
 )DOC");
 }
 
+void FusionSeqPoolConcatGradOp::InferShape(
+    framework::InferShapeContext* ctx) const {
+  OP_INOUT_CHECK(ctx->HasInputs("X"), "Input", "X", "FusionSeqPoolConcatGrad");
+  OP_INOUT_CHECK(ctx->HasInput(framework::GradVarName("Out")), "Input",
+                 framework::GradVarName("Out"), "FusionSeqPoolConcatGrad");
+  ctx->SetOutputsDim(framework::GradVarName("X"), ctx->GetInputsDim("X"));
+  ctx->ShareAllLoD("X", framework::GradVarName("X"));
+}
+
+framework::OpKernelType FusionSeqPoolConcatGradOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return framework::OpKernelType(OperatorWithKernel::IndicateVarDataType(
+                                     ctx, framework::GradVarName("Out")),
+                                 ctx.GetPlace());
+}
+
+template <typename T>
+class FusionSeqPoolConcatGradOpMaker : public framework::SingleGradOpMaker<T> {
+ public:
+  using framework::SingleGradOpMaker<T>::SingleGradOpMaker;
+
+ protected:
+  void Apply(GradOpPtr<T> op) const override {
+    op->SetType("fusion_seqpool_concat_grad");
+    op->SetInput("X", this->Input("X"));
+    op->SetInput(framework::GradVarName("Out"), this->OutputGrad("Out"));
+    op->SetOutput(framework::GradVarName("X"), this->InputGrad("X", false));
+    op->SetAttrMap(this->Attrs());
+  }
+};
+
 template <typename T>
 class FusionSeqPoolConcatKernel : public framework::OpKernel<T> {
  public:
@@ -90,61 +125,31 @@ class FusionSeqPoolConcatKernel : public framework::OpKernel<T> {
     auto ins = ctx.MultiInput<LoDTensor>("X");
     auto* out = ctx.Output<LoDTensor>("Out");
     std::string pooltype = ctx.Attr<std::string>("pooltype");
-    auto x0_lod = ins[0]->lod();
-    auto x0_dims = ins[0]->dims();
-    auto y_dims = out->dims();
-    size_t bs = x0_lod[0].size() - 1;
-    out->Resize({static_cast<int64_t>(bs), y_dims[1]});
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    math::MultiSlotSeqPoolFunctor<T> seqpool;
+    seqpool(dev_ctx, pooltype, static_cast<T>(0), ins, false, out);
+
+    size_t bs = out->dims()[0];
     framework::LoD y_lod(1);
     y_lod[0].resize(bs + 1);
     for (size_t i = 0; i <= bs; ++i) {
       y_lod[0][i] = i;
     }
     out->set_lod(y_lod);
-    auto place = ctx.GetPlace();
-    T* y_data = out->mutable_data<T>(place);
-
-    int w = ins[0]->numel() / x0_dims[0];
-    PADDLE_ENFORCE_EQ(y_dims[1] % w, 0,
-                      platform::errors::InvalidArgument(
-                          "The output of dims[1] should be dividable of w, but "
-                          "dims[1] is %d, w is %d.",
-                          y_dims[1], w));
-    jit::seq_pool_attr_t attr(w, jit::SeqPoolType::kSum);
-    if (pooltype == "AVERAGE") {
-      attr.type = jit::SeqPoolType::kAvg;
-    } else if (pooltype == "SQRT") {
-      attr.type = jit::SeqPoolType::kSqrt;
-    }
-    auto seqpool =
-        jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
-            attr);
-    size_t n = ins.size();
-    size_t dst_step_size = n * w;
-    for (size_t i = 0; i < n; ++i) {
-      auto x_dims = ins[i]->dims();
-      auto x_lod = ins[i]->lod()[0];
-      const T* src = ins[i]->data<T>();
-      T* dst = y_data + i * w;
-      PADDLE_ENFORCE_EQ(
-          static_cast<int>(ins[i]->numel() / x_dims[0]), w,
-          platform::errors::InvalidArgument(
-              "Width of all inputs should be equal, but the width of the %d-th "
-              "input %d is not equal to the previous %d",
-              i, static_cast<int>(ins[i]->numel() / x_dims[0]), w));
-      PADDLE_ENFORCE_EQ(
-          x_lod.size(), bs + 1,
-          platform::errors::InvalidArgument(
-              "Batchsize of all inputs should be equal, but the value of the "
-              "%d-th %d is not equal to the previous %d.",
-              i, x_lod.size(), bs + 1));
-      for (size_t j = 0; j < bs; ++j) {
-        attr.h = static_cast<int>(x_lod[j + 1] - x_lod[j]);
-        seqpool(src, dst, &attr);
-        dst += dst_step_size;
-        src += attr.h * attr.w;
-      }
-    }
+  }
+};
+
+template <typename T>
+class FusionSeqPoolConcatGradKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto ins = ctx.MultiInput<LoDTensor>("X");
+    auto* out_grad = ctx.Input<LoDTensor>(framework::GradVarName("Out"));
+    auto in_grads = ctx.MultiOutput<LoDTensor>(framework::GradVarName("X"));
+    std::string pooltype = ctx.Attr<std::string>("pooltype");
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    math::MultiSlotSeqPoolGradFunctor<T> seqpool_grad;
+    seqpool_grad(dev_ctx, pooltype, ins, *out_grad, nullptr, false, in_grads);
   }
 };
 
@@ -152,9 +157,16 @@ class FusionSeqPoolConcatKernel : public framework::OpKernel<T> {
 }  // namespace paddle
 
 namespace ops = paddle::operators;
-REGISTER_OPERATOR(fusion_seqpool_concat, ops::FusionSeqPoolConcatOp,
-                  ops::FusionSeqPoolConcatOpMaker);
+REGISTER_OPERATOR(
+    fusion_seqpool_concat, ops::FusionSeqPoolConcatOp,
+    ops::FusionSeqPoolConcatOpMaker,
+    ops::FusionSeqPoolConcatGradOpMaker<paddle::framework::OpDesc>,
+    ops::FusionSeqPoolConcatGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OPERATOR(fusion_seqpool_concat_grad, ops::FusionSeqPoolConcatGradOp);
 
 REGISTER_OP_CPU_KERNEL(fusion_seqpool_concat,
                        ops::FusionSeqPoolConcatKernel<float>,
                        ops::FusionSeqPoolConcatKernel<double>);
+REGISTER_OP_CPU_KERNEL(fusion_seqpool_concat_grad,
+                       ops::FusionSeqPoolConcatGradKernel<float>,
+                       ops::FusionSeqPoolConcatGradKernel<double>);
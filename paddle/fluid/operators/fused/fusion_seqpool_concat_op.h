@@ -32,6 +32,17 @@ class FusionSeqPoolConcatOp : public framework::OperatorWithKernel {
       const framework::ExecutionContext& ctx) const override;
 };
 
+class FusionSeqPoolConcatGradOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override;
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override;
+};
+
 class FusionSeqPoolConcatOpMaker : public framework::OpProtoAndCheckerMaker {
  public:
   void Make() override;
@@ -15,7 +15,7 @@
 #include "paddle/fluid/operators/fused/fusion_seqpool_cvm_concat_op.h"
 #include <string>
 #include <vector>
-#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/sequence_pooling.h"
 
 namespace paddle {
 namespace operators {
@@ -73,17 +73,59 @@ void FusionSeqPoolCVMConcatOpMaker::Make() {
                        "(string, default 'SUM') some of the pooling "
                        "pooltype of SequencePoolOp.")
       .SetDefault("SUM")
-      .InEnum({"AVERAGE", "SUM", "SQRT"});
+      .InEnum({"AVERAGE", "SUM", "SQRT", "MAX", "LAST", "FIRST"});
   AddAttr<bool>("use_cvm", "bool, use cvm or not").SetDefault(true);
   AddAttr<int>("axis",
                "The axis along which the input tensors will be concatenated. "
                "Only supports concat axis=1 yet.")
       .SetDefault(1);
   AddComment(R"DOC(
-Fusion Sequence Pool of pooltype(sum, average and sqrt) and Concat Operator.
+Fusion Sequence Pool, CVM and Concat Operator.
+
+Pools the sequences of every input by pooltype, one of sum, average, sqrt,
+max, last and first, applies cvm to the show and click of the pooled inputs
+and concats them along axis 1. The sequences of all the inputs are pooled in
+parallel, and the empty ones are 0 before cvm. The gradients of show and
+click are CVM.
 )DOC");
 }
 
+void FusionSeqPoolCVMConcatGradOp::InferShape(
+    framework::InferShapeContext* ctx) const {
+  OP_INOUT_CHECK(ctx->HasInputs("X"), "Input", "X",
+                 "FusionSeqPoolCVMConcatGrad");
+  OP_INOUT_CHECK(ctx->HasInput("CVM"), "Input", "CVM",
+                 "FusionSeqPoolCVMConcatGrad");
+  OP_INOUT_CHECK(ctx->HasInput(framework::GradVarName("Out")), "Input",
+                 framework::GradVarName("Out"), "FusionSeqPoolCVMConcatGrad");
+  ctx->SetOutputsDim(framework::GradVarName("X"), ctx->GetInputsDim("X"));
+  ctx->ShareAllLoD("X", framework::GradVarName("X"));
+}
+
+framework::OpKernelType FusionSeqPoolCVMConcatGradOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return framework::OpKernelType(OperatorWithKernel::IndicateVarDataType(
+                                     ctx, framework::GradVarName("Out")),
+                                 ctx.GetPlace());
+}
+
+template <typename T>
+class FusionSeqPoolCVMConcatGradOpMaker
+    : public framework::SingleGradOpMaker<T> {
+ public:
+  using framework::SingleGradOpMaker<T>::SingleGradOpMaker;
+
+ protected:
+  void Apply(GradOpPtr<T> op) const override {
+    op->SetType("fusion_seqpool_cvm_concat_grad");
+    op->SetInput("X", this->Input("X"));
+    op->SetInput("CVM", this->Input("CVM"));
+    op->SetInput(framework::GradVarName("Out"), this->OutputGrad("Out"));
+    op->SetOutput(framework::GradVarName("X"), this->InputGrad("X", false));
+    op->SetAttrMap(this->Attrs());
+  }
+};
+
 template <typename T>
 class FusionSeqPoolCVMConcatKernel : public framework::OpKernel<T> {
  public:
@@ -91,58 +133,35 @@ class FusionSeqPoolCVMConcatKernel : public framework::OpKernel<T> {
     auto ins = ctx.MultiInput<LoDTensor>("X");
     auto* out = ctx.Output<LoDTensor>("Out");
     std::string pooltype = ctx.Attr<std::string>("pooltype");
-    auto x0_lod = ins[0]->lod();
-    auto x0_dims = ins[0]->dims();
-    auto y_dims = out->dims();
-    size_t bs = x0_lod[0].size() - 1;
-    out->Resize({static_cast<int64_t>(bs), y_dims[1]});
+    bool use_cvm = ctx.Attr<bool>("use_cvm");
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    math::MultiSlotSeqPoolFunctor<T> seqpool;
+    seqpool(dev_ctx, pooltype, static_cast<T>(0), ins, use_cvm, out);
+
+    size_t bs = out->dims()[0];
     framework::LoD y_lod(1);
     y_lod[0].resize(bs + 1);
     for (size_t i = 0; i <= bs; ++i) {
       y_lod[0][i] = i;
     }
     out->set_lod(y_lod);
-    auto place = ctx.GetPlace();
-    T* y_data = out->mutable_data<T>(place);
-
-    int w = ins[0]->numel() / x0_dims[0];
-    PADDLE_ENFORCE_EQ(y_dims[1] % w, 0,
-                      paddle::platform::errors::InvalidArgument(
-                          "The output of dims[1] should be dividable of w"));
-    jit::seq_pool_attr_t attr(w, jit::SeqPoolType::kSum);
-    if (pooltype == "AVERAGE") {
-      attr.type = jit::SeqPoolType::kAvg;
-    } else if (pooltype == "SQRT") {
-      attr.type = jit::SeqPoolType::kSqrt;
-    }
-    auto seqpool =
-        jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
-            attr);
-    size_t n = ins.size();
-    size_t dst_step_size = n * w;
-    for (size_t i = 0; i < n; ++i) {
-      auto x_dims = ins[i]->dims();
-      auto x_lod = ins[i]->lod()[0];
-      const T* src = ins[i]->data<T>();
-      T* dst = y_data + i * w;
-      PADDLE_ENFORCE_EQ(static_cast<int>(ins[i]->numel() / x_dims[0]), w,
-                        paddle::platform::errors::InvalidArgument(
-                            "Width of all inputs should be equal."));
-      PADDLE_ENFORCE_EQ(x_lod.size(), bs + 1,
-                        paddle::platform::errors::InvalidArgument(
-                            "Batchsize of all inputs should be equal."));
-      for (size_t j = 0; j < bs; ++j) {
-        attr.h = static_cast<int>(x_lod[j + 1] - x_lod[j]);
-        seqpool(src, dst, &attr);
-
-        // Currently only use_cvm is true.
-        dst[0] = log(dst[0] + 1);
-        dst[1] = log(dst[1] + 1) - dst[0];
-
-        dst += dst_step_size;
-        src += attr.h * attr.w;
-      }
-    }
+  }
+};
+
+// The gradients of show and click are the CVM, like the cvm op.
+template <typename T>
+class FusionSeqPoolCVMConcatGradKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto ins = ctx.MultiInput<LoDTensor>("X");
+    auto* cvm = ctx.Input<LoDTensor>("CVM");
+    auto* out_grad = ctx.Input<LoDTensor>(framework::GradVarName("Out"));
+    auto in_grads = ctx.MultiOutput<LoDTensor>(framework::GradVarName("X"));
+    std::string pooltype = ctx.Attr<std::string>("pooltype");
+    bool use_cvm = ctx.Attr<bool>("use_cvm");
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    math::MultiSlotSeqPoolGradFunctor<T> seqpool_grad;
+    seqpool_grad(dev_ctx, pooltype, ins, *out_grad, cvm, use_cvm, in_grads);
   }
 };
 
@@ -153,9 +172,14 @@ namespace ops = paddle::operators;
 REGISTER_OPERATOR(
     fusion_seqpool_cvm_concat, ops::FusionSeqPoolCVMConcatOp,
     ops::FusionSeqPoolCVMConcatOpMaker,
-    paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
-    paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+    ops::FusionSeqPoolCVMConcatGradOpMaker<paddle::framework::OpDesc>,
+    ops::FusionSeqPoolCVMConcatGradOpMaker<paddle::imperative::OpBase>);
+REGISTER_OPERATOR(fusion_seqpool_cvm_concat_grad,
+                  ops::FusionSeqPoolCVMConcatGradOp);
 
 REGISTER_OP_CPU_KERNEL(fusion_seqpool_cvm_concat,
                        ops::FusionSeqPoolCVMConcatKernel<float>,
                        ops::FusionSeqPoolCVMConcatKernel<double>);
+REGISTER_OP_CPU_KERNEL(fusion_seqpool_cvm_concat_grad,
+                       ops::FusionSeqPoolCVMConcatGradKernel<float>,
+                       ops::FusionSeqPoolCVMConcatGradKernel<double>);
@@ -32,6 +32,17 @@ class FusionSeqPoolCVMConcatOp : public framework::OperatorWithKernel {
       const framework::ExecutionContext& ctx) const override;
 };
 
+class FusionSeqPoolCVMConcatGradOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override;
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override;
+};
+
 class FusionSeqPoolCVMConcatOpMaker : public framework::OpProtoAndCheckerMaker {
  public:
   void Make() override;
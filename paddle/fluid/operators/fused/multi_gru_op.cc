@@ -13,14 +13,9 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/operators/fused/multi_gru_op.h"
-// #include "paddle/fluid/operators/fused/fusion_gru_op.h"
-#include <cstring>  // for memcpy
 #include <string>
 #include <vector>
-#include "paddle/fluid/operators/jit/kernels.h"
-#include "paddle/fluid/operators/math/blas.h"
-#include "paddle/fluid/operators/math/fc.h"
-#include "paddle/fluid/operators/math/sequence2batch.h"
+#include "paddle/fluid/operators/math/packed_rnn.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
 #endif
@@ -117,8 +112,12 @@ void MultiGRUOp::InferShape(framework::InferShapeContext* ctx) const {
 
 framework::OpKernelType MultiGRUOp::GetExpectedKernelType(
     const framework::ExecutionContext& ctx) const {
-  framework::LibraryType library = framework::LibraryType::kMKLDNN;
-  framework::DataLayout layout = framework::DataLayout::kMKLDNN;
+  framework::LibraryType library = framework::LibraryType::kPlain;
+  framework::DataLayout layout = framework::DataLayout::kAnyLayout;
+#ifdef PADDLE_WITH_MKLDNN
+  library = framework::LibraryType::kMKLDNN;
+  layout = framework::DataLayout::kMKLDNN;
+#endif
 
   return framework::OpKernelType(
       OperatorWithKernel::IndicateVarDataType(ctx, "X"), ctx.GetPlace(), layout,
@@ -196,8 +195,62 @@ more details can refer to GRU op.
 )DOC");
 }
 
+// The layers on CPU without MKL-DNN, the directions of a layer at the same
+// time on two threads.
+template <typename T>
+class MultiGRUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    using DeviceContext = paddle::platform::CPUDeviceContext;
+    auto* x = ctx.Input<LoDTensor>("X");
+    auto wx = ctx.MultiInput<Tensor>("WeightX");
+    auto wh = ctx.MultiInput<Tensor>("WeightH");
+    auto biases = ctx.MultiInput<Tensor>("Bias");
+    auto* hidden_out = ctx.Output<LoDTensor>("Hidden");
+    const int layers = ctx.Attr<int>("layers");
+    PADDLE_ENFORCE_EQ(
+        wx.size(), static_cast<size_t>(2 * layers),
+        platform::errors::InvalidArgument(
+            "The number of WeightX inputs does not match the number of "
+            "layers, expected %d but received %d.",
+            2 * layers, wx.size()));
+    PADDLE_ENFORCE_EQ(
+        wh.size(), wx.size(),
+        platform::errors::InvalidArgument(
+            "The number of WeightH inputs does not match the number of "
+            "layers, expected %d but received %d.",
+            wx.size(), wh.size()));
+    PADDLE_ENFORCE_EQ(
+        biases.empty() || biases.size() == wx.size(), true,
+        platform::errors::InvalidArgument(
+            "The number of Bias inputs does not match the number of layers, "
+            "expected %d but received %d.",
+            wx.size(), biases.size()));
+
+    math::PackedRNNAttr attr;
+    attr.cell = math::PackedRNNCell::kGRU;
+    attr.num_layers = layers;
+    attr.is_bidirec = true;
+    attr.gate_activation = ctx.Attr<std::string>("gate_activation");
+    attr.candidate_activation = ctx.Attr<std::string>("activation");
+    attr.origin_mode = ctx.Attr<bool>("origin_mode");
+    std::vector<math::PackedRNNWeight> weights(wx.size());
+    for (size_t i = 0; i < wx.size(); ++i) {
+      weights[i] = math::PackedRNNWeight{
+          wx[i], wh[i], biases.empty() ? nullptr : biases[i]};
+    }
+    auto* op = dynamic_cast<const MultiGRUOp*>(&ctx.GetOp());
+    math::PackedRNNFunctor<T> rnn;
+    rnn(ctx.template device_context<DeviceContext>(), attr, *x, weights,
+        op ? op->packed_weights() : nullptr, nullptr, nullptr, hidden_out,
+        nullptr);
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
 namespace ops = paddle::operators;
 REGISTER_OPERATOR(multi_gru, ops::MultiGRUOp, ops::MultiGRUOpMaker);
+REGISTER_OP_CPU_KERNEL(multi_gru, ops::MultiGRUKernel<float>,
+                       ops::MultiGRUKernel<double>);
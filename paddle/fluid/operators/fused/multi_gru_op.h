@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/operators/math/packed_rnn.h"
 
 namespace paddle {
 namespace operators {
@@ -29,9 +30,16 @@ class MultiGRUOp : public framework::OperatorWithKernel {
 
   void InferShape(framework::InferShapeContext* ctx) const override;
 
+  math::PackedRNNWeightCache* packed_weights() const {
+    return &packed_weights_;
+  }
+
  protected:
   framework::OpKernelType GetExpectedKernelType(
       const ExecutionContext& ctx) const override;
+
+ private:
+  mutable math::PackedRNNWeightCache packed_weights_;
 };
 
 class MultiGRUOpMaker : public framework::OpProtoAndCheckerMaker {
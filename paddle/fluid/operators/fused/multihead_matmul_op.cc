@@ -12,8 +12,11 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <cstring>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
 #include "paddle/fluid/platform/errors.h"
 
 namespace paddle {
@@ -111,9 +114,139 @@ Example of matrix multiplication with head_number of B
   }
 };
 
+template <typename T>
+class MultiHeadMatMulV2CPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &context) const override {
+    using Tensor = framework::Tensor;
+    auto *input = context.Input<framework::Tensor>("Input");
+    auto *w = context.Input<framework::Tensor>("W");
+    auto *bias = context.Input<framework::Tensor>("Bias");
+    auto &bias_qk = GET_DATA_SAFELY(context.Input<framework::Tensor>("BiasQK"),
+                                    "Input", "BiasQK", "MultiHeadMatMulV2");
+
+    auto *bias_d = bias->data<T>();
+    auto *bias_qk_d = bias_qk.template data<T>();
+    T scale = static_cast<T>(context.Attr<float>("alpha"));
+    int head_number = context.Attr<int>("head_number");
+
+    auto &device_ctx =
+        context.template device_context<platform::CPUDeviceContext>();
+    // should be (B * S * hidden)
+    auto input_dims = input->dims();
+    // shouble be (hidden * 3 * all_head_size)
+    auto w_dims = w->dims();
+    int batch = input_dims[0];
+    int seq_len = input_dims[1];
+
+    int all_head_size = w_dims[2];
+    int head_size = all_head_size / head_number;
+
+    auto *out = context.Output<framework::Tensor>("Out");
+    out->Resize({batch, seq_len, all_head_size});
+    auto *output_d = out->mutable_data<T>(context.GetPlace());
+
+    // (B*S, hidden)
+    const Tensor input_matrix =
+        framework::ReshapeToMatrix(*input, 2 /*x_num_col_dims */);
+    // (hidden, 3 * all_head_size)
+    const Tensor w_matrix =
+        framework::ReshapeToMatrix(*w, 1 /*y_num_col_dims*/);
+
+    // (B * S, hidden) * (hidden, 3 * N * H) -> (B * S * 3 * N * H)
+    Tensor temp_out_tensor;
+    temp_out_tensor.Resize({batch * seq_len, 3 * all_head_size});
+    auto *temp_out_data = temp_out_tensor.mutable_data<T>(context.GetPlace());
+    auto blas = math::GetBlas<platform::CPUDeviceContext, T>(device_ctx);
+    blas.MatMul(input_matrix, w_matrix, &temp_out_tensor);
+
+    // B * head_number * S * S + 3 * B * head_number * S * H
+    int64_t scratch_size =
+        static_cast<int64_t>(batch) * head_number * seq_len * seq_len;
+    int64_t tsize = static_cast<int64_t>(batch) * seq_len * all_head_size;
+    Tensor multihead_temp_tensor;
+    multihead_temp_tensor.Resize({scratch_size + 3 * tsize});
+    auto *qkptr = multihead_temp_tensor.mutable_data<T>(context.GetPlace());
+    auto *qptr = qkptr + scratch_size;
+    auto *kptr = qptr + tsize;
+    auto *vptr = kptr + tsize;
+
+    auto vadd =
+        jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(
+            head_size);
+    // Do the transpose with bias.
+    // BxSx3xNxH => 3xBxNxSxH.
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int bs = 0; bs < batch * seq_len; ++bs) {
+      int b = bs / seq_len;
+      int s = bs % seq_len;
+      const T *src =
+          temp_out_data + static_cast<int64_t>(bs) * 3 * all_head_size;
+      for (int m = 0; m < 3; ++m) {
+        for (int n = 0; n < head_number; ++n) {
+          int64_t dst_offset =
+              m * tsize +
+              ((static_cast<int64_t>(b) * head_number + n) * seq_len + s) *
+                  head_size;
+          int64_t src_offset = (m * head_number + n) * head_size;
+          vadd(src + src_offset, bias_d + src_offset, qptr + dst_offset,
+               head_size);
+        }
+      }
+    }
+
+    // softmax(scale * Q * K^T + BiasQK), (B * N, S, S)
+    blas.BatchedGEMM(CblasNoTrans, CblasTrans, seq_len, seq_len, head_size,
+                     scale, qptr, kptr, static_cast<T>(0.0), qkptr,
+                     batch * head_number, seq_len * head_size,
+                     seq_len * head_size);
+    auto vadd_row =
+        jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(
+            seq_len);
+    auto softmax =
+        jit::KernelFuncs<jit::SoftmaxTuple<T>, platform::CPUPlace>::Cache().At(
+            seq_len);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < scratch_size / seq_len; ++i) {
+      T *row = qkptr + i * seq_len;
+      vadd_row(bias_qk_d + i * seq_len, row, row, seq_len);
+      softmax(row, row, seq_len, 1, 1);
+    }
+
+    // QK * V, (B * N, S, H), written over Q which is no longer needed.
+    blas.BatchedGEMM(CblasNoTrans, CblasNoTrans, seq_len, head_size, seq_len,
+                     static_cast<T>(1.0), qkptr, vptr, static_cast<T>(0.0),
+                     qptr, batch * head_number, seq_len * seq_len,
+                     seq_len * head_size);
+
+    // BxNxSxH => BxSxNxH
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int bs = 0; bs < batch * seq_len; ++bs) {
+      int b = bs / seq_len;
+      int s = bs % seq_len;
+      T *dst = output_d + static_cast<int64_t>(bs) * all_head_size;
+      for (int n = 0; n < head_number; ++n) {
+        const T *src =
+            qptr +
+            ((static_cast<int64_t>(b) * head_number + n) * seq_len + s) *
+                head_size;
+        std::memcpy(dst + n * head_size, src, head_size * sizeof(T));
+      }
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
 namespace ops = paddle::operators;
 REGISTER_OP_WITHOUT_GRADIENT(multihead_matmul, ops::MultiHeadMatMulV2Op,
                              ops::MultiHeadMatMulV2OpMaker);
+REGISTER_OP_CPU_KERNEL(multihead_matmul,
+                       ops::MultiHeadMatMulV2CPUKernel<float>);
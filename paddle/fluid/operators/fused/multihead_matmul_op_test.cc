@@ -0,0 +1,222 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <chrono>  // NOLINT
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/scope.h"
+
+USE_OP(multihead_matmul);
+USE_OP(skip_layernorm);
+USE_OP(mul);
+USE_OP(elementwise_add);
+USE_OP(reshape2);
+USE_OP(transpose2);
+USE_OP(scale);
+USE_OP(matmul);
+USE_OP(softmax);
+USE_OP(layer_norm);
+
+namespace paddle {
+namespace operators {
+
+namespace f = paddle::framework;
+
+// The attention block and the residual layer_norm of a BERT-base encoder
+// layer.
+constexpr int kBatch = 4;
+constexpr int kSeqLen = 128;
+constexpr int kHeadNum = 12;
+constexpr int kHeadSize = 64;
+constexpr int kHidden = kHeadNum * kHeadSize;
+
+static float* InitTensor(f::Scope* scope, const std::string& name,
+                         const std::vector<int64_t>& shape,
+                         std::mt19937* rng) {
+  std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+  auto* tensor = scope->Var(name)->GetMutable<f::LoDTensor>();
+  float* data =
+      tensor->mutable_data<float>(f::make_ddim(shape), platform::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = dist(*rng);
+  }
+  return data;
+}
+
+class EncoderAttention {
+ public:
+  EncoderAttention() {
+    std::mt19937 rng(2021);
+    InitTensor(&scope_, "input", {kBatch, kSeqLen, kHidden}, &rng);
+    InitTensor(&scope_, "bias_qk", {kBatch, kHeadNum, kSeqLen, kSeqLen}, &rng);
+    InitTensor(&scope_, "ln_scale", {kHidden}, &rng);
+    InitTensor(&scope_, "ln_bias", {kHidden}, &rng);
+
+    // The fused op takes the q, k and v weights as one (hidden, 3, N * H)
+    // tensor and the biases as one (3, N * H) tensor.
+    float* w = InitTensor(&scope_, "w", {kHidden, 3, kHidden}, &rng);
+    float* b = InitTensor(&scope_, "b", {3, kHidden}, &rng);
+    const char* names[] = {"q", "k", "v"};
+    for (int m = 0; m < 3; ++m) {
+      std::string name = names[m];
+      float* w_m = InitTensor(&scope_, name + "_w", {kHidden, kHidden}, &rng);
+      float* b_m = InitTensor(&scope_, name + "_b", {kHidden}, &rng);
+      for (int i = 0; i < kHidden; ++i) {
+        for (int j = 0; j < kHidden; ++j) {
+          w_m[i * kHidden + j] = w[(i * 3 + m) * kHidden + j];
+        }
+        b_m[i] = b[m * kHidden + i];
+      }
+    }
+    BuildUnfusedOps();
+    BuildFusedOps();
+  }
+
+  void RunUnfused() {
+    for (auto& op : unfused_ops_) {
+      op->Run(scope_, place_);
+    }
+  }
+
+  void RunFused() {
+    for (auto& op : fused_ops_) {
+      op->Run(scope_, place_);
+    }
+  }
+
+  const f::LoDTensor& Get(const std::string& name) {
+    return scope_.FindVar(name)->Get<f::LoDTensor>();
+  }
+
+ private:
+  void AddOp(std::vector<std::unique_ptr<f::OperatorBase>>* ops,
+             const std::string& type, const f::VariableNameMap& inputs,
+             const f::VariableNameMap& outputs, f::AttributeMap attrs) {
+    for (auto& output : outputs) {
+      for (auto& name : output.second) {
+        scope_.Var(name)->GetMutable<f::LoDTensor>();
+      }
+    }
+    ops->emplace_back(f::OpRegistry::CreateOp(type, inputs, outputs, attrs));
+  }
+
+  void BuildUnfusedOps() {
+    auto* ops = &unfused_ops_;
+    std::vector<int> split_shape({kBatch, kSeqLen, kHeadNum, kHeadSize});
+    std::vector<int> axis({0, 2, 1, 3});
+    for (std::string name : {"q", "k", "v"}) {
+      AddOp(ops, "mul", {{"X", {"input"}}, {"Y", {name + "_w"}}},
+            {{"Out", {name + "_mul"}}}, {{"x_num_col_dims", 2}});
+      AddOp(ops, "elementwise_add",
+            {{"X", {name + "_mul"}}, {"Y", {name + "_b"}}},
+            {{"Out", {name + "_add"}}}, {{"axis", 2}});
+      AddOp(ops, "reshape2", {{"X", {name + "_add"}}},
+            {{"Out", {name + "_reshape"}}, {"XShape", {name + "_xshape0"}}},
+            {{"shape", split_shape}});
+      AddOp(ops, "transpose2", {{"X", {name + "_reshape"}}},
+            {{"Out", {name + "_trans"}}, {"XShape", {name + "_xshape1"}}},
+            {{"axis", axis}});
+    }
+    AddOp(ops, "scale", {{"X", {"q_trans"}}}, {{"Out", {"q_scale"}}},
+          {{"scale", 0.125f}});
+    AddOp(ops, "matmul", {{"X", {"q_scale"}}, {"Y", {"k_trans"}}},
+          {{"Out", {"qk"}}}, {{"transpose_Y", true}});
+    AddOp(ops, "elementwise_add", {{"X", {"qk"}}, {"Y", {"bias_qk"}}},
+          {{"Out", {"qk_add"}}}, {});
+    AddOp(ops, "softmax", {{"X", {"qk_add"}}}, {{"Out", {"qk_softmax"}}}, {});
+    AddOp(ops, "matmul", {{"X", {"qk_softmax"}}, {"Y", {"v_trans"}}},
+          {{"Out", {"qkv"}}}, {});
+    AddOp(ops, "transpose2", {{"X", {"qkv"}}},
+          {{"Out", {"qkv_trans"}}, {"XShape", {"qkv_xshape0"}}},
+          {{"axis", axis}});
+    AddOp(ops, "reshape2", {{"X", {"qkv_trans"}}},
+          {{"Out", {"attention"}}, {"XShape", {"qkv_xshape1"}}},
+          {{"shape", std::vector<int>({kBatch, kSeqLen, kHidden})}});
+    AddOp(ops, "elementwise_add", {{"X", {"attention"}}, {"Y", {"input"}}},
+          {{"Out", {"residual"}}}, {});
+    AddOp(ops, "layer_norm",
+          {{"X", {"residual"}}, {"Scale", {"ln_scale"}}, {"Bias", {"ln_bias"}}},
+          {{"Y", {"unfused_out"}}, {"Mean", {"mean"}}, {"Variance", {"var"}}},
+          {{"begin_norm_axis", 2}});
+  }
+
+  void BuildFusedOps() {
+    AddOp(&fused_ops_, "multihead_matmul",
+          {{"Input", {"input"}},
+           {"W", {"w"}},
+           {"Bias", {"b"}},
+           {"BiasQK", {"bias_qk"}}},
+          {{"Out", {"fused_attention"}}},
+          {{"alpha", 0.125f}, {"head_number", kHeadNum}});
+    AddOp(&fused_ops_, "skip_layernorm",
+          {{"X", {"fused_attention"}},
+           {"Y", {"input"}},
+           {"Scale", {"ln_scale"}},
+           {"Bias", {"ln_bias"}}},
+          {{"Out", {"fused_out"}}}, {{"begin_norm_axis", 2}});
+  }
+
+  f::Scope scope_;
+  platform::CPUPlace place_;
+  std::vector<std::unique_ptr<f::OperatorBase>> unfused_ops_;
+  std::vector<std::unique_ptr<f::OperatorBase>> fused_ops_;
+};
+
+template <typename Callback>
+static double AverageMs(int repeat, Callback callback) {
+  callback();  // warm up
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i) {
+    callback();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() /
+         repeat;
+}
+
+static void ExpectTensorNear(const f::LoDTensor& expected,
+                             const f::LoDTensor& actual, float eps) {
+  ASSERT_EQ(expected.numel(), actual.numel());
+  const float* expected_data = expected.data<float>();
+  const float* actual_data = actual.data<float>();
+  for (int64_t i = 0; i < expected.numel(); ++i) {
+    ASSERT_NEAR(expected_data[i], actual_data[i], eps) << "at " << i;
+  }
+}
+
+TEST(MultiHeadMatMulOp, CPUEncoderAttention) {
+  EncoderAttention attention;
+  attention.RunUnfused();
+  attention.RunFused();
+  ExpectTensorNear(attention.Get("attention"),
+                   attention.Get("fused_attention"), 1e-3);
+  ExpectTensorNear(attention.Get("unfused_out"), attention.Get("fused_out"),
+                   1e-3);
+
+  const int repeat = 10;
+  double unfused_ms = AverageMs(repeat, [&] { attention.RunUnfused(); });
+  double fused_ms = AverageMs(repeat, [&] { attention.RunFused(); });
+  LOG(INFO) << "encoder attention (batch " << kBatch << ", seq_len "
+            << kSeqLen << ", hidden " << kHidden << "): unfused "
+            << unfused_ms << " ms, fused " << fused_ms << " ms, speedup "
+            << unfused_ms / fused_ms << "x";
+}
+
+}  // namespace operators
+}  // namespace paddle
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/platform/errors.h"
 
 namespace paddle {
@@ -83,9 +84,56 @@ This op is used for skip_layernorm_fuse_pass, which fuse op pattern as followed.
   }
 };
 
+template <typename T>
+class SkipLayerNormCPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &context) const override {
+    auto *X = context.Input<framework::Tensor>("X");
+    auto *Y = context.Input<framework::Tensor>("Y");
+    auto *scale = context.Input<framework::Tensor>("Scale");
+    auto *bias = context.Input<framework::Tensor>("Bias");
+
+    const T *X_d = X->data<T>();
+    const T *Y_d = Y->data<T>();
+    const T *scale_d = scale->data<T>();
+    const T *bias_d = bias->data<T>();
+    float epsilon = context.Attr<float>("epsilon");
+
+    auto *out = context.Output<framework::Tensor>("Out");
+    out->Resize(X->dims());
+    T *output_d = out->mutable_data<T>(context.GetPlace());
+
+    int hidden = X->dims()[X->dims().size() - 1];
+    int64_t num = X->numel() / hidden;
+
+    // The jit layer_norm kernel does not support normalizing in place, so
+    // the sum of X and Y is kept in a temporary buffer.
+    framework::Tensor sum;
+    T *sum_d = sum.mutable_data<T>(X->dims(), context.GetPlace());
+
+    auto vadd =
+        jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache().At(
+            hidden);
+    auto layer_norm =
+        jit::KernelFuncs<jit::LayerNormTuple<T>, platform::CPUPlace>::Cache()
+            .At(hidden);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < num; ++i) {
+      T mean, var;
+      int64_t offset = i * hidden;
+      vadd(X_d + offset, Y_d + offset, sum_d + offset, hidden);
+      layer_norm(sum_d + offset, output_d + offset, &mean, &var, scale_d,
+                 bias_d, 1, epsilon, hidden);
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
 namespace ops = paddle::operators;
 REGISTER_OP_WITHOUT_GRADIENT(skip_layernorm, ops::SkipLayerNormOp,
                              ops::SkipLayerNormOpMaker);
+REGISTER_OP_CPU_KERNEL(skip_layernorm, ops::SkipLayerNormCPUKernel<float>);
@@ -19,6 +19,7 @@
 #include "glog/logging.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/device_tracer.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -123,12 +124,22 @@ void BenchAllImpls(const typename KernelTuple::attr_type& attr, Args... args) {
   }
   infos.push_back(std::make_pair("Target", benchmark(tgt, args...)));
 
-  // print
+  // print, with the speedup over refer
+  double refer_time = 0.;
+  for (auto pair : infos) {
+    if (pair.first == "Refer") {
+      refer_time = pair.second;
+    }
+  }
   std::ostringstream loginfos;
   loginfos << "Kernel Type " << jit::to_string(KernelTuple::kernel_type) << ": "
            << attr << ": ";
   for (auto pair : infos) {
-    loginfos << pair.first << " takes " << pair.second << " us; ";
+    loginfos << pair.first << " takes " << pair.second << " us";
+    if (refer_time > 0. && pair.second > 0.) {
+      loginfos << " (x" << refer_time / pair.second << ")";
+    }
+    loginfos << "; ";
   }
   LOG(INFO) << loginfos.str();
 }
@@ -564,11 +575,24 @@ BENCH_FP32_CPU(VBroadcast);
 //     --repeat: the repeat times
 //     --max_size: the max size would be tested
 //     --filter: the bench name would be run
+//     --jit_avx512: whether the jitcode uses zmm, set it false to get the
+//                   speedup of ymm (AVX/AVX2) jitcode on the same machine
 int main(int argc, char* argv[]) {
   ::GFLAGS_NAMESPACE::ParseCommandLineFlags(&argc, &argv, true);
   google::InitGoogleLogging(argv[0]);
   LOG(INFO) << "Burning " << FLAGS_burning << " times, Repeat " << FLAGS_repeat
             << " times.";
+  std::string isa = "none";
+  if (FLAGS_jit_avx512 &&
+      paddle::platform::MayIUse(paddle::platform::avx512f)) {
+    isa = "avx512f";
+  } else if (paddle::platform::MayIUse(paddle::platform::avx2)) {
+    isa = "avx2";
+  } else if (paddle::platform::MayIUse(paddle::platform::avx)) {
+    isa = "avx";
+  }
+  LOG(INFO) << "Jitcode ISA: " << isa
+            << ", the speedup over Refer is shown as (xN).";
 
   RUN_ALL_BENCHMARK();
 }
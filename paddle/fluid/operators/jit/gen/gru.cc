@@ -26,60 +26,32 @@ namespace jit {
 namespace gen {
 
 void GRUJitCode::genCode() {
-  reg64_t reg_ptr_gates = rax;
-  reg64_t reg_ptr_ht_1 = r9;
-  reg64_t reg_ptr_ht = r10;
   mov(reg_ptr_gates, ptr[param1 + offsetof(gru_t, gates)]);
   mov(reg_ptr_ht_1, ptr[param1 + offsetof(gru_t, ht_1)]);
   mov(reg_ptr_ht, ptr[param1 + offsetof(gru_t, ht)]);
-  ymm_t ymm_one = ymm_t(0);
+  const bool use_zmm = UseAVX512();
 
   if (id_ == 2) {
     reg64_t reg_ptr_tmp = r11;
     mov(reg_ptr_tmp, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(ymm_one, ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
+    if (use_zmm) {
+      // the low 256 bits could also be used as ymm one
+      vbroadcastss(zmm_t(0), ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
+    } else {
+      vmovaps(ymm_t(0), ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
+    }
   }
   int offset = 0;
-  int d = num_ * sizeof(float);
-  for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
-    ymm_t ymm_u = ymm_t(1);
-    ymm_t ymm_r = ymm_t(2);
-    ymm_t ymm_s = ymm_t(3);
-    ymm_t ymm_ht_1 = ymm_t(4);
-    // W: {W_update, W_reset; W_state}
-    if (id_ == 0 || id_ == 2) {
-      vmovups(ymm_u, ptr[reg_ptr_gates + offset]);
-      vmovups(ymm_s, ptr[reg_ptr_gates + offset + 2 * d]);
-    }
-    if (id_ == 1) {
-      vmovups(ymm_r, ptr[reg_ptr_gates + offset + d]);
-    }
-    if (id_ == 1 || id_ == 2) {
-      vmovups(ymm_ht_1, ptr[reg_ptr_ht_1 + offset]);
-    }
-
-    if (id_ == 0) {
-      // ht = act_gate(u) * act_cand(s)
-      act<ymm_t>(ymm_u, ymm_u, act_gate_);
-      act<ymm_t>(ymm_s, ymm_s, act_cand_);
-      vmulps(ymm_s, ymm_s, ymm_u);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_s);
-    } else if (id_ == 1) {
-      // ht = act_gate(r) * ht_1
-      act<ymm_t>(ymm_r, ymm_r, act_gate_);
-      vmulps(ymm_r, ymm_r, ymm_ht_1);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_r);
-    } else if (id_ == 2) {
-      // ht = act_gate(u) * act_cand(s) + (1-act_gate(u)) * ht_1
-      ymm_t ymm_one_inner = ymm_t(ymm_one.getIdx());
-      act<ymm_t>(ymm_u, ymm_u, act_gate_);
-      act<ymm_t>(ymm_s, ymm_s, act_cand_);
-      vmulps(ymm_s, ymm_s, ymm_u);
-      vsubps(ymm_u, ymm_one_inner, ymm_u);
-      vmulps(ymm_u, ymm_ht_1, ymm_u);
-      vaddps(ymm_u, ymm_s, ymm_u);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_u);
+  int rest = num_;
+  if (use_zmm) {
+    for (int i = 0; i < num_ / ZMM_FLOAT_BLOCK; ++i) {
+      compute_block<zmm_t>(offset);
+      offset += sizeof(float) * ZMM_FLOAT_BLOCK;
     }
+    rest = num_ % ZMM_FLOAT_BLOCK;
+  }
+  for (int i = 0; i < rest / YMM_FLOAT_BLOCK; ++i) {
+    compute_block<ymm_t>(offset);
     offset += sizeof(float) * YMM_FLOAT_BLOCK;
   }
   ret();
@@ -88,11 +88,58 @@ class GRUJitCode : public VActFunc {
   void genCode() override;
 
  protected:
+  // compute one block of zmm or ymm at offset
+  template <typename JMM>
+  void compute_block(int offset) {
+    int d = num_ * sizeof(float);
+    JMM jmm_u = JMM(1);
+    JMM jmm_r = JMM(2);
+    JMM jmm_s = JMM(3);
+    JMM jmm_ht_1 = JMM(4);
+    // W: {W_update, W_reset; W_state}
+    if (id_ == 0 || id_ == 2) {
+      vmovups(jmm_u, ptr[reg_ptr_gates + offset]);
+      vmovups(jmm_s, ptr[reg_ptr_gates + offset + 2 * d]);
+    }
+    if (id_ == 1) {
+      vmovups(jmm_r, ptr[reg_ptr_gates + offset + d]);
+    }
+    if (id_ == 1 || id_ == 2) {
+      vmovups(jmm_ht_1, ptr[reg_ptr_ht_1 + offset]);
+    }
+
+    if (id_ == 0) {
+      // ht = act_gate(u) * act_cand(s)
+      act<JMM>(jmm_u, jmm_u, act_gate_);
+      act<JMM>(jmm_s, jmm_s, act_cand_);
+      vmulps(jmm_s, jmm_s, jmm_u);
+      vmovups(ptr[reg_ptr_ht + offset], jmm_s);
+    } else if (id_ == 1) {
+      // ht = act_gate(r) * ht_1
+      act<JMM>(jmm_r, jmm_r, act_gate_);
+      vmulps(jmm_r, jmm_r, jmm_ht_1);
+      vmovups(ptr[reg_ptr_ht + offset], jmm_r);
+    } else if (id_ == 2) {
+      // ht = act_gate(u) * act_cand(s) + (1-act_gate(u)) * ht_1
+      JMM jmm_one = JMM(0);
+      act<JMM>(jmm_u, jmm_u, act_gate_);
+      act<JMM>(jmm_s, jmm_s, act_cand_);
+      vmulps(jmm_s, jmm_s, jmm_u);
+      vsubps(jmm_u, jmm_one, jmm_u);
+      vmulps(jmm_u, jmm_ht_1, jmm_u);
+      vaddps(jmm_u, jmm_s, jmm_u);
+      vmovups(ptr[reg_ptr_ht + offset], jmm_u);
+    }
+  }
+
   int id_;
   int num_;
   operand_type act_gate_;
   operand_type act_cand_;
   reg64_t param1{abi_param1};
+  reg64_t reg_ptr_gates{rax};
+  reg64_t reg_ptr_ht_1{r9};
+  reg64_t reg_ptr_ht{r10};
 };
 
 #define DECLARE_GRU_JITCODE(name, id)                                \
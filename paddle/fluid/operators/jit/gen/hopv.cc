@@ -23,18 +23,42 @@ namespace jit {
 namespace gen {
 
 void HOPVJitCode::genCode() {
-  const int num_blocks = num_ / YMM_FLOAT_BLOCK;
   int offset = 0;
+  int rest = num_;
+  // whether ymm_tmp has been loaded
+  bool has_ymm_tmp = false;
 
-  if (num_blocks > 0) {
+  if (UseAVX512() && num_ >= ZMM_FLOAT_BLOCK) {
+    const int num_blocks = num_ / ZMM_FLOAT_BLOCK;
     // load one firstly
-    vmovups(ymm_tmp, ptr[param_src]);
-    offset += sizeof(float) * YMM_FLOAT_BLOCK;
+    vmovups(zmm_tmp, ptr[param_src]);
+    offset += sizeof(float) * ZMM_FLOAT_BLOCK;
     for (int i = 1; i < num_blocks; ++i) {
+      vmovups(zmm_src, ptr[param_src + offset]);
+      process(zmm_tmp, zmm_src, zmm_tmp);
+      offset += sizeof(float) * ZMM_FLOAT_BLOCK;
+    }
+    vextractf64x4(ymm_src, zmm_tmp, 1);
+    process(ymm_tmp, ymm_tmp, ymm_src);
+    rest = num_ % ZMM_FLOAT_BLOCK;
+    has_ymm_tmp = true;
+  }
+
+  const int num_blocks = rest / YMM_FLOAT_BLOCK;
+  for (int i = 0; i < num_blocks; ++i) {
+    if (has_ymm_tmp) {
       vmovups(ymm_src, ptr[param_src + offset]);
       process(ymm_tmp, ymm_src, ymm_tmp);
-      offset += sizeof(float) * YMM_FLOAT_BLOCK;
+    } else {
+      // load one firstly
+      vmovups(ymm_tmp, ptr[param_src + offset]);
+      has_ymm_tmp = true;
     }
+    offset += sizeof(float) * YMM_FLOAT_BLOCK;
+  }
+  rest = rest % YMM_FLOAT_BLOCK;
+
+  if (has_ymm_tmp) {
     vextractf128(xmm_dst, ymm_tmp, 1);
     process(xmm_dst, xmm_dst, xmm_tmp);
   } else {
@@ -45,7 +69,6 @@ void HOPVJitCode::genCode() {
     }
   }
 
-  int rest = num_ % YMM_FLOAT_BLOCK;
   if (rest >= 4) {
     vmovups(xmm_src, ptr[param_src + offset]);
     offset += sizeof(float) * 4;
@@ -66,6 +66,9 @@ class HOPVJitCode : public JitCode {
   reg64_t param_dst{abi_param2};
   reg64_t param_attr{abi_param3};
 
+  zmm_t zmm_tmp = zmm_t(0);
+  zmm_t zmm_src = zmm_t(1);
+
   ymm_t ymm_tmp = ymm_t(0);
   ymm_t ymm_src = ymm_t(1);
   ymm_t ymm_dst = ymm_t(2);
@@ -97,6 +97,11 @@ class JitCode : public GenBase, public Xbyak::CodeGenerator {
     }
     ret();
   }
+  // The zmm code can be disabled by FLAGS_jit_avx512, then the ymm code would
+  // be generated, which is used to compare the performance of them.
+  bool UseAVX512() const {
+    return FLAGS_jit_avx512 && platform::MayIUse(platform::avx512f);
+  }
   void L(const char* label) { Xbyak::CodeGenerator::L(label); }
   void L(Xbyak::Label& label) { Xbyak::CodeGenerator::L(label); }  // NOLINT
   // Enhanced vector extension
@@ -92,6 +92,70 @@ class LSTMJitCode : public VActFunc {
   void genCode() override;
 
  protected:
+  // compute one block of zmm or ymm at offset
+  template <typename JMM>
+  void compute_block(int offset) {
+    int d = num_ * sizeof(float);
+    /* gates: W_ch, W_ih, W_fh, W_oh */
+    JMM jmm_c = JMM(0);
+    JMM jmm_i = JMM(1);
+    JMM jmm_f = JMM(2);
+    JMM jmm_o = JMM(3);
+    JMM jmm_ct_1 = JMM(4);
+    JMM jmm_wp0 = JMM(5);
+    JMM jmm_wp1 = JMM(6);
+    JMM jmm_wp2 = JMM(7);
+    vmovups(jmm_c, ptr[reg_ptr_gates + offset]);
+    vmovups(jmm_i, ptr[reg_ptr_gates + offset + d]);
+    vmovups(jmm_f, ptr[reg_ptr_gates + offset + 2 * d]);
+    vmovups(jmm_o, ptr[reg_ptr_gates + offset + 3 * d]);
+    if (!compute_c1h1_) {
+      vmovups(jmm_ct_1, ptr[reg_ptr_ct_1 + offset]);
+    }
+    if (use_peephole_) {
+      vmovups(jmm_wp0, ptr[reg_ptr_wp + offset]);
+      vmovups(jmm_wp1, ptr[reg_ptr_wp + offset + d]);
+      vmovups(jmm_wp2, ptr[reg_ptr_wp + offset + 2 * d]);
+    }
+    /* C_t = act_cand(c) * act_gate(i) + C_t-1 * act_gate(f) */
+    // act_cand(c)
+    act<JMM>(jmm_c, jmm_c, act_cand_);
+    // act_gate(i) or act_gate(ct_1 * wp0 + i)
+    if (!compute_c1h1_ && use_peephole_) {
+      vmulps(jmm_wp0, jmm_ct_1, jmm_wp0);
+      vaddps(jmm_i, jmm_i, jmm_wp0);
+    }
+    act<JMM>(jmm_i, jmm_i, act_gate_);
+    vmulps(jmm_c, jmm_c, jmm_i);
+    if (!compute_c1h1_) {
+      // act_gate(f) or act_gate(ct_1 * wp1 + f)
+      if (use_peephole_) {
+        vmulps(jmm_wp1, jmm_ct_1, jmm_wp1);
+        vaddps(jmm_f, jmm_f, jmm_wp1);
+      }
+      act<JMM>(jmm_f, jmm_f, act_gate_);
+      // ct
+      vmulps(jmm_f, jmm_f, jmm_ct_1);
+      vaddps(jmm_f, jmm_f, jmm_c);
+    }
+    /* H_t = act_cell(C_t) * act_gate(o) */
+    // act_cell(C_t)
+    JMM jmm_ct = compute_c1h1_ ? jmm_c : jmm_f;
+    JMM jmm_tmp = jmm_i;
+    act<JMM>(jmm_tmp, jmm_ct, act_cell_);
+    // act_gate(o) or act_gate(ct * wp2 + o)
+    if (use_peephole_) {
+      vmulps(jmm_wp2, jmm_ct, jmm_wp2);
+      vaddps(jmm_o, jmm_o, jmm_wp2);
+    }
+    act<JMM>(jmm_o, jmm_o, act_gate_);
+    // ht
+    vmulps(jmm_o, jmm_o, jmm_tmp);
+    // save ct and ht
+    vmovups(ptr[reg_ptr_ct + offset], jmm_ct);
+    vmovups(ptr[reg_ptr_ht + offset], jmm_o);
+  }
+
   int num_;
   bool compute_c1h1_;
   bool use_peephole_;
@@ -99,6 +163,11 @@ class LSTMJitCode : public VActFunc {
   operand_type act_cand_;
   operand_type act_cell_;
   reg64_t param1{abi_param1};
+  reg64_t reg_ptr_gates{rax};
+  reg64_t reg_ptr_ct_1{r9};
+  reg64_t reg_ptr_ct{r10};
+  reg64_t reg_ptr_ht{r11};
+  reg64_t reg_ptr_wp{r12};
 };
 
 #define DECLARE_LSTM_JITCODE(name, compute_c1h1)                      \
@@ -24,8 +24,9 @@ namespace gen {
 
 void VBroadcastJitCode::genCode() {
   preCode();
-  constexpr int block = YMM_FLOAT_BLOCK;
-  constexpr int max_num_regs = 16;
+  const bool use_zmm = UseAVX512();
+  const int block = use_zmm ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
+  const int max_num_regs = use_zmm ? 32 : 16;
   const int num_block = w_ / block;
   const int num_groups = num_block / max_num_regs;
   const size_t block_size = sizeof(float) * block;
@@ -34,6 +35,8 @@ void VBroadcastJitCode::genCode() {
   if (rest_num_regs > 0) {
     groups.push_back(rest_num_regs);
   }
+  // w_ is divisible by YMM_FLOAT_BLOCK, so only one ymm is left with zmm
+  const int rest = w_ % block;
 
   // protect param_h
   mov(reg_height, param_h);
@@ -46,18 +49,31 @@ void VBroadcastJitCode::genCode() {
     for (int num_regs : groups) {
       size_t w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ymm_t(reg_i), ptr[reg_ptr_src_i + w_offset]);
+        if (use_zmm) {
+          vmovups(zmm_t(reg_i), ptr[reg_ptr_src_i + w_offset]);
+        } else {
+          vmovups(ymm_t(reg_i), ptr[reg_ptr_src_i + w_offset]);
+        }
         w_offset += block_size;
       }
       add(reg_ptr_src_i, num_regs * block_size);
 
       w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ptr[reg_ptr_dst_i + w_offset], ymm_t(reg_i));
+        if (use_zmm) {
+          vmovups(ptr[reg_ptr_dst_i + w_offset], zmm_t(reg_i));
+        } else {
+          vmovups(ptr[reg_ptr_dst_i + w_offset], ymm_t(reg_i));
+        }
         w_offset += block_size;
       }
       add(reg_ptr_dst_i, num_regs * block_size);
     }  // end of groups
+    if (rest > 0) {
+      vmovups(ymm_t(0), ptr[reg_ptr_src_i]);
+      vmovups(ptr[reg_ptr_dst_i], ymm_t(0));
+      add(reg_ptr_dst_i, rest * sizeof(float));
+    }
     inc(reg_h_i);
     cmp(reg_h_i, reg_height);
     jl(l_next_h, T_NEAR);
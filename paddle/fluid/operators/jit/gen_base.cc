@@ -24,6 +24,9 @@
 #endif
 
 DEFINE_bool(dump_jitcode, false, "Whether to dump the jitcode to file");
+DEFINE_bool(jit_avx512, true,
+            "Whether to generate the jitcode with zmm when AVX-512 is "
+            "supported. Disable it to generate the ymm one.");
 
 namespace paddle {
 namespace operators {
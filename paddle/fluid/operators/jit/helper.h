@@ -43,30 +43,26 @@ GetJitCode(const typename KernelTuple::attr_type& attr) {
   using Attr = typename KernelTuple::attr_type;
   int64_t key = JitCodeKey<Attr>(attr);
   auto& codes = JitCodePool<KernelTuple::kernel_type>::Instance();
-  if (codes.Has(key)) {
-    return codes.AllKernels().at(key).get();
-  }
-
-  // creator is not related with attr, so can use KernelKey as key
-  KernelKey kkey(KernelTuple::kernel_type, PlaceType());
-  // pool: (KernelKey(type, place), vector<GenCreatorPtr>)
-  auto& creator_map = JitCodeCreatorPool::Instance().AllCreators();
-  auto iter = creator_map.find(kkey);
-  if (iter != creator_map.end()) {
-    auto& creators = iter->second;
-    for (auto& cur : creators) {
-      auto i = dynamic_cast<const JitCodeCreator<Attr>*>(cur.get());
-      if (i && i->CanBeUsed(attr)) {
-        auto p = i->CreateJitCode(attr);
-        if (p) {
-          auto res = p.get();
-          codes.Insert(key, std::move(p));
-          return res;
+  return codes.GetOrCreate(key, [&attr]() -> std::unique_ptr<GenBase> {
+    // creator is not related with attr, so can use KernelKey as key
+    KernelKey kkey(KernelTuple::kernel_type, PlaceType());
+    // pool: (KernelKey(type, place), vector<GenCreatorPtr>)
+    auto& creator_map = JitCodeCreatorPool::Instance().AllCreators();
+    auto iter = creator_map.find(kkey);
+    if (iter != creator_map.end()) {
+      auto& creators = iter->second;
+      for (auto& cur : creators) {
+        auto i = dynamic_cast<const JitCodeCreator<Attr>*>(cur.get());
+        if (i && i->CanBeUsed(attr)) {
+          auto p = i->CreateJitCode(attr);
+          if (p) {
+            return p;
+          }
         }
       }
     }
-  }
-  return nullptr;
+    return nullptr;
+  });
 }
 
 template <typename KernelTuple, typename PlaceType>
@@ -78,6 +74,16 @@ GetJitCode(const typename KernelTuple::attr_type& attr) {
   return nullptr;
 }
 
+// Generate the jitcode of these attrs in advance, so the first run of the
+// kernels would not pay for the code generation. The codes are shared by all
+// threads, so it only needs to be called once in a process.
+template <typename KernelTuple, typename PlaceType = platform::CPUPlace>
+void WarmUpJitCode(const std::vector<typename KernelTuple::attr_type>& attrs) {
+  for (auto& attr : attrs) {
+    GetJitCode<KernelTuple, PlaceType>(attr);
+  }
+}
+
 // Refer code do not related with attr, which is just for cast
 // Refer is always on CPUPlace
 template <typename KernelTuple>
@@ -19,10 +19,52 @@ namespace operators {
 namespace jit {
 
 std::map<size_t, std::shared_ptr<void>>& GetJITCodesMap() {
-  static thread_local std::map<size_t, std::shared_ptr<void>> g_jit_codes_map;
+  static std::map<size_t, std::shared_ptr<void>> g_jit_codes_map;
   return g_jit_codes_map;
 }
 
+std::mutex& GetJITCodesMapMutex() {
+  static std::mutex g_jit_codes_map_mutex;
+  return g_jit_codes_map_mutex;
+}
+
+static std::mutex& GetJitCodeStatMutex() {
+  static std::mutex g_jit_code_stat_mutex;
+  return g_jit_code_stat_mutex;
+}
+
+static std::map<KernelType, JitCodeStat>& GetJitCodeStatMap() {
+  static std::map<KernelType, JitCodeStat> g_jit_code_stat_map;
+  return g_jit_code_stat_map;
+}
+
+void AddJitCodeStat(KernelType kt, int64_t hits, int64_t misses,
+                    int64_t gen_count, double gen_time_us) {
+  std::lock_guard<std::mutex> guard(GetJitCodeStatMutex());
+  auto& stat = GetJitCodeStatMap()[kt];
+  stat.hits += hits;
+  stat.misses += misses;
+  stat.gen_count += gen_count;
+  stat.gen_time_us += gen_time_us;
+}
+
+JitCodeStat GetJitCodeStat(KernelType kt) {
+  std::lock_guard<std::mutex> guard(GetJitCodeStatMutex());
+  auto& stat_map = GetJitCodeStatMap();
+  auto iter = stat_map.find(kt);
+  return iter == stat_map.end() ? JitCodeStat() : iter->second;
+}
+
+std::map<KernelType, JitCodeStat> GetAllJitCodeStats() {
+  std::lock_guard<std::mutex> guard(GetJitCodeStatMutex());
+  return GetJitCodeStatMap();
+}
+
+void ResetJitCodeStats() {
+  std::lock_guard<std::mutex> guard(GetJitCodeStatMutex());
+  GetJitCodeStatMap().clear();
+}
+
 JitCodeCreatorPool& JitCodeCreatorPool::Instance() {
   static JitCodeCreatorPool g_creator_pool;
   return g_creator_pool;
@@ -14,8 +14,11 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>  // NOLINT
 #include <map>
 #include <memory>  // for unique_ptr
+#include <mutex>   // NOLINT
 #include <string>
 #include <unordered_map>
 #include <utility>  // for move
@@ -33,37 +36,113 @@ namespace jit {
 struct KernelKey;
 
 extern std::map<size_t, std::shared_ptr<void>>& GetJITCodesMap();
+extern std::mutex& GetJITCodesMapMutex();
+
+// The statistics of the jitcode of one kernel type.
+struct JitCodeStat {
+  int64_t hits{0};
+  int64_t misses{0};
+  int64_t gen_count{0};   // how many jitcode have been generated
+  double gen_time_us{0};  // total time spent on generating jitcode
+};
+
+extern void AddJitCodeStat(KernelType kt, int64_t hits, int64_t misses,
+                           int64_t gen_count, double gen_time_us);
+extern JitCodeStat GetJitCodeStat(KernelType kt);
+extern std::map<KernelType, JitCodeStat> GetAllJitCodeStats();
+extern void ResetJitCodeStats();
 
+// The jitcode pool is shared by all threads of the process, so the jitcode of
+// one attr is only generated once. The codes are sharded by key and each shard
+// has its own lock, so the threads looking up different attrs seldom contend.
 template <KernelType KT>
 class JitCodePool {
   typedef std::unique_ptr<GenBase> GenBasePtr;
   typedef std::unordered_map<int64_t, GenBasePtr> JitCodeMap;
+  static constexpr size_t kNumShards = 16;
+
+  struct Shard {
+    mutable std::mutex mtx;
+    JitCodeMap codes;
+  };
 
  public:
   JitCodePool() = default;
   static JitCodePool& Instance() {
-    auto& jit_codes_map = GetJITCodesMap();
-    auto key = typeid(JitCodePool<KT>).hash_code();
-    auto iter = jit_codes_map.find(key);
-    if (iter != jit_codes_map.end()) {
-      return *(JitCodePool<KT>*)(iter->second.get());
-    } else {
-      std::shared_ptr<void> cache = std::make_shared<JitCodePool<KT>>();
-      jit_codes_map.emplace(key, cache);
-      return *(JitCodePool<KT>*)(cache.get());
+    // The pool is kept in GetJITCodesMap() rather than a static member, so
+    // the same pool would be used across all the shared libraries.
+    static JitCodePool<KT>* pool = []() {
+      std::lock_guard<std::mutex> guard(GetJITCodesMapMutex());
+      auto& jit_codes_map = GetJITCodesMap();
+      auto key = typeid(JitCodePool<KT>).hash_code();
+      auto iter = jit_codes_map.find(key);
+      if (iter == jit_codes_map.end()) {
+        std::shared_ptr<void> cache = std::make_shared<JitCodePool<KT>>();
+        iter = jit_codes_map.emplace(key, cache).first;
+      }
+      return reinterpret_cast<JitCodePool<KT>*>(iter->second.get());
+    }();
+    return *pool;
+  }
+
+  size_t Size() const {
+    size_t res = 0;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard.mtx);
+      res += shard.codes.size();
     }
+    return res;
   }
 
-  const JitCodeMap& AllKernels() { return codes_; }
+  bool Has(int64_t key) const { return Get(key) != nullptr; }
 
-  bool Has(int64_t key) const { return codes_.find(key) != codes_.end(); }
+  const GenBase* Get(int64_t key) const {
+    auto& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.mtx);
+    auto iter = shard.codes.find(key);
+    return iter == shard.codes.end() ? nullptr : iter->second.get();
+  }
 
-  void Insert(int64_t key, GenBasePtr value) {
-    codes_.emplace(key, std::move(value));
+  // Insert the code if the key does not exist, and return the code in pool.
+  const GenBase* Insert(int64_t key, GenBasePtr value) {
+    auto& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.mtx);
+    return shard.codes.emplace(key, std::move(value)).first->second.get();
   }
 
+  // Return the code of key, or generate it with creator() if it does not
+  // exist. The generation is done under the shard lock, so the threads asking
+  // the same attr at the same time would wait for one generation.
+  // Return nullptr if creator() can not generate any code.
+  template <typename Creator>
+  const GenBase* GetOrCreate(int64_t key, Creator&& creator) {
+    auto& shard = GetShard(key);
+    std::lock_guard<std::mutex> guard(shard.mtx);
+    auto iter = shard.codes.find(key);
+    if (iter != shard.codes.end()) {
+      AddJitCodeStat(KT, 1, 0, 0, 0.);
+      return iter->second.get();
+    }
+    auto start = std::chrono::steady_clock::now();
+    GenBasePtr code = creator();
+    if (!code) {
+      AddJitCodeStat(KT, 0, 1, 0, 0.);
+      return nullptr;
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    AddJitCodeStat(KT, 0, 1, 1, elapsed.count());
+    return shard.codes.emplace(key, std::move(code)).first->second.get();
+  }
+
+  JitCodeStat Stat() const { return GetJitCodeStat(KT); }
+
  private:
-  JitCodeMap codes_;
+  Shard& GetShard(int64_t key) const {
+    return shards_[static_cast<uint64_t>(key) % kNumShards];
+  }
+
+  mutable std::array<Shard, kNumShards> shards_;
   DISABLE_COPY_AND_ASSIGN(JitCodePool);
 };
 
@@ -0,0 +1,194 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/jit/more/intrinsic/bf16.h"
+#include <cmath>
+#include "paddle/fluid/operators/jit/registry.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace operators {
+namespace jit {
+namespace more {
+namespace intrinsic {
+
+// The kernels here compute in float with the same order as the refer
+// bfloat16 kernels, so the results are exactly the same. LayerNorm is in
+// layer_norm.cc and does not keep the order.
+
+void VMulBF16(const bf16* x, const bf16* y, bf16* z, int n) {
+  const int end = n - n % YMM_FLOAT_BLOCK;
+  for (int i = 0; i < end; i += YMM_FLOAT_BLOCK) {
+    StoreBF16(z + i, _mm256_mul_ps(LoadBF16(x + i), LoadBF16(y + i)));
+  }
+  for (int i = end; i < n; ++i) {
+    z[i] = bf16(static_cast<float>(x[i]) * static_cast<float>(y[i]));
+  }
+}
+
+void VAddBF16(const bf16* x, const bf16* y, bf16* z, int n) {
+  const int end = n - n % YMM_FLOAT_BLOCK;
+  for (int i = 0; i < end; i += YMM_FLOAT_BLOCK) {
+    StoreBF16(z + i, _mm256_add_ps(LoadBF16(x + i), LoadBF16(y + i)));
+  }
+  for (int i = end; i < n; ++i) {
+    z[i] = bf16(static_cast<float>(x[i]) + static_cast<float>(y[i]));
+  }
+}
+
+void SeqPoolBF16(const bf16* x, bf16* y, const seq_pool_attr_t* attr) {
+  const int w = attr->w;
+  const int h = attr->h;
+  const bool need_scale =
+      attr->type == SeqPoolType::kAvg || attr->type == SeqPoolType::kSqrt;
+  float scalar = 1.f;
+  if (attr->type == SeqPoolType::kAvg) {
+    scalar = scalar / static_cast<float>(h);
+  } else if (attr->type == SeqPoolType::kSqrt) {
+    scalar = scalar / std::sqrt(static_cast<float>(h));
+  }
+  const __m256 scalar_vec = _mm256_set1_ps(scalar);
+  const int end = w - w % YMM_FLOAT_BLOCK;
+  for (int j = 0; j < end; j += YMM_FLOAT_BLOCK) {
+    __m256 sum = _mm256_setzero_ps();
+    for (int i = 0; i < h; ++i) {
+      sum = _mm256_add_ps(sum, LoadBF16(x + i * w + j));
+    }
+    if (need_scale) {
+      sum = _mm256_mul_ps(scalar_vec, sum);
+    }
+    StoreBF16(y + j, sum);
+  }
+  for (int j = end; j < w; ++j) {
+    float sum = 0.f;
+    for (int i = 0; i < h; ++i) {
+      sum = sum + static_cast<float>(x[i * w + j]);
+    }
+    if (need_scale) {
+      sum = scalar * sum;
+    }
+    y[j] = bf16(sum);
+  }
+}
+
+void EmbSeqPoolBF16(const bf16* table, const int64_t* idx, bf16* out,
+                    const emb_seq_pool_attr_t* attr) {
+  PADDLE_ENFORCE_EQ(
+      attr->table_width * attr->index_width, attr->out_width,
+      platform::errors::InvalidArgument(
+          "The attribute table_width * index_width of EmbSeqPool should "
+          "be equal to out_width. But table_width * index_width is %d and "
+          "out_width is %d.",
+          attr->table_width * attr->index_width, attr->out_width));
+  for (int64_t i = 0; i < attr->index_height * attr->index_width; ++i) {
+    PADDLE_ENFORCE_LT(
+        idx[i], attr->table_height,
+        platform::errors::InvalidArgument(
+            "The idx shoud be lower than the attribute table_height of "
+            "EmbSeqPool. But %dth of idx is %d and table_height is %d.",
+            i, idx[i], attr->table_height));
+    PADDLE_ENFORCE_GE(idx[i], 0, platform::errors::InvalidArgument(
+                                     "The idx shoud be equal to or larger than "
+                                     "the 0. But %dth of idx is %d.",
+                                     i, idx[i]));
+  }
+
+  const int64_t tw = attr->table_width;
+  const int64_t iw = attr->index_width;
+  const int64_t end = tw - tw % YMM_FLOAT_BLOCK;
+  for (int64_t w = 0; w < iw; ++w) {
+    bf16* dst = out + w * tw;
+    for (int64_t j = 0; j < end; j += YMM_FLOAT_BLOCK) {
+      __m256 sum = _mm256_setzero_ps();
+      for (int64_t h = 0; h < attr->index_height; ++h) {
+        sum = _mm256_add_ps(sum, LoadBF16(table + idx[h * iw + w] * tw + j));
+      }
+      StoreBF16(dst + j, sum);
+    }
+    for (int64_t j = end; j < tw; ++j) {
+      float sum = 0.f;
+      for (int64_t h = 0; h < attr->index_height; ++h) {
+        sum += static_cast<float>(table[idx[h * iw + w] * tw + j]);
+      }
+      dst[j] = bf16(sum);
+    }
+  }
+}
+
+// A(M,K) * B(K,N) = C(M,N)
+void MatMulBF16(const bf16* A, const bf16* B, bf16* C,
+                const matmul_attr_t* attr) {
+  const int M = attr->m;
+  const int N = attr->n;
+  const int K = attr->k;
+  const int end = N - N % YMM_FLOAT_BLOCK;
+  for (int m = 0; m < M; ++m) {
+    const bf16* pa = A + m * K;
+    bf16* pc = C + m * N;
+    for (int n = 0; n < end; n += YMM_FLOAT_BLOCK) {
+      __m256 sum = _mm256_mul_ps(_mm256_set1_ps(static_cast<float>(pa[0])),
+                                 LoadBF16(B + n));
+      for (int k = 1; k < K; ++k) {
+        sum = _mm256_add_ps(
+            sum, _mm256_mul_ps(_mm256_set1_ps(static_cast<float>(pa[k])),
+                               LoadBF16(B + k * N + n)));
+      }
+      StoreBF16(pc + n, sum);
+    }
+    for (int n = end; n < N; ++n) {
+      float sum = static_cast<float>(pa[0]) * static_cast<float>(B[n]);
+      for (int k = 1; k < K; ++k) {
+        sum += static_cast<float>(pa[k]) * static_cast<float>(B[k * N + n]);
+      }
+      pc[n] = bf16(sum);
+    }
+  }
+}
+
+bool VMulBF16Kernel::CanBeUsed(const int& d) const {
+  return platform::MayIUse(platform::avx);
+}
+
+bool VAddBF16Kernel::CanBeUsed(const int& d) const {
+  return platform::MayIUse(platform::avx);
+}
+
+bool SeqPoolBF16Kernel::CanBeUsed(const seq_pool_attr_t& attr) const {
+  return platform::MayIUse(platform::avx);
+}
+
+bool EmbSeqPoolBF16Kernel::CanBeUsed(const emb_seq_pool_attr_t& attr) const {
+  return platform::MayIUse(platform::avx) &&
+         attr.pool_type == SeqPoolType::kSum;
+}
+
+bool MatMulBF16Kernel::CanBeUsed(const matmul_attr_t& attr) const {
+  return platform::MayIUse(platform::avx);
+}
+
+}  // namespace intrinsic
+}  // namespace more
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
+
+namespace intrinsic = paddle::operators::jit::more::intrinsic;
+
+REGISTER_JITKERNEL_MORE(kVMul, intrinsic, intrinsic::VMulBF16Kernel);
+REGISTER_JITKERNEL_MORE(kVAdd, intrinsic, intrinsic::VAddBF16Kernel);
+REGISTER_JITKERNEL_MORE(kSeqPool, intrinsic, intrinsic::SeqPoolBF16Kernel);
+REGISTER_JITKERNEL_MORE(kEmbSeqPool, intrinsic,
+                        intrinsic::EmbSeqPoolBF16Kernel);
+REGISTER_JITKERNEL_MORE(kMatMul, intrinsic, intrinsic::MatMulBF16Kernel);
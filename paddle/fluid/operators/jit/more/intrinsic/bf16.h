@@ -0,0 +1,98 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <immintrin.h>
+#include <type_traits>
+
+#include "paddle/fluid/operators/jit/kernel_base.h"
+#include "paddle/fluid/platform/bfloat16.h"
+
+namespace paddle {
+namespace operators {
+namespace jit {
+namespace more {
+namespace intrinsic {
+
+// bfloat16 is the high 16 bits of float, so loading is only a shift and
+// storing truncates the low 16 bits, the same as platform::bfloat16(float).
+inline __m256 LoadBF16(const platform::bfloat16* x) {
+  __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x));
+  __m128i zero = _mm_setzero_si128();
+  __m256 res = _mm256_castps128_ps256(
+      _mm_castsi128_ps(_mm_unpacklo_epi16(zero, v)));
+  return _mm256_insertf128_ps(res,
+                              _mm_castsi128_ps(_mm_unpackhi_epi16(zero, v)), 1);
+}
+
+inline void StoreBF16(platform::bfloat16* y, __m256 v) {
+  __m128i lo = _mm_srli_epi32(_mm_castps_si128(_mm256_castps256_ps128(v)), 16);
+  __m128i hi =
+      _mm_srli_epi32(_mm_castps_si128(_mm256_extractf128_ps(v, 1)), 16);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm_packus_epi32(lo, hi));
+}
+
+inline void BF16ToFloat(const platform::bfloat16* x, float* y, int64_t n) {
+  const int64_t end = n - n % YMM_FLOAT_BLOCK;
+  for (int64_t i = 0; i < end; i += YMM_FLOAT_BLOCK) {
+    _mm256_storeu_ps(y + i, LoadBF16(x + i));
+  }
+  for (int64_t i = end; i < n; ++i) {
+    y[i] = static_cast<float>(x[i]);
+  }
+}
+
+inline void FloatToBF16(const float* x, platform::bfloat16* y, int64_t n) {
+  const int64_t end = n - n % YMM_FLOAT_BLOCK;
+  for (int64_t i = 0; i < end; i += YMM_FLOAT_BLOCK) {
+    StoreBF16(y + i, _mm256_loadu_ps(x + i));
+  }
+  for (int64_t i = end; i < n; ++i) {
+    y[i] = platform::bfloat16(x[i]);
+  }
+}
+
+using bf16 = platform::bfloat16;
+
+void VMulBF16(const bf16* x, const bf16* y, bf16* z, int n);
+void VAddBF16(const bf16* x, const bf16* y, bf16* z, int n);
+void SeqPoolBF16(const bf16* x, bf16* y, const seq_pool_attr_t* attr);
+void EmbSeqPoolBF16(const bf16* table, const int64_t* idx, bf16* out,
+                    const emb_seq_pool_attr_t* attr);
+void MatMulBF16(const bf16* A, const bf16* B, bf16* C,
+                const matmul_attr_t* attr);
+
+#define DECLARE_BF16_KERNEL(name)                                             \
+  class name##BF16Kernel : public KernelMore<name##Tuple<bf16>> {             \
+   public:                                                                    \
+    name##BF16Kernel() { this->func = name##BF16; }                           \
+    bool CanBeUsed(                                                           \
+        const typename name##Tuple<bf16>::attr_type&) const override;         \
+    const char* ImplType() const override { return "Intrinsic"; }             \
+  }
+
+DECLARE_BF16_KERNEL(VMul);
+DECLARE_BF16_KERNEL(VAdd);
+DECLARE_BF16_KERNEL(SeqPool);
+DECLARE_BF16_KERNEL(EmbSeqPool);
+DECLARE_BF16_KERNEL(MatMul);
+
+#undef DECLARE_BF16_KERNEL
+
+}  // namespace intrinsic
+}  // namespace more
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
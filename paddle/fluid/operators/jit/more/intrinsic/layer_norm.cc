@@ -14,6 +14,8 @@
 
 #include "paddle/fluid/operators/jit/more/intrinsic/layer_norm.h"
 #include <limits>
+#include <vector>
+#include "paddle/fluid/operators/jit/more/intrinsic/bf16.h"
 #include "paddle/fluid/operators/jit/registry.h"
 #include "paddle/fluid/platform/cpu_info.h"
 
@@ -167,6 +169,36 @@ bool LayerNormKernel::CanBeUsed(const int& d) const {
   return platform::MayIUse(platform::avx) && d >= YMM_FLOAT_BLOCK;
 }
 
+void LayerNormBF16(platform::bfloat16* x, platform::bfloat16* out,
+                   platform::bfloat16* mean, platform::bfloat16* var,
+                   const platform::bfloat16* scale,
+                   const platform::bfloat16* bias, int height,
+                   const float epsilon, int right) {
+  const int64_t numel = static_cast<int64_t>(height) * right;
+  std::vector<float> x_fp(numel), out_fp(numel);
+  std::vector<float> mean_fp(height), var_fp(height);
+  std::vector<float> scale_fp, bias_fp;
+  BF16ToFloat(x, x_fp.data(), numel);
+  if (scale) {
+    scale_fp.resize(right);
+    BF16ToFloat(scale, scale_fp.data(), right);
+  }
+  if (bias) {
+    bias_fp.resize(right);
+    BF16ToFloat(bias, bias_fp.data(), right);
+  }
+  LayerNorm(x_fp.data(), out_fp.data(), mean_fp.data(), var_fp.data(),
+            scale ? scale_fp.data() : nullptr, bias ? bias_fp.data() : nullptr,
+            height, epsilon, right);
+  FloatToBF16(out_fp.data(), out, numel);
+  FloatToBF16(mean_fp.data(), mean, height);
+  FloatToBF16(var_fp.data(), var, height);
+}
+
+bool LayerNormBF16Kernel::CanBeUsed(const int& d) const {
+  return platform::MayIUse(platform::avx) && d >= YMM_FLOAT_BLOCK;
+}
+
 }  // namespace intrinsic
 }  // namespace more
 }  // namespace jit
@@ -175,4 +207,5 @@ bool LayerNormKernel::CanBeUsed(const int& d) const {
 
 namespace intrinsic = paddle::operators::jit::more::intrinsic;
 
-REGISTER_JITKERNEL_MORE(kLayerNorm, intrinsic, intrinsic::LayerNormKernel);
+REGISTER_JITKERNEL_MORE(kLayerNorm, intrinsic, intrinsic::LayerNormKernel,
+                        intrinsic::LayerNormBF16Kernel);
@@ -17,6 +17,7 @@
 #include <type_traits>
 
 #include "paddle/fluid/operators/jit/kernel_base.h"
+#include "paddle/fluid/platform/bfloat16.h"
 
 namespace paddle {
 namespace operators {
@@ -36,6 +37,24 @@ class LayerNormKernel : public KernelMore<LayerNormTuple<float>> {
   const char* ImplType() const override { return "Intrinsic"; }
 };
 
+// bfloat16 inputs are widened to float and normalized by LayerNorm above,
+// whose lane-wise reductions do not keep the summation order of the refer
+// kernel.
+void LayerNormBF16(platform::bfloat16* x, platform::bfloat16* out,
+                   platform::bfloat16* mean, platform::bfloat16* var,
+                   const platform::bfloat16* scale,
+                   const platform::bfloat16* bias, int height,
+                   const float epsilon, int right);
+
+class LayerNormBF16Kernel
+    : public KernelMore<LayerNormTuple<platform::bfloat16>> {
+ public:
+  LayerNormBF16Kernel() { this->func = LayerNormBF16; }
+  bool CanBeUsed(const typename LayerNormTuple<platform::bfloat16>::attr_type&)
+      const override;
+  const char* ImplType() const override { return "Intrinsic"; }
+};
+
 }  // namespace intrinsic
 }  // namespace more
 }  // namespace jit
@@ -21,8 +21,13 @@ namespace refer = paddle::operators::jit::refer;
   REGISTER_JITKERNEL_REFER(k##func, refer::func##Kernel<float>, \
                            refer::func##Kernel<double>)
 
-REGISTER_REFER_KERNEL(VMul);
-REGISTER_REFER_KERNEL(VAdd);
+#define REGISTER_REFER_KERNEL_WITH_BF16(func)                     \
+  REGISTER_JITKERNEL_REFER(k##func, refer::func##Kernel<float>,   \
+                           refer::func##Kernel<double>,           \
+                           refer::func##Kernel<paddle::platform::bfloat16>)
+
+REGISTER_REFER_KERNEL_WITH_BF16(VMul);
+REGISTER_REFER_KERNEL_WITH_BF16(VAdd);
 REGISTER_REFER_KERNEL(VAddRelu);
 REGISTER_REFER_KERNEL(VSub);
 
@@ -46,16 +51,17 @@ REGISTER_REFER_KERNEL(GRUHtPart1);
 REGISTER_REFER_KERNEL(GRUHtPart2);
 
 REGISTER_REFER_KERNEL(CRFDecoding);
-REGISTER_REFER_KERNEL(LayerNorm);
+REGISTER_REFER_KERNEL_WITH_BF16(LayerNorm);
 REGISTER_REFER_KERNEL(NCHW16CMulNC);
-REGISTER_REFER_KERNEL(SeqPool);
-REGISTER_REFER_KERNEL(MatMul);
+REGISTER_REFER_KERNEL_WITH_BF16(SeqPool);
+REGISTER_REFER_KERNEL_WITH_BF16(MatMul);
 REGISTER_REFER_KERNEL(HMax);
 REGISTER_REFER_KERNEL(HSum);
 REGISTER_REFER_KERNEL(StrideASum);
-REGISTER_REFER_KERNEL(Softmax);
-REGISTER_REFER_KERNEL(EmbSeqPool);
+REGISTER_REFER_KERNEL_WITH_BF16(Softmax);
+REGISTER_REFER_KERNEL_WITH_BF16(EmbSeqPool);
 REGISTER_REFER_KERNEL(Sgd);
 REGISTER_REFER_KERNEL(VBroadcast);
 
 #undef REGISTER_REFER_KERNEL
+#undef REGISTER_REFER_KERNEL_WITH_BF16
@@ -17,9 +17,11 @@
 #include <cmath>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/operators/jit/helper.h"
 #include "paddle/fluid/operators/jit/kernel_base.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
@@ -552,6 +554,137 @@ void Sgd(const T* lr, const T* param, const T* grad, const int64_t* rows,
   }
 }
 
+// The bfloat16 kernels compute in float and only convert the outputs to
+// bfloat16 at last. The intrinsic kernels in bf16.cc sum in the same order,
+// while the intrinsic LayerNorm reduces the mean and variance 8 lanes at a
+// time and may differ from these in the last bit.
+inline std::vector<float> BF16ToFloat(const platform::bfloat16* x, int64_t n) {
+  std::vector<float> res(n);
+  for (int64_t i = 0; i < n; ++i) {
+    res[i] = static_cast<float>(x[i]);
+  }
+  return res;
+}
+
+inline void FloatToBF16(const float* x, platform::bfloat16* y, int64_t n) {
+  for (int64_t i = 0; i < n; ++i) {
+    y[i] = platform::bfloat16(x[i]);
+  }
+}
+
+template <>
+inline void VMul<platform::bfloat16>(const platform::bfloat16* x,
+                                     const platform::bfloat16* y,
+                                     platform::bfloat16* z, int n) {
+  for (int i = 0; i < n; ++i) {
+    z[i] = platform::bfloat16(static_cast<float>(x[i]) *
+                              static_cast<float>(y[i]));
+  }
+}
+
+template <>
+inline void VAdd<platform::bfloat16>(const platform::bfloat16* x,
+                                     const platform::bfloat16* y,
+                                     platform::bfloat16* z, int n) {
+  for (int i = 0; i < n; ++i) {
+    z[i] = platform::bfloat16(static_cast<float>(x[i]) +
+                              static_cast<float>(y[i]));
+  }
+}
+
+template <>
+inline void LayerNorm<platform::bfloat16>(
+    platform::bfloat16* x, platform::bfloat16* out, platform::bfloat16* mean,
+    platform::bfloat16* var, const platform::bfloat16* scale,
+    const platform::bfloat16* bias, int height, const float epsilon,
+    int right) {
+  auto x_fp = BF16ToFloat(x, height * right);
+  std::vector<float> out_fp(height * right), mean_fp(height), var_fp(height);
+  std::vector<float> scale_fp, bias_fp;
+  if (scale) {
+    scale_fp = BF16ToFloat(scale, right);
+  }
+  if (bias) {
+    bias_fp = BF16ToFloat(bias, right);
+  }
+  LayerNorm<float>(x_fp.data(), out_fp.data(), mean_fp.data(), var_fp.data(),
+                   scale ? scale_fp.data() : nullptr,
+                   bias ? bias_fp.data() : nullptr, height, epsilon, right);
+  FloatToBF16(out_fp.data(), out, height * right);
+  FloatToBF16(mean_fp.data(), mean, height);
+  FloatToBF16(var_fp.data(), var, height);
+}
+
+template <>
+inline void SeqPool<platform::bfloat16>(const platform::bfloat16* x,
+                                        platform::bfloat16* y,
+                                        const seq_pool_attr_t* attr) {
+  auto x_fp = BF16ToFloat(x, attr->h * attr->w);
+  std::vector<float> y_fp(attr->w);
+  SeqPool<float>(x_fp.data(), y_fp.data(), attr);
+  FloatToBF16(y_fp.data(), y, attr->w);
+}
+
+template <>
+inline void MatMul<platform::bfloat16>(const platform::bfloat16* A,
+                                       const platform::bfloat16* B,
+                                       platform::bfloat16* C,
+                                       const matmul_attr_t* attr) {
+  auto a_fp = BF16ToFloat(A, attr->m * attr->k);
+  auto b_fp = BF16ToFloat(B, attr->k * attr->n);
+  std::vector<float> c_fp(attr->m * attr->n);
+  MatMul<float>(a_fp.data(), b_fp.data(), c_fp.data(), attr);
+  FloatToBF16(c_fp.data(), C, attr->m * attr->n);
+}
+
+template <>
+inline void Softmax<platform::bfloat16>(const platform::bfloat16* x,
+                                        platform::bfloat16* y, int n, int bs,
+                                        int remain) {
+  auto x_fp = BF16ToFloat(x, n * bs);
+  std::vector<float> y_fp(n * bs);
+  Softmax<float>(x_fp.data(), y_fp.data(), n, bs, remain);
+  FloatToBF16(y_fp.data(), y, n * bs);
+}
+
+template <>
+inline void EmbSeqPool<platform::bfloat16>(const platform::bfloat16* table,
+                                           const int64_t* idx,
+                                           platform::bfloat16* out,
+                                           const emb_seq_pool_attr_t* attr) {
+  PADDLE_ENFORCE_EQ(
+      attr->table_width * attr->index_width, attr->out_width,
+      platform::errors::InvalidArgument(
+          "The attribute table_width * index_width of EmbSeqPool should "
+          "be equal to out_width. But table_width * index_width is %d and "
+          "out_width is %d.",
+          attr->table_width * attr->index_width, attr->out_width));
+  // only convert the rows used, the table would be too large
+  std::vector<float> out_fp(attr->out_width, 0.f);
+  for (int64_t h = 0; h < attr->index_height; ++h) {
+    for (int64_t w = 0; w < attr->index_width; ++w) {
+      int64_t i = h * attr->index_width + w;
+      PADDLE_ENFORCE_LT(
+          idx[i], attr->table_height,
+          platform::errors::InvalidArgument(
+              "The idx shoud be lower than the attribute table_height of "
+              "EmbSeqPool. But %dth of idx is %d and table_height is %d.",
+              i, idx[i], attr->table_height));
+      PADDLE_ENFORCE_GE(idx[i], 0,
+                        platform::errors::InvalidArgument(
+                            "The idx shoud be equal to or larger than "
+                            "the 0. But %dth of idx is %d.",
+                            i, idx[i]));
+      const platform::bfloat16* row = table + idx[i] * attr->table_width;
+      float* dst = out_fp.data() + w * attr->table_width;
+      for (int64_t j = 0; j < attr->table_width; ++j) {
+        dst[j] += static_cast<float>(row[j]);
+      }
+    }
+  }
+  FloatToBF16(out_fp.data(), out, attr->out_width);
+}
+
 #define DECLARE_REFER_KERNEL(name)                          \
   template <typename T>                                     \
   class name##Kernel : public ReferKernel<name##Tuple<T>> { \
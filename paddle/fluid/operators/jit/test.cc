@@ -12,13 +12,17 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <random>
+#include <thread>  // NOLINT
 
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -983,14 +987,56 @@ TEST(JITKernel_pool, jitcreator) {
 
 TEST(JITKernel_pool, jitpool) {
   // jitpool is related with attr
-  const auto& kers = jit::JitCodePool<jit::kVAdd>().Instance().AllKernels();
-  EXPECT_EQ(kers.size(), 0UL);
+  const auto& kers = jit::JitCodePool<jit::kVAdd>::Instance();
+  EXPECT_EQ(kers.Size(), 0UL);
   jit::GetAllCandidateKernels<jit::VAddTuple<float>, CPUPlace>(3);
 // after call GetAllCandidateKernels, it will create jitcode Automatically
 #if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
-  EXPECT_EQ(kers.size(), 0UL);
+  EXPECT_EQ(kers.Size(), 0UL);
 #else
-  EXPECT_EQ(kers.size(), 1UL);
+  EXPECT_EQ(kers.Size(), 1UL);
+#endif
+}
+
+TEST(JITKernel_pool, jitpool_multi_thread) {
+  // jitcode is shared by all threads and only generated once for one attr
+  const auto& kers = jit::JitCodePool<jit::kVSub>::Instance();
+  EXPECT_EQ(kers.Size(), 0UL);
+  std::vector<std::thread> threads;
+  std::vector<const jit::Kernel*> res(8, nullptr);
+  for (size_t i = 0; i < res.size(); ++i) {
+    threads.emplace_back([&res, i]() {
+      res[i] = jit::GetJitCode<jit::VSubTuple<float>, CPUPlace>(5);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (size_t i = 1; i < res.size(); ++i) {
+    EXPECT_EQ(res[i], res[0]);
+  }
+#if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
+  EXPECT_EQ(kers.Size(), 0UL);
+#else
+  EXPECT_EQ(kers.Size(), 1UL);
+  auto stat = kers.Stat();
+  EXPECT_EQ(stat.gen_count, 1);
+  EXPECT_EQ(stat.hits + stat.misses, static_cast<int64_t>(res.size()));
+#endif
+}
+
+TEST(JITKernel_pool, jitpool_warmup) {
+  const auto& kers = jit::JitCodePool<jit::kVMul>::Instance();
+  EXPECT_EQ(kers.Size(), 0UL);
+  jit::WarmUpJitCode<jit::VMulTuple<float>>({1, 8, 16, 17});
+#if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
+  EXPECT_EQ(kers.Size(), 0UL);
+#else
+  EXPECT_EQ(kers.Size(), 4UL);
+  EXPECT_EQ(kers.Stat().gen_count, 4);
+  // all warmed attrs should hit the pool
+  jit::GetJitCode<jit::VMulTuple<float>, CPUPlace>(16);
+  EXPECT_EQ(kers.Stat().hits, 1);
 #endif
 }
 
@@ -1000,6 +1046,10 @@ TEST(JITKernel_pool, more) {
 
 #ifdef __AVX__
   target_num += 2;
+#ifndef PADDLE_WITH_MKLML
+  // bfloat16 intrinsic of VMul, VAdd, SeqPool, EmbSeqPool and MatMul
+  target_num += 5;
+#endif
 #endif
 
 #ifdef PADDLE_WITH_MKLML
@@ -1385,3 +1435,212 @@ TEST_CPU_KERNEL(VBroadcast);
 
 TEST_CPU_KERNEL(StrideASum);
 TEST_CPU_KERNEL(StrideScal);
+
+// test bfloat16 kernels
+using bf16 = paddle::platform::bfloat16;
+
+// Random bfloat16 data, and the same values in float for the float refer code
+void RandomBF16Vec(const int n, bf16* a, float* a_fp) {
+  RandomVec<float>(n, a_fp);
+  for (int i = 0; i < n; ++i) {
+    a[i] = bf16(a_fp[i]);
+    a_fp[i] = static_cast<float>(a[i]);
+  }
+}
+
+// bfloat16 only keeps 8 bits of mantissa, so compare it with the float
+// results by relative error
+void ExpectBF16EQ(const bf16* target, const float* refer, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    float acc = 1e-2f * std::max(1.f, std::fabs(refer[i]));
+    EXPECT_NEAR(static_cast<float>(target[i]), refer[i], acc)
+        << " at index : " << i;
+  }
+}
+
+template <template <typename> class KernelTuple>
+void TestBF16KernelXYZN() {
+  for (int d : TestSizes()) {
+    std::vector<bf16> x(d), y(d);
+    std::vector<float> x_fp(d), y_fp(d), zref(d);
+    RandomBF16Vec(d, x.data(), x_fp.data());
+    RandomBF16Vec(d, y.data(), y_fp.data());
+    auto ref = jit::GetReferFunc<KernelTuple<float>>();
+    ref(x_fp.data(), y_fp.data(), zref.data(), d);
+
+    auto verifier = [](const typename KernelTuple<bf16>::func_type tgt,
+                       const std::vector<bf16>& x, const std::vector<bf16>& y,
+                       const std::vector<float>& zref) {
+      EXPECT_TRUE(tgt != nullptr);
+      const int d = zref.size();
+      std::vector<bf16> ztgt(d);
+      tgt(x.data(), y.data(), ztgt.data(), d);
+      ExpectBF16EQ(ztgt.data(), zref.data(), d);
+      // test inplace x
+      std::copy(x.begin(), x.end(), ztgt.begin());
+      tgt(ztgt.data(), y.data(), ztgt.data(), d);
+      ExpectBF16EQ(ztgt.data(), zref.data(), d);
+    };
+    TestAllImpls<KernelTuple<bf16>, CPUPlace>(d, verifier, x, y, zref);
+  }
+}
+
+TEST(JITKernel_bf16, VMul) { TestBF16KernelXYZN<jit::VMulTuple>(); }
+
+TEST(JITKernel_bf16, VAdd) { TestBF16KernelXYZN<jit::VAddTuple>(); }
+
+TEST(JITKernel_bf16, LayerNorm) {
+  const float epsilon = 9.99999975e-06;
+  for (int left : {1, 9, 17}) {
+    for (int right : TestSizes()) {
+      int sz = left * right;
+      std::vector<bf16> x(sz), scale(right), bias(right);
+      std::vector<float> x_fp(sz), scale_fp(right), bias_fp(right);
+      std::vector<float> outref(sz), mean(left), var(left);
+      RandomBF16Vec(sz, x.data(), x_fp.data());
+      RandomBF16Vec(right, scale.data(), scale_fp.data());
+      RandomBF16Vec(right, bias.data(), bias_fp.data());
+      auto ref = jit::GetReferFunc<jit::LayerNormTuple<float>>();
+      ref(x_fp.data(), outref.data(), mean.data(), var.data(), scale_fp.data(),
+          bias_fp.data(), left, epsilon, right);
+
+      auto verifier = [](
+          const typename jit::LayerNormTuple<bf16>::func_type tgt,
+          const std::vector<bf16>& x_, const std::vector<bf16>& scale,
+          const std::vector<bf16>& bias, const std::vector<float>& outref,
+          const std::vector<float>& meanref, int left, float epsilon,
+          int right) {
+        EXPECT_TRUE(tgt != nullptr);
+        std::vector<bf16> x(x_), out(outref.size()), mean(left), var(left);
+        tgt(x.data(), out.data(), mean.data(), var.data(), scale.data(),
+            bias.data(), left, epsilon, right);
+        ExpectBF16EQ(out.data(), outref.data(), outref.size());
+        ExpectBF16EQ(mean.data(), meanref.data(), left);
+      };
+      TestAllImpls<jit::LayerNormTuple<bf16>, CPUPlace>(
+          right, verifier, x, scale, bias, outref, mean, left, epsilon, right);
+    }
+  }
+}
+
+TEST(JITKernel_bf16, SeqPool) {
+  std::vector<jit::SeqPoolType> pool_types = {
+      jit::SeqPoolType::kSum, jit::SeqPoolType::kAvg, jit::SeqPoolType::kSqrt};
+  for (auto type : pool_types) {
+    for (int w : {1, 7, 8, 16, 31, 100}) {
+      jit::seq_pool_attr_t attr(w, type);
+      for (int h : {1, 2, 9, 32}) {
+        attr.h = h;
+        std::vector<bf16> x(h * w);
+        std::vector<float> x_fp(h * w), yref(w);
+        RandomBF16Vec(h * w, x.data(), x_fp.data());
+        auto ref = jit::GetReferFunc<jit::SeqPoolTuple<float>>();
+        ref(x_fp.data(), yref.data(), &attr);
+
+        auto verifier = [](
+            const typename jit::SeqPoolTuple<bf16>::func_type tgt,
+            const std::vector<bf16>& x, const std::vector<float>& yref,
+            const jit::seq_pool_attr_t& attr) {
+          EXPECT_TRUE(tgt != nullptr);
+          std::vector<bf16> y(yref.size());
+          tgt(x.data(), y.data(), &attr);
+          ExpectBF16EQ(y.data(), yref.data(), yref.size());
+        };
+        TestAllImpls<jit::SeqPoolTuple<bf16>, CPUPlace>(attr, verifier, x, yref,
+                                                        attr);
+      }
+    }
+  }
+}
+
+TEST(JITKernel_bf16, EmbSeqPool) {
+  int64_t tbl_h = 1000;
+  for (int tbl_w : {1, 7, 8, 16, 31, 100}) {
+    std::vector<bf16> table(tbl_h * tbl_w);
+    std::vector<float> table_fp(tbl_h * tbl_w);
+    RandomBF16Vec(tbl_h * tbl_w, table.data(), table_fp.data());
+    for (int idx_w : {1, 2, 10}) {
+      for (int idx_h : {1, 2, 13}) {
+        std::vector<int64_t> idx(idx_h * idx_w);
+        RandomVec<int64_t>(idx_h * idx_w, idx.data(), 0, tbl_h - 1);
+        int64_t out_w = tbl_w * idx_w;
+        std::vector<float> oref(out_w);
+        jit::emb_seq_pool_attr_t attr(tbl_h, tbl_w, idx_h, idx_w, out_w,
+                                      jit::SeqPoolType::kSum);
+        auto ref = jit::GetReferFunc<jit::EmbSeqPoolTuple<float>>();
+        ref(table_fp.data(), idx.data(), oref.data(), &attr);
+
+        auto verifier = [](
+            const typename jit::EmbSeqPoolTuple<bf16>::func_type tgt,
+            const std::vector<bf16>& table, const std::vector<int64_t>& idx,
+            const std::vector<float>& oref,
+            const jit::emb_seq_pool_attr_t& attr) {
+          EXPECT_TRUE(tgt != nullptr);
+          std::vector<bf16> out(oref.size());
+          tgt(table.data(), idx.data(), out.data(), &attr);
+          ExpectBF16EQ(out.data(), oref.data(), oref.size());
+        };
+        TestAllImpls<jit::EmbSeqPoolTuple<bf16>, CPUPlace>(
+            attr, verifier, table, idx, oref, attr);
+      }
+    }
+  }
+}
+
+TEST(JITKernel_bf16, MatMul) {
+  for (int m : {1, 2, 3}) {
+    for (int n : {1, 7, 8, 17}) {
+      for (int k : {1, 2, 16, 31}) {
+        std::vector<bf16> a(m * k), b(k * n);
+        std::vector<float> a_fp(m * k), b_fp(k * n), cref(m * n);
+        RandomBF16Vec(m * k, a.data(), a_fp.data());
+        RandomBF16Vec(k * n, b.data(), b_fp.data());
+        const jit::matmul_attr_t attr{m, n, k};
+        auto ref = jit::GetReferFunc<jit::MatMulTuple<float>>();
+        ref(a_fp.data(), b_fp.data(), cref.data(), &attr);
+
+        auto verifier = [](const typename jit::MatMulTuple<bf16>::func_type tgt,
+                           const std::vector<bf16>& a,
+                           const std::vector<bf16>& b,
+                           const std::vector<float>& cref,
+                           const jit::matmul_attr_t& attr) {
+          EXPECT_TRUE(tgt != nullptr);
+          std::vector<bf16> c(cref.size());
+          tgt(a.data(), b.data(), c.data(), &attr);
+          ExpectBF16EQ(c.data(), cref.data(), cref.size());
+        };
+        TestAllImpls<jit::MatMulTuple<bf16>, CPUPlace>(attr, verifier, a, b,
+                                                       cref, attr);
+      }
+    }
+  }
+}
+
+TEST(JITKernel_bf16, Softmax) {
+  for (int bs : {1, 2, 10}) {
+    for (int n : {1, 6, 8, 17, 100}) {
+      for (int m : {1, 2}) {  // remain
+        if (m > n || n % m != 0) {
+          continue;
+        }
+        std::vector<bf16> x(bs * n);
+        std::vector<float> x_fp(bs * n), yref(bs * n);
+        RandomBF16Vec(bs * n, x.data(), x_fp.data());
+        auto ref = jit::GetReferFunc<jit::SoftmaxTuple<float>>();
+        ref(x_fp.data(), yref.data(), n, bs, m);
+
+        auto verifier = [](
+            const typename jit::SoftmaxTuple<bf16>::func_type tgt,
+            const std::vector<bf16>& x, const std::vector<float>& yref, int n,
+            int bs, int m) {
+          EXPECT_TRUE(tgt != nullptr);
+          std::vector<bf16> y(yref.size());
+          tgt(x.data(), y.data(), n, bs, m);
+          ExpectBF16EQ(y.data(), yref.data(), yref.size());
+        };
+        TestAllImpls<jit::SoftmaxTuple<bf16>, CPUPlace>(n, verifier, x, yref,
+                                                        n, bs, m);
+      }
+    }
+  }
+}
@@ -0,0 +1,148 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/test_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+template <typename T>
+static void ReferenceBatchedGEMM(bool trans_a, bool trans_b, int M, int N,
+                                 int K, T alpha, const T* A, const T* B,
+                                 T beta, T* C, int batch_count) {
+  for (int b = 0; b < batch_count; ++b) {
+    const T* a = A + b * M * K;
+    const T* bm = B + b * K * N;
+    T* c = C + b * M * N;
+    for (int i = 0; i < M; ++i) {
+      for (int j = 0; j < N; ++j) {
+        double sum = 0;
+        for (int k = 0; k < K; ++k) {
+          sum += static_cast<double>(trans_a ? a[k * M + i] : a[i * K + k]) *
+                 (trans_b ? bm[j * K + k] : bm[k * N + j]);
+        }
+        c[i * N + j] = alpha * sum + beta * c[i * N + j];
+      }
+    }
+  }
+}
+
+template <typename T>
+static void TestBatchedGEMM(bool trans_a, bool trans_b, int M, int N, int K,
+                            int batch_count, T beta) {
+  std::mt19937 rng(M * 131 + N * 17 + K);
+  std::vector<T> a(batch_count * M * K);
+  std::vector<T> b(batch_count * K * N);
+  std::vector<T> c(batch_count * M * N);
+  RandomFill(&a, &rng);
+  RandomFill(&b, &rng);
+  RandomFill(&c, &rng);
+  std::vector<T> expected(c);
+  T alpha = static_cast<T>(0.5);
+  ReferenceBatchedGEMM(trans_a, trans_b, M, N, K, alpha, a.data(), b.data(),
+                       beta, expected.data(), batch_count);
+
+  platform::CPUDeviceContext context;
+  auto blas = GetBlas<platform::CPUDeviceContext, T>(context);
+  blas.BatchedGEMM(trans_a ? CblasTrans : CblasNoTrans,
+                   trans_b ? CblasTrans : CblasNoTrans, M, N, K, alpha,
+                   a.data(), b.data(), beta, c.data(), batch_count,
+                   static_cast<int64_t>(M) * K, static_cast<int64_t>(K) * N);
+  for (size_t i = 0; i < c.size(); ++i) {
+    ASSERT_NEAR(expected[i], c[i], 1e-3)
+        << "at " << i << " of M=" << M << ", N=" << N << ", K=" << K
+        << ", trans_a=" << trans_a << ", trans_b=" << trans_b;
+  }
+}
+
+TEST(BatchedGEMM, CPUShapes) {
+  platform::SetNumThreads(4);
+  for (bool trans_a : {false, true}) {
+    for (bool trans_b : {false, true}) {
+      TestBatchedGEMM<float>(trans_a, trans_b, 1, 1, 1, 3, 0.f);
+      TestBatchedGEMM<float>(trans_a, trans_b, 7, 33, 5, 8, 1.f);
+      TestBatchedGEMM<float>(trans_a, trans_b, 32, 32, 300, 6, 0.f);
+      TestBatchedGEMM<double>(trans_a, trans_b, 64, 17, 64, 12, 0.5);
+    }
+  }
+}
+
+// The matrices of the attention of BERT-base: QK^T and (QK^T)V of every head
+// in a batch of sequences. It takes seconds, so it only runs with
+// --gtest_also_run_disabled_tests.
+TEST(BatchedGEMM, DISABLED_CPUAttentionBenchmark) {
+  const int num_threads = 4;
+  platform::SetNumThreads(num_threads);
+  platform::CPUDeviceContext context;
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  std::mt19937 rng(2021);
+
+  struct Shape {
+    int batch_count;
+    int M, N, K;
+    bool trans_b;
+  };
+  const int head_number = 12;
+  const int head_size = 64;
+  std::vector<Shape> shapes;
+  for (int batch : {1, 8}) {
+    for (int seq_len : {128, 384}) {
+      int batch_count = batch * head_number;
+      shapes.push_back({batch_count, seq_len, seq_len, head_size, true});
+      shapes.push_back({batch_count, seq_len, head_size, seq_len, false});
+    }
+  }
+
+  const int repeat = 10;
+  for (auto& shape : shapes) {
+    int M = shape.M, N = shape.N, K = shape.K;
+    std::vector<float> a(shape.batch_count * M * K);
+    std::vector<float> b(shape.batch_count * K * N);
+    std::vector<float> c(shape.batch_count * M * N);
+    RandomFill(&a, &rng);
+    RandomFill(&b, &rng);
+    CBLAS_TRANSPOSE trans_b = shape.trans_b ? CblasTrans : CblasNoTrans;
+
+    auto batched = [&] {
+      blas.BatchedGEMM(CblasNoTrans, trans_b, M, N, K, 1.f, a.data(),
+                       b.data(), 0.f, c.data(), shape.batch_count,
+                       static_cast<int64_t>(M) * K,
+                       static_cast<int64_t>(K) * N);
+    };
+    auto one_by_one = [&] {
+      for (int i = 0; i < shape.batch_count; ++i) {
+        blas.GEMM(CblasNoTrans, trans_b, M, N, K, 1.f, &a[i * M * K],
+                  &b[i * K * N], 0.f, &c[i * M * N]);
+      }
+    };
+    CompareSpeed(
+        string::Sprintf("BatchedGEMM %d x (%d x %d) * (%d x %d)%s with %d "
+                        "threads",
+                        shape.batch_count, M, K, K, N,
+                        shape.trans_b ? ", trans_b" : "", num_threads),
+        "GEMM one by one", one_by_one, "batched", batched, repeat);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
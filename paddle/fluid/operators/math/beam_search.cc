@@ -14,6 +14,10 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/math/beam_search.h"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
 namespace paddle {
 namespace framework {
 class LoDTensor;
@@ -43,24 +47,52 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
     auto abs_lod = framework::ToAbsOffset(scores->lod());
     auto &high_level = abs_lod[level];
 
-    auto items = SelectTopBeamSizeItems(pre_ids, pre_scores, ids, scores, level,
-                                        beam_size, end_id, is_accumulated);
-    auto selected_items = ToMap(items, high_level.back());
+    auto *pre_ids_data = pre_ids->data<int64_t>();
+    auto *pre_scores_data = pre_scores->data<float>();
+    auto *ids_data = ids ? ids->data<int64_t>() : nullptr;
+    auto *scores_data = scores->data<float>();
+    size_t seq_width = 1;
+    for (int i = 1; i < scores->dims().size(); i++) {
+      seq_width *= scores->dims()[i];
+    }
+
+    // The selected items of source sentence i are
+    // items[i * beam_size, i * beam_size + num_selected[i]), they are
+    // sorted by offset. The buffers are kept by the thread across the steps.
+    int64_t num_seqs = high_level.size() - 1;
+    auto &scratch = GetScratch();
+    scratch.items.resize(num_seqs * beam_size);
+    scratch.num_selected.resize(num_seqs);
+    Item *items = scratch.items.data();
+    size_t *num_selected = scratch.num_selected.data();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int64_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+      Item *top_beam = items + seq_id * beam_size;
+      size_t num_items = SelectTopBeamSizeItems(
+          pre_ids_data, pre_scores_data, ids_data, scores_data, seq_width,
+          high_level[seq_id], high_level[seq_id + 1], beam_size, end_id,
+          is_accumulated, top_beam);
+      std::sort(top_beam, top_beam + num_items, ByOffset);
+      if (IsFinished(pre_ids_data, top_beam, num_items, end_id)) {
+        num_items = 0;
+      }
+      num_selected[seq_id] = num_items;
+    }
     if (FLAGS_v == 3) {
       VLOG(3) << "selected_items:";
-      for (size_t i = 0; i < selected_items.size(); ++i) {
-        VLOG(3) << "offset: " << i;
-        for (auto &item : selected_items[i]) {
-          VLOG(3) << item.ToString();
+      for (int64_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+        VLOG(3) << "source: " << seq_id;
+        for (size_t i = 0; i < num_selected[seq_id]; ++i) {
+          VLOG(3) << items[seq_id * beam_size + i].ToString();
         }
       }
     }
 
-    PruneEndBeams(pre_ids, abs_lod, &selected_items, level, end_id);
     // calculate the output tensor's height
-    size_t num_instances = std::accumulate(
-        std::begin(selected_items), std::end(selected_items), 0,
-        [](size_t a, std::vector<Item> &b) { return a + b.size(); });
+    size_t num_instances = std::accumulate(num_selected,
+                                           num_selected + num_seqs, size_t(0));
     // the output tensor shape should be [num_instances, 1]
     auto dims = framework::make_ddim(
         std::vector<int64_t>({static_cast<int>(num_instances), 1}));
@@ -74,21 +106,29 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
                   {static_cast<int64_t>(num_instances)}, platform::CPUPlace())
             : nullptr;
 
-    // fill in data
-    std::vector<size_t> low_level;
+    // fill in data, low_level[i] is the number of the items whose offset is
+    // less than i.
+    size_t num_offsets = high_level.back();
+    std::vector<size_t> low_level(num_offsets + 1);
     size_t low_offset = 0;
-    for (auto &items : selected_items) {
-      low_level.push_back(low_offset);
-      for (auto &item : items) {
+    size_t offset = 0;
+    for (int64_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+      for (size_t i = 0; i < num_selected[seq_id]; ++i) {
+        const Item &item = items[seq_id * beam_size + i];
+        for (; offset <= item.offset; ++offset) {
+          low_level[offset] = low_offset;
+        }
         if (parent_idx) {
-          parent_idx_data[low_offset] = static_cast<int>(low_level.size() - 1);
+          parent_idx_data[low_offset] = static_cast<int>(item.offset);
         }
         selected_ids_data[low_offset] = item.id;
         selected_scores_data[low_offset] = item.score;
         low_offset++;
       }
     }
-    low_level.push_back(low_offset);
+    for (; offset <= num_offsets; ++offset) {
+      low_level[offset] = low_offset;
+    }
 
     // fill lod
     framework::LoD lod(2);
@@ -109,29 +149,18 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
    */
   struct Item {
     Item() {}
-    Item(size_t offset, size_t id, float score)
-        : offset(offset), id(id), score(score) {}
+    Item(size_t offset, size_t index, int64_t id, float score)
+        : offset(offset), index(index), id(id), score(score) {}
     // offset in the higher lod level.
     size_t offset;
-    // prefix id in the lower lod level.
-    // size_t prefix;
+    // the index of the candidate in the candidates of the prefix.
+    size_t index;
     // the candidate id
-    size_t id;
+    int64_t id;
     // the corresponding score
     float score;
 
-    inline bool operator<(const Item &in) const {
-      return (score < in.score) ||
-             ((score == in.score) && (offset < in.offset));
-    }
-
-    inline void operator=(const Item &in) {
-      offset = in.offset;
-      id = in.id;
-      score = in.score;
-    }
-
-    std::string ToString() {
+    std::string ToString() const {
       std::ostringstream os;
       os << "{";
       os << "offset: " << offset << ", ";
@@ -143,150 +172,119 @@ class BeamSearchFunctor<platform::CPUDeviceContext, T> {
   };
 
  protected:
+  struct Scratch {
+    std::vector<Item> items;
+    std::vector<size_t> num_selected;
+  };
+
+  static Scratch &GetScratch() {
+    static thread_local Scratch scratch;
+    return scratch;
+  }
+
   /*
-   * Prune the source sentences all branchs finished, and it is optional.
-   * Pruning must one step later than finishing (thus pre_ids is needed here),
-   * since the end tokens must be writed out.
+   * The order of the selection: the higher score, then the larger offset, then
+   * the earlier candidate of a prefix is better.
    */
-  void PruneEndBeams(const framework::LoDTensor *pre_ids,
-                     const framework::LoD &abs_lod,
-                     std::vector<std::vector<Item>> *items, size_t lod_level,
-                     int end_id) {
-    auto *pre_ids_data = pre_ids->data<int64_t>();
-    auto &high_level = abs_lod[lod_level];
-    for (size_t src_idx = 0; src_idx < high_level.size() - 1; ++src_idx) {
-      size_t src_prefix_start = high_level[src_idx];
-      size_t src_prefix_end = high_level[src_idx + 1];
-      bool finish_flag = true;
-      for (size_t offset = src_prefix_start; offset < src_prefix_end;
-           offset++) {
-        for (auto &item : items->at(offset)) {
-          if (item.id != static_cast<size_t>(end_id) ||
-              pre_ids_data[offset] != end_id) {
-            finish_flag = false;
-            break;
-          }
-        }
-        if (!finish_flag) break;
-      }
-      if (finish_flag) {  // all branchs of the beam (source sentence) end and
-                          // prune this beam
-        for (size_t offset = src_prefix_start; offset < src_prefix_end;
-             offset++)
-          items->at(offset).clear();
-      }
-    }
+  static bool Better(const Item &a, const Item &b) {
+    return a.score > b.score ||
+           (a.score == b.score &&
+            (a.offset > b.offset ||
+             (a.offset == b.offset && a.index < b.index)));
   }
 
   /*
-   * Transform the items into a map whose key is offset, value is the items.
-   * NOTE low performance.
+   * The order of the output: the items are grouped by offset, and sorted by
+   * the order of the selection in a group.
    */
-  std::vector<std::vector<Item>> ToMap(
-      const std::vector<std::vector<Item>> &items, size_t element_num) {
-    std::vector<std::vector<Item>> result;
-    result.resize(element_num);
-    for (auto &entries : items) {
-      for (const auto &item : entries) {
-        result[item.offset].push_back(item);
-      }
-    }
-    return result;
+  static bool ByOffset(const Item &a, const Item &b) {
+    return a.offset < b.offset || (a.offset == b.offset && Better(a, b));
   }
 
-  void Insert(std::vector<Item> *top_beam_ptr, const Item &item,
-              size_t beam_size) {
-    std::vector<Item> &top_beam = *top_beam_ptr;
-
-    size_t num_beams = top_beam.size();
-    if (num_beams < beam_size) {
-      top_beam.resize(num_beams + 1);
-      num_beams++;
-    } else {
-      if (item < top_beam[beam_size - 1]) {
-        return;
-      }
+  /*
+   * Keep the k best items in the heap [top, top + *num_items), whose front is
+   * the worst one.
+   */
+  static void Push(const Item &item, size_t k, Item *top, size_t *num_items) {
+    if (*num_items < k) {
+      top[(*num_items)++] = item;
+      std::push_heap(top, top + *num_items, Better);
+    } else if (Better(item, top[0])) {
+      std::pop_heap(top, top + k, Better);
+      top[k - 1] = item;
+      std::push_heap(top, top + k, Better);
     }
+  }
 
-    for (int k = static_cast<int>(num_beams) - 2; k >= 0; --k) {
-      if (top_beam[k] < item) {
-        top_beam[k + 1] = top_beam[k];
-      } else {
-        top_beam[k + 1] = item;
-        return;
+  /*
+   * Prune the source sentences all branchs finished, and it is optional.
+   * Pruning must one step later than finishing (thus pre_ids is needed here),
+   * since the end tokens must be writed out.
+   */
+  bool IsFinished(const int64_t *pre_ids_data, const Item *items,
+                  size_t num_items, int end_id) {
+    for (size_t i = 0; i < num_items; ++i) {
+      if (items[i].id != end_id || pre_ids_data[items[i].offset] != end_id) {
+        return false;
       }
     }
-    top_beam[0] = item;
+    return true;
   }
 
   /*
-   * For each source, select top beam_size records.
+   * For a source, select top beam_size records into top_beam and return the
+   * number of them.
    */
-  std::vector<std::vector<Item>> SelectTopBeamSizeItems(
-      const framework::LoDTensor *pre_ids,
-      const framework::LoDTensor *pre_scores, const framework::LoDTensor *ids,
-      const framework::LoDTensor *scores, size_t lod_level, size_t beam_size,
-      int end_id, bool is_accumulated) {
-    std::vector<std::vector<Item>> result;
-
-    // find the current candidates
-    auto abs_lod = framework::ToAbsOffset(scores->lod());
-
-    auto *pre_ids_data = pre_ids->data<int64_t>();
-    auto *pre_scores_data = pre_scores->data<float>();
-
-    auto *ids_data = ids ? ids->data<int64_t>() : nullptr;
-    auto *scores_data = scores->data<float>();
-
-    size_t num_seqs = scores->NumElements(lod_level);
-    size_t seq_width = 1;
-    for (int i = 1; i < scores->dims().size(); i++) {
-      seq_width *= scores->dims()[i];
-    }
-
-    for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
-      size_t seq_offset_start = abs_lod[lod_level][seq_id];
-      size_t seq_offset_end = abs_lod[lod_level][seq_id + 1];
-
-      std::vector<Item> top_beam;
-      top_beam.reserve(beam_size);
-
-      for (size_t offset = seq_offset_start; offset < seq_offset_end;
-           ++offset) {
-        auto pre_id = pre_ids_data[offset];
-        auto pre_score = pre_scores_data[offset];
-        if (pre_id == end_id) {
-          // Allocate all probability mass to end_id for finished branchs and
-          // the other candidate ids can be ignored.
-          Item item(offset, end_id, pre_score);
-          Insert(&top_beam, item, beam_size);
-        } else {
-          size_t index = offset * seq_width;
-          for (size_t d = 0; d < seq_width; d++, index++) {
-            int64_t id = ids_data ? ids_data[index] : static_cast<int64_t>(d);
-            float score = is_accumulated
-                              ? scores_data[index]
-                              : pre_score + std::log(scores_data[index]);
-            Item item(offset, id, score);
-            Insert(&top_beam, item, beam_size);
-          }
-        }
+  size_t SelectTopBeamSizeItems(const int64_t *pre_ids_data,
+                                const float *pre_scores_data,
+                                const int64_t *ids_data,
+                                const float *scores_data, size_t seq_width,
+                                size_t seq_offset_start, size_t seq_offset_end,
+                                size_t beam_size, int end_id,
+                                bool is_accumulated, Item *top_beam) {
+    if (beam_size == 0) return 0;
+    static thread_local std::vector<Item> row_top;
+    row_top.resize(beam_size);
+
+    size_t num_items = 0;
+    for (size_t offset = seq_offset_start; offset < seq_offset_end; ++offset) {
+      auto pre_id = pre_ids_data[offset];
+      auto pre_score = pre_scores_data[offset];
+      if (pre_id == end_id) {
+        // Allocate all probability mass to end_id for finished branchs and
+        // the other candidate ids can be ignored.
+        Push(Item(offset, 0, end_id, pre_score), beam_size, top_beam,
+             &num_items);
+        continue;
       }
-
-      result.emplace_back(top_beam);
-    }
-
-    if (FLAGS_v == 3) {
-      VLOG(3) << "SelectTopBeamSizeItems result size " << result.size();
-      for (auto &items : result) {
-        VLOG(3) << "item set:";
-        for (auto &item : items) {
-          VLOG(3) << item.ToString();
+      size_t index = offset * seq_width;
+      if (is_accumulated) {
+        for (size_t d = 0; d < seq_width; d++, index++) {
+          float score = scores_data[index];
+          // Most of the candidates are worse than the worst selected one.
+          if (num_items == beam_size && score < top_beam[0].score) continue;
+          int64_t id = ids_data ? ids_data[index] : static_cast<int64_t>(d);
+          Push(Item(offset, d, id, score), beam_size, top_beam, &num_items);
+        }
+      } else {
+        // log is increasing, so only the beam_size highest probabilities of
+        // the prefix can be selected, and the log is taken only for them.
+        size_t num_row_items = 0;
+        for (size_t d = 0; d < seq_width; d++, index++) {
+          float score = scores_data[index];
+          if (num_row_items == beam_size && score < row_top[0].score) continue;
+          int64_t id = ids_data ? ids_data[index] : static_cast<int64_t>(d);
+          Push(Item(offset, d, id, score), beam_size, row_top.data(),
+               &num_row_items);
+        }
+        for (size_t i = 0; i < num_row_items; ++i) {
+          Item item = row_top[i];
+          item.score = pre_score + std::log(item.score);
+          Push(item, beam_size, top_beam, &num_items);
         }
       }
     }
-
-    return result;
+    return num_items;
   }
 };
 
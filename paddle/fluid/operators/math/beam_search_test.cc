@@ -16,6 +16,16 @@ limitations under the License. */
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/operators/math/test_helper.h"
+#include "paddle/fluid/string/printf.h"
+
 void PrepareCPUTensors(paddle::framework::LoDTensor* ids,
                        paddle::framework::LoDTensor* scores,
                        paddle::framework::LoDTensor* pre_ids,
@@ -129,6 +139,312 @@ void TestBeamSearch() {
   delete context;
 }
 
+// The CPU beam search before the selection was heap based. It is the
+// reference of the results and the baseline of the benchmark.
+class LegacyBeamSearch {
+ public:
+  void operator()(const paddle::framework::LoDTensor* pre_ids,
+                  const paddle::framework::LoDTensor* pre_scores,
+                  const paddle::framework::LoDTensor* ids,
+                  const paddle::framework::LoDTensor* scores,
+                  paddle::framework::LoDTensor* selected_ids,
+                  paddle::framework::LoDTensor* selected_scores,
+                  paddle::framework::Tensor* parent_idx, size_t level,
+                  size_t beam_size, int end_id, bool is_accumulated) {
+    auto abs_lod = paddle::framework::ToAbsOffset(scores->lod());
+    auto& high_level = abs_lod[level];
+    auto items = SelectTopBeamSizeItems(pre_ids, pre_scores, ids, scores, level,
+                                        beam_size, end_id, is_accumulated);
+    auto selected_items = ToMap(items, high_level.back());
+    PruneEndBeams(pre_ids, abs_lod, &selected_items, level, end_id);
+    size_t num_instances = 0;
+    for (auto& items : selected_items) {
+      num_instances += items.size();
+    }
+    auto dims = paddle::framework::make_ddim(
+        std::vector<int64_t>({static_cast<int>(num_instances), 1}));
+    paddle::platform::CPUPlace place;
+    auto* selected_ids_data = selected_ids->mutable_data<int64_t>(dims, place);
+    auto* selected_scores_data =
+        selected_scores->mutable_data<float>(dims, place);
+    auto* parent_idx_data = parent_idx->mutable_data<int>(
+        {static_cast<int64_t>(num_instances)}, place);
+    std::vector<size_t> low_level;
+    size_t low_offset = 0;
+    for (auto& items : selected_items) {
+      low_level.push_back(low_offset);
+      for (auto& item : items) {
+        parent_idx_data[low_offset] = static_cast<int>(low_level.size() - 1);
+        selected_ids_data[low_offset] = item.id;
+        selected_scores_data[low_offset] = item.score;
+        low_offset++;
+      }
+    }
+    low_level.push_back(low_offset);
+    paddle::framework::LoD lod(2);
+    lod[0].assign(high_level.begin(), high_level.end());
+    lod[1].assign(low_level.begin(), low_level.end());
+    selected_ids->set_lod(lod);
+    selected_scores->set_lod(lod);
+  }
+
+ private:
+  struct Item {
+    Item() {}
+    Item(size_t offset, size_t id, float score)
+        : offset(offset), id(id), score(score) {}
+    size_t offset;
+    size_t id;
+    float score;
+
+    bool operator<(const Item& in) const {
+      return (score < in.score) ||
+             ((score == in.score) && (offset < in.offset));
+    }
+  };
+
+  void PruneEndBeams(const paddle::framework::LoDTensor* pre_ids,
+                     const paddle::framework::LoD& abs_lod,
+                     std::vector<std::vector<Item>>* items, size_t lod_level,
+                     int end_id) {
+    auto* pre_ids_data = pre_ids->data<int64_t>();
+    auto& high_level = abs_lod[lod_level];
+    for (size_t src_idx = 0; src_idx < high_level.size() - 1; ++src_idx) {
+      size_t src_prefix_start = high_level[src_idx];
+      size_t src_prefix_end = high_level[src_idx + 1];
+      bool finish_flag = true;
+      for (size_t offset = src_prefix_start; offset < src_prefix_end;
+           offset++) {
+        for (auto& item : items->at(offset)) {
+          if (item.id != static_cast<size_t>(end_id) ||
+              pre_ids_data[offset] != end_id) {
+            finish_flag = false;
+            break;
+          }
+        }
+        if (!finish_flag) break;
+      }
+      if (finish_flag) {
+        for (size_t offset = src_prefix_start; offset < src_prefix_end;
+             offset++)
+          items->at(offset).clear();
+      }
+    }
+  }
+
+  std::vector<std::vector<Item>> ToMap(
+      const std::vector<std::vector<Item>>& items, size_t element_num) {
+    std::vector<std::vector<Item>> result;
+    result.resize(element_num);
+    for (auto& entries : items) {
+      for (const auto& item : entries) {
+        result[item.offset].push_back(item);
+      }
+    }
+    return result;
+  }
+
+  void Insert(std::vector<Item>* top_beam_ptr, const Item& item,
+              size_t beam_size) {
+    std::vector<Item>& top_beam = *top_beam_ptr;
+    size_t num_beams = top_beam.size();
+    if (num_beams < beam_size) {
+      top_beam.resize(num_beams + 1);
+      num_beams++;
+    } else {
+      if (item < top_beam[beam_size - 1]) {
+        return;
+      }
+    }
+    for (int k = static_cast<int>(num_beams) - 2; k >= 0; --k) {
+      if (top_beam[k] < item) {
+        top_beam[k + 1] = top_beam[k];
+      } else {
+        top_beam[k + 1] = item;
+        return;
+      }
+    }
+    top_beam[0] = item;
+  }
+
+  std::vector<std::vector<Item>> SelectTopBeamSizeItems(
+      const paddle::framework::LoDTensor* pre_ids,
+      const paddle::framework::LoDTensor* pre_scores,
+      const paddle::framework::LoDTensor* ids,
+      const paddle::framework::LoDTensor* scores, size_t lod_level,
+      size_t beam_size, int end_id, bool is_accumulated) {
+    std::vector<std::vector<Item>> result;
+    auto abs_lod = paddle::framework::ToAbsOffset(scores->lod());
+    auto* pre_ids_data = pre_ids->data<int64_t>();
+    auto* pre_scores_data = pre_scores->data<float>();
+    auto* ids_data = ids ? ids->data<int64_t>() : nullptr;
+    auto* scores_data = scores->data<float>();
+    size_t num_seqs = scores->NumElements(lod_level);
+    size_t seq_width = 1;
+    for (int i = 1; i < scores->dims().size(); i++) {
+      seq_width *= scores->dims()[i];
+    }
+    for (size_t seq_id = 0; seq_id < num_seqs; ++seq_id) {
+      size_t seq_offset_start = abs_lod[lod_level][seq_id];
+      size_t seq_offset_end = abs_lod[lod_level][seq_id + 1];
+      std::vector<Item> top_beam;
+      top_beam.reserve(beam_size);
+      for (size_t offset = seq_offset_start; offset < seq_offset_end;
+           ++offset) {
+        auto pre_id = pre_ids_data[offset];
+        auto pre_score = pre_scores_data[offset];
+        if (pre_id == end_id) {
+          Item item(offset, end_id, pre_score);
+          Insert(&top_beam, item, beam_size);
+        } else {
+          size_t index = offset * seq_width;
+          for (size_t d = 0; d < seq_width; d++, index++) {
+            int64_t id = ids_data ? ids_data[index] : static_cast<int64_t>(d);
+            float score = is_accumulated
+                              ? scores_data[index]
+                              : pre_score + std::log(scores_data[index]);
+            Item item(offset, id, score);
+            Insert(&top_beam, item, beam_size);
+          }
+        }
+      }
+      result.emplace_back(top_beam);
+    }
+    return result;
+  }
+};
+
+// num_sources source sentences with beam_size prefixes each, every prefix has
+// vocab_size candidates whose scores are distinct.
+struct BeamSearchInputs {
+  BeamSearchInputs(int num_sources, int beam_size, int vocab_size,
+                   bool is_accumulated, int end_id, std::mt19937* rng) {
+    paddle::platform::CPUPlace place;
+    int num_prefixes = num_sources * beam_size;
+    paddle::framework::LoD lod(1);
+    for (int i = 0; i <= num_sources; ++i) {
+      lod[0].push_back(i * beam_size);
+    }
+    scores.set_lod(lod);
+
+    auto* scores_data = scores.mutable_data<float>(
+        paddle::framework::make_ddim({num_prefixes, vocab_size}), place);
+    std::vector<int> order(num_prefixes * vocab_size);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), *rng);
+    for (size_t i = 0; i < order.size(); ++i) {
+      // probabilities in (0, 1), or accumulated log probabilities
+      float p = (order[i] + 0.5f) / order.size();
+      scores_data[i] = is_accumulated ? -10.f * p : p;
+    }
+
+    auto* pre_ids_data = pre_ids.mutable_data<int64_t>(
+        paddle::framework::make_ddim({num_prefixes, 1}), place);
+    auto* pre_scores_data = pre_scores.mutable_data<float>(
+        paddle::framework::make_ddim({num_prefixes, 1}), place);
+    std::uniform_int_distribution<int> id_dist(0, vocab_size - 1);
+    // Small enough for the log probabilities added to them to stay distinct.
+    std::uniform_real_distribution<float> score_dist(-0.5f, 0.f);
+    for (int i = 0; i < num_prefixes; ++i) {
+      // Some branches have finished, all of the last source have.
+      bool finished = i % 5 == 0 || i >= num_prefixes - beam_size;
+      pre_ids_data[i] = finished ? end_id : id_dist(*rng);
+      pre_scores_data[i] = score_dist(*rng);
+    }
+  }
+
+  paddle::framework::LoDTensor pre_ids;
+  paddle::framework::LoDTensor pre_scores;
+  paddle::framework::LoDTensor scores;
+};
+
+struct BeamSearchOutputs {
+  paddle::framework::LoDTensor selected_ids;
+  paddle::framework::LoDTensor selected_scores;
+  paddle::framework::LoDTensor parent_idx;
+};
+
+static void ExpectSameOutputs(const BeamSearchOutputs& expected,
+                              const BeamSearchOutputs& actual) {
+  ASSERT_EQ(expected.selected_ids.lod(), actual.selected_ids.lod());
+  ASSERT_EQ(expected.selected_scores.lod(), actual.selected_scores.lod());
+  ASSERT_EQ(expected.selected_ids.numel(), actual.selected_ids.numel());
+  for (int64_t i = 0; i < expected.selected_ids.numel(); ++i) {
+    ASSERT_EQ(expected.selected_ids.data<int64_t>()[i],
+              actual.selected_ids.data<int64_t>()[i]);
+    ASSERT_EQ(expected.selected_scores.data<float>()[i],
+              actual.selected_scores.data<float>()[i]);
+    ASSERT_EQ(expected.parent_idx.data<int>()[i],
+              actual.parent_idx.data<int>()[i]);
+  }
+}
+
+TEST(BeamSearch, CPUCompareWithLegacy) {
+  std::mt19937 rng(2021);
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceContext context(place);
+  const int end_id = 0;
+  for (bool is_accumulated : {true, false}) {
+    for (int beam_size : {1, 4, 7}) {
+      BeamSearchInputs inputs(3, beam_size, 50, is_accumulated, end_id, &rng);
+      BeamSearchOutputs expected, actual;
+      LegacyBeamSearch legacy;
+      legacy(&inputs.pre_ids, &inputs.pre_scores, nullptr, &inputs.scores,
+             &expected.selected_ids, &expected.selected_scores,
+             &expected.parent_idx, 0, beam_size, end_id, is_accumulated);
+      paddle::operators::math::BeamSearchFunctor<
+          paddle::platform::CPUDeviceContext, float>
+          beamsearch;
+      beamsearch(context, &inputs.pre_ids, &inputs.pre_scores, nullptr,
+                 &inputs.scores, &actual.selected_ids, &actual.selected_scores,
+                 &actual.parent_idx, 0, beam_size, end_id, is_accumulated);
+      ExpectSameOutputs(expected, actual);
+    }
+  }
+}
+
+// A step of the decoder of a translation model with a large beam and
+// vocabulary. Disabled in the default run for its time, enable it with
+// --gtest_also_run_disabled_tests.
+TEST(BeamSearch, DISABLED_CPUBenchmark) {
+  std::mt19937 rng(2021);
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceContext context(place);
+  const int num_sources = 16;
+  const int beam_size = 16;
+  const int vocab_size = 30000;
+  const int end_id = 0;
+  const int repeat = 10;
+  for (bool is_accumulated : {true, false}) {
+    BeamSearchInputs inputs(num_sources, beam_size, vocab_size, is_accumulated,
+                            end_id, &rng);
+    BeamSearchOutputs legacy_outputs, outputs;
+    LegacyBeamSearch legacy;
+    paddle::operators::math::BeamSearchFunctor<
+        paddle::platform::CPUDeviceContext, float>
+        beamsearch;
+    auto run_legacy = [&] {
+      legacy(&inputs.pre_ids, &inputs.pre_scores, nullptr, &inputs.scores,
+             &legacy_outputs.selected_ids, &legacy_outputs.selected_scores,
+             &legacy_outputs.parent_idx, 0, beam_size, end_id,
+             is_accumulated);
+    };
+    auto run = [&] {
+      beamsearch(context, &inputs.pre_ids, &inputs.pre_scores, nullptr,
+                 &inputs.scores, &outputs.selected_ids,
+                 &outputs.selected_scores, &outputs.parent_idx, 0, beam_size,
+                 end_id, is_accumulated);
+    };
+    paddle::operators::math::CompareSpeed(
+        paddle::string::Sprintf(
+            "beam search of %d sources, beam size %d, vocabulary size %d%s",
+            num_sources, beam_size, vocab_size,
+            is_accumulated ? ", accumulated" : ""),
+        "legacy", run_legacy, "heap", run, repeat);
+    ExpectSameOutputs(legacy_outputs, outputs);
+  }
+}
+
 TEST(BeamSearch, CPU) {
   TestBeamSearch<paddle::platform::CPUDeviceContext,
                  paddle::platform::CPUPlace>();
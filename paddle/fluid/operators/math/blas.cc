@@ -14,6 +14,14 @@
 
 #include "paddle/fluid/operators/math/blas.h"
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+
+#include "paddle/fluid/framework/threadpool.h"
+
 namespace paddle {
 namespace operators {
 namespace math {
@@ -50,6 +58,51 @@ MatDescriptor CreateMatrixDescriptor(const framework::DDim &tensor_dim,
   retv.trans_ = trans;
   return retv;
 }
+
+void RunBatchInParallel(int batch_count, int num_threads,
+                        const std::function<void(int)> &fn) {
+  num_threads = (std::min)(num_threads, batch_count);
+  if (num_threads <= 1) {
+    for (int i = 0; i < batch_count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  // The tasks of the pool may start after this function returns, so the
+  // state they share with the calling thread is held by a shared_ptr. A late
+  // task finds no batch left and never touches fn.
+  struct State {
+    std::atomic<int> next{0};
+    int done{0};
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+  auto state = std::make_shared<State>();
+  const std::function<void(int)> *fn_ptr = &fn;
+  auto worker = [state, fn_ptr, batch_count]() {
+    int finished = 0;
+    for (int i = state->next++; i < batch_count; i = state->next++) {
+      (*fn_ptr)(i);
+      ++finished;
+    }
+    if (finished > 0) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->done += finished;
+      if (state->done == batch_count) {
+        state->cv.notify_all();
+      }
+    }
+  };
+
+  auto *pool = framework::ThreadPool::GetInstance();
+  for (int t = 1; t < num_threads; ++t) {
+    pool->Run(worker);
+  }
+  worker();
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->cv.wait(lock, [&] { return state->done == batch_count; });
+}
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle
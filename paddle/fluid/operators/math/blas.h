@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/tensor.h"
 
@@ -84,6 +86,15 @@ struct MatDescriptor {
 extern MatDescriptor CreateMatrixDescriptor(const framework::DDim& tensor_dim,
                                             int num_flatten_cols, bool trans);
 
+/**
+ * Run fn(i) for each i in [0, batch_count) with at most num_threads threads,
+ * the calling thread and the threads of framework::ThreadPool. The calling
+ * thread takes its share of the batches, so it never waits for a task that
+ * is still queued in the pool. fn must not throw.
+ */
+extern void RunBatchInParallel(int batch_count, int num_threads,
+                               const std::function<void(int)>& fn);
+
 template <typename DeviceContext>
 class Blas {
  public:
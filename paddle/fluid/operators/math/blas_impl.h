@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cmath>
 #include <limits>
+#include <type_traits>
 #include <vector>
 
 #include "paddle/fluid/operators/math/math_function.h"
@@ -994,6 +995,175 @@ void Blas<platform::CPUDeviceContext>::GEMV(bool trans_a, int M, int N, T alpha,
   CBlas<T>::GEMV(CblasRowMajor, transA, M, N, alpha, A, N, B, 1, beta, C, 1);
 }
 
+#ifndef PADDLE_WITH_MKLML
+namespace detail {
+
+// GEMM of one small matrix, C = alpha * op(A) * op(B) + beta * C, where
+// op(A) is M x K, op(B) is K x N and all matrices are row-major. The panels
+// of op(A) and op(B) are packed into contiguous buffers kKC deep, so that the
+// micro kernel streams through them and keeps a kMR x kNR block of C in
+// registers.
+template <typename T>
+struct SmallGemm {
+  static constexpr int kMR = 4;  // MicroKernel is written for 4 rows.
+  static constexpr int kNR = 16;
+  static constexpr int kKC = 256;
+
+  static void Run(bool trans_a, bool trans_b, int M, int N, int K, T alpha,
+                  const T *A, const T *B, T beta, T *C) {
+    if (M == 0 || N == 0) return;
+    if (K == 0) {
+      for (int64_t i = 0; i < static_cast<int64_t>(M) * N; ++i) {
+        C[i] = beta == static_cast<T>(0) ? static_cast<T>(0) : beta * C[i];
+      }
+      return;
+    }
+    const int n_panels = (N + kNR - 1) / kNR;
+    thread_local std::vector<T> packed_a;
+    thread_local std::vector<T> packed_b;
+    packed_a.resize(kKC * kMR);
+    packed_b.resize(static_cast<size_t>(kKC) * n_panels * kNR);
+
+    for (int k0 = 0; k0 < K; k0 += kKC) {
+      const int kc = (std::min)(kKC, K - k0);
+      PackB(trans_b, N, K, B, k0, kc, n_panels, packed_b.data());
+      // beta is applied with the first panel of K only.
+      const bool first = k0 == 0;
+      for (int i0 = 0; i0 < M; i0 += kMR) {
+        const int mr = (std::min)(kMR, M - i0);
+        PackA(trans_a, M, K, A, i0, mr, k0, kc, packed_a.data());
+        for (int j = 0; j < n_panels; ++j) {
+          const int j0 = j * kNR;
+          const int nr = (std::min)(kNR, N - j0);
+          T acc[kMR][kNR];
+          MicroKernel(kc, packed_a.data(),
+                      packed_b.data() + static_cast<size_t>(j) * kc * kNR,
+                      acc);
+          for (int ii = 0; ii < mr; ++ii) {
+            T *c = C + static_cast<int64_t>(i0 + ii) * N + j0;
+            if (!first) {
+              for (int jj = 0; jj < nr; ++jj) c[jj] += alpha * acc[ii][jj];
+            } else if (beta == static_cast<T>(0)) {
+              for (int jj = 0; jj < nr; ++jj) c[jj] = alpha * acc[ii][jj];
+            } else {
+              for (int jj = 0; jj < nr; ++jj) {
+                c[jj] = alpha * acc[ii][jj] + beta * c[jj];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+ private:
+  // Packs rows [i0, i0 + mr) and columns [k0, k0 + kc) of op(A), column by
+  // column, padding the rows to kMR with zeros.
+  static void PackA(bool trans_a, int M, int K, const T *A, int i0, int mr,
+                    int k0, int kc, T *dst) {
+    for (int p = 0; p < kc; ++p) {
+      for (int ii = 0; ii < kMR; ++ii) {
+        int64_t i = i0 + ii;
+        int64_t k = k0 + p;
+        dst[p * kMR + ii] = ii < mr ? (trans_a ? A[k * M + i] : A[i * K + k])
+                                    : static_cast<T>(0);
+      }
+    }
+  }
+
+  // Packs rows [k0, k0 + kc) of op(B) into panels of kNR columns, padding
+  // the last panel with zeros.
+  static void PackB(bool trans_b, int N, int K, const T *B, int k0, int kc,
+                    int n_panels, T *dst) {
+    for (int j = 0; j < n_panels; ++j) {
+      T *panel = dst + static_cast<size_t>(j) * kc * kNR;
+      for (int p = 0; p < kc; ++p) {
+        for (int jj = 0; jj < kNR; ++jj) {
+          int64_t n = j * kNR + jj;
+          int64_t k = k0 + p;
+          panel[p * kNR + jj] =
+              n < N ? (trans_b ? B[n * K + k] : B[k * N + n])
+                    : static_cast<T>(0);
+        }
+      }
+    }
+  }
+
+  // The rows of the block are accumulated in local arrays rather than in
+  // acc, so that the compiler knows they do not alias the panels and keeps
+  // them in vector registers. kMR is 4.
+  static void MicroKernel(int kc, const T *a, const T *b, T acc[kMR][kNR]) {
+    T c0[kNR] = {0}, c1[kNR] = {0}, c2[kNR] = {0}, c3[kNR] = {0};
+    for (int p = 0; p < kc; ++p) {
+      const T *b_p = b + p * kNR;
+      const T a0 = a[p * kMR];
+      const T a1 = a[p * kMR + 1];
+      const T a2 = a[p * kMR + 2];
+      const T a3 = a[p * kMR + 3];
+      for (int jj = 0; jj < kNR; ++jj) {
+        c0[jj] += a0 * b_p[jj];
+        c1[jj] += a1 * b_p[jj];
+        c2[jj] += a2 * b_p[jj];
+        c3[jj] += a3 * b_p[jj];
+      }
+    }
+    for (int jj = 0; jj < kNR; ++jj) {
+      acc[0][jj] = c0[jj];
+      acc[1][jj] = c1[jj];
+      acc[2][jj] = c2[jj];
+      acc[3][jj] = c3[jj];
+    }
+  }
+};
+
+template <typename T>
+constexpr int SmallGemm<T>::kMR;
+template <typename T>
+constexpr int SmallGemm<T>::kNR;
+template <typename T>
+constexpr int SmallGemm<T>::kKC;
+
+// Without MKL, cblas parallelizes inside one GEMM, which pays off only for
+// large matrices. The batches of small matrices, such as those of attention
+// heads, are computed in parallel by SmallGemm instead. It returns false if
+// the batches should go to cblas one by one.
+template <typename T, typename GetA, typename GetB, typename GetC>
+typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+TryParallelBatchedGEMM(CBLAS_TRANSPOSE transA, CBLAS_TRANSPOSE transB, int M,
+                       int N, int K, T alpha, GetA get_a, GetB get_b, T beta,
+                       GetC get_c, int batchCount) {
+  constexpr int64_t kMaxMNK = 256 * 256 * 256;
+  constexpr int64_t kMinTotalMNK = 32 * 32 * 32;
+#ifdef PADDLE_USE_OPENBLAS
+  int num_threads = openblas_get_num_threads();
+#else
+  int num_threads = 1;
+#endif
+  int64_t mnk = static_cast<int64_t>(M) * N * K;
+  if (num_threads < 2 || batchCount < 2 || mnk > kMaxMNK ||
+      mnk * batchCount < kMinTotalMNK) {
+    return false;
+  }
+  bool trans_a = transA != CblasNoTrans;
+  bool trans_b = transB != CblasNoTrans;
+  RunBatchInParallel(batchCount, num_threads, [&](int k) {
+    SmallGemm<T>::Run(trans_a, trans_b, M, N, K, alpha, get_a(k), get_b(k),
+                      beta, get_c(k));
+  });
+  return true;
+}
+
+template <typename T, typename GetA, typename GetB, typename GetC>
+typename std::enable_if<!std::is_floating_point<T>::value, bool>::type
+TryParallelBatchedGEMM(CBLAS_TRANSPOSE transA, CBLAS_TRANSPOSE transB, int M,
+                       int N, int K, T alpha, GetA get_a, GetB get_b, T beta,
+                       GetC get_c, int batchCount) {
+  return false;
+}
+
+}  // namespace detail
+#endif
+
 template <>
 template <typename T>
 void Blas<platform::CPUDeviceContext>::BatchedGEMM(
@@ -1017,6 +1187,14 @@ void Blas<platform::CPUDeviceContext>::BatchedGEMM(
                        a_array.data(), &lda, b_array.data(), &ldb, &beta,
                        c_array.data(), &ldc, 1 /* group_count */, &batchCount);
 #else
+  if (detail::TryParallelBatchedGEMM<T>(
+          transA, transB, M, N, K, alpha,
+          [&](int k) { return &A[k * strideA]; },
+          [&](int k) { return &B[k * strideB]; }, beta,
+          [&](int k) { return &C[static_cast<int64_t>(k) * M * N]; },
+          batchCount)) {
+    return;
+  }
   for (int k = 0; k < batchCount; ++k) {
     auto *Ak = &A[k * strideA];
     auto *Bk = &B[k * strideB];
@@ -1039,6 +1217,12 @@ void Blas<platform::CPUDeviceContext>::BatchedGEMM(
                        &lda, B, &ldb, &beta, C, &ldc, 1 /* group_count */,
                        &batchCount);
 #else
+  if (detail::TryParallelBatchedGEMM<T>(
+          transA, transB, M, N, K, alpha, [&](int k) { return A[k]; },
+          [&](int k) { return B[k]; }, beta, [&](int k) { return C[k]; },
+          batchCount)) {
+    return;
+  }
   for (int k = 0; k < batchCount; ++k) {
     this->template GEMM<T>(transA, transB, M, N, K, alpha, A[k], B[k], beta,
                            C[k]);
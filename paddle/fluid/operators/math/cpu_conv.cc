@@ -0,0 +1,475 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/cpu_conv.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <limits>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/operator_kernel_configs.h"
+#include "paddle/fluid/operators/math/blas.h"
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+DECLARE_bool(cpu_conv_exhaustive_search);
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+Conv2DShape::Conv2DShape(const framework::DDim& input_dims,
+                         const framework::DDim& filter_dims,
+                         const framework::DDim& output_dims,
+                         const std::vector<int>& strides,
+                         const std::vector<int>& paddings,
+                         const std::vector<int>& dilations, int groups)
+    : batch_size(static_cast<int>(input_dims[0])),
+      in_channels(static_cast<int>(input_dims[1])),
+      in_height(static_cast<int>(input_dims[2])),
+      in_width(static_cast<int>(input_dims[3])),
+      out_channels(static_cast<int>(output_dims[1])),
+      out_height(static_cast<int>(output_dims[2])),
+      out_width(static_cast<int>(output_dims[3])),
+      filter_height(static_cast<int>(filter_dims[2])),
+      filter_width(static_cast<int>(filter_dims[3])),
+      stride_height(strides[0]),
+      stride_width(strides[1]),
+      pad_top(paddings[0]),
+      pad_left(paddings[2]),
+      dilation_height(dilations[0]),
+      dilation_width(dilations[1]),
+      groups(groups) {}
+
+bool CPUConvAlgoApplicable(CPUConvAlgo algo, const Conv2DShape& shape) {
+  switch (algo) {
+    case CPUConvAlgo::kIm2ColGemm:
+      return true;
+    case CPUConvAlgo::kDepthwise:
+      // A single input channel is an ordinary convolution, which GEMM does
+      // better.
+      return shape.in_channels > 1 && shape.groups == shape.in_channels &&
+             shape.out_channels % shape.in_channels == 0;
+    case CPUConvAlgo::kWinograd:
+      return shape.groups == 1 && shape.filter_height == 3 &&
+             shape.filter_width == 3 && shape.stride_height == 1 &&
+             shape.stride_width == 1 && shape.dilation_height == 1 &&
+             shape.dilation_width == 1;
+  }
+  return false;
+}
+
+CPUConvAlgo SelectCPUConvAlgo(const Conv2DShape& shape) {
+  if (CPUConvAlgoApplicable(CPUConvAlgo::kDepthwise, shape)) {
+    return CPUConvAlgo::kDepthwise;
+  }
+  // Winograd does 2.25x fewer multiplications, which pays for its transforms
+  // once the GEMMs have enough channels.
+  if (CPUConvAlgoApplicable(CPUConvAlgo::kWinograd, shape) &&
+      shape.in_channels >= 16 && shape.out_channels >= 16) {
+    return CPUConvAlgo::kWinograd;
+  }
+  return CPUConvAlgo::kIm2ColGemm;
+}
+
+static int NumThreads() {
+#ifdef PADDLE_WITH_MKLML
+  return omp_get_max_threads();
+#elif defined(PADDLE_USE_OPENBLAS)
+  return openblas_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
+// Runs fn(i) for every i in [0, n) in parallel. fn must not throw.
+static void ParallelFor(int n, const std::function<void(int)>& fn) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+  for (int i = 0; i < n; ++i) {
+    fn(i);
+  }
+#else
+  RunBatchInParallel(n, NumThreads(), fn);
+#endif
+}
+
+// [*begin, *end) are the output columns, out of [0, out_width), whose input
+// column ow * stride + offset is in [0, width).
+static void ValidColumns(int offset, int stride, int width, int out_width,
+                         int* begin, int* end) {
+  int b = offset >= 0 ? 0 : (-offset + stride - 1) / stride;
+  int e = width - 1 - offset < 0 ? 0 : (width - 1 - offset) / stride + 1;
+  *begin = std::min(b, out_width);
+  *end = std::max(std::min(e, out_width), *begin);
+}
+
+// The col of the channels of an image:
+// [channels, filter_height, filter_width, out_height, out_width].
+template <typename T>
+static void Im2Col(const Conv2DShape& s, const T* im, int channels, T* col) {
+  const int out_size = s.out_height * s.out_width;
+  for (int c = 0; c < channels; ++c) {
+    const T* im_data = im + c * s.in_height * s.in_width;
+    for (int kh = 0; kh < s.filter_height; ++kh) {
+      for (int kw = 0; kw < s.filter_width; ++kw) {
+        T* col_data = col + ((c * s.filter_height + kh) * s.filter_width + kw) *
+                                out_size;
+        int offset = kw * s.dilation_width - s.pad_left;
+        int begin, end;
+        ValidColumns(offset, s.stride_width, s.in_width, s.out_width, &begin,
+                     &end);
+        for (int oh = 0; oh < s.out_height; ++oh) {
+          T* col_row = col_data + oh * s.out_width;
+          int ih = oh * s.stride_height - s.pad_top + kh * s.dilation_height;
+          if (ih < 0 || ih >= s.in_height) {
+            std::fill(col_row, col_row + s.out_width, static_cast<T>(0));
+            continue;
+          }
+          const T* im_row = im_data + ih * s.in_width + offset;
+          std::fill(col_row, col_row + begin, static_cast<T>(0));
+          for (int ow = begin; ow < end; ++ow) {
+            col_row[ow] = im_row[ow * s.stride_width];
+          }
+          std::fill(col_row + end, col_row + s.out_width, static_cast<T>(0));
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+static void Im2ColGemm(const platform::CPUDeviceContext& context,
+                       const Conv2DShape& s, const T* input, const T* filter,
+                       T* output) {
+  const int in_step = s.in_channels / s.groups;
+  const int out_step = s.out_channels / s.groups;
+  const int in_size = s.in_height * s.in_width;
+  const int M = out_step;
+  const int N = s.out_height * s.out_width;
+  const int K = in_step * s.filter_height * s.filter_width;
+  // The GEMM of the 1x1 convolution of stride 1 without padding reads the
+  // input directly.
+  const bool need_col =
+      !(s.filter_height == 1 && s.filter_width == 1 && s.stride_height == 1 &&
+        s.stride_width == 1 && s.pad_top == 0 && s.pad_left == 0 &&
+        s.out_height == s.in_height && s.out_width == s.in_width);
+  auto blas = GetBlas<platform::CPUDeviceContext, T>(context);
+
+  auto conv_image = [&](int n, T* col, bool sequential) {
+    for (int g = 0; g < s.groups; ++g) {
+      const T* in = input + (n * s.in_channels + g * in_step) * in_size;
+      if (need_col) {
+        Im2Col(s, in, in_step, col);
+      }
+      const T* a = filter + g * M * K;
+      const T* b = need_col ? col : in;
+      T* c = output + (n * s.out_channels + g * out_step) * N;
+#ifndef PADDLE_WITH_MKLML
+      if (sequential) {
+        detail::SmallGemm<T>::Run(false, false, M, N, K, static_cast<T>(1), a,
+                                  b, static_cast<T>(0), c);
+        continue;
+      }
+#endif
+      // MKL runs sequentially in the OpenMP parallel regions.
+      blas.GEMM(CblasNoTrans, CblasNoTrans, M, N, K, static_cast<T>(1), a, b,
+                static_cast<T>(0), c);
+    }
+  };
+
+  // Every thread convolves its own chunk of images when there are enough of
+  // them. Without MKL the sequential GEMM is only fast enough for small
+  // matrices, the larger ones run one by one on the threads of the BLAS
+  // library.
+  constexpr int64_t kMaxSequentialMNK = 256 * 256 * 256;
+  int num_threads = NumThreads();
+  bool batch_parallel = num_threads >= 2 && s.batch_size >= num_threads;
+#ifndef PADDLE_WITH_MKLML
+  batch_parallel = batch_parallel &&
+                   static_cast<int64_t>(M) * N * K <= kMaxSequentialMNK;
+#endif
+  // One col buffer for every chunk of images.
+  const int num_chunks = batch_parallel ? num_threads : 1;
+  const int64_t col_size = static_cast<int64_t>(K) * N;
+  framework::Tensor col_tensor;
+  T* cols = need_col ? col_tensor.mutable_data<T>({num_chunks, col_size},
+                                                  platform::CPUPlace())
+                     : nullptr;
+  if (batch_parallel) {
+    ParallelFor(num_chunks, [&](int chunk) {
+      T* col = need_col ? cols + chunk * col_size : nullptr;
+      int begin = static_cast<int64_t>(chunk) * s.batch_size / num_chunks;
+      int end = static_cast<int64_t>(chunk + 1) * s.batch_size / num_chunks;
+      for (int n = begin; n < end; ++n) {
+        conv_image(n, col, true);
+      }
+    });
+  } else {
+    for (int n = 0; n < s.batch_size; ++n) {
+      conv_image(n, cols, false);
+    }
+  }
+}
+
+// The direct convolution of every channel of every image, the output
+// channel oc convolves the input channel oc / (out_channels / in_channels).
+template <typename T>
+static void DepthwiseConv(const Conv2DShape& s, const T* input,
+                          const T* filter, T* output) {
+  const int multiplier = s.out_channels / s.in_channels;
+  const int in_size = s.in_height * s.in_width;
+  const int out_size = s.out_height * s.out_width;
+  const int filter_size = s.filter_height * s.filter_width;
+  ParallelFor(s.batch_size * s.out_channels, [&](int i) {
+    int n = i / s.out_channels;
+    int oc = i % s.out_channels;
+    const T* in = input + (n * s.in_channels + oc / multiplier) * in_size;
+    const T* w = filter + oc * filter_size;
+    T* out = output + static_cast<int64_t>(i) * out_size;
+    std::fill(out, out + out_size, static_cast<T>(0));
+    for (int oh = 0; oh < s.out_height; ++oh) {
+      T* out_row = out + oh * s.out_width;
+      for (int kh = 0; kh < s.filter_height; ++kh) {
+        int ih = oh * s.stride_height - s.pad_top + kh * s.dilation_height;
+        if (ih < 0 || ih >= s.in_height) continue;
+        for (int kw = 0; kw < s.filter_width; ++kw) {
+          int offset = kw * s.dilation_width - s.pad_left;
+          int begin, end;
+          ValidColumns(offset, s.stride_width, s.in_width, s.out_width, &begin,
+                       &end);
+          const T* in_row = in + ih * s.in_width + offset;
+          const T weight = w[kh * s.filter_width + kw];
+          if (s.stride_width == 1) {
+            for (int ow = begin; ow < end; ++ow) {
+              out_row[ow] += weight * in_row[ow];
+            }
+          } else {
+            for (int ow = begin; ow < end; ++ow) {
+              out_row[ow] += weight * in_row[ow * s.stride_width];
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+/*
+ * Winograd F(2x2, 3x3): every 2x2 tile of the output is
+ * A^T [(G g G^T) .* (B^T d B)] A, where d is the 4x4 input tile and g the
+ * 3x3 filter. The element-wise products are summed over the input channels
+ * by 16 GEMMs, one per element of the 4x4 transformed tiles.
+ */
+template <typename T>
+static void WinogradConv(const platform::CPUDeviceContext& context,
+                         const Conv2DShape& s, const T* input, const T* filter,
+                         T* output) {
+  const int IC = s.in_channels;
+  const int OC = s.out_channels;
+  const int tiles_h = (s.out_height + 1) / 2;
+  const int tiles_w = (s.out_width + 1) / 2;
+  const int num_tiles = tiles_h * tiles_w;
+  // The tiles are transformed and multiplied kTileBlock at a time to keep
+  // the transformed tiles in the cache.
+  constexpr int kTileBlock = 256;
+  const T half = static_cast<T>(0.5);
+
+  // u[k][oc][ic] = (G g G^T)[k]
+  framework::Tensor u_tensor, v_tensor, m_tensor;
+  T* u = u_tensor.mutable_data<T>({16, OC, IC}, platform::CPUPlace());
+  T* v = v_tensor.mutable_data<T>({16, IC, kTileBlock}, platform::CPUPlace());
+  T* m = m_tensor.mutable_data<T>({16, OC, kTileBlock}, platform::CPUPlace());
+  for (int oc = 0; oc < OC; ++oc) {
+    for (int ic = 0; ic < IC; ++ic) {
+      const T* g = filter + (oc * IC + ic) * 9;
+      T gg[4][3];
+      for (int j = 0; j < 3; ++j) {
+        gg[0][j] = g[j];
+        gg[1][j] = (g[j] + g[3 + j] + g[6 + j]) * half;
+        gg[2][j] = (g[j] - g[3 + j] + g[6 + j]) * half;
+        gg[3][j] = g[6 + j];
+      }
+      for (int i = 0; i < 4; ++i) {
+        T ggg[4] = {gg[i][0], (gg[i][0] + gg[i][1] + gg[i][2]) * half,
+                    (gg[i][0] - gg[i][1] + gg[i][2]) * half, gg[i][2]};
+        for (int j = 0; j < 4; ++j) {
+          u[((i * 4 + j) * OC + oc) * IC + ic] = ggg[j];
+        }
+      }
+    }
+  }
+
+  auto blas = GetBlas<platform::CPUDeviceContext, T>(context);
+  const int in_size = s.in_height * s.in_width;
+  const int out_size = s.out_height * s.out_width;
+  for (int n = 0; n < s.batch_size; ++n) {
+    const T* in = input + n * IC * in_size;
+    T* out = output + n * OC * out_size;
+    for (int t0 = 0; t0 < num_tiles; t0 += kTileBlock) {
+      const int nt = std::min(kTileBlock, num_tiles - t0);
+      // v[k][ic][t] = (B^T d B)[k]
+      for (int ic = 0; ic < IC; ++ic) {
+        const T* im = in + ic * in_size;
+        for (int t = 0; t < nt; ++t) {
+          int y0 = (t0 + t) / tiles_w * 2 - s.pad_top;
+          int x0 = (t0 + t) % tiles_w * 2 - s.pad_left;
+          T d[4][4];
+          for (int i = 0; i < 4; ++i) {
+            int y = y0 + i;
+            for (int j = 0; j < 4; ++j) {
+              int x = x0 + j;
+              d[i][j] = (y >= 0 && y < s.in_height && x >= 0 && x < s.in_width)
+                            ? im[y * s.in_width + x]
+                            : static_cast<T>(0);
+            }
+          }
+          T bd[4][4];
+          for (int j = 0; j < 4; ++j) {
+            bd[0][j] = d[0][j] - d[2][j];
+            bd[1][j] = d[1][j] + d[2][j];
+            bd[2][j] = d[2][j] - d[1][j];
+            bd[3][j] = d[1][j] - d[3][j];
+          }
+          for (int i = 0; i < 4; ++i) {
+            T* vi = v + (i * 4 * IC + ic) * nt + t;
+            vi[0] = bd[i][0] - bd[i][2];
+            vi[IC * nt] = bd[i][1] + bd[i][2];
+            vi[2 * IC * nt] = bd[i][2] - bd[i][1];
+            vi[3 * IC * nt] = bd[i][1] - bd[i][3];
+          }
+        }
+      }
+      // m[k] = u[k] * v[k]
+      for (int k = 0; k < 16; ++k) {
+        blas.GEMM(CblasNoTrans, CblasNoTrans, OC, nt, IC, static_cast<T>(1),
+                  u + k * OC * IC, v + k * IC * nt, static_cast<T>(0),
+                  m + k * OC * nt);
+      }
+      // the output tiles A^T m A
+      for (int oc = 0; oc < OC; ++oc) {
+        T* out_data = out + oc * out_size;
+        for (int t = 0; t < nt; ++t) {
+          T mm[16];
+          for (int k = 0; k < 16; ++k) {
+            mm[k] = m[(k * OC + oc) * nt + t];
+          }
+          T am[2][4];
+          for (int j = 0; j < 4; ++j) {
+            am[0][j] = mm[j] + mm[4 + j] + mm[8 + j];
+            am[1][j] = mm[4 + j] - mm[8 + j] - mm[12 + j];
+          }
+          int y0 = (t0 + t) / tiles_w * 2;
+          int x0 = (t0 + t) % tiles_w * 2;
+          for (int i = 0; i < 2 && y0 + i < s.out_height; ++i) {
+            T* out_row = out_data + (y0 + i) * s.out_width + x0;
+            out_row[0] = am[i][0] + am[i][1] + am[i][2];
+            if (x0 + 1 < s.out_width) {
+              out_row[1] = am[i][1] - am[i][2] - am[i][3];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+void CPUConv2DFunctor<T>::operator()(const platform::CPUDeviceContext& context,
+                                     const framework::Tensor& input,
+                                     const framework::Tensor& filter,
+                                     const std::vector<int>& strides,
+                                     const std::vector<int>& paddings,
+                                     const std::vector<int>& dilations,
+                                     int groups, framework::Tensor* output) {
+  Conv2DShape shape(input.dims(), filter.dims(), output->dims(), strides,
+                    paddings, dilations, groups);
+  if (!FLAGS_cpu_conv_exhaustive_search) {
+    (*this)(context, input, filter, strides, paddings, dilations, groups,
+            SelectCPUConvAlgo(shape), output);
+    return;
+  }
+
+  static framework::AlgorithmsCache<CPUConvAlgo> algo_cache;
+  auto search = [&]() {
+    CPUConvAlgo best_algo = CPUConvAlgo::kIm2ColGemm;
+    double best_time = std::numeric_limits<double>::max();
+    for (auto algo : {CPUConvAlgo::kIm2ColGemm, CPUConvAlgo::kDepthwise,
+                      CPUConvAlgo::kWinograd}) {
+      if (!CPUConvAlgoApplicable(algo, shape)) continue;
+      auto start = std::chrono::steady_clock::now();
+      (*this)(context, input, filter, strides, paddings, dilations, groups,
+              algo, output);
+      auto end = std::chrono::steady_clock::now();
+      double time = std::chrono::duration<double>(end - start).count();
+      VLOG(3) << "CPU conv algo " << static_cast<int>(algo) << " takes "
+              << time << " s";
+      if (time < best_time) {
+        best_time = time;
+        best_algo = algo;
+      }
+    }
+    VLOG(3) << "CPU conv picks algo " << static_cast<int>(best_algo);
+    return best_algo;
+  };
+  auto algo = algo_cache.GetAlgorithm(
+      framework::vectorize(input.dims()), framework::vectorize(filter.dims()),
+      strides, paddings, dilations, groups, sizeof(T), search);
+  (*this)(context, input, filter, strides, paddings, dilations, groups, algo,
+          output);
+}
+
+template <typename T>
+void CPUConv2DFunctor<T>::operator()(const platform::CPUDeviceContext& context,
+                                     const framework::Tensor& input,
+                                     const framework::Tensor& filter,
+                                     const std::vector<int>& strides,
+                                     const std::vector<int>& paddings,
+                                     const std::vector<int>& dilations,
+                                     int groups, CPUConvAlgo algo,
+                                     framework::Tensor* output) {
+  Conv2DShape shape(input.dims(), filter.dims(), output->dims(), strides,
+                    paddings, dilations, groups);
+  PADDLE_ENFORCE_EQ(CPUConvAlgoApplicable(algo, shape), true,
+                    platform::errors::InvalidArgument(
+                        "The CPU convolution algorithm %d is not applicable "
+                        "to the convolution.",
+                        static_cast<int>(algo)));
+  const T* input_data = input.data<T>();
+  const T* filter_data = filter.data<T>();
+  T* output_data = output->data<T>();
+  switch (algo) {
+    case CPUConvAlgo::kIm2ColGemm:
+      Im2ColGemm(context, shape, input_data, filter_data, output_data);
+      break;
+    case CPUConvAlgo::kDepthwise:
+      DepthwiseConv(shape, input_data, filter_data, output_data);
+      break;
+    case CPUConvAlgo::kWinograd:
+      WinogradConv(context, shape, input_data, filter_data, output_data);
+      break;
+  }
+}
+
+template class CPUConv2DFunctor<float>;
+template class CPUConv2DFunctor<double>;
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,95 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <vector>
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * The algorithms of the 2-D convolution on CPU.
+ *
+ * kIm2ColGemm: im2col and a GEMM for every image and group, the images run in
+ *   parallel when their GEMMs are small. The im2col is skipped for the 1x1
+ *   convolutions of stride 1 without padding, whose GEMM reads the input
+ *   directly.
+ * kDepthwise: the direct convolution of the depthwise convolutions, whose
+ *   groups equal to the input channels and which have more than one input
+ *   channel.
+ * kWinograd: Winograd F(2x2, 3x3) for the 3x3 convolutions of stride 1 and
+ *   dilation 1 without groups.
+ */
+enum class CPUConvAlgo { kIm2ColGemm = 0, kDepthwise = 1, kWinograd = 2 };
+
+struct Conv2DShape {
+  Conv2DShape(const framework::DDim& input_dims,
+              const framework::DDim& filter_dims,
+              const framework::DDim& output_dims,
+              const std::vector<int>& strides,
+              const std::vector<int>& paddings,
+              const std::vector<int>& dilations, int groups);
+
+  int batch_size;
+  int in_channels, in_height, in_width;
+  int out_channels, out_height, out_width;
+  int filter_height, filter_width;
+  int stride_height, stride_width;
+  int pad_top, pad_left;
+  int dilation_height, dilation_width;
+  int groups;
+};
+
+bool CPUConvAlgoApplicable(CPUConvAlgo algo, const Conv2DShape& shape);
+
+/*
+ * Picks the algorithm of the shape by its kernel size, channels and groups.
+ */
+CPUConvAlgo SelectCPUConvAlgo(const Conv2DShape& shape);
+
+/*
+ * \brief The forward 2-D convolution of the NCHW input and the
+ * [out_channels, in_channels / groups, filter_height, filter_width] filter.
+ *
+ * paddings are [top, bottom, left, right]. The algorithm is picked by
+ * SelectCPUConvAlgo, or by timing all the applicable ones on the first run of
+ * every shape when FLAGS_cpu_conv_exhaustive_search is set.
+ */
+template <typename T>
+class CPUConv2DFunctor {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor& input,
+                  const framework::Tensor& filter,
+                  const std::vector<int>& strides,
+                  const std::vector<int>& paddings,
+                  const std::vector<int>& dilations, int groups,
+                  framework::Tensor* output);
+
+  // Runs the given algorithm, which must be applicable to the shape.
+  void operator()(const platform::CPUDeviceContext& context,
+                  const framework::Tensor& input,
+                  const framework::Tensor& filter,
+                  const std::vector<int>& strides,
+                  const std::vector<int>& paddings,
+                  const std::vector<int>& dilations, int groups,
+                  CPUConvAlgo algo, framework::Tensor* output);
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,255 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/math/cpu_conv.h"
+
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/im2col.h"
+#include "paddle/fluid/operators/math/test_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+struct ConvParam {
+  int batch_size, in_channels, height, width;
+  int out_channels, filter_height, filter_width;
+  std::vector<int> strides;
+  std::vector<int> paddings;  // [top, bottom, left, right]
+  std::vector<int> dilations;
+  int groups;
+
+  framework::DDim InputDims() const {
+    return framework::make_ddim({batch_size, in_channels, height, width});
+  }
+  framework::DDim FilterDims() const {
+    return framework::make_ddim(
+        {out_channels, in_channels / groups, filter_height, filter_width});
+  }
+  framework::DDim OutputDims() const {
+    int out_height = (height + paddings[0] + paddings[1] -
+                      (dilations[0] * (filter_height - 1) + 1)) /
+                         strides[0] +
+                     1;
+    int out_width = (width + paddings[2] + paddings[3] -
+                     (dilations[1] * (filter_width - 1) + 1)) /
+                        strides[1] +
+                    1;
+    return framework::make_ddim(
+        {batch_size, out_channels, out_height, out_width});
+  }
+};
+
+template <typename T>
+static void ReferenceConv(const Conv2DShape& s, const T* input,
+                          const T* filter, T* output) {
+  int in_step = s.in_channels / s.groups;
+  int out_step = s.out_channels / s.groups;
+  for (int n = 0; n < s.batch_size; ++n) {
+    for (int oc = 0; oc < s.out_channels; ++oc) {
+      int g = oc / out_step;
+      for (int oh = 0; oh < s.out_height; ++oh) {
+        for (int ow = 0; ow < s.out_width; ++ow) {
+          double sum = 0;
+          for (int c = 0; c < in_step; ++c) {
+            for (int kh = 0; kh < s.filter_height; ++kh) {
+              for (int kw = 0; kw < s.filter_width; ++kw) {
+                int ih = oh * s.stride_height - s.pad_top +
+                         kh * s.dilation_height;
+                int iw = ow * s.stride_width - s.pad_left +
+                         kw * s.dilation_width;
+                if (ih < 0 || ih >= s.in_height || iw < 0 ||
+                    iw >= s.in_width) {
+                  continue;
+                }
+                int ic = g * in_step + c;
+                sum += static_cast<double>(
+                           input[((n * s.in_channels + ic) * s.in_height +
+                                  ih) *
+                                     s.in_width +
+                                 iw]) *
+                       filter[((oc * in_step + c) * s.filter_height + kh) *
+                                  s.filter_width +
+                              kw];
+              }
+            }
+          }
+          output[((n * s.out_channels + oc) * s.out_height + oh) *
+                     s.out_width +
+                 ow] = sum;
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+static void TestCPUConv(const ConvParam& param) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext context;
+  std::mt19937 rng(param.in_channels * 131 + param.height * 17 + param.groups);
+  framework::Tensor input, filter, output;
+  input.mutable_data<T>(param.InputDims(), place);
+  filter.mutable_data<T>(param.FilterDims(), place);
+  output.mutable_data<T>(param.OutputDims(), place);
+  RandomFill<T>(&input, &rng);
+  RandomFill<T>(&filter, &rng);
+
+  Conv2DShape shape(input.dims(), filter.dims(), output.dims(), param.strides,
+                    param.paddings, param.dilations, param.groups);
+  std::vector<T> expected(output.numel());
+  ReferenceConv(shape, input.data<T>(), filter.data<T>(), expected.data());
+
+  CPUConv2DFunctor<T> conv;
+  for (auto algo : {CPUConvAlgo::kIm2ColGemm, CPUConvAlgo::kDepthwise,
+                    CPUConvAlgo::kWinograd}) {
+    if (!CPUConvAlgoApplicable(algo, shape)) continue;
+    conv(context, input, filter, param.strides, param.paddings,
+         param.dilations, param.groups, algo, &output);
+    const T* data = output.data<T>();
+    for (int64_t i = 0; i < output.numel(); ++i) {
+      ASSERT_NEAR(expected[i], data[i], 1e-3)
+          << "at " << i << " of algo " << static_cast<int>(algo)
+          << ", input " << input.dims() << ", filter " << filter.dims();
+    }
+  }
+}
+
+TEST(CPUConv2D, Shapes) {
+  platform::SetNumThreads(4);
+  std::vector<ConvParam> params = {
+      // Winograd, with odd outputs and asymmetric paddings
+      {2, 3, 7, 9, 4, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1},
+      {1, 4, 5, 6, 6, 3, 3, {1, 1}, {1, 0, 2, 1}, {1, 1}, 1},
+      {1, 16, 40, 40, 16, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1},
+      // depthwise, with channel multiplier, strides and dilations
+      {2, 4, 9, 7, 8, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 4},
+      {2, 4, 10, 11, 4, 5, 3, {2, 1}, {2, 1, 0, 2}, {2, 1}, 4},
+      // groups
+      {2, 6, 9, 7, 6, 3, 3, {2, 2}, {1, 1, 1, 1}, {1, 1}, 2},
+      // 1x1, with and without im2col
+      {3, 8, 6, 6, 5, 1, 1, {1, 1}, {0, 0, 0, 0}, {1, 1}, 1},
+      {3, 8, 6, 6, 5, 1, 1, {2, 2}, {0, 0, 0, 0}, {1, 1}, 1},
+      {2, 5, 7, 7, 3, 2, 4, {3, 1}, {1, 2, 0, 3}, {2, 2}, 1},
+      // a single input channel, whose groups also equal to the channels
+      {2, 1, 9, 9, 8, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1},
+  };
+  for (auto& param : params) {
+    TestCPUConv<float>(param);
+    TestCPUConv<double>(param);
+  }
+}
+
+TEST(CPUConv2D, SelectAlgo) {
+  auto select = [](const ConvParam& param) {
+    Conv2DShape shape(param.InputDims(), param.FilterDims(),
+                      param.OutputDims(), param.strides, param.paddings,
+                      param.dilations, param.groups);
+    return SelectCPUConvAlgo(shape);
+  };
+  EXPECT_EQ(select({1, 32, 14, 14, 32, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 32}),
+            CPUConvAlgo::kDepthwise);
+  EXPECT_EQ(select({1, 32, 14, 14, 32, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1}),
+            CPUConvAlgo::kWinograd);
+  EXPECT_EQ(select({1, 32, 14, 14, 32, 3, 3, {2, 2}, {1, 1, 1, 1}, {1, 1}, 1}),
+            CPUConvAlgo::kIm2ColGemm);
+  // A single input channel is not run as a depthwise convolution.
+  EXPECT_EQ(select({1, 1, 28, 28, 32, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1}),
+            CPUConvAlgo::kIm2ColGemm);
+}
+
+// The convolutions of ResNet-50 and MobileNet-v1 against the im2col and GEMM
+// of the images one by one, which the conv2d kernel ran before. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(CPUConv2D, DISABLED_Benchmark) {
+  const int num_threads = 4;
+  platform::SetNumThreads(num_threads);
+  platform::CPUPlace place;
+  platform::CPUDeviceContext context;
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  std::mt19937 rng(2021);
+
+  std::vector<std::pair<const char*, ConvParam>> params = {
+      {"ResNet 3x3",
+       {8, 64, 56, 56, 64, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 1}},
+      {"ResNet 1x1",
+       {8, 256, 56, 56, 64, 1, 1, {1, 1}, {0, 0, 0, 0}, {1, 1}, 1}},
+      {"MobileNet depthwise",
+       {8, 128, 56, 56, 128, 3, 3, {1, 1}, {1, 1, 1, 1}, {1, 1}, 128}},
+  };
+
+  const int repeat = 5;
+  for (auto& named_param : params) {
+    const ConvParam& param = named_param.second;
+    framework::Tensor input, filter, output;
+    input.mutable_data<float>(param.InputDims(), place);
+    filter.mutable_data<float>(param.FilterDims(), place);
+    output.mutable_data<float>(param.OutputDims(), place);
+    RandomFill<float>(&input, &rng);
+    RandomFill<float>(&filter, &rng);
+    Conv2DShape s(input.dims(), filter.dims(), output.dims(), param.strides,
+                  param.paddings, param.dilations, param.groups);
+
+    int in_step = s.in_channels / s.groups;
+    int out_step = s.out_channels / s.groups;
+    int M = out_step;
+    int N = s.out_height * s.out_width;
+    int K = in_step * s.filter_height * s.filter_width;
+    framework::Tensor col;
+    col.mutable_data<float>(
+        framework::make_ddim({in_step, s.filter_height, s.filter_width,
+                              s.out_height, s.out_width}),
+        place);
+    Im2ColFunctor<ColFormat::kCFO, platform::CPUDeviceContext, float> im2col;
+    auto one_by_one = [&] {
+      for (int n = 0; n < s.batch_size; ++n) {
+        for (int g = 0; g < s.groups; ++g) {
+          framework::Tensor in_slice =
+              input.Slice(n, n + 1).Resize(framework::make_ddim(
+                  {s.in_channels, s.in_height, s.in_width}));
+          in_slice = in_slice.Slice(g * in_step, (g + 1) * in_step);
+          im2col(context, in_slice, param.dilations, param.strides,
+                 {param.paddings[0], param.paddings[2], param.paddings[1],
+                  param.paddings[3]},
+                 &col);
+          blas.GEMM(CblasNoTrans, CblasNoTrans, M, N, K, 1.f,
+                    filter.data<float>() + g * M * K, col.data<float>(), 0.f,
+                    output.data<float>() +
+                        static_cast<int64_t>(n * s.out_channels + g * M) * N);
+        }
+      }
+    };
+    auto engine = [&] {
+      CPUConv2DFunctor<float>()(context, input, filter, param.strides,
+                                param.paddings, param.dilations, param.groups,
+                                &output);
+    };
+    CompareSpeed(string::Sprintf("%s %s * %s with %d threads, algo %d",
+                                 named_param.first, input.dims(),
+                                 filter.dims(), num_threads,
+                                 static_cast<int>(SelectCPUConvAlgo(s))),
+                 "im2col and GEMM one by one", one_by_one, "CPUConv2DFunctor",
+                 engine, repeat);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
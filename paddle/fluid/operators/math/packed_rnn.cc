@@ -0,0 +1,506 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/math/packed_rnn.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/fc.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+template <typename T>
+PackedGemmWeight<T>::PackedGemmWeight(
+    const platform::CPUDeviceContext& context, const T* weight, int K, int N)
+    : K_(K), N_(N), weight_(weight) {
+#ifdef PADDLE_WITH_MKLML
+  auto blas = GetBlas<platform::CPUDeviceContext, T>(context);
+  packed_ = blas.GEMM_ALLOC(CblasBMatrix, 1, N, K);
+  PADDLE_ENFORCE_NOT_NULL(
+      packed_, platform::errors::ResourceExhausted(
+                   "Failed to allocate the packed weight of %d x %d.", K, N));
+  blas.GEMM_PACK(CblasBMatrix, CblasNoTrans, 1, N, K, static_cast<T>(1),
+                 weight, N, packed_);
+#endif
+}
+
+template <typename T>
+PackedGemmWeight<T>::~PackedGemmWeight() {
+#ifdef PADDLE_WITH_MKLML
+  auto* context = static_cast<platform::CPUDeviceContext*>(
+      platform::DeviceContextPool::Instance().Get(platform::CPUPlace()));
+  GetBlas<platform::CPUDeviceContext, T>(*context).GEMM_FREE(packed_);
+#endif
+}
+
+template <typename T>
+void PackedGemmWeight<T>::AddProduct(const platform::CPUDeviceContext& context,
+                                     int M, const T* A, int lda, T* C,
+                                     int ldc) const {
+  auto blas = GetBlas<platform::CPUDeviceContext, T>(context);
+#ifdef PADDLE_WITH_MKLML
+  blas.GEMM_COMPUTE(CblasNoTrans, CblasPacked, M, N_, K_, A, lda, packed_, N_,
+                    static_cast<T>(1), C, ldc);
+#else
+  blas.GEMM(CblasNoTrans, CblasNoTrans, M, N_, K_, static_cast<T>(1), A, lda,
+            weight_, N_, static_cast<T>(1), C, ldc);
+#endif
+}
+
+template <typename T>
+std::shared_ptr<const PackedGemmWeight<T>> PackedRNNWeightCache::Get(
+    const platform::CPUDeviceContext& context, int slot,
+    const framework::Tensor& weight, int64_t offset, int K, int N) {
+  PADDLE_ENFORCE_LE(offset + static_cast<int64_t>(K) * N, weight.numel(),
+                    platform::errors::InvalidArgument(
+                        "The %d x %d weight at %d is out of the tensor of %d "
+                        "elements.",
+                        K, N, offset, weight.numel()));
+  const T* data = weight.data<T>() + offset;
+#ifndef PADDLE_WITH_MKLML
+  // The weight is read as it is, there is nothing to keep.
+  return std::make_shared<const PackedGemmWeight<T>>(context, data, K, N);
+#else
+  const size_t size = sizeof(T) * K * N;
+  std::lock_guard<std::mutex> lock(mutex_);
+  Entry& entry = entries_[slot];
+  if (entry.packed == nullptr || entry.K != K || entry.N != N ||
+      entry.source.size() != size ||
+      std::memcmp(entry.source.data(), data, size) != 0) {
+    entry.source.assign(reinterpret_cast<const char*>(data),
+                        reinterpret_cast<const char*>(data) + size);
+    entry.K = K;
+    entry.N = N;
+    entry.packed = std::make_shared<const PackedGemmWeight<T>>(
+        context, reinterpret_cast<const T*>(entry.source.data()), K, N);
+  }
+  return std::static_pointer_cast<const PackedGemmWeight<T>>(entry.packed);
+#endif
+}
+
+// The buffers of a direction of a layer.
+template <typename T>
+struct RNNDirectionBuffers {
+  std::vector<T> projection;  // [T, GD]
+  std::vector<T> gates;       // [N, GD]
+  std::vector<T> h_prev, h_cur, c_prev, c_cur;  // [N, D]
+  std::vector<T> checked;                       // [2D], of peepholes
+};
+
+template <typename T>
+static T* Reserve(std::vector<T>* buffer, size_t size) {
+  if (buffer->size() < size) {
+    buffer->resize(size);
+  }
+  return buffer->data();
+}
+
+// The packed weights and the jit kernels of a direction of a layer.
+template <typename T>
+struct RNNDirection {
+  int M;  // the width of the input
+  int D;
+  const T* weight_x;
+  const T* bias;
+  const T* peepholes;
+  // LSTM: WeightH. GRU: W_update and W_reset, then W_state.
+  std::shared_ptr<const PackedGemmWeight<T>> packed_h[2];
+  const T* h0;
+  const T* c0;
+  bool is_reverse;
+};
+
+template <typename T>
+struct RNNKernels {
+  explicit RNNKernels(const PackedRNNAttr& attr, int D)
+      : gru_attr(D, jit::to_kerneltype(attr.gate_activation),
+                 jit::to_kerneltype(attr.candidate_activation)),
+        lstm_attr(D, jit::to_kerneltype(attr.gate_activation),
+                  jit::to_kerneltype(attr.candidate_activation),
+                  jit::to_kerneltype(attr.cell_activation),
+                  attr.use_peepholes) {
+    if (attr.cell == PackedRNNCell::kGRU) {
+      gru_h1 = jit::KernelFuncs<jit::GRUH1Tuple<T>, platform::CPUPlace>::Cache()
+                   .At(gru_attr);
+      gru_part1 =
+          jit::KernelFuncs<jit::GRUHtPart1Tuple<T>, platform::CPUPlace>::Cache()
+              .At(gru_attr);
+      gru_part2 =
+          jit::KernelFuncs<jit::GRUHtPart2Tuple<T>, platform::CPUPlace>::Cache()
+              .At(gru_attr);
+    } else {
+      lstm_c1h1 =
+          jit::KernelFuncs<jit::LSTMC1H1Tuple<T>, platform::CPUPlace>::Cache()
+              .At(lstm_attr);
+      lstm_ctht =
+          jit::KernelFuncs<jit::LSTMCtHtTuple<T>, platform::CPUPlace>::Cache()
+              .At(lstm_attr);
+    }
+  }
+
+  jit::gru_attr_t gru_attr;
+  jit::lstm_attr_t lstm_attr;
+  typename jit::GRUH1Tuple<T>::func_type gru_h1{nullptr};
+  typename jit::GRUHtPart1Tuple<T>::func_type gru_part1{nullptr};
+  typename jit::GRUHtPart2Tuple<T>::func_type gru_part2{nullptr};
+  typename jit::LSTMC1H1Tuple<T>::func_type lstm_c1h1{nullptr};
+  typename jit::LSTMCtHtTuple<T>::func_type lstm_ctht{nullptr};
+};
+
+// The sequences in the order of their lengths, the longest first.
+struct RNNSequences {
+  explicit RNNSequences(const framework::Vector<size_t>& lod) : lod(lod) {
+    int n = static_cast<int>(lod.size()) - 1;
+    order.resize(n);
+    for (int i = 0; i < n; ++i) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+      return lod[a + 1] - lod[a] > lod[b + 1] - lod[b];
+    });
+    max_len = n > 0 ? static_cast<int>(Length(order[0])) : 0;
+  }
+
+  size_t Length(int i) const { return lod[i + 1] - lod[i]; }
+  // the row of step t of sequence i
+  size_t Row(int i, int t, bool is_reverse) const {
+    return is_reverse ? lod[i + 1] - 1 - t : lod[i] + t;
+  }
+
+  const framework::Vector<size_t>& lod;
+  std::vector<int> order;
+  int max_len;
+};
+
+// 1 - sigmoid(x) = sigmoid(-x), so the update gate of origin_mode is that of
+// the negative input.
+template <typename T>
+static inline void NegateUpdateGate(T* gates, int D) {
+  for (int i = 0; i < D; ++i) {
+    gates[i] = -gates[i];
+  }
+}
+
+// Runs a direction of a layer. The hidden and the cell states of step t of
+// a sequence are written to hidden[row * ld + col], and to cell when it is
+// not nullptr.
+template <typename T>
+static void RunRNNDirection(const platform::CPUDeviceContext& context,
+                            const PackedRNNAttr& attr,
+                            const RNNKernels<T>& kernels,
+                            const RNNSequences& seqs, const T* input,
+                            const RNNDirection<T>& dir, T* hidden, T* cell,
+                            int ld, int col, RNNDirectionBuffers<T>* buffers) {
+  const bool is_gru = attr.cell == PackedRNNCell::kGRU;
+  const int D = dir.D;
+  const int GD = (is_gru ? 3 : 4) * D;
+  const int total_T = static_cast<int>(seqs.lod.back());
+  const int N = static_cast<int>(seqs.order.size());
+
+  T* projection = Reserve(&buffers->projection,
+                          static_cast<size_t>(total_T) * GD);
+  FCFunctor<platform::CPUDeviceContext, T> fc;
+  fc(context, total_T, GD, dir.M, input, dir.weight_x, projection, dir.bias);
+
+  T* gates = Reserve(&buffers->gates, static_cast<size_t>(N) * GD);
+  T* h_prev = Reserve(&buffers->h_prev, static_cast<size_t>(N) * D);
+  T* h_cur = Reserve(&buffers->h_cur, static_cast<size_t>(N) * D);
+  T* c_prev = nullptr;
+  T* c_cur = nullptr;
+  jit::lstm_t lstm_step;
+  if (!is_gru) {
+    c_prev = Reserve(&buffers->c_prev, static_cast<size_t>(N) * D);
+    c_cur = Reserve(&buffers->c_cur, static_cast<size_t>(N) * D);
+    lstm_step.wp = dir.peepholes;
+    lstm_step.checked = attr.use_peepholes
+                            ? Reserve(&buffers->checked, 2 * D)
+                            : nullptr;
+  }
+  jit::gru_t gru_step;
+  const size_t row_size = sizeof(T) * D;
+
+  int active = N;
+  for (int t = 0; t < seqs.max_len; ++t) {
+    while (active > 0 && seqs.Length(seqs.order[active - 1]) <=
+                               static_cast<size_t>(t)) {
+      --active;
+    }
+    for (int i = 0; i < active; ++i) {
+      size_t row = seqs.Row(seqs.order[i], t, dir.is_reverse);
+      std::memcpy(gates + i * GD, projection + row * GD, sizeof(T) * GD);
+    }
+    bool first = t == 0;
+    if (first && dir.h0) {
+      for (int i = 0; i < active; ++i) {
+        std::memcpy(h_prev + i * D, dir.h0 + seqs.order[i] * D, row_size);
+        if (!is_gru) {
+          std::memcpy(c_prev + i * D, dir.c0 + seqs.order[i] * D, row_size);
+        }
+      }
+      first = false;
+    }
+
+    if (is_gru) {
+      if (first) {
+        for (int i = 0; i < active; ++i) {
+          if (attr.origin_mode) NegateUpdateGate(gates + i * GD, D);
+          gru_step.gates = gates + i * GD;
+          gru_step.ht = h_cur + i * D;
+          kernels.gru_h1(&gru_step, &kernels.gru_attr);
+        }
+      } else {
+        dir.packed_h[0]->AddProduct(context, active, h_prev, D, gates, GD);
+        for (int i = 0; i < active; ++i) {
+          gru_step.gates = gates + i * GD;
+          gru_step.ht_1 = h_prev + i * D;
+          gru_step.ht = h_cur + i * D;
+          kernels.gru_part1(&gru_step, &kernels.gru_attr);
+        }
+        // h_cur holds r * h_prev
+        dir.packed_h[1]->AddProduct(context, active, h_cur, D, gates + 2 * D,
+                                    GD);
+        for (int i = 0; i < active; ++i) {
+          if (attr.origin_mode) NegateUpdateGate(gates + i * GD, D);
+          gru_step.gates = gates + i * GD;
+          gru_step.ht_1 = h_prev + i * D;
+          gru_step.ht = h_cur + i * D;
+          kernels.gru_part2(&gru_step, &kernels.gru_attr);
+        }
+      }
+    } else {
+      if (!first) {
+        dir.packed_h[0]->AddProduct(context, active, h_prev, D, gates, GD);
+      }
+      for (int i = 0; i < active; ++i) {
+        lstm_step.gates = gates + i * GD;
+        lstm_step.ct_1 = c_prev + i * D;
+        lstm_step.ct = c_cur + i * D;
+        lstm_step.ht = h_cur + i * D;
+        if (first) {
+          kernels.lstm_c1h1(&lstm_step, &kernels.lstm_attr);
+        } else {
+          kernels.lstm_ctht(&lstm_step, &kernels.lstm_attr);
+        }
+      }
+    }
+
+    for (int i = 0; i < active; ++i) {
+      size_t row = seqs.Row(seqs.order[i], t, dir.is_reverse);
+      std::memcpy(hidden + row * ld + col, h_cur + i * D, row_size);
+      if (cell) {
+        std::memcpy(cell + row * ld + col, c_cur + i * D, row_size);
+      }
+    }
+    // The sequences of the next step are the first ones of this step.
+    std::swap(h_prev, h_cur);
+    std::swap(c_prev, c_cur);
+  }
+}
+
+// The buffers of the calling thread, which are kept across the calls.
+template <typename T>
+struct RNNBuffers {
+  RNNDirectionBuffers<T> directions[2];
+  std::vector<T> layer_hidden[2];
+};
+
+template <typename T>
+void PackedRNNFunctor<T>::operator()(
+    const platform::CPUDeviceContext& context, const PackedRNNAttr& attr,
+    const framework::LoDTensor& input,
+    const std::vector<PackedRNNWeight>& weights,
+    PackedRNNWeightCache* packed_weights, const framework::Tensor* h0,
+    const framework::Tensor* c0, framework::Tensor* hidden,
+    framework::Tensor* cell) {
+  const bool is_gru = attr.cell == PackedRNNCell::kGRU;
+  const int G = is_gru ? 3 : 4;
+  const int num_directions = attr.is_bidirec ? 2 : 1;
+  PADDLE_ENFORCE_GE(attr.num_layers, 1,
+                    platform::errors::InvalidArgument(
+                        "The number of the RNN layers must be at least 1, but "
+                        "received %d.",
+                        attr.num_layers));
+  PADDLE_ENFORCE_EQ(
+      weights.size(),
+      static_cast<size_t>(attr.num_layers * num_directions),
+      platform::errors::InvalidArgument(
+          "The RNN of %d layers and %d directions needs %d weights, but "
+          "received %d.",
+          attr.num_layers, num_directions, attr.num_layers * num_directions,
+          weights.size()));
+  if (attr.origin_mode) {
+    PADDLE_ENFORCE_EQ(
+        jit::to_kerneltype(attr.gate_activation), jit::kVSigmoid,
+        platform::errors::Unimplemented(
+            "The GRU of origin_mode only supports the sigmoid gate "
+            "activation, but received %s.",
+            attr.gate_activation));
+  }
+  PADDLE_ENFORCE_GT(input.lod().size(), 0UL,
+                    platform::errors::InvalidArgument(
+                        "The input of the RNN must have LoD."));
+  const auto& lod = input.lod()[0];
+  const int total_T = static_cast<int>(input.dims()[0]);
+  PADDLE_ENFORCE_EQ(lod.back(), static_cast<size_t>(total_T),
+                    platform::errors::InvalidArgument(
+                        "The LoD of the RNN input ends at %d, but the input "
+                        "has %d rows.",
+                        lod.back(), total_T));
+  RNNSequences seqs(lod);
+  const int N = static_cast<int>(seqs.order.size());
+
+  // Checks all the weights and packs them before any thread starts.
+  std::vector<RNNDirection<T>> dirs(weights.size());
+  int M = static_cast<int>(input.numel() / std::max(total_T, 1));
+  int64_t state_offset = 0;
+  for (int l = 0; l < attr.num_layers; ++l) {
+    int D = 0;
+    for (int d = 0; d < num_directions; ++d) {
+      const auto& w = weights[l * num_directions + d];
+      auto& dir = dirs[l * num_directions + d];
+      const auto& wh_dims = w.weight_h->dims();
+      dir.D = static_cast<int>(wh_dims[0]);
+      dir.M = M;
+      PADDLE_ENFORCE_EQ(wh_dims[1], G * dir.D,
+                        platform::errors::InvalidArgument(
+                            "The WeightH of layer %d should be [D, %dD], but "
+                            "received [%s].",
+                            l, G, wh_dims));
+      PADDLE_ENFORCE_EQ(
+          w.weight_x->dims(), framework::make_ddim({M, G * dir.D}),
+          platform::errors::InvalidArgument(
+              "The WeightX of layer %d should be [%d, %d], but received [%s].",
+              l, M, G * dir.D, w.weight_x->dims()));
+      if (d > 0) {
+        PADDLE_ENFORCE_EQ(dir.D, D, platform::errors::InvalidArgument(
+                                        "The hidden sizes of the directions "
+                                        "of layer %d should be equal.",
+                                        l));
+      }
+      D = dir.D;
+      dir.weight_x = w.weight_x->data<T>();
+      dir.bias = nullptr;
+      dir.peepholes = nullptr;
+      if (w.bias) {
+        int bias_size = (attr.use_peepholes && !is_gru ? G + 3 : G) * D;
+        PADDLE_ENFORCE_EQ(w.bias->numel(), bias_size,
+                          platform::errors::InvalidArgument(
+                              "The Bias of layer %d should have %d elements, "
+                              "but received %d.",
+                              l, bias_size, w.bias->numel()));
+        dir.bias = w.bias->data<T>();
+        if (attr.use_peepholes && !is_gru) {
+          dir.peepholes = dir.bias + G * D;
+        }
+      } else {
+        PADDLE_ENFORCE_EQ(is_gru, true,
+                          platform::errors::InvalidArgument(
+                              "The Bias of LSTM should not be null."));
+      }
+      // Packs the weights every call without a cache.
+      PackedRNNWeightCache local_cache;
+      PackedRNNWeightCache* cache =
+          packed_weights ? packed_weights : &local_cache;
+      const int slot = 2 * (l * num_directions + d);
+      if (is_gru) {
+        dir.packed_h[0] =
+            cache->Get<T>(context, slot, *w.weight_h, 0, D, 2 * D);
+        dir.packed_h[1] = cache->Get<T>(context, slot + 1, *w.weight_h,
+                                        static_cast<int64_t>(2) * D * D, D, D);
+      } else {
+        dir.packed_h[0] =
+            cache->Get<T>(context, slot, *w.weight_h, 0, D, 4 * D);
+      }
+      dir.h0 = h0 ? h0->data<T>() + state_offset : nullptr;
+      dir.c0 = c0 ? c0->data<T>() + state_offset : nullptr;
+      dir.is_reverse = attr.is_bidirec ? d == 1 : attr.is_reverse;
+      state_offset += static_cast<int64_t>(N) * D;
+    }
+    M = num_directions * D;
+  }
+  if (h0) {
+    PADDLE_ENFORCE_EQ(h0->numel(), state_offset,
+                      platform::errors::InvalidArgument(
+                          "The H0 of the RNN should have %d elements, but "
+                          "received %d.",
+                          state_offset, h0->numel()));
+  }
+  if (!is_gru) {
+    PADDLE_ENFORCE_EQ(
+        c0 == nullptr, h0 == nullptr,
+        platform::errors::InvalidArgument(
+            "The C0 and H0 of LSTM should be both given or both null."));
+    if (c0) {
+      PADDLE_ENFORCE_EQ(c0->numel(), state_offset,
+                        platform::errors::InvalidArgument(
+                            "The C0 of the RNN should have %d elements, but "
+                            "received %d.",
+                            state_offset, c0->numel()));
+    }
+  }
+
+  const int last_D = dirs.back().D;
+  hidden->Resize(framework::make_ddim({total_T, num_directions * last_D}));
+  T* hidden_data = hidden->mutable_data<T>(context.GetPlace());
+  T* cell_data = nullptr;
+  if (cell && !is_gru) {
+    cell->Resize(hidden->dims());
+    cell_data = cell->mutable_data<T>(context.GetPlace());
+  }
+
+  // The directions run on the other threads with the buffers of this one.
+  static thread_local RNNBuffers<T> local_buffers;
+  RNNBuffers<T>* buffers = &local_buffers;
+  const T* layer_input = input.data<T>();
+  for (int l = 0; l < attr.num_layers; ++l) {
+    const int D = dirs[l * num_directions].D;
+    const int ld = num_directions * D;
+    const bool last = l == attr.num_layers - 1;
+    T* layer_hidden =
+        last ? hidden_data
+             : Reserve(&buffers->layer_hidden[l % 2],
+                       static_cast<size_t>(total_T) * ld);
+    T* layer_cell = last ? cell_data : nullptr;
+    RNNKernels<T> kernels(attr, D);
+    RunBatchInParallel(num_directions, num_directions, [&](int d) {
+      RunRNNDirection<T>(context, attr, kernels, seqs, layer_input,
+                         dirs[l * num_directions + d], layer_hidden,
+                         layer_cell, ld, d * D, &buffers->directions[d]);
+    });
+    layer_input = layer_hidden;
+  }
+}
+
+template class PackedGemmWeight<float>;
+template class PackedGemmWeight<double>;
+template std::shared_ptr<const PackedGemmWeight<float>>
+PackedRNNWeightCache::Get<float>(const platform::CPUDeviceContext& context,
+                                 int slot, const framework::Tensor& weight,
+                                 int64_t offset, int K, int N);
+template std::shared_ptr<const PackedGemmWeight<double>>
+PackedRNNWeightCache::Get<double>(const platform::CPUDeviceContext& context,
+                                  int slot, const framework::Tensor& weight,
+                                  int64_t offset, int K, int N);
+template class PackedRNNFunctor<float>;
+template class PackedRNNFunctor<double>;
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
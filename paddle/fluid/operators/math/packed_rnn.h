@@ -0,0 +1,149 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+/*
+ * A K x N weight packed once for the GEMMs of many rows, by the packed GEMM
+ * of MKL when there is MKLML, or read as it is otherwise.
+ */
+template <typename T>
+class PackedGemmWeight {
+ public:
+  PackedGemmWeight(const platform::CPUDeviceContext& context, const T* weight,
+                   int K, int N);
+  ~PackedGemmWeight();
+
+  // C[M x N] += A[M x K] * weight
+  void AddProduct(const platform::CPUDeviceContext& context, int M, const T* A,
+                  int lda, T* C, int ldc) const;
+
+ private:
+  int K_;
+  int N_;
+  const T* weight_;
+  T* packed_{nullptr};
+};
+
+/*
+ * The packed weights of an op, kept by the op instance so that every
+ * predictor packs its weights once. A weight is packed again when its data
+ * is no longer the one it was packed from, e.g. after it is set or loaded in
+ * place, which costs a comparison with a copy of the weight every call.
+ */
+class PackedRNNWeightCache {
+ public:
+  PackedRNNWeightCache() = default;
+  // The copy of an op packs its weights again.
+  PackedRNNWeightCache(const PackedRNNWeightCache&) {}
+  PackedRNNWeightCache& operator=(const PackedRNNWeightCache&) {
+    return *this;
+  }
+
+  // Returns the packed K x N weight which starts at the element offset of
+  // the tensor. slot tells the weights of the op apart.
+  template <typename T>
+  std::shared_ptr<const PackedGemmWeight<T>> Get(
+      const platform::CPUDeviceContext& context, int slot,
+      const framework::Tensor& weight, int64_t offset, int K, int N);
+
+ private:
+  struct Entry {
+    std::vector<char> source;  // the data packed
+    int K{0};
+    int N{0};
+    std::shared_ptr<const void> packed;
+  };
+
+  std::mutex mutex_;
+  std::unordered_map<int, Entry> entries_;
+};
+
+enum class PackedRNNCell { kGRU, kLSTM };
+
+struct PackedRNNAttr {
+  PackedRNNCell cell{PackedRNNCell::kGRU};
+  int num_layers{1};
+  bool is_bidirec{false};
+  // of the only direction when not bidirectional
+  bool is_reverse{false};
+  std::string gate_activation{"sigmoid"};
+  std::string candidate_activation{"tanh"};
+  // LSTM only
+  std::string cell_activation{"tanh"};
+  bool use_peepholes{false};
+  // GRU only, h = u * h_prev + (1 - u) * c as GRUOp
+  bool origin_mode{false};
+};
+
+/*
+ * The weights of a direction of a layer, in the layouts of fusion_gru and
+ * fusion_lstm: WeightX is M x GD and Bias is 1 x GD, where G is 3 for GRU
+ * and 4 for LSTM, and the LSTM with peepholes has 3D more of Bias. The
+ * WeightH of GRU is {W_update, W_reset; W_state}, a D x 2D and a D x D
+ * matrix one after the other, and that of LSTM is D x 4D.
+ */
+struct PackedRNNWeight {
+  const framework::Tensor* weight_x;
+  const framework::Tensor* weight_h;
+  // may be nullptr for GRU
+  const framework::Tensor* bias;
+};
+
+/*
+ * \brief The forward GRU and LSTM of the sequences of a LoDTensor on CPU,
+ * stacked in layers and bidirectional.
+ *
+ * The inputs of all the time steps and sequences are projected by a single
+ * GEMM for every direction of a layer. The sequences are then run together,
+ * the longest first, so the hidden states of a time step are a GEMM with
+ * the packed WeightH and need no reordering of the input. The two directions
+ * of a layer run at the same time on two threads, and the buffers are kept
+ * by the calling thread across the calls.
+ *
+ * weights are those of the layers in order, the forward one then the
+ * backward one of every layer when bidirectional. The layers after the
+ * first take the hidden states of the last one, the forward and the backward
+ * ones concatenated. h0 and c0 are nullptr, or the initial states
+ * [num_layers * num_directions, N, D] of the layers and directions in the
+ * order of weights. hidden is [T, num_directions * D] of the last layer, and
+ * so is cell of LSTM, which may be nullptr. The WeightH are packed every call
+ * when packed_weights is nullptr.
+ */
+template <typename T>
+class PackedRNNFunctor {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const PackedRNNAttr& attr, const framework::LoDTensor& input,
+                  const std::vector<PackedRNNWeight>& weights,
+                  PackedRNNWeightCache* packed_weights,
+                  const framework::Tensor* h0, const framework::Tensor* c0,
+                  framework::Tensor* hidden, framework::Tensor* cell);
+};
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,406 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/math/packed_rnn.h"
+
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
+#include "paddle/fluid/operators/math/fc.h"
+#include "paddle/fluid/operators/math/test_helper.h"
+#include "paddle/fluid/platform/cpu_helper.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+static double Sigmoid(double x) { return 1 / (1 + std::exp(-x)); }
+
+// The weights of the layers and directions, in the order of PackedRNNFunctor.
+template <typename T>
+struct RNNWeights {
+  RNNWeights(const PackedRNNAttr& attr, int M, int D, std::mt19937* rng) {
+    const int G = attr.cell == PackedRNNCell::kGRU ? 3 : 4;
+    const int num_directions = attr.is_bidirec ? 2 : 1;
+    const int num = attr.num_layers * num_directions;
+    weight_x.resize(num);
+    weight_h.resize(num);
+    bias.resize(num);
+    for (int i = 0; i < num; ++i) {
+      int in = i < num_directions ? M : num_directions * D;
+      int bias_size = attr.use_peepholes ? 7 * D : G * D;
+      platform::CPUPlace place;
+      weight_x[i].mutable_data<T>(framework::make_ddim({in, G * D}), place);
+      weight_h[i].mutable_data<T>(framework::make_ddim({D, G * D}), place);
+      bias[i].mutable_data<T>(framework::make_ddim({1, bias_size}), place);
+      RandomFill<T>(&weight_x[i], rng, -0.5, 0.5);
+      RandomFill<T>(&weight_h[i], rng, -0.5, 0.5);
+      RandomFill<T>(&bias[i], rng, -0.5, 0.5);
+      packed.push_back(
+          PackedRNNWeight{&weight_x[i], &weight_h[i], &bias[i]});
+    }
+  }
+
+  std::vector<framework::Tensor> weight_x, weight_h, bias;
+  std::vector<PackedRNNWeight> packed;
+};
+
+// A direction of a layer, the sequences one by one and the steps one by one.
+template <typename T>
+static void ReferenceDirection(const PackedRNNAttr& attr,
+                               const framework::Vector<size_t>& lod,
+                               const std::vector<double>& input, int M,
+                               const PackedRNNWeight& w, bool is_reverse,
+                               const T* h0, const T* c0,
+                               std::vector<double>* hidden,
+                               std::vector<double>* cell, int ld, int col) {
+  const bool is_gru = attr.cell == PackedRNNCell::kGRU;
+  const int D = w.weight_h->dims()[0];
+  const int GD = (is_gru ? 3 : 4) * D;
+  const T* wx = w.weight_x->data<T>();
+  const T* wh = w.weight_h->data<T>();
+  const T* b = w.bias ? w.bias->data<T>() : nullptr;
+  for (size_t s = 0; s + 1 < lod.size(); ++s) {
+    std::vector<double> h(D, 0), c(D, 0);
+    if (h0) {
+      for (int j = 0; j < D; ++j) {
+        h[j] = h0[s * D + j];
+        c[j] = c0 ? c0[s * D + j] : 0;
+      }
+    }
+    int len = lod[s + 1] - lod[s];
+    for (int t = 0; t < len; ++t) {
+      size_t row = is_reverse ? lod[s + 1] - 1 - t : lod[s] + t;
+      std::vector<double> x(GD);
+      for (int j = 0; j < GD; ++j) {
+        x[j] = b ? b[j] : 0;
+        for (int k = 0; k < M; ++k) {
+          x[j] += input[row * M + k] * wx[k * GD + j];
+        }
+      }
+      std::vector<double> next_h(D), next_c(D);
+      if (is_gru) {
+        std::vector<double> u(D), r(D), rh(D);
+        for (int j = 0; j < D; ++j) {
+          double xu = x[j], xr = x[D + j];
+          for (int k = 0; k < D; ++k) {
+            xu += h[k] * wh[k * 2 * D + j];
+            xr += h[k] * wh[k * 2 * D + D + j];
+          }
+          u[j] = Sigmoid(xu);
+          r[j] = Sigmoid(xr);
+          rh[j] = r[j] * h[j];
+        }
+        for (int j = 0; j < D; ++j) {
+          double xc = x[2 * D + j];
+          for (int k = 0; k < D; ++k) {
+            xc += rh[k] * wh[2 * D * D + k * D + j];
+          }
+          double cand = std::tanh(xc);
+          next_h[j] = attr.origin_mode ? (1 - u[j]) * cand + u[j] * h[j]
+                                       : u[j] * cand + (1 - u[j]) * h[j];
+        }
+      } else {
+        const T* wp = attr.use_peepholes ? b + 4 * D : nullptr;
+        for (int j = 0; j < GD; ++j) {
+          for (int k = 0; k < D; ++k) {
+            x[j] += h[k] * wh[k * GD + j];
+          }
+        }
+        for (int j = 0; j < D; ++j) {
+          double i_gate = Sigmoid(x[D + j] + (wp ? wp[j] * c[j] : 0));
+          double f_gate = Sigmoid(x[2 * D + j] + (wp ? wp[D + j] * c[j] : 0));
+          next_c[j] = std::tanh(x[j]) * i_gate + c[j] * f_gate;
+          double o_gate =
+              Sigmoid(x[3 * D + j] + (wp ? wp[2 * D + j] * next_c[j] : 0));
+          next_h[j] = std::tanh(next_c[j]) * o_gate;
+        }
+      }
+      for (int j = 0; j < D; ++j) {
+        (*hidden)[row * ld + col + j] = next_h[j];
+        if (!is_gru) (*cell)[row * ld + col + j] = next_c[j];
+      }
+      h.swap(next_h);
+      c.swap(next_c);
+    }
+  }
+}
+
+template <typename T>
+static void TestPackedRNN(const PackedRNNAttr& attr,
+                          const std::vector<size_t>& lengths, int M, int D,
+                          bool with_h0) {
+  platform::CPUPlace place;
+  platform::CPUDeviceContext context;
+  std::mt19937 rng(M * 131 + D * 17 + lengths.size());
+  const bool is_gru = attr.cell == PackedRNNCell::kGRU;
+  const int num_directions = attr.is_bidirec ? 2 : 1;
+  const int N = lengths.size();
+
+  framework::LoD lod(1, framework::Vector<size_t>(1, 0));
+  for (size_t len : lengths) {
+    lod[0].push_back(lod[0].back() + len);
+  }
+  const int total_T = lod[0].back();
+  framework::LoDTensor input;
+  input.set_lod(lod);
+  input.mutable_data<T>(framework::make_ddim({total_T, M}), place);
+  RandomFill<T>(&input, &rng, -0.5, 0.5);
+  RNNWeights<T> weights(attr, M, D, &rng);
+  framework::Tensor h0, c0;
+  if (with_h0) {
+    auto dims =
+        framework::make_ddim({attr.num_layers * num_directions, N, D});
+    h0.mutable_data<T>(dims, place);
+    c0.mutable_data<T>(dims, place);
+    RandomFill<T>(&h0, &rng, -0.5, 0.5);
+    RandomFill<T>(&c0, &rng, -0.5, 0.5);
+  }
+
+  std::vector<double> expected_h, expected_c;
+  auto reference = [&] {
+    std::vector<double> layer_input(input.data<T>(),
+                                    input.data<T>() + input.numel());
+    int layer_M = M;
+    for (int l = 0; l < attr.num_layers; ++l) {
+      expected_h.assign(total_T * num_directions * D, 0);
+      expected_c.assign(total_T * num_directions * D, 0);
+      for (int d = 0; d < num_directions; ++d) {
+        int i = l * num_directions + d;
+        bool is_reverse = attr.is_bidirec ? d == 1 : attr.is_reverse;
+        ReferenceDirection<T>(
+            attr, lod[0], layer_input, layer_M, weights.packed[i], is_reverse,
+            with_h0 ? h0.data<T>() + i * N * D : nullptr,
+            with_h0 && !is_gru ? c0.data<T>() + i * N * D : nullptr,
+            &expected_h, &expected_c, num_directions * D, d * D);
+      }
+      layer_input = expected_h;
+      layer_M = num_directions * D;
+    }
+  };
+
+  framework::Tensor hidden, cell;
+  PackedRNNFunctor<T> rnn;
+  PackedRNNWeightCache packed_weights;
+  auto check = [&] {
+    rnn(context, attr, input, weights.packed, &packed_weights,
+        with_h0 ? &h0 : nullptr, with_h0 && !is_gru ? &c0 : nullptr, &hidden,
+        is_gru ? nullptr : &cell);
+    ASSERT_EQ(hidden.dims(),
+              framework::make_ddim({total_T, num_directions * D}));
+    for (int64_t i = 0; i < hidden.numel(); ++i) {
+      ASSERT_NEAR(expected_h[i], hidden.data<T>()[i], 1e-4)
+          << "at " << i << " of " << attr.num_layers << " layers, "
+          << num_directions << " directions";
+      if (!is_gru) {
+        ASSERT_NEAR(expected_c[i], cell.data<T>()[i], 1e-4) << "at " << i;
+      }
+    }
+  };
+  reference();
+  // twice, on the packed weights and the buffers of the first time
+  check();
+  check();
+  // The WeightH set in place, as a predictor loading new parameters into
+  // its scope, are packed again.
+  for (framework::Tensor& weight_h : weights.weight_h) {
+    const T* data = weight_h.data<T>();
+    RandomFill<T>(&weight_h, &rng, -0.5, 0.5);
+    ASSERT_EQ(data, weight_h.data<T>());
+  }
+  reference();
+  check();
+}
+
+TEST(PackedRNN, WeightCache) {
+  platform::CPUDeviceContext context;
+  std::mt19937 rng(7);
+  const int D = 6;
+  framework::Tensor weight;
+  weight.mutable_data<float>(framework::make_ddim({D, 3 * D}),
+                             platform::CPUPlace());
+  RandomFill<float>(&weight, &rng, -0.5, 0.5);
+  PackedRNNWeightCache cache;
+  auto first = cache.Get<float>(context, 0, weight, 0, D, 2 * D);
+  auto second = cache.Get<float>(context, 1, weight, 2 * D * D, D, D);
+  EXPECT_NE(first, second);
+#ifdef PADDLE_WITH_MKLML
+  // packed once while the weight is not changed
+  EXPECT_EQ(first, cache.Get<float>(context, 0, weight, 0, D, 2 * D));
+  EXPECT_EQ(second, cache.Get<float>(context, 1, weight, 2 * D * D, D, D));
+  // the slot of the changed part only
+  weight.data<float>()[2 * D * D] += 1.f;
+  EXPECT_EQ(first, cache.Get<float>(context, 0, weight, 0, D, 2 * D));
+  EXPECT_NE(second, cache.Get<float>(context, 1, weight, 2 * D * D, D, D));
+#endif
+  // the copy of an op does not share the packed weights
+  PackedRNNWeightCache copy(cache);
+  EXPECT_NE(first, copy.Get<float>(context, 0, weight, 0, D, 2 * D));
+  EXPECT_THROW(cache.Get<float>(context, 2, weight, 2 * D * D, D, 2 * D),
+               platform::EnforceNotMet);
+}
+
+TEST(PackedRNN, GRU) {
+  PackedRNNAttr attr;
+  std::vector<size_t> lengths = {3, 7, 0, 1, 7, 4};
+  for (bool is_reverse : {false, true}) {
+    for (bool origin_mode : {false, true}) {
+      for (bool with_h0 : {false, true}) {
+        attr.is_reverse = is_reverse;
+        attr.origin_mode = origin_mode;
+        TestPackedRNN<float>(attr, lengths, 5, 8, with_h0);
+        TestPackedRNN<double>(attr, lengths, 5, 8, with_h0);
+      }
+    }
+  }
+  TestPackedRNN<float>(attr, {1}, 3, 4, false);
+}
+
+TEST(PackedRNN, LSTM) {
+  PackedRNNAttr attr;
+  attr.cell = PackedRNNCell::kLSTM;
+  std::vector<size_t> lengths = {2, 6, 5, 0, 9};
+  for (bool is_reverse : {false, true}) {
+    for (bool use_peepholes : {false, true}) {
+      for (bool with_h0 : {false, true}) {
+        attr.is_reverse = is_reverse;
+        attr.use_peepholes = use_peepholes;
+        TestPackedRNN<float>(attr, lengths, 6, 7, with_h0);
+        TestPackedRNN<double>(attr, lengths, 6, 7, with_h0);
+      }
+    }
+  }
+}
+
+TEST(PackedRNN, MultiLayerBidirectional) {
+  platform::SetNumThreads(2);
+  std::vector<size_t> lengths = {5, 1, 8, 3, 8, 2, 6};
+  for (auto cell : {PackedRNNCell::kGRU, PackedRNNCell::kLSTM}) {
+    PackedRNNAttr attr;
+    attr.cell = cell;
+    attr.num_layers = 3;
+    attr.is_bidirec = true;
+    TestPackedRNN<float>(attr, lengths, 10, 6, false);
+    TestPackedRNN<float>(attr, lengths, 10, 6, true);
+    TestPackedRNN<double>(attr, lengths, 4, 5, true);
+  }
+}
+
+// The GRU of fusion_gru before, the sequences one by one with the GEMVs of
+// the steps on the WeightH as it is, the directions one after the other.
+static void SequenceBySequenceGRU(const platform::CPUDeviceContext& context,
+                                  const framework::LoDTensor& input,
+                                  const PackedRNNWeight& w, bool is_reverse,
+                                  float* xx, float* hidden, int ld, int col) {
+  auto blas = GetBlas<platform::CPUDeviceContext, float>(context);
+  const auto& lod = input.lod()[0];
+  const int total_T = input.dims()[0];
+  const int M = input.dims()[1];
+  const int D = w.weight_h->dims()[0];
+  const int D2 = 2 * D, D3 = 3 * D;
+  const float* wh = w.weight_h->data<float>();
+  const jit::gru_attr_t attr(D, jit::kVSigmoid, jit::kVTanh);
+  auto h1 = jit::KernelFuncs<jit::GRUH1Tuple<float>,
+                             platform::CPUPlace>::Cache().At(attr);
+  auto part1 = jit::KernelFuncs<jit::GRUHtPart1Tuple<float>,
+                                platform::CPUPlace>::Cache().At(attr);
+  auto part2 = jit::KernelFuncs<jit::GRUHtPart2Tuple<float>,
+                                platform::CPUPlace>::Cache().At(attr);
+  FCFunctor<platform::CPUDeviceContext, float>()(
+      context, total_T, D3, M, input.data<float>(),
+      w.weight_x->data<float>(), xx, w.bias->data<float>());
+  std::vector<float> prev(D), cur(D);
+  jit::gru_t step;
+  for (size_t s = 0; s + 1 < lod.size(); ++s) {
+    int len = lod[s + 1] - lod[s];
+    for (int t = 0; t < len; ++t) {
+      size_t row = is_reverse ? lod[s + 1] - 1 - t : lod[s] + t;
+      step.gates = xx + row * D3;
+      step.ht_1 = prev.data();
+      step.ht = cur.data();
+      if (t == 0) {
+        h1(&step, &attr);
+      } else {
+        blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D2, D, 1.f, prev.data(), D,
+                  wh, D2, 1.f, xx + row * D3, D3);
+        part1(&step, &attr);
+        blas.GEMM(CblasNoTrans, CblasNoTrans, 1, D, D, 1.f, cur.data(), D,
+                  wh + D * D2, D, 1.f, xx + row * D3 + D2, D3);
+        part2(&step, &attr);
+      }
+      std::memcpy(hidden + row * ld + col, cur.data(), sizeof(float) * D);
+      prev.swap(cur);
+    }
+  }
+}
+
+// The bidirectional GRU of the batches of variable-length sentences, as
+// those of the NLP predictors. It is skipped unless
+// --gtest_also_run_disabled_tests is given.
+TEST(PackedRNN, DISABLED_Benchmark) {
+  platform::SetNumThreads(1);
+  platform::CPUPlace place;
+  platform::CPUDeviceContext context;
+  std::mt19937 rng(2021);
+  const int M = 128, D = 128;
+  const int repeat = 10;
+
+  PackedRNNAttr attr;
+  attr.is_bidirec = true;
+  RNNWeights<float> weights(attr, M, D, &rng);
+  PackedRNNFunctor<float> rnn;
+  PackedRNNWeightCache packed_weights;
+  for (int batch_size : {1, 16, 64}) {
+    std::uniform_int_distribution<size_t> length(5, 60);
+    framework::LoD lod(1, framework::Vector<size_t>(1, 0));
+    for (int i = 0; i < batch_size; ++i) {
+      lod[0].push_back(lod[0].back() + length(rng));
+    }
+    const int total_T = lod[0].back();
+    framework::LoDTensor input;
+    input.set_lod(lod);
+    input.mutable_data<float>(framework::make_ddim({total_T, M}), place);
+    RandomFill<float>(&input, &rng, -0.5, 0.5);
+    framework::Tensor hidden, xx;
+    hidden.mutable_data<float>(framework::make_ddim({total_T, 2 * D}), place);
+    xx.mutable_data<float>(framework::make_ddim({total_T, 3 * D}), place);
+
+    auto one_by_one = [&] {
+      for (int d = 0; d < 2; ++d) {
+        SequenceBySequenceGRU(context, input, weights.packed[d], d == 1,
+                              xx.data<float>(), hidden.data<float>(), 2 * D,
+                              d * D);
+      }
+    };
+    auto engine = [&] {
+      rnn(context, attr, input, weights.packed, &packed_weights, nullptr,
+          nullptr, &hidden, nullptr);
+    };
+    CompareSpeed(string::Sprintf("bidirectional GRU of %d sequences, %d "
+                                 "steps, M %d, D %d",
+                                 batch_size, total_T, M, D),
+                 "sequence by sequence", one_by_one, "PackedRNNFunctor",
+                 engine, repeat);
+  }
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
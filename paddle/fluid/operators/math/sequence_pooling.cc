@@ -12,7 +12,12 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
@@ -453,10 +458,273 @@ class SequencePoolGradFunctor<platform::CPUDeviceContext, T> {
   }
 };
 
+enum class MultiSlotPoolType { kSum, kAvg, kSqrt, kMax, kLast, kFirst };
+
+static MultiSlotPoolType ToMultiSlotPoolType(const std::string& pooltype) {
+  if (pooltype == "SUM") return MultiSlotPoolType::kSum;
+  if (pooltype == "AVERAGE") return MultiSlotPoolType::kAvg;
+  if (pooltype == "SQRT") return MultiSlotPoolType::kSqrt;
+  if (pooltype == "MAX") return MultiSlotPoolType::kMax;
+  if (pooltype == "LAST") return MultiSlotPoolType::kLast;
+  if (pooltype == "FIRST") return MultiSlotPoolType::kFirst;
+  PADDLE_THROW(platform::errors::InvalidArgument(
+      "unsupported pooling pooltype: %s. Only support \"SUM\", \"AVERAGE\", "
+      "\"SQRT\", \"MAX\", \"LAST\" and \"FIRST\"",
+      pooltype));
+}
+
+// About the number of the input elements pooled by a task, so that the tasks
+// of the short sequences do not cost more to schedule than to run.
+constexpr int64_t kMultiSlotTaskSize = 4096;
+
+// Runs fn(begin, end) on the blocks of the rows [0, rows) in parallel. fn
+// must not throw.
+static void ParallelForRows(int64_t rows, int64_t rows_per_task,
+                            const std::function<void(int64_t, int64_t)>& fn) {
+  int num_tasks = static_cast<int>((rows + rows_per_task - 1) / rows_per_task);
+  auto task = [&](int t) {
+    int64_t begin = t * rows_per_task;
+    fn(begin, std::min(rows, begin + rows_per_task));
+  };
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+  for (int t = 0; t < num_tasks; ++t) {
+    task(t);
+  }
+#else
+#ifdef PADDLE_USE_OPENBLAS
+  int num_threads = openblas_get_num_threads();
+#else
+  int num_threads = 1;
+#endif
+  RunBatchInParallel(num_tasks, num_threads, task);
+#endif
+}
+
+// Checks that all the slots are of the same width and number of sequences,
+// and returns the number of sequences.
+static int64_t CheckMultiSlotInputs(
+    const std::vector<const framework::LoDTensor*>& ins, int64_t* w) {
+  PADDLE_ENFORCE_GT(ins.size(), 0UL,
+                    platform::errors::InvalidArgument(
+                        "The inputs of multi-slot sequence pool should not "
+                        "be empty."));
+  PADDLE_ENFORCE_GT(ins[0]->lod().size(), 0UL,
+                    platform::errors::InvalidArgument(
+                        "The input of multi-slot sequence pool must have "
+                        "LoD."));
+  *w = ins[0]->numel() / ins[0]->dims()[0];
+  int64_t bs = static_cast<int64_t>(ins[0]->lod().back().size()) - 1;
+  for (size_t i = 0; i < ins.size(); ++i) {
+    PADDLE_ENFORCE_EQ(ins[i]->numel() / ins[i]->dims()[0], *w,
+                      platform::errors::InvalidArgument(
+                          "Width of all inputs should be equal, but the "
+                          "width of input %d is %d, not %d.",
+                          i, ins[i]->numel() / ins[i]->dims()[0], *w));
+    PADDLE_ENFORCE_GT(ins[i]->lod().size(), 0UL,
+                      platform::errors::InvalidArgument(
+                          "Input %d of multi-slot sequence pool must have "
+                          "LoD.",
+                          i));
+    PADDLE_ENFORCE_EQ(
+        static_cast<int64_t>(ins[i]->lod().back().size()) - 1, bs,
+        platform::errors::InvalidArgument(
+            "Batchsize of all inputs should be equal, but the batch size of "
+            "input %d is %d, not %d.",
+            i, ins[i]->lod().back().size() - 1, bs));
+  }
+  return bs;
+}
+
+static int64_t MultiSlotRowsPerTask(
+    const std::vector<const framework::LoDTensor*>& ins, int64_t w,
+    int64_t bs) {
+  int64_t size = 0;
+  for (auto* in : ins) {
+    size += in->numel();
+  }
+  int64_t per_row = std::max<int64_t>(size / std::max<int64_t>(bs, 1), w);
+  return std::max<int64_t>(kMultiSlotTaskSize / per_row, 1);
+}
+
+template <typename T>
+void MultiSlotSeqPoolFunctor<T>::operator()(
+    const platform::CPUDeviceContext& context, const std::string& pooltype,
+    T pad_value, const std::vector<const framework::LoDTensor*>& ins,
+    bool use_cvm, framework::Tensor* output) {
+  MultiSlotPoolType type = ToMultiSlotPoolType(pooltype);
+  int64_t w = 0;
+  int64_t bs = CheckMultiSlotInputs(ins, &w);
+  if (use_cvm) {
+    PADDLE_ENFORCE_GE(w, 2, platform::errors::InvalidArgument(
+                                "The width of the inputs should be at least 2 "
+                                "with cvm, but received %d.",
+                                w));
+  }
+  int64_t n = static_cast<int64_t>(ins.size());
+  output->Resize(framework::make_ddim({bs, n * w}));
+  T* out_data = output->mutable_data<T>(context.GetPlace());
+
+  jit::seq_pool_attr_t pool_attr(static_cast<int>(w), jit::SeqPoolType::kSum);
+  if (type == MultiSlotPoolType::kAvg) {
+    pool_attr.type = jit::SeqPoolType::kAvg;
+  } else if (type == MultiSlotPoolType::kSqrt) {
+    pool_attr.type = jit::SeqPoolType::kSqrt;
+  }
+  auto seqpool =
+      jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
+          pool_attr);
+
+  int64_t rows_per_task = MultiSlotRowsPerTask(ins, w, bs);
+  ParallelForRows(bs, rows_per_task, [&](int64_t begin, int64_t end) {
+    jit::seq_pool_attr_t attr = pool_attr;
+    for (int64_t j = begin; j < end; ++j) {
+      T* dst = out_data + j * n * w;
+      for (int64_t i = 0; i < n; ++i, dst += w) {
+        const auto& lod = ins[i]->lod().back();
+        int64_t h = static_cast<int64_t>(lod[j + 1] - lod[j]);
+        const T* src = ins[i]->data<T>() + lod[j] * w;
+        if (h == 0) {
+          std::fill(dst, dst + w, pad_value);
+        } else {
+          switch (type) {
+            case MultiSlotPoolType::kMax:
+              std::memcpy(dst, src, w * sizeof(T));
+              for (int64_t r = 1; r < h; ++r) {
+                const T* row = src + r * w;
+                for (int64_t k = 0; k < w; ++k) {
+                  dst[k] = row[k] > dst[k] ? row[k] : dst[k];
+                }
+              }
+              break;
+            case MultiSlotPoolType::kLast:
+              std::memcpy(dst, src + (h - 1) * w, w * sizeof(T));
+              break;
+            case MultiSlotPoolType::kFirst:
+              std::memcpy(dst, src, w * sizeof(T));
+              break;
+            default:
+              attr.h = static_cast<int>(h);
+              seqpool(src, dst, &attr);
+          }
+        }
+        if (use_cvm) {
+          dst[0] = std::log(dst[0] + 1);
+          dst[1] = std::log(dst[1] + 1) - dst[0];
+        }
+      }
+    }
+  });
+}
+
+template <typename T>
+void MultiSlotSeqPoolGradFunctor<T>::operator()(
+    const platform::CPUDeviceContext& context, const std::string& pooltype,
+    const std::vector<const framework::LoDTensor*>& ins,
+    const framework::Tensor& out_grad, const framework::Tensor* cvm,
+    bool use_cvm, const std::vector<framework::LoDTensor*>& in_grads) {
+  MultiSlotPoolType type = ToMultiSlotPoolType(pooltype);
+  int64_t w = 0;
+  int64_t bs = CheckMultiSlotInputs(ins, &w);
+  int64_t n = static_cast<int64_t>(ins.size());
+  PADDLE_ENFORCE_EQ(in_grads.size(), ins.size(),
+                    platform::errors::InvalidArgument(
+                        "The number of the gradients %d should be the "
+                        "number of the inputs %d.",
+                        in_grads.size(), ins.size()));
+  PADDLE_ENFORCE_EQ(out_grad.numel(), bs * n * w,
+                    platform::errors::InvalidArgument(
+                        "The size of the output gradient should be %d, but "
+                        "received %d.",
+                        bs * n * w, out_grad.numel()));
+  const T* cvm_data = nullptr;
+  if (use_cvm) {
+    PADDLE_ENFORCE_NOT_NULL(
+        cvm, platform::errors::InvalidArgument(
+                 "The CVM of multi-slot sequence pool with cvm should not be "
+                 "null."));
+    PADDLE_ENFORCE_EQ(cvm->numel(), bs * 2,
+                      platform::errors::InvalidArgument(
+                          "The CVM should be of shape [%d, 2], but received "
+                          "[%s].",
+                          bs, cvm->dims()));
+    cvm_data = cvm->data<T>();
+  }
+  std::vector<T*> dx_data(n, nullptr);
+  for (int64_t i = 0; i < n; ++i) {
+    if (in_grads[i] == nullptr) continue;
+    in_grads[i]->Resize(ins[i]->dims());
+    in_grads[i]->set_lod(ins[i]->lod());
+    dx_data[i] = in_grads[i]->mutable_data<T>(context.GetPlace());
+  }
+  const T* dy_data = out_grad.data<T>();
+
+  int64_t rows_per_task = MultiSlotRowsPerTask(ins, w, bs);
+  ParallelForRows(bs, rows_per_task, [&](int64_t begin, int64_t end) {
+    std::vector<T> grad(w);
+    for (int64_t j = begin; j < end; ++j) {
+      for (int64_t i = 0; i < n; ++i) {
+        if (dx_data[i] == nullptr) continue;
+        const auto& lod = ins[i]->lod().back();
+        int64_t h = static_cast<int64_t>(lod[j + 1] - lod[j]);
+        if (h == 0) continue;
+        T* dx = dx_data[i] + lod[j] * w;
+        const T* dy = dy_data + (j * n + i) * w;
+        std::memcpy(grad.data(), dy, w * sizeof(T));
+        if (use_cvm) {
+          grad[0] = cvm_data[j * 2];
+          grad[1] = cvm_data[j * 2 + 1];
+        }
+        T scale = 1;
+        switch (type) {
+          case MultiSlotPoolType::kMax: {
+            std::fill(dx, dx + h * w, static_cast<T>(0));
+            const T* x = ins[i]->data<T>() + lod[j] * w;
+            for (int64_t k = 0; k < w; ++k) {
+              // the first of the max, like the forward of sequence_pool
+              int64_t max_row = 0;
+              for (int64_t r = 1; r < h; ++r) {
+                if (x[r * w + k] > x[max_row * w + k]) max_row = r;
+              }
+              dx[max_row * w + k] = grad[k];
+            }
+            continue;
+          }
+          case MultiSlotPoolType::kLast:
+          case MultiSlotPoolType::kFirst: {
+            std::fill(dx, dx + h * w, static_cast<T>(0));
+            int64_t row = type == MultiSlotPoolType::kLast ? h - 1 : 0;
+            std::memcpy(dx + row * w, grad.data(), w * sizeof(T));
+            continue;
+          }
+          case MultiSlotPoolType::kAvg:
+            scale = static_cast<T>(1) / static_cast<T>(h);
+            break;
+          case MultiSlotPoolType::kSqrt:
+            scale = static_cast<T>(1) / std::sqrt(static_cast<T>(h));
+            break;
+          default:
+            break;
+        }
+        for (int64_t k = 0; k < w; ++k) {
+          dx[k] = grad[k] * scale;
+        }
+        for (int64_t r = 1; r < h; ++r) {
+          std::memcpy(dx + r * w, dx, w * sizeof(T));
+        }
+      }
+    }
+  });
+}
+
 template class SequencePoolFunctor<platform::CPUDeviceContext, float>;
 template class SequencePoolFunctor<platform::CPUDeviceContext, double>;
 template class SequencePoolGradFunctor<platform::CPUDeviceContext, float>;
 template class SequencePoolGradFunctor<platform::CPUDeviceContext, double>;
+template class MultiSlotSeqPoolFunctor<float>;
+template class MultiSlotSeqPoolFunctor<double>;
+template class MultiSlotSeqPoolGradFunctor<float>;
+template class MultiSlotSeqPoolGradFunctor<double>;
 
 }  // namespace math
 }  // namespace operators
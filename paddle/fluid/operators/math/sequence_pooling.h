@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 #include <string>
+#include <vector>
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/platform/device_context.h"
@@ -42,6 +43,43 @@ class SequencePoolGradFunctor {
                   const framework::Tensor* index = nullptr);
 };
 
+/*
+ * \brief Pools the sequences of many slots and concats them by columns, as
+ * fusion_seqpool_concat and fusion_seqpool_cvm_concat do.
+ *
+ * All the inputs have the same width w and the same number of sequences bs
+ * in the last level of their LoD. The output is [bs, n * w], whose row j is
+ * the pooled sequences j of the n slots. The sequences of all the slots are
+ * pooled in parallel. The pooltype is one of SUM, AVERAGE, SQRT, MAX, LAST
+ * and FIRST, and the empty sequences are pad_value. When use_cvm, the first
+ * two columns of every slot, show and click, become log(show + 1) and
+ * log(click + 1) - log(show + 1), like the cvm op.
+ */
+template <typename T>
+class MultiSlotSeqPoolFunctor {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const std::string& pooltype, T pad_value,
+                  const std::vector<const framework::LoDTensor*>& ins,
+                  bool use_cvm, framework::Tensor* output);
+};
+
+/*
+ * The gradients of MultiSlotSeqPoolFunctor. The max of MAX is found again
+ * in the inputs. When use_cvm, the gradients of show and click are cvm of
+ * [bs, 2], like the cvm op. The in_grads which are nullptr are skipped.
+ */
+template <typename T>
+class MultiSlotSeqPoolGradFunctor {
+ public:
+  void operator()(const platform::CPUDeviceContext& context,
+                  const std::string& pooltype,
+                  const std::vector<const framework::LoDTensor*>& ins,
+                  const framework::Tensor& out_grad,
+                  const framework::Tensor* cvm, bool use_cvm,
+                  const std::vector<framework::LoDTensor*>& in_grads);
+};
+
 }  // namespace math
 }  // namespace operators
 }  // namespace paddle
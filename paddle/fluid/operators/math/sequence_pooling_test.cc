@@ -14,6 +14,9 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/math/sequence_pooling.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 template <typename DeviceContext, typename T>
 void TestSequencePoolingSum(const DeviceContext &context,
@@ -140,3 +143,61 @@ TEST(SequencePoolingGrad, CUDA_SUM) {
                                                                      lod2, 128);
 }
 #endif
+
+// The multi-slot pooling against the pooling of the slots one by one.
+template <typename T>
+void TestMultiSlotSeqPool(const std::string &pooltype,
+                          const std::vector<paddle::framework::LoD> &lods,
+                          const int64_t width) {
+  auto place = paddle::platform::CPUPlace();
+  auto *context = static_cast<paddle::platform::CPUDeviceContext *>(
+      paddle::platform::DeviceContextPool::Instance().Get(place));
+  const size_t n = lods.size();
+  const int64_t bs = lods[0][0].size() - 1;
+
+  std::vector<paddle::framework::LoDTensor> ins(n);
+  std::vector<const paddle::framework::LoDTensor *> in_ptrs;
+  for (size_t i = 0; i < n; ++i) {
+    ins[i].set_lod(lods[i]);
+    auto dims = paddle::framework::make_ddim(
+        {std::max<int64_t>(lods[i][0].back(), 1), width});
+    T *data = ins[i].mutable_data<T>(dims, place);
+    for (int64_t k = 0; k < ins[i].numel(); ++k) {
+      data[k] = static_cast<T>((k * 37 + i * 11) % 23) / 7;
+    }
+    in_ptrs.push_back(&ins[i]);
+  }
+
+  paddle::framework::Tensor out;
+  paddle::operators::math::MultiSlotSeqPoolFunctor<T>()(
+      *context, pooltype, static_cast<T>(0), in_ptrs, false, &out);
+  ASSERT_EQ(out.dims(), paddle::framework::make_ddim(
+                            {bs, static_cast<int64_t>(n) * width}));
+
+  for (size_t i = 0; i < n; ++i) {
+    paddle::framework::LoDTensor expected;
+    paddle::framework::Tensor index;
+    expected.mutable_data<T>(paddle::framework::make_ddim({bs, width}), place);
+    index.mutable_data<int>(paddle::framework::make_ddim({bs, width}), place);
+    paddle::operators::math::SequencePoolFunctor<
+        paddle::platform::CPUDeviceContext, T>()(
+        *context, pooltype, static_cast<T>(0), ins[i], &expected, false,
+        &index);
+    for (int64_t j = 0; j < bs; ++j) {
+      for (int64_t k = 0; k < width; ++k) {
+        EXPECT_NEAR(out.data<T>()[(j * n + i) * width + k],
+                    expected.data<T>()[j * width + k], 1e-5)
+            << pooltype << " slot " << i << " sequence " << j;
+      }
+    }
+  }
+}
+
+TEST(MultiSlotSeqPool, CPU) {
+  std::vector<paddle::framework::LoD> lods = {
+      {{0, 2, 7, 7, 10}}, {{0, 1, 1, 4, 9}}, {{0, 3, 4, 8, 9}}};
+  for (auto pooltype : {"SUM", "AVERAGE", "SQRT", "MAX", "LAST", "FIRST"}) {
+    TestMultiSlotSeqPool<float>(pooltype, lods, 16);
+    TestMultiSlotSeqPool<double>(pooltype, lods, 3);
+  }
+}
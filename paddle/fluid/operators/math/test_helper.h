@@ -0,0 +1,84 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+// The helpers shared by the tests of the math functors.
+
+#include <chrono>  // NOLINT
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/tensor.h"
+
+namespace paddle {
+namespace operators {
+namespace math {
+
+// Fills the n values of data with the uniform random numbers of [min, max).
+template <typename T>
+void RandomFill(T* data, int64_t n, std::mt19937* rng, double min,
+                double max) {
+  std::uniform_real_distribution<T> dist(min, max);
+  for (int64_t i = 0; i < n; ++i) {
+    data[i] = dist(*rng);
+  }
+}
+
+template <typename T>
+void RandomFill(std::vector<T>* data, std::mt19937* rng, double min = -1,
+                double max = 1) {
+  RandomFill<T>(data->data(), data->size(), rng, min, max);
+}
+
+template <typename T>
+void RandomFill(framework::Tensor* tensor, std::mt19937* rng,
+                double min = -1, double max = 1) {
+  RandomFill<T>(tensor->data<T>(), tensor->numel(), rng, min, max);
+}
+
+// Runs fn once to warm up, and returns the average milliseconds of the next
+// repeat runs.
+inline double AverageMilliseconds(const std::function<void()>& fn,
+                                  int repeat) {
+  fn();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeat; ++i) {
+    fn();
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() /
+         repeat;
+}
+
+// Times baseline and target, and logs their milliseconds and the speedup of
+// target under title.
+inline void CompareSpeed(const std::string& title,
+                         const std::string& baseline_name,
+                         const std::function<void()>& baseline,
+                         const std::string& target_name,
+                         const std::function<void()>& target, int repeat) {
+  double baseline_ms = AverageMilliseconds(baseline, repeat);
+  double target_ms = AverageMilliseconds(target, repeat);
+  LOG(INFO) << title << ": " << baseline_name << " " << baseline_ms << " ms, "
+            << target_name << " " << target_ms << " ms, speedup "
+            << baseline_ms / target_ms << "x";
+}
+
+}  // namespace math
+}  // namespace operators
+}  // namespace paddle
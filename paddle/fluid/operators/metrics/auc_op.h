@@ -16,6 +16,7 @@ limitations under the License. */
 
 #include <string>
 #include <vector>
+#include "paddle/fluid/framework/fleet/metrics.h"
 #include "paddle/fluid/framework/op_registry.h"
 
 namespace paddle {
@@ -60,8 +61,21 @@ class AucKernel : public framework::OpKernel<T> {
               (slide_steps > 0 ? 1 : 0)) *
                  sizeof(int64_t));
     }
-    statAuc(label, predict, num_thresholds, slide_steps, origin_stat_pos,
-            origin_stat_neg);
+    if (slide_steps == 0) {
+      // The threads running the op on the same persistable stats, e.g. those
+      // of Hogwild, add the batches to histograms of their own, and only
+      // lock to move their counts into the stats.
+      auto *accumulator = framework::AucAccumulator::ForOp(
+          ctx.OutputName("StatPosOut"), num_thresholds);
+      const size_t inference_width = predict->dims()[1];
+      accumulator->Add(predict->data<T>() + (inference_width - 1),
+                       inference_width, label->data<int64_t>(),
+                       predict->dims()[0]);
+      accumulator->FlushLocal(origin_stat_pos, origin_stat_neg);
+    } else {
+      statAuc(label, predict, num_thresholds, slide_steps, origin_stat_pos,
+              origin_stat_neg);
+    }
 
     int sum_offset = slide_steps * (num_thresholds + 1);
     calcAuc(origin_stat_pos + sum_offset, origin_stat_neg + sum_offset,
@@ -88,28 +102,9 @@ class AucKernel : public framework::OpKernel<T> {
     const T *inference_data = predict->data<T>();
     const auto *label_data = label->data<int64_t>();
     const int bucket_length = num_thresholds + 1;
-    if (slide_steps == 0) {
-      for (size_t i = 0; i < batch_size; i++) {
-        // if predict_data[i] has dim of 2, then predict_data[i][1] is pos prob
-        // if predict_data[i] has dim of 1, then predict_data[i][0] is pos prob
-        auto predict_data =
-            inference_data[i * inference_width + (inference_width - 1)];
-        PADDLE_ENFORCE_LE(predict_data, 1,
-                          platform::errors::PreconditionNotMet(
-                              "The predict data must less or equal 1."));
-        PADDLE_ENFORCE_GE(predict_data, 0,
-                          platform::errors::PreconditionNotMet(
-                              "The predict data must gather or equal 0."));
-
-        uint32_t binIdx = static_cast<uint32_t>(predict_data * num_thresholds);
-        if (label_data[i] > 0) {
-          origin_stat_pos[binIdx] += 1;
-        } else if (label_data[i] == 0) {
-          origin_stat_neg[binIdx] += 1;
-        }
-      }
-      return;
-    }
+    // if predict_data[i] has dim of 2, then predict_data[i][1] is pos prob
+    // if predict_data[i] has dim of 1, then predict_data[i][0] is pos prob
+    const T *pos_prob_data = inference_data + (inference_width - 1);
     // the last number of origin_stat_pos store the index should be used in
     // current step
     int cur_step_index =
@@ -129,25 +124,10 @@ class AucKernel : public framework::OpKernel<T> {
     std::memset(origin_stat_neg + cur_step_begin, 0,
                 bucket_length * sizeof(int64_t));
 
-    for (size_t i = 0; i < batch_size; i++) {
-      // if predict_data[i] has dim of 2, then predict_data[i][1] is pos prob
-      // if predict_data[i] has dim of 1, then predict_data[i][0] is pos prob
-      auto predict_data =
-          inference_data[i * inference_width + (inference_width - 1)];
-      PADDLE_ENFORCE_LE(predict_data, 1,
-                        platform::errors::PreconditionNotMet(
-                            "The predict data must less or equal 1."));
-      PADDLE_ENFORCE_GE(predict_data, 0,
-                        platform::errors::PreconditionNotMet(
-                            "The predict data must gather or equal 0."));
-
-      uint32_t binIdx = static_cast<uint32_t>(predict_data * num_thresholds);
-      if (label_data[i] > 0) {
-        origin_stat_pos[cur_step_begin + binIdx] += 1;
-      } else if (label_data[i] == 0) {
-        origin_stat_neg[cur_step_begin + binIdx] += 1;
-      }
-    }
+    framework::AddAucInstances(pos_prob_data, inference_width, label_data,
+                               batch_size, num_thresholds,
+                               origin_stat_pos + cur_step_begin,
+                               origin_stat_neg + cur_step_begin);
     for (int i = 0; i < bucket_length; ++i) {
       origin_stat_pos[sum_step_begin + i] +=
           origin_stat_pos[cur_step_begin + i];
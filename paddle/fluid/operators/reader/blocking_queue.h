@@ -92,9 +92,13 @@ class BlockingQueue {
       PADDLE_ENFORCE_NOT_NULL(
           elem, platform::errors::InvalidArgument(
                     "The holder to receive queue data is null pointer."));
-      *elem = queue_.front();
       if (LIKELY(!speed_test_mode_)) {
+        // The element is leaving the queue, so hand its resources over to
+        // the receiver instead of copying them.
+        *elem = std::move(queue_.front());
         queue_.pop_front();
+      } else {
+        *elem = queue_.front();
       }
       send_cv_.notify_one();
       return true;
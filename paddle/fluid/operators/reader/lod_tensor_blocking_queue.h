@@ -49,6 +49,12 @@ class LoDTensorBlockingQueue {
     return lod_tensor_vec;
   }
 
+  // Receive the next batch into *lod_tensor_vec directly, so that the
+  // tensors pushed by the feeder are moved into the caller without copies.
+  bool Pop(std::vector<framework::LoDTensor>* lod_tensor_vec) {
+    return queue_.Receive(lod_tensor_vec);
+  }
+
   inline size_t Cap() const { return queue_.Cap(); }
 
   inline size_t Size() const { return queue_.Size(); }
@@ -123,6 +129,10 @@ class OrderedMultiDeviceLoDTensorBlockingQueue {
     return CurQueue()->Push(lod_tensor_vec);
   }
 
+  bool Push(std::vector<framework::LoDTensor>&& lod_tensor_vec) {
+    return CurQueue()->Push(std::move(lod_tensor_vec));
+  }
+
   inline size_t Size() const {
     size_t size = 0;
     for (auto& item : queues_) {
@@ -31,9 +31,7 @@ PyReader::PyReader(
 }
 
 void PyReader::ReadNext(std::vector<framework::LoDTensor>* out) {
-  bool success;
-  *out = queue_->Pop(&success);
-  if (!success) out->clear();
+  if (!queue_->Pop(out)) out->clear();
 }
 
 PyReader::~PyReader() { queue_->Close(); }
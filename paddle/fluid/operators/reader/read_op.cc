@@ -12,6 +12,8 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <utility>
+
 #include "paddle/fluid/framework/framework.pb.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/reader.h"
@@ -147,8 +149,10 @@ class ReadOp : public framework::OperatorBase {
                 "The data type of fed Variable %s must be %s, but received %s",
                 out_arg_names[i], var_types[i], ins[i].type()));
       }
+      // ins is dropped right after this loop, so the output variable can
+      // take over the allocation and the LoD of the fed tensor as they are.
       out->ShareDataWith(ins[i]);
-      out->set_lod(ins[i].lod());
+      *out->mutable_lod() = std::move(*ins[i].mutable_lod());
     }
   }
 };
@@ -12,7 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "paddle/fluid/operators/reader/blocking_queue.h"
@@ -238,3 +241,54 @@ TEST(BlockingQueue, speed_test_mode) {
   }
   EXPECT_EQ(q2.Size(), queue_size);
 }
+
+// A batch that owns a large payload and counts how many times it is copied,
+// standing in for a vector of LoDTensors pushed by the feeder.
+struct CountedBatch {
+  static std::atomic<size_t> copy_count;
+
+  CountedBatch() = default;
+  explicit CountedBatch(size_t bytes) : data_(bytes, 1) {}
+  CountedBatch(const CountedBatch& b) : data_(b.data_) { ++copy_count; }
+  CountedBatch(CountedBatch&& b) = default;
+  CountedBatch& operator=(const CountedBatch& b) {
+    data_ = b.data_;
+    ++copy_count;
+    return *this;
+  }
+  CountedBatch& operator=(CountedBatch&& b) = default;
+
+  std::vector<char> data_;
+};
+
+std::atomic<size_t> CountedBatch::copy_count{0};
+
+TEST(BlockingQueue, MoveThroughputTest) {
+  const size_t batch_num = 200;
+  for (size_t batch_bytes : {64UL << 10, 4UL << 20}) {
+    CountedBatch::copy_count = 0;
+    BlockingQueue<CountedBatch> q(4);
+    auto start = std::chrono::steady_clock::now();
+    std::thread sender([&]() {
+      for (size_t i = 0; i < batch_num; ++i) {
+        EXPECT_TRUE(q.Send(CountedBatch(batch_bytes)));
+      }
+      q.Close();
+    });
+    size_t received = 0;
+    CountedBatch batch;
+    while (q.Receive(&batch)) {
+      EXPECT_EQ(batch.data_.size(), batch_bytes);
+      ++received;
+    }
+    sender.join();
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    EXPECT_EQ(received, batch_num);
+    EXPECT_EQ(CountedBatch::copy_count.load(), 0UL);
+    LOG(INFO) << "Transferred " << batch_num << " batches of " << batch_bytes
+              << " bytes in " << seconds << " s, "
+              << batch_num * batch_bytes / seconds / (1 << 20) << " MB/s";
+  }
+}
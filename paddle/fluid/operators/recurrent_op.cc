@@ -14,6 +14,8 @@ limitations under the License. */
 
 #include "paddle/fluid/operators/recurrent_op.h"
 
+#include <algorithm>
+
 namespace paddle {
 namespace framework {
 class InferShapeContext;
@@ -73,6 +75,15 @@ StepScopes::StepScopes(const platform::DeviceContext &dev_ctx,
                     platform::errors::PreconditionNotMet(
                         "Cannot backward when is not training"));
   if (!is_backward_) {
+    // In inference the two step scopes are used by turns across the steps
+    // with their variables kept, so those of the last run are reused too.
+    if (!is_train && scopes->size() == num_step_scopes &&
+        std::all_of(scopes->begin(), scopes->end(),
+                    [&parent](const framework::Scope *s) {
+                      return parent.HasKid(s);
+                    })) {
+      return;
+    }
     ClearStepScopes(dev_ctx, const_cast<framework::Scope *>(&parent), scopes);
     scopes->reserve(static_cast<size_t>(num_step_scopes));
     for (size_t i = 0; i < num_step_scopes; ++i) {
@@ -210,7 +221,7 @@ void RecurrentOp::RunImpl(const framework::Scope &scope,
   auto *block = Attr<framework::BlockDesc *>(kStepBlock);
 
   auto *program = block->Program();
-  auto ctx = executor.Prepare(
+  auto ctx = prepared_block_.Get(
       *program, block->ID(), Attr<std::vector<std::string>>(
                                  kSkipEagerDeletionVars) /*skip_ref_cnt_vars*/);
 
@@ -321,7 +332,7 @@ void RecurrentGradOp::RunImpl(const framework::Scope &scope,
   framework::Executor executor(place);
   auto *block = Attr<framework::BlockDesc *>(kStepBlock);
   auto *program = block->Program();
-  auto ctx = executor.Prepare(
+  auto ctx = prepared_block_.Get(
       *program, block->ID(), Attr<std::vector<std::string>>(
                                  kSkipEagerDeletionVars) /*skip_ref_cnt_vars*/);
 
@@ -218,6 +218,8 @@ class RecurrentOp : public RecurrentBase {
   StepScopes CreateStepScopes(const platform::DeviceContext &dev_ctx,
                               const framework::Scope &scope,
                               size_t seq_len) const;
+
+  mutable framework::PreparedBlockCache prepared_block_;
 };
 
 class RecurrentGradOp : public RecurrentBase {
@@ -243,6 +245,8 @@ class RecurrentGradOp : public RecurrentBase {
 
   static std::vector<std::string> GradVarLists(
       const std::vector<std::string> &var_names);
+
+  mutable framework::PreparedBlockCache prepared_block_;
 };
 
 }  // namespace operators
@@ -14,6 +14,21 @@ limitations under the License. */
 
 #include "paddle/fluid/platform/cpu_helper.h"
 
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+
 #ifdef PADDLE_WITH_MKLML
 #include <omp.h>
 
@@ -52,5 +67,101 @@ void SetNumThreads(int num_threads) {
 #endif
 }
 
+#if !defined(_WIN32) && !defined(__APPLE__)
+static std::string NumaNodePath(int node) {
+  return "/sys/devices/system/node/node" + std::to_string(node);
+}
+#endif
+
+int NumaNodeCount() {
+#if !defined(_WIN32) && !defined(__APPLE__)
+  static int count = [] {
+    int n = 0;
+    while (access(NumaNodePath(n).c_str(), F_OK) == 0) ++n;
+    return n > 0 ? n : 1;
+  }();
+  return count;
+#else
+  return 1;
+#endif
+}
+
+std::vector<int> NumaNodeCpus(int node) {
+  PADDLE_ENFORCE_LT(
+      node, NumaNodeCount(),
+      platform::errors::InvalidArgument(
+          "The NUMA node %d is out of range [0, %d).", node, NumaNodeCount()));
+  std::vector<int> cpus;
+#if !defined(_WIN32) && !defined(__APPLE__)
+  // The cpulist is in the format of "0-11,24-35".
+  std::ifstream fin(NumaNodePath(node) + "/cpulist");
+  std::string item;
+  while (fin.good() && std::getline(fin, item, ',')) {
+    int begin = 0;
+    char dash = 0;
+    std::istringstream range(item);
+    if (!(range >> begin)) continue;
+    int end = begin;
+    if (range >> dash && dash == '-' && !(range >> end)) end = begin;
+    for (int cpu = begin; cpu <= end; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    int num_cpus = static_cast<int>(std::thread::hardware_concurrency());
+    for (int cpu = 0; cpu < num_cpus; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+bool BindCurrentThread(const std::vector<int>& cpus, int numa_node) {
+#if !defined(_WIN32) && !defined(__APPLE__)
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &mask);
+  }
+  if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+    VLOG(1) << "WARNING: Failed to set thread affinity";
+    return false;
+  }
+#ifdef SYS_set_mempolicy
+  if (numa_node >= 0 && NumaNodeCount() > 1) {
+    // MPOL_PREFERRED in <numaif.h>, not to depend on libnuma.
+    const int kMpolPreferred = 1;
+    unsigned long nodemask = 1UL << numa_node;  // NOLINT
+    if (syscall(SYS_set_mempolicy, kMpolPreferred, &nodemask,
+                sizeof(nodemask) * 8) != 0) {
+      VLOG(1) << "WARNING: Failed to set the memory policy of NUMA node "
+              << numa_node;
+      return false;
+    }
+  }
+#endif
+  return true;
+#else
+  return false;
+#endif
+}
+
+void RunOnNumaNode(int node, const std::function<void()>& fn) {
+  std::exception_ptr exception;
+  std::thread thread([&] {
+    try {
+      BindCurrentThread(NumaNodeCpus(node), node);
+      fn();
+    } catch (...) {
+      exception = std::current_exception();
+    }
+  });
+  thread.join();
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
 }  // namespace platform
 }  // namespace paddle
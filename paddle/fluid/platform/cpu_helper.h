@@ -15,6 +15,8 @@ limitations under the License. */
 #pragma once
 
 #include <stddef.h>
+#include <functional>
+#include <vector>
 
 namespace paddle {
 namespace platform {
@@ -22,5 +24,19 @@ namespace platform {
 //! Set the number of threads in use.
 void SetNumThreads(int num_threads);
 
+//! Get the number of NUMA nodes, 1 if the NUMA topology is unknown.
+int NumaNodeCount();
+
+//! Get the cpus of a NUMA node.
+std::vector<int> NumaNodeCpus(int node);
+
+//! Bind the current thread to `cpus`. If numa_node >= 0, the memory first
+//! touched by the thread is preferred to be allocated on that node.
+bool BindCurrentThread(const std::vector<int>& cpus, int numa_node = -1);
+
+//! Run `fn` in a thread bound to the NUMA node and wait for it, so that the
+//! memory first touched by `fn` is allocated on the node.
+void RunOnNumaNode(int node, const std::function<void()>& fn);
+
 }  // namespace platform
 }  // namespace paddle
@@ -20,3 +20,11 @@ TEST(CpuHelper, SetNumThread) {
   paddle::platform::SetNumThreads(1);
   paddle::platform::SetNumThreads(4);
 }
+
+TEST(CpuHelper, NumaNode) {
+  int num_nodes = paddle::platform::NumaNodeCount();
+  ASSERT_GE(num_nodes, 1);
+  for (int node = 0; node < num_nodes; ++node) {
+    ASSERT_FALSE(paddle::platform::NumaNodeCpus(node).empty());
+  }
+}
@@ -12,8 +12,13 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <dlfcn.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
 #include <set>
 #include <utility>
 
@@ -22,6 +27,16 @@ limitations under the License. */
 
 DECLARE_string(cuda_dir);
 
+DEFINE_string(fusion_group_cpu_compiler, "c++",
+              "The host compiler used for JIT compiling of the CPU code "
+              "generated by fusion_group.");
+DEFINE_string(fusion_group_cpu_cache_dir, "",
+              "The directory to cache the shared libraries compiled from the "
+              "CPU code generated by fusion_group. It must be owned by the "
+              "current user and not accessible to others. If empty, "
+              "$XDG_CACHE_HOME/paddle/fusion_group or "
+              "$HOME/.cache/paddle/fusion_group is used.");
+
 namespace paddle {
 namespace platform {
 
@@ -65,13 +80,26 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
                     errors::InvalidArgument(
                         "Expected the number of places >= 1. But received %d.",
                         places.size()));
+  AddPlaces(places);
+
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+  CUDADeviceCode::CheckAvailableStatus();
+#endif
+}
+
+void DeviceCodePool::AddPlaces(const std::vector<platform::Place>& places) {
   // Remove the duplicated places
   std::set<Place> set;
   for (auto& p : places) {
     set.insert(p);
   }
   for (auto& p : set) {
-    if (is_gpu_place(p)) {
+    if (device_codes_.find(p) != device_codes_.end()) {
+      continue;
+    }
+    if (is_cpu_place(p)) {
+      device_codes_.emplace(p, DeviceCodeMap());
+    } else if (is_gpu_place(p)) {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
       device_codes_.emplace(p, DeviceCodeMap());
 #else
@@ -81,10 +109,228 @@ DeviceCodePool::DeviceCodePool(const std::vector<platform::Place>& places) {
 #endif
     }
   }
+}
 
-#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
-  CUDADeviceCode::CheckAvailableStatus();
-#endif
+CPUDeviceCode::CPUDeviceCode(const Place& place, const std::string& name,
+                             const std::string& kernel) {
+  if (!is_cpu_place(place)) {
+    PADDLE_THROW(platform::errors::PermissionDenied(
+        "CPUDeviceCode can only launch on CPU place."));
+  }
+
+  place_ = place;
+  name_ = name;
+  kernel_ = kernel;
+}
+
+CPUDeviceCode::~CPUDeviceCode() {
+  if (handle_) {
+    dlclose(handle_);
+  }
+}
+
+// Runs the command and returns its exit status, with its output in log.
+static int RunCommand(const std::string& cmd, std::string* log) {
+  FILE* pipe = popen(cmd.c_str(), "r");
+  if (pipe == nullptr) {
+    return -1;
+  }
+  char buffer[256];
+  while (fgets(buffer, sizeof(buffer), pipe) != nullptr) {
+    log->append(buffer);
+  }
+  return pclose(pipe);
+}
+
+// The macros predefined by the host compiler for -march=native, which tell
+// the instruction sets of the host. The cached libraries are built for them,
+// so they must not be loaded on a host of other instruction sets which shares
+// the cache directory.
+static const std::string& NativeTargetMacros() {
+  static std::string macros = [] {
+    std::string log;
+    if (RunCommand(FLAGS_fusion_group_cpu_compiler +
+                       " -march=native -dM -E -x c++ /dev/null 2>&1",
+                   &log) != 0) {
+      log.clear();
+    }
+    return log;
+  }();
+  return macros;
+}
+
+bool CPUDeviceCode::IsAvailable() {
+  static bool available = [] {
+    std::string cmd =
+        FLAGS_fusion_group_cpu_compiler + " --version > /dev/null 2>&1";
+    bool ret = std::system(cmd.c_str()) == 0;
+    if (!ret) {
+      LOG_FIRST_N(WARNING, 1) << "The host compiler "
+                              << FLAGS_fusion_group_cpu_compiler
+                              << " is needed for JIT compiling of CPU code.";
+    }
+    return ret;
+  }();
+  return available;
+}
+
+// Whether path is a directory of the current user, which is not accessible
+// to others, so that nobody else can plant libraries in it.
+static bool IsPrivateDirectory(const std::string& path) {
+  struct stat st;
+  return lstat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode) &&
+         st.st_uid == geteuid() && (st.st_mode & (S_IRWXG | S_IRWXO)) == 0;
+}
+
+// Whether path is a regular file of the current user, which is not writable
+// by others, so that it is safe to be loaded.
+static bool IsTrustedFile(const std::string& path) {
+  struct stat st;
+  return lstat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode) &&
+         st.st_uid == geteuid() && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+// Creates the missing directories of path, only accessible to the current
+// user.
+static bool MakePrivateDirectories(const std::string& path) {
+  for (size_t pos = path.find('/', 1);; pos = path.find('/', pos + 1)) {
+    std::string dir = path.substr(0, pos);
+    if (mkdir(dir.c_str(), S_IRWXU) != 0 && errno != EEXIST) {
+      return false;
+    }
+    if (pos == std::string::npos) {
+      return true;
+    }
+  }
+}
+
+// Returns the directory to cache the compiled libraries, or an empty string
+// if it cannot be created or is not private to the current user.
+static std::string CPUCacheDirectory() {
+  std::string dir = FLAGS_fusion_group_cpu_cache_dir;
+  if (dir.empty()) {
+    const char* xdg_cache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    if (xdg_cache != nullptr && xdg_cache[0] == '/') {
+      dir = std::string(xdg_cache) + "/paddle/fusion_group";
+    } else if (home != nullptr && home[0] == '/') {
+      dir = std::string(home) + "/.cache/paddle/fusion_group";
+    } else {
+      // Without a home, the libraries are cached in a directory private to
+      // this process.
+      static std::string tmp_dir = [] {
+        char tmpl[] = "/tmp/paddle_fusion_group_XXXXXX";
+        return mkdtemp(tmpl) == nullptr ? std::string() : std::string(tmpl);
+      }();
+      dir = tmp_dir;
+    }
+  }
+  if (dir.empty() || !MakePrivateDirectories(dir)) {
+    LOG(WARNING) << "Cannot create the cache directory " << dir
+                 << " for JIT compiling of CPU code.";
+    return "";
+  }
+  if (!IsPrivateDirectory(dir)) {
+    LOG(WARNING) << "The cache directory " << dir
+                 << " for JIT compiling of CPU code must be owned by the "
+                    "current user and not accessible to others.";
+    return "";
+  }
+  return dir;
+}
+
+bool CPUDeviceCode::Compile(bool include_path) {
+  is_compiled_ = false;
+  if (!IsAvailable()) {
+    return false;
+  }
+
+  std::string options = "-std=c++11 -O3 -march=native -fPIC -shared";
+  std::string cache_dir = CPUCacheDirectory();
+  if (cache_dir.empty()) {
+    return false;
+  }
+  size_t key = std::hash<std::string>()(FLAGS_fusion_group_cpu_compiler +
+                                        options + NativeTargetMacros() +
+                                        kernel_);
+  std::string prefix = cache_dir + "/" + name_ + "_" + std::to_string(key);
+  std::string lib_path = prefix + ".so";
+
+  struct stat st;
+  if (lstat(lib_path.c_str(), &st) != 0) {
+    // Compile to a temporary file and rename it, so that the processes
+    // compiling the same code do not see a partial library.
+    std::string src_path = prefix + ".XXXXXX.cc";
+    int src_fd = mkstemps(&src_path[0], 3);
+    if (src_fd < 0) {
+      LOG(WARNING) << "Cannot create the source file " << src_path
+                   << " for JIT compiling of CPU code.";
+      return false;
+    }
+    bool written = write(src_fd, kernel_.data(), kernel_.size()) ==
+                   static_cast<ssize_t>(kernel_.size());
+    close(src_fd);
+    std::string tmp_lib_path = lib_path + ".XXXXXX";
+    int lib_fd = written ? mkstemp(&tmp_lib_path[0]) : -1;
+    if (lib_fd < 0) {
+      LOG(WARNING) << "Cannot write the source file " << src_path
+                   << " for JIT compiling of CPU code.";
+      std::remove(src_path.c_str());
+      return false;
+    }
+    close(lib_fd);
+    std::string cmd = FLAGS_fusion_group_cpu_compiler + " " + options +
+                      " -o " + tmp_lib_path + " " + src_path + " 2>&1";
+    std::string log;
+    int status = RunCommand(cmd, &log);
+    std::remove(src_path.c_str());
+    if (status != 0) {
+      LOG(WARNING) << "JIT compiling of CPU code failed:"
+                   << "\n  Kernel name: " << name_ << "\n  Kernel body:\n"
+                   << kernel_ << "\n  Compiling log: " << log;
+      std::remove(tmp_lib_path.c_str());
+      return false;
+    }
+    if (std::rename(tmp_lib_path.c_str(), lib_path.c_str()) != 0) {
+      std::remove(tmp_lib_path.c_str());
+      return false;
+    }
+  }
+
+  if (!IsTrustedFile(lib_path)) {
+    LOG(WARNING) << "Refuse to load " << lib_path
+                 << ", which is not a regular file of the current user or is "
+                    "writable by others.";
+    return false;
+  }
+  handle_ = dlopen(lib_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (handle_ == nullptr) {
+    LOG(WARNING) << "Fail to load " << lib_path << ": " << dlerror();
+    return false;
+  }
+  function_ = reinterpret_cast<FuncType>(dlsym(handle_, name_.c_str()));
+  if (function_ == nullptr) {
+    LOG(WARNING) << "Fail to find function " << name_ << " in " << lib_path;
+    return false;
+  }
+  is_compiled_ = true;
+  return true;
+}
+
+void CPUDeviceCode::Launch(const size_t n, std::vector<void*>* args) const {
+  PADDLE_ENFORCE_EQ(
+      is_compiled_, true,
+      errors::PreconditionNotMet(
+          "Please compile the code before launching the kernel."));
+
+  // The args are laid out as those of CUDADeviceCode, the first one is the
+  // address of n, and the others are the addresses of the data pointers.
+  std::vector<void*> ptrs;
+  ptrs.reserve(args->size());
+  for (size_t i = 1; i < args->size(); ++i) {
+    ptrs.push_back(*reinterpret_cast<void**>((*args)[i]));
+  }
+  function_(static_cast<int>(n), ptrs.data());
 }
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
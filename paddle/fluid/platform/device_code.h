@@ -88,6 +88,31 @@ class CUDADeviceCode : public DeviceCode {
 };
 #endif
 
+// Compile the generated C++ code by the host compiler into a shared library
+// and load it. The libraries are cached in FLAGS_fusion_group_cpu_cache_dir,
+// keyed by the code and the compiling options, so that they are compiled only
+// once across processes. The directory must be private to the current user,
+// and only the libraries owned by the current user are loaded. The code
+// should define a function named `name` with the signature
+// `void(int n, void** args)`.
+class CPUDeviceCode : public DeviceCode {
+ public:
+  explicit CPUDeviceCode(const Place& place, const std::string& name,
+                         const std::string& kernel);
+  ~CPUDeviceCode();
+  bool Compile(bool include_path = false) override;
+  void Launch(const size_t n, std::vector<void*>* args) const override;
+
+  static bool IsAvailable();
+
+ private:
+  using FuncType = void (*)(int, void**);
+
+  bool is_compiled_{false};
+  void* handle_{nullptr};
+  FuncType function_{nullptr};
+};
+
 class DeviceCodePool {
  public:
   using DeviceCodeMap =
@@ -106,6 +131,8 @@ class DeviceCodePool {
   static DeviceCodePool& Init(const std::vector<platform::Place>& places) {
     if (pool == nullptr) {
       pool = new DeviceCodePool(places);
+    } else {
+      pool->AddPlaces(places);
     }
     return *pool;
   }
@@ -124,6 +151,8 @@ class DeviceCodePool {
   }
 
  private:
+  void AddPlaces(const std::vector<platform::Place>& places);
+
   static DeviceCodePool* pool;
   std::map<Place, DeviceCodeMap> device_codes_;
   DISABLE_COPY_AND_ASSIGN(DeviceCodePool);
@@ -13,11 +13,19 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/platform/device_code.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <string>
 #include <utility>
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/platform/init.h"
 
+DECLARE_string(fusion_group_cpu_cache_dir);
+
 #ifdef PADDLE_WITH_CUDA
 constexpr auto saxpy_code = R"(
 extern "C" __global__
@@ -123,3 +131,88 @@ TEST(DeviceCodePool, cuda) {
   LOG(INFO) << "get ptr: " << code_get;
 }
 #endif
+
+constexpr auto saxpy_cpu_code = R"(
+extern "C" void saxpy_cpu_kernel(int n, void** args) {
+  float a = *static_cast<float*>(args[0]);
+  const float* x = static_cast<const float*>(args[1]);
+  const float* y = static_cast<const float*>(args[2]);
+  float* z = static_cast<float*>(args[3]);
+  for (int i = 0; i < n; ++i) {
+    z[i] = a * x[i] + y[i];
+  }
+}
+)";
+
+TEST(DeviceCode, cpu) {
+  ASSERT_TRUE(paddle::platform::CPUDeviceCode::IsAvailable())
+      << "The host compiler set by FLAGS_fusion_group_cpu_compiler is not "
+         "found.";
+
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceCode code(place, "saxpy_cpu_kernel",
+                                       saxpy_cpu_code);
+
+  paddle::framework::Tensor x;
+  paddle::framework::Tensor y;
+  paddle::framework::Tensor z;
+
+  float scale = 2;
+  auto dims = paddle::framework::make_ddim(
+      {static_cast<int64_t>(256), static_cast<int64_t>(1024)});
+  float* x_data = x.mutable_data<float>(dims, place);
+  float* y_data = y.mutable_data<float>(dims, place);
+  float* z_data = z.mutable_data<float>(dims, place);
+
+  size_t n = x.numel();
+  for (size_t i = 0; i < n; ++i) {
+    x_data[i] = static_cast<float>(i);
+    y_data[i] = static_cast<float>(0.5);
+  }
+
+  EXPECT_EQ(code.Compile(), true);
+
+  // The args are laid out as those of CUDADeviceCode.
+  float* scale_ptr = &scale;
+  std::vector<void*> args = {&n, &scale_ptr, &x_data, &y_data, &z_data};
+  code.Launch(n, &args);
+
+  for (size_t i = 0; i < n; i++) {
+    EXPECT_EQ(z_data[i], static_cast<float>(i) * scale + 0.5);
+  }
+}
+
+TEST(DeviceCode, cpu_shared_cache_dir) {
+  if (!paddle::platform::CPUDeviceCode::IsAvailable()) {
+    return;
+  }
+
+  // The code must not be compiled into or loaded from a directory which is
+  // writable by others.
+  char tmpl[] = "/tmp/device_code_test_XXXXXX";
+  ASSERT_NE(mkdtemp(tmpl), nullptr);
+  std::string cache_dir = tmpl;
+  ASSERT_EQ(chmod(cache_dir.c_str(), 0777), 0);
+  std::string old_cache_dir = FLAGS_fusion_group_cpu_cache_dir;
+  FLAGS_fusion_group_cpu_cache_dir = cache_dir;
+
+  paddle::platform::CPUPlace place;
+  paddle::platform::CPUDeviceCode code(place, "saxpy_cpu_kernel",
+                                       saxpy_cpu_code);
+  EXPECT_EQ(code.Compile(), false);
+
+  ASSERT_EQ(chmod(cache_dir.c_str(), 0700), 0);
+  EXPECT_EQ(code.Compile(), true);
+
+  FLAGS_fusion_group_cpu_cache_dir = old_cache_dir;
+  DIR* dir = opendir(cache_dir.c_str());
+  ASSERT_NE(dir, nullptr);
+  while (struct dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+    if (name != "." && name != "..") {
+      std::remove((cache_dir + "/" + name).c_str());
+    }
+  }
+  closedir(dir);
+  EXPECT_EQ(rmdir(cache_dir.c_str()), 0);
+}
@@ -167,6 +167,22 @@ DEFINE_bool(cudnn_batchnorm_spatial_persistent, false,
             "batch_norm, default is False.");
 #endif
 
+/**
+ * CPU convolution related FLAG
+ * Name: FLAGS_cpu_conv_exhaustive_search
+ * Since Version: 2.1.0
+ * Value Range: bool, default=false
+ * Example:
+ * Note: Represents whether the algorithm of the CPU 2-D convolution is picked
+ *       by timing all the applicable ones, like FLAGS_cudnn_exhaustive_search.
+ *       The picked algorithm is cached for every shape, so only the first run
+ *       of a shape is slower.
+ */
+DEFINE_bool(cpu_conv_exhaustive_search, false,
+            "Whether to pick the algorithm of the CPU 2-D convolution by "
+            "timing all the applicable ones on the first run of every shape, "
+            "default is False.");
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 
 /**
@@ -217,6 +233,31 @@ DEFINE_bool(communicator_is_sgd_optimizer, true,
  */
 DEFINE_int32(communicator_send_queue_size, 20,
              "queue size to recv gradient before send");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_geo_delta_threshold
+ * Since Version: 2.1.0
+ * Value Range: double, default=0.0
+ * Example:
+ * Note: In geo mode, the sparse rows whose max abs delta is lower than it
+ *       are not sent. They are kept on the trainer and sent in a later round
+ *       once their accumulated delta reaches it. 0 sends all the rows.
+ */
+DEFINE_double(communicator_geo_delta_threshold, 0.0,
+              "in geo mode, the rows whose max abs delta is lower than it are "
+              "kept on the trainer and sent after they accumulate enough");
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_communicator_geo_send_chunk_size
+ * Since Version: 2.1.0
+ * Value Range: int32, default=0
+ * Example:
+ * Note: In geo mode, the max number of sparse rows of one push request, the
+ *       delta of a table is sent in several requests when it has more. 0
+ *       sends it in one request.
+ */
+DEFINE_int32(communicator_geo_send_chunk_size, 0,
+             "max rows of one geo sparse push request, 0 means no limit");
 #endif
 
 /**
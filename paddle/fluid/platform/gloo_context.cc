@@ -23,8 +23,12 @@ void GlooParallelContext::Init() {
   gloo_ptr->SetSize(strategy_.rank_num);
   gloo_ptr->SetIface(strategy_.iface);
   gloo_ptr->SetTimeoutSeconds(strategy_.init_seconds, strategy_.run_seconds);
-  gloo_ptr->SetHttpStore(strategy_.ip_address, strategy_.ip_port,
-                         strategy_.scope);
+  if (strategy_.store_path.empty()) {
+    gloo_ptr->SetHttpStore(strategy_.ip_address, strategy_.ip_port,
+                           strategy_.scope);
+  } else {
+    gloo_ptr->SetFileStore(strategy_.store_path);
+  }
   gloo_ptr->Init();
 }
 #endif
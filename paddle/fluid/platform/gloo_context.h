@@ -30,6 +30,9 @@ struct GlooParallelStrategy {
   std::string ip_address;
   int ip_port;
   std::string scope{"worker"};
+  // Rendezvous through this shared directory instead of the http store
+  // if it is not empty.
+  std::string store_path;
 };
 
 class GlooParallelContext {
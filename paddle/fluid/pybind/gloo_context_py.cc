@@ -89,7 +89,14 @@ void BindGlooContext(py::module *m) {
                     },
                     [](platform::GlooParallelStrategy &self, int ip_port) {
                       self.ip_port = ip_port;
-                    });
+                    })
+      .def_property(
+          "store_path",
+          [](const platform::GlooParallelStrategy &self) {
+            return self.store_path;
+          },
+          [](platform::GlooParallelStrategy &self,
+             const std::string &store_path) { self.store_path = store_path; });
 
   py::class_<platform::GlooParallelContext> gloo_ctx(*m, "GlooParallelContext");
   gloo_ctx.def(py::init<const platform::GlooParallelStrategy &>())
@@ -22,6 +22,7 @@ limitations under the License. */
 #include <vector>
 
 #include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+#include "paddle/fluid/framework/fleet/metrics.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/pybind/gloo_wrapper_py.h"
@@ -52,6 +53,36 @@ void BindGlooWrapper(py::module* m) {
       .def("all_gather", &framework::GlooWrapper::AllGather<int64_t>)
       .def("all_gather", &framework::GlooWrapper::AllGather<float>)
       .def("all_gather", &framework::GlooWrapper::AllGather<double>);
+
+  // The auc of the histograms of the auc op summed over the ranks of gloo,
+  // which only exchange their non-empty buckets when there are few of them.
+  // gloo is None for one trainer.
+  m->def("_global_auc",
+         [](const std::vector<int64_t>& stat_pos,
+            const std::vector<int64_t>& stat_neg,
+            framework::GlooWrapper* gloo) {
+           PADDLE_ENFORCE_EQ(
+               stat_pos.size(), stat_neg.size(),
+               platform::errors::InvalidArgument(
+                   "The stat_pos and stat_neg of auc must be of the same "
+                   "size, but got %d and %d.",
+                   stat_pos.size(), stat_neg.size()));
+           PADDLE_ENFORCE_GT(stat_pos.size(), 1UL,
+                             platform::errors::InvalidArgument(
+                                 "The stat_pos of auc must have at least 2 "
+                                 "buckets, but got %d.",
+                                 stat_pos.size()));
+           framework::AucAccumulator accumulator(
+               static_cast<int>(stat_pos.size()) - 1);
+           accumulator.AddHistograms(stat_pos.data(), stat_neg.data());
+           accumulator.Merge();
+           if (gloo != nullptr) {
+             accumulator.MergeRanks(gloo);
+           }
+           return accumulator.auc();
+         },
+         py::arg("stat_pos"), py::arg("stat_neg"),
+         py::arg("gloo") = py::none());
 }  // end BindGlooWrapper
 }  // end namespace pybind
 }  // end namespace paddle
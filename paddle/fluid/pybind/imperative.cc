@@ -34,6 +34,7 @@ limitations under the License. */
 #include "paddle/fluid/imperative/basic_engine.h"
 #include "paddle/fluid/imperative/bkcl_context.h"
 #include "paddle/fluid/imperative/data_loader.h"
+#include "paddle/fluid/imperative/gloo_context.h"
 #include "paddle/fluid/imperative/layer.h"
 #include "paddle/fluid/imperative/nccl_context.h"
 #include "paddle/fluid/imperative/partial_grad_engine.h"
@@ -510,8 +511,10 @@ void BindImperative(py::module *m_ptr) {
     }
   });
 
-  m.def("_cleanup_mmap_fds",
-        []() { memory::allocation::MemoryMapFdSet::Instance().Clear(); });
+  m.def("_cleanup_mmap_fds", []() {
+    memory::allocation::MemoryMapFdSet::Instance().Clear();
+    memory::allocation::MemoryMapAllocationPool::Instance().Clear();
+  });
 #endif
 
   m.def("start_imperative_gperf_profiler",
@@ -1413,7 +1416,7 @@ void BindImperative(py::module *m_ptr) {
       py::call_guard<py::gil_scoped_release>());
 
 #if defined(PADDLE_WITH_NCCL) || defined(PADDLE_WITH_RCCL) || \
-    defined(PADDLE_WITH_XPU_BKCL)
+    defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
   py::class_<imperative::ParallelContext,
              std::shared_ptr<imperative::ParallelContext>>(m,
                                                            "ParallelContext");
@@ -1452,6 +1455,15 @@ void BindImperative(py::module *m_ptr) {
                     const platform::XPUPlace &>())
       .def("init", [](imperative::BKCLParallelContext &self) { self.Init(); });
 #endif
+
+#if defined(PADDLE_WITH_GLOO)
+  py::class_<imperative::GLOOParallelContext, imperative::ParallelContext,
+             std::shared_ptr<imperative::GLOOParallelContext>>(
+      m, "GLOOParallelContext")
+      .def(py::init<const imperative::ParallelStrategy &,
+                    const platform::CPUPlace &>())
+      .def("init", [](imperative::GLOOParallelContext &self) { self.Init(); });
+#endif
 }
 
 }  // namespace pybind
@@ -15,6 +15,7 @@ limitations under the License. */
 
 #include <algorithm>
 #include <cstdlib>
+#include <future>  // NOLINT
 #include <map>
 #include <memory>
 #include <mutex>  // NOLINT // for call_once
@@ -428,6 +429,25 @@ PYBIND11_MODULE(core_noavx, m) {
           SaveStaticNameListToDisk(str_file_name, vec_name_list, scope);
         });
 
+  py::class_<std::shared_future<void>>(m, "_SaveStaticDictTask", R"DOC(
+    The write of the file of _save_static_dict_async.
+    )DOC")
+      .def("wait", [](const std::shared_future<void> &self) { self.get(); },
+           py::call_guard<py::gil_scoped_release>(),
+           R"DOC(Waits for the file to be written, and raises the error of
+           the write if any.)DOC");
+
+  // The variables are copied before returning, and written to the file in
+  // the background, so the training can go on while they are saved.
+  m.def("_save_static_dict_async",
+        [](const std::string &str_file_name, const py::handle &vec_var_list,
+           const Scope &scope) {
+          std::vector<std::string> vec_name_list = GetNameList(vec_var_list);
+          return SaveStaticNameListToDiskAsync(str_file_name, vec_name_list,
+                                               scope)
+              .share();
+        });
+
   m.def("_load_static_dict",
         [](const std::string &str_file_name, const py::handle &vec_var_list,
            const Scope &scope, const Executor *executor) {
@@ -1023,10 +1043,11 @@ PYBIND11_MODULE(core_noavx, m) {
 
             return py::make_tuple(mmap_writer_allocation->ipc_name(),
                                   mmap_writer_allocation->size(),
-                                  type_idx, vectorize(t.dims()), t.lod());
+                                  type_idx, vectorize(t.dims()), t.lod(),
+                                  mmap_writer_allocation->pooled());
           },
           [](py::tuple t) {  // __setstate__
-            if (t.size() != 5)
+            if (t.size() != 6)
               throw std::runtime_error("Invalid LoDTensor state!");
 
             // 1. Create a new C++ instance
@@ -1037,7 +1058,7 @@ PYBIND11_MODULE(core_noavx, m) {
             size_t size = t[1].cast<size_t>();
             auto shared_reader_holder =
               memory::allocation::RebuildMemoryMapReaderAllocation(
-                ipc_name, size);
+                ipc_name, size, t[5].cast<bool>());
 
             // 3. Maintain global fd set
             VLOG(3) << "LoDTensor ipc name: " << ipc_name;
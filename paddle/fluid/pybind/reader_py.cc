@@ -406,8 +406,8 @@ void BindReader(py::module *module) {
       m, "LoDTensorBlockingQueue", "")
       .def("push",
            [](reader::LoDTensorBlockingQueue &self,
-              const std::vector<framework::LoDTensor> &lod_tensor_vec) {
-             return self.Push(lod_tensor_vec);
+              std::vector<framework::LoDTensor> lod_tensor_vec) {
+             return self.Push(std::move(lod_tensor_vec));
            },
            py::call_guard<py::gil_scoped_release>())
       .def("size", &reader::LoDTensorBlockingQueue::Size)
@@ -422,8 +422,8 @@ void BindReader(py::module *module) {
       m, "OrderedMultiDeviceLoDTensorBlockingQueue", "")
       .def("push",
            [](reader::OrderedMultiDeviceLoDTensorBlockingQueue &self,
-              const std::vector<framework::LoDTensor> &lod_tensor_vec) {
-             return self.Push(lod_tensor_vec);
+              std::vector<framework::LoDTensor> lod_tensor_vec) {
+             return self.Push(std::move(lod_tensor_vec));
            },
            py::call_guard<py::gil_scoped_release>())
       .def("size", &reader::OrderedMultiDeviceLoDTensorBlockingQueue::Size)
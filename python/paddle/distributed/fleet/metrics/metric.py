@@ -179,6 +179,17 @@ def auc(stat_pos, stat_neg, scope=None, util=None):
         stat_neg = np.array(scope.find_var(stat_neg.name).get_tensor())
     elif isinstance(stat_neg, str):
         stat_neg = np.array(scope.find_var(stat_neg).get_tensor())
+    # the histograms of the global auc, the first row of the stats
+    stat_pos = np.array(stat_pos)
+    stat_neg = np.array(stat_neg)
+    gloo = _worker_gloo(util)
+    if gloo is not None and stat_pos.ndim == 2 and stat_pos.shape[1] > 1:
+        # AucAccumulator of core only exchanges the non-empty buckets when
+        # there are few of them
+        return paddle.fluid.core._global_auc(
+            stat_pos[0].astype(np.int64).tolist(),
+            stat_neg[0].astype(np.int64).tolist(), gloo)
+
     # auc pos bucket shape
     old_pos_shape = np.array(stat_pos.shape)
     # reshape to one dim
@@ -222,6 +233,21 @@ def auc(stat_pos, stat_neg, scope=None, util=None):
     return auc_value
 
 
+def _worker_gloo(util):
+    """
+    the gloo of the workers of the role maker of util, or None when it does
+    not use gloo
+    """
+    role_maker = getattr(util, "role_maker", None)
+    gloo = getattr(role_maker, "_gloo", None)
+    if gloo is None or not getattr(gloo, "_is_initialized", False):
+        return None
+    comm = getattr(gloo, "_worker_comm", None)
+    if not isinstance(comm, paddle.fluid.core.Gloo):
+        return None
+    return comm
+
+
 def mae(abserr, total_ins_num, scope=None, util=None):
     """
     distributed mae in fleet
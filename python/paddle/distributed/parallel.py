@@ -120,12 +120,15 @@ def init_parallel_env():
         )
         return
 
-    # 1. gpu xpu check, must be gpu or xpu
-    if not core.is_compiled_with_cuda() and not core.is_compiled_with_xpu():
+    # 1. gpu xpu check, must be gpu or xpu, or cpu with gloo
+    is_cpu_only = not core.is_compiled_with_cuda(
+    ) and not core.is_compiled_with_xpu()
+    if is_cpu_only and not hasattr(core, "GLOOParallelContext"):
         raise NotImplementedError(
-            "Cannot initialize parallel environment in CPU-only version, now only "
-            "supports initializing the GPU and XPU parallel environment. Please recompile "
-            "or reinstall paddle with GPU or XPU support.")
+            "Cannot initialize parallel environment in CPU-only version without GLOO, "
+            "now only supports initializing the GPU, XPU and GLOO CPU parallel "
+            "environment. Please recompile or reinstall paddle with GPU, XPU or "
+            "GLOO support.")
 
     # 2. check env
     def _check_var_exists(var_name):
@@ -146,9 +149,15 @@ def init_parallel_env():
     _check_var_exists("PADDLE_TRAINER_ENDPOINTS")
 
     # 3: init gloo context (step 1: httpsever start)
-    init_gloo = int(os.getenv("PADDLE_WITH_GLOO", "0"))
+    # The CPU version communicates through gloo, so gloo is always needed.
+    # If PADDLE_GLOO_FS_PATH is set, the trainers meet through the files
+    # in this directory shared by them instead of the http server.
+    init_gloo = is_cpu_only or int(os.getenv("PADDLE_WITH_GLOO", "0"))
+    gloo_fs_path = os.getenv("PADDLE_GLOO_FS_PATH", "")
+    use_http_store = init_gloo and not gloo_fs_path
     if init_gloo:
         ep_rank_0 = parallel_env.trainer_endpoints[0].split(":")
+    if use_http_store:
         ep_rank = parallel_env.trainer_endpoints[parallel_env.rank].split(":")
         manager = Manager()
         # glboal dict to store status
@@ -184,39 +193,52 @@ def init_parallel_env():
         place = core.CUDAPlace(parallel_env.device_id)
     elif core.is_compiled_with_xpu():
         place = core.XPUPlace(parallel_env.device_id)
+    else:
+        place = core.CPUPlace()
     _set_expected_place(place)
 
-    # init nccl or bkcl context
-    if core.is_compiled_with_cuda():
-        parallel_helper._set_parallel_ctx(
-            core.NCCLParallelContext(strategy, place))
-    elif core.is_compiled_with_xpu():
-        parallel_helper._set_parallel_ctx(
-            core.BKCLParallelContext(strategy, place))
-    parallel_helper._init_parallel_ctx()
-
-    # 5: init gloo context (step 2: gloo init)
-    # dividing init_gloo into two part beacause nccl and gloo
-    # are separately looking for free ports which sometimes
-    # leads to port-conflict.
-    if init_gloo:
-        wait_server_ready([parallel_env.trainer_endpoints[0]])
+    def _init_gloo():
+        if use_http_store:
+            wait_server_ready([parallel_env.trainer_endpoints[0]])
 
         gloo_strategy = core.GlooParallelStrategy()
         gloo_strategy.rank = parallel_env.rank
         gloo_strategy.rank_num = parallel_env.world_size
         gloo_strategy.ip_address = ep_rank_0[0]
         gloo_strategy.ip_port = int(ep_rank_0[1])
+        gloo_strategy.store_path = gloo_fs_path
         default_init_timeout_seconds = 3600
         default_run_timeout_seconds = 9999999
         gloo_strategy.init_seconds = default_init_timeout_seconds
         gloo_strategy.run_seconds = default_run_timeout_seconds
         gloo = core.GlooParallelContext(gloo_strategy)
         gloo.init()
-        if parallel_env.rank == 0:
+        if use_http_store and parallel_env.rank == 0:
             http_server_d["running"] = False
             http_server.join()
 
+    # init nccl, bkcl or gloo context
+    if core.is_compiled_with_cuda():
+        parallel_helper._set_parallel_ctx(
+            core.NCCLParallelContext(strategy, place))
+    elif core.is_compiled_with_xpu():
+        parallel_helper._set_parallel_ctx(
+            core.BKCLParallelContext(strategy, place))
+    else:
+        # GLOOParallelContext allreduces through the gloo context,
+        # so gloo must be initialized first.
+        _init_gloo()
+        parallel_helper._set_parallel_ctx(
+            core.GLOOParallelContext(strategy, place))
+    parallel_helper._init_parallel_ctx()
+
+    # 5: init gloo context (step 2: gloo init)
+    # dividing init_gloo into two part beacause nccl and gloo
+    # are separately looking for free ports which sometimes
+    # leads to port-conflict.
+    if init_gloo and not is_cpu_only:
+        _init_gloo()
+
 
 def get_rank():
     """
@@ -204,12 +204,15 @@ def __bootstrap__():
         'call_stack_level',
         'sort_sum_gradient',
         'max_inplace_grad_add',
+        'cpu_conv_exhaustive_search',
     ]
     if 'Darwin' not in sysstr:
         read_env_flags.append('use_pinned_memory')
 
     if os.name != 'nt':
         read_env_flags.append('cpu_deterministic')
+        read_env_flags.append('use_shm_pool')
+        read_env_flags.append('shm_pool_max_mb')
 
     if core.is_compiled_with_mkldnn():
         read_env_flags.append('use_mkldnn')
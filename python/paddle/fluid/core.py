@@ -267,6 +267,8 @@ if avx_supported():
         from .core_avx import _switch_tracer
         from .core_avx import _set_paddle_lib_path
         from .core_avx import _save_static_dict
+        from .core_avx import _save_static_dict_async
+        from .core_avx import _global_auc
         from .core_avx import _load_static_dict
         from .core_avx import _save_dygraph_dict
         from .core_avx import _load_dygraph_dict
@@ -321,6 +323,8 @@ if load_noavx:
         from .core_noavx import _switch_tracer
         from .core_noavx import _set_paddle_lib_path
         from .core_noavx import _save_static_dict
+        from .core_noavx import _save_static_dict_async
+        from .core_noavx import _global_auc
         from .core_noavx import _load_static_dict
         from .core_noavx import _save_dygraph_dict
         from .core_noavx import _load_dygraph_dict
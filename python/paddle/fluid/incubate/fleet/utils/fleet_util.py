@@ -216,6 +216,17 @@ class FleetUtil(object):
             self.rank0_print("not found auc bucket")
             return None
         fleet._role_maker._barrier_worker()
+        comm = getattr(fleet._role_maker, "_node_type_comm", None)
+        if isinstance(comm, core.Gloo):
+            # AucAccumulator of core only exchanges the non-empty buckets
+            # when there are few of them
+            pos = np.array(scope.find_var(stat_pos).get_tensor())
+            neg = np.array(scope.find_var(stat_neg).get_tensor())
+            auc_value = core._global_auc(
+                pos[0].astype(np.int64).tolist(),
+                neg[0].astype(np.int64).tolist(), comm)
+            fleet._role_maker._barrier_worker()
+            return auc_value
         # auc pos bucket
         pos = np.array(scope.find_var(stat_pos).get_tensor())
         # auc pos bucket shape
@@ -126,6 +126,34 @@ class TestFleetMetric(unittest.TestCase):
         metric.mse(arr, arr3, util=self.util)
         metric.acc(arr, arr3, util=self.util)
 
+    def test_metric_auc_gloo(self):
+        """Test auc through the gloo of the role maker."""
+
+        class FakeGloo:
+            def __init__(self, comm):
+                self._is_initialized = True
+                self._worker_comm = comm
+
+        class FakeRoleMaker:
+            def __init__(self, comm):
+                self._gloo = FakeGloo(comm)
+
+        class GlooUtil(UtilBase):
+            def __init__(self, comm):
+                super(UtilBase, self).__init__()
+                self.role_maker = FakeRoleMaker(comm)
+
+        np.random.seed(1)
+        stat_pos = np.random.randint(0, 100, size=(1, 4096)).astype('int64')
+        stat_neg = np.random.randint(0, 100, size=(1, 4096)).astype('int64')
+        stat_pos[0, 100:4000] = 0
+        stat_neg[0, 200:3000] = 0
+        expect = metric.auc(stat_pos, stat_neg, util=self.util)
+        gloo_util = GlooUtil(self.util.fleet.gloo)
+        self.assertIsNotNone(metric._worker_gloo(gloo_util))
+        self.assertAlmostEqual(
+            metric.auc(stat_pos, stat_neg, util=gloo_util), expect, places=6)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -18,6 +18,7 @@ import unittest
 import platform
 import numpy as np
 from op_test import OpTest, skip_check_grad_ci
+from op_test import convert_float_to_uint16, convert_uint16_to_float
 import paddle.fluid.core as core
 import paddle.fluid as fluid
 from paddle.fluid.op import Operator
@@ -92,6 +93,33 @@ class TestLookupTableOpWithPadding(TestFusedEmbeddingSeqPoolOp):
                 ['W'], 'Out', no_grad_set=['Ids'], check_dygraph=False)
 
 
+@skip_check_grad_ci(reason="The bfloat16 table has no grad kernel.")
+class TestFusedEmbeddingSeqPoolBF16Op(OpTest):
+    def setUp(self):
+        self.op_type = "fused_embedding_seq_pool"
+        self.dtype = np.uint16
+        self.emb_size = 20
+        table = np.random.random((17, self.emb_size)).astype("float32")
+        table_bf16 = convert_float_to_uint16(table)
+        # the sums of the bfloat16 values in float
+        table = convert_uint16_to_float(table_bf16)
+        ids = np.array([[[4], [3]], [[4], [3]], [[2], [1]],
+                        [[16], [1]]]).astype("int64")
+        ids_expand = np.expand_dims(ids, axis=1)
+        lod = [[3, 1]]
+        self.inputs = {'W': table_bf16, 'Ids': (ids_expand, lod)}
+        self.outputs = {
+            'Out': np.reshape(
+                np.array([
+                    table[[4, 3]] + table[[4, 3]] + table[[2, 1]],
+                    table[[16, 1]]
+                ]), [len(lod[0]), 2 * self.emb_size])
+        }
+
+    def test_check_output(self):
+        self.check_output_with_place(core.CPUPlace(), check_dygraph=False)
+
+
 class TestFusedEmbeddingSeqPoolApi(unittest.TestCase):
     def test_api(self):
         if ver.mkl() == "ON" and 'Linux' in platform.platform():
@@ -143,6 +143,18 @@ class TestFusionGRUOpBS1(TestFusionGRUOp):
         self.D = 16
 
 
+class TestFusionGRUOpOriginMode(TestFusionGRUOp):
+    def set_confs(self):
+        self.origin_mode = True
+
+
+class TestFusionGRUOpOriginModeReverse(TestFusionGRUOp):
+    def set_confs(self):
+        self.origin_mode = True
+        self.is_reverse = True
+        self.with_h0 = False
+
+
 if __name__ == "__main__":
     from paddle import enable_static
     enable_static()
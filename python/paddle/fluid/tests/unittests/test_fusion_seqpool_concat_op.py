@@ -21,9 +21,56 @@ from test_reorder_lod_tensor import convert_to_offset
 from sequence.test_sequence_pool import compute_seqpool_sum, compute_seqpool_avg, compute_seqpool_sqrt
 
 
+def compute_seqpool(x, offset, out, pooltype):
+    if pooltype == "SUM":
+        compute_seqpool_sum(x, offset, out)
+    elif pooltype == "AVERAGE":
+        compute_seqpool_avg(x, offset, out)
+    elif pooltype == "SQRT":
+        compute_seqpool_sqrt(x, offset, out)
+    elif pooltype in ["MAX", "LAST", "FIRST"]:
+        level = len(offset) - 1
+        for i in range(len(offset[level]) - 1):
+            begin, end = offset[level][i], offset[level][i + 1]
+            if begin == end:
+                out[i] = 0.0
+            elif pooltype == "MAX":
+                out[i] = x[begin:end, :].max(axis=0)
+            elif pooltype == "LAST":
+                out[i] = x[end - 1, :]
+            else:
+                out[i] = x[begin, :]
+    else:
+        raise Exception("Unsupported pool type!")
+
+
+def compute_seqpool_grad(x, offset, out_grad, pooltype):
+    level = len(offset) - 1
+    x_grad = np.zeros_like(x)
+    for i in range(len(offset[level]) - 1):
+        begin, end = offset[level][i], offset[level][i + 1]
+        if begin == end:
+            continue
+        if pooltype == "SUM":
+            x_grad[begin:end, :] = out_grad[i]
+        elif pooltype == "AVERAGE":
+            x_grad[begin:end, :] = out_grad[i] / (end - begin)
+        elif pooltype == "SQRT":
+            x_grad[begin:end, :] = out_grad[i] / np.sqrt(end - begin)
+        elif pooltype == "MAX":
+            rows = begin + x[begin:end, :].argmax(axis=0)
+            x_grad[rows, np.arange(x.shape[1])] = out_grad[i]
+        elif pooltype == "LAST":
+            x_grad[end - 1, :] = out_grad[i]
+        else:
+            x_grad[begin, :] = out_grad[i]
+    return x_grad
+
+
 class TestFusionSeqPoolConcatOp(OpTest):
     def setUp(self):
-        self.w = 11
+        self.w = 13
+        self.dtype = np.float64
         self.lods = [[[2, 3, 5]], [[1, 5, 2]]]
         self.set_conf()
         self.set_pooltype()
@@ -36,17 +83,10 @@ class TestFusionSeqPoolConcatOp(OpTest):
         for lod in self.lods:
             assert bs == len(lod[0]), 'All lod size should be equal'
             x = np.random.uniform(0.1, 1,
-                                  [sum(lod[0]), self.w]).astype('float32')
+                                  [sum(lod[0]), self.w]).astype(self.dtype)
             offset = convert_to_offset(lod)
-            out = np.zeros((bs, self.w)).astype('float32')
-            if self.pooltype == "SUM":
-                compute_seqpool_sum(x, offset, out)
-            elif self.pooltype == "AVERAGE":
-                compute_seqpool_avg(x, offset, out)
-            elif self.pooltype == "SQRT":
-                compute_seqpool_sqrt(x, offset, out)
-            else:
-                raise Exception("Unsupported pool type!")
+            out = np.zeros((bs, self.w)).astype(self.dtype)
+            compute_seqpool(x, offset, out, self.pooltype)
             inputs.append(('x_{0}'.format(i), (x, lod)))
             outs.append(out)
             i = i + 1
@@ -67,15 +107,33 @@ class TestFusionSeqPoolConcatOp(OpTest):
     def test_check_output(self):
         self.check_output()
 
+    def test_check_grad(self):
+        # The loss of check_grad is the mean of Out.
+        out = self.outputs['Out']
+        out_grad = np.full(out.shape, 1.0 / out.size).astype(self.dtype)
+        names = []
+        user_grads = []
+        for i, (name, (x, lod)) in enumerate(self.inputs['X']):
+            slot_grad = out_grad[:, i * self.w:(i + 1) * self.w]
+            names.append(name)
+            user_grads.append(
+                compute_seqpool_grad(x,
+                                     convert_to_offset(lod), slot_grad,
+                                     self.pooltype))
+        self.check_grad(
+            names, 'Out', user_defined_grads=user_grads, check_dygraph=False)
+
 
 class TestFusionSeqPoolConcatOpCase1(TestFusionSeqPoolConcatOp):
     def set_conf(self):
         self.lods = [[[1]]]
+        self.w = 100
 
 
 class TestFusionSeqPoolConcatOpCase2(TestFusionSeqPoolConcatOp):
     def set_conf(self):
         self.lods = [[[1]], [[1]], [[1]]]
+        self.w = 100
 
 
 class TestFusionSeqPoolConcatOpCase3(TestFusionSeqPoolConcatOp):
@@ -87,32 +145,35 @@ class TestFusionSeqPoolConcatOpCase3(TestFusionSeqPoolConcatOp):
 class TestFusionSeqPoolConcatOpCase4(TestFusionSeqPoolConcatOp):
     def set_conf(self):
         self.lods = [[[2, 13, 4]], [[1, 1, 1]], [[5, 3, 1]], [[9, 10, 3]]]
-        self.w = 3
+        self.w = 34
+
+
+class TestFusionSeqPoolConcatOpCase5(TestFusionSeqPoolConcatOp):
+    def set_conf(self):
+        # empty sequences
+        self.lods = [[[2, 0, 4]], [[0, 3, 1]]]
+        self.w = 25
 
 
-## test avg pool and sqrt
-def create_test_avg_sqrt_class(parent):
-    class TestSeqPoolAvgCase(parent):
-        def set_pooltype(self):
-            self.pooltype = "AVERAGE"
+## test the other pooltypes
+def create_test_pooltype_class(parent):
+    for pooltype in ["AVERAGE", "SQRT", "MAX", "LAST", "FIRST"]:
 
-    class TestSeqPoolSqrtCase(parent):
-        def set_pooltype(self):
-            self.pooltype = "SQRT"
+        class TestSeqPoolCase(parent):
+            def set_pooltype(self, pooltype=pooltype):
+                self.pooltype = pooltype
 
-    cls_name_avg = "{0}_{1}".format(parent.__name__, "avg")
-    cls_name_sqrt = "{0}_{1}".format(parent.__name__, "sqrt")
-    TestSeqPoolAvgCase.__name__ = cls_name_avg
-    TestSeqPoolSqrtCase.__name__ = cls_name_sqrt
-    globals()[cls_name_avg] = TestSeqPoolAvgCase
-    globals()[cls_name_sqrt] = TestSeqPoolSqrtCase
+        cls_name = "{0}_{1}".format(parent.__name__, pooltype.lower())
+        TestSeqPoolCase.__name__ = cls_name
+        globals()[cls_name] = TestSeqPoolCase
 
 
-create_test_avg_sqrt_class(TestFusionSeqPoolConcatOp)
-create_test_avg_sqrt_class(TestFusionSeqPoolConcatOpCase1)
-create_test_avg_sqrt_class(TestFusionSeqPoolConcatOpCase2)
-create_test_avg_sqrt_class(TestFusionSeqPoolConcatOpCase3)
-create_test_avg_sqrt_class(TestFusionSeqPoolConcatOpCase4)
+create_test_pooltype_class(TestFusionSeqPoolConcatOp)
+create_test_pooltype_class(TestFusionSeqPoolConcatOpCase1)
+create_test_pooltype_class(TestFusionSeqPoolConcatOpCase2)
+create_test_pooltype_class(TestFusionSeqPoolConcatOpCase3)
+create_test_pooltype_class(TestFusionSeqPoolConcatOpCase4)
+create_test_pooltype_class(TestFusionSeqPoolConcatOpCase5)
 
 if __name__ == '__main__':
     unittest.main()
@@ -18,13 +18,14 @@ import unittest
 import numpy as np
 from op_test import OpTest
 from test_reorder_lod_tensor import convert_to_offset
-from sequence.test_sequence_pool import compute_seqpool_sum, compute_seqpool_avg, compute_seqpool_sqrt
 from test_cvm_op import cvm_compute
+from test_fusion_seqpool_concat_op import compute_seqpool, compute_seqpool_grad
 
 
 class TestFusionSeqPoolCVMConcatOp(OpTest):
     def setUp(self):
-        self.w = 11
+        self.w = 13
+        self.dtype = np.float64
         self.use_cvm = True
         self.lods = [[[2, 3, 5]], [[1, 5, 2]]]
         self.set_conf()
@@ -34,26 +35,17 @@ class TestFusionSeqPoolCVMConcatOp(OpTest):
         bs = len(self.lods[0][0])
         inputs = []
         outs = []
-        # The cvm variable is not actually used.
-        cvm = np.array([[0.6, 0.4]]).astype("float32")
+        # The cvm variable is only used by the gradients of show and click.
+        cvm = np.random.uniform(0.1, 1, [bs, 2]).astype(self.dtype)
         i = 0
         for lod in self.lods:
             assert bs == len(lod[0]), 'All lod size should be equal'
             x = np.random.uniform(0.1, 1,
-                                  [sum(lod[0]), self.w]).astype('float32')
+                                  [sum(lod[0]), self.w]).astype(self.dtype)
             offset = convert_to_offset(lod)
-            out = np.zeros((bs, self.w)).astype('float32')
-            if self.pooltype == "SUM":
-                compute_seqpool_sum(x, offset, out)
-                out = cvm_compute(out, self.w, self.use_cvm)
-            elif self.pooltype == "AVERAGE":
-                compute_seqpool_avg(x, offset, out)
-                out = cvm_compute(out, self.w, self.use_cvm)
-            elif self.pooltype == "SQRT":
-                compute_seqpool_sqrt(x, offset, out)
-                out = cvm_compute(out, self.w, self.use_cvm)
-            else:
-                raise Exception("Unsupported pool type!")
+            out = np.zeros((bs, self.w)).astype(self.dtype)
+            compute_seqpool(x, offset, out, self.pooltype)
+            out = cvm_compute(out, self.w, self.use_cvm).astype(self.dtype)
             inputs.append(('x_{0}'.format(i), (x, lod)))
             outs.append(out)
             i = i + 1
@@ -74,15 +66,35 @@ class TestFusionSeqPoolCVMConcatOp(OpTest):
     def test_check_output(self):
         self.check_output()
 
+    def test_check_grad(self):
+        # The loss of check_grad is the mean of Out, and the gradients of show
+        # and click are CVM, like the cvm op.
+        out = self.outputs['Out']
+        out_grad = np.full(out.shape, 1.0 / out.size).astype(self.dtype)
+        names = []
+        user_grads = []
+        for i, (name, (x, lod)) in enumerate(self.inputs['X']):
+            slot_grad = out_grad[:, i * self.w:(i + 1) * self.w].copy()
+            slot_grad[:, :2] = self.inputs['CVM']
+            names.append(name)
+            user_grads.append(
+                compute_seqpool_grad(x,
+                                     convert_to_offset(lod), slot_grad,
+                                     self.pooltype))
+        self.check_grad(
+            names, 'Out', user_defined_grads=user_grads, check_dygraph=False)
+
 
 class TestFusionSeqPoolCVMConcatOpCase1(TestFusionSeqPoolCVMConcatOp):
     def set_conf(self):
         self.lods = [[[1]]]
+        self.w = 100
 
 
 class TestFusionSeqPoolCVMConcatOpCase2(TestFusionSeqPoolCVMConcatOp):
     def set_conf(self):
         self.lods = [[[1]], [[1]], [[1]]]
+        self.w = 100
 
 
 class TestFusionSeqPoolCVMConcatOpCase3(TestFusionSeqPoolCVMConcatOp):
@@ -94,32 +106,35 @@ class TestFusionSeqPoolCVMConcatOpCase3(TestFusionSeqPoolCVMConcatOp):
 class TestFusionSeqPoolCVMConcatOpCase4(TestFusionSeqPoolCVMConcatOp):
     def set_conf(self):
         self.lods = [[[2, 13, 4]], [[1, 1, 1]], [[5, 3, 1]], [[9, 10, 3]]]
-        self.w = 3
+        self.w = 34
+
+
+class TestFusionSeqPoolCVMConcatOpCase5(TestFusionSeqPoolCVMConcatOp):
+    def set_conf(self):
+        # empty sequences
+        self.lods = [[[2, 0, 4]], [[0, 3, 1]]]
+        self.w = 25
 
 
-## test avg pool and sqrt
-def create_test_avg_sqrt_class(parent):
-    class TestSeqPoolAvgCase(parent):
-        def set_pooltype(self):
-            self.pooltype = "AVERAGE"
+## test the other pooltypes
+def create_test_pooltype_class(parent):
+    for pooltype in ["AVERAGE", "SQRT", "MAX", "LAST", "FIRST"]:
 
-    class TestSeqPoolSqrtCase(parent):
-        def set_pooltype(self):
-            self.pooltype = "SQRT"
+        class TestSeqPoolCase(parent):
+            def set_pooltype(self, pooltype=pooltype):
+                self.pooltype = pooltype
 
-    cls_name_avg = "{0}_{1}".format(parent.__name__, "avg")
-    cls_name_sqrt = "{0}_{1}".format(parent.__name__, "sqrt")
-    TestSeqPoolAvgCase.__name__ = cls_name_avg
-    TestSeqPoolSqrtCase.__name__ = cls_name_sqrt
-    globals()[cls_name_avg] = TestSeqPoolAvgCase
-    globals()[cls_name_sqrt] = TestSeqPoolSqrtCase
+        cls_name = "{0}_{1}".format(parent.__name__, pooltype.lower())
+        TestSeqPoolCase.__name__ = cls_name
+        globals()[cls_name] = TestSeqPoolCase
 
 
-create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatOp)
-create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatOpCase1)
-create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatOpCase2)
-create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatOpCase3)
-create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatOpCase4)
+create_test_pooltype_class(TestFusionSeqPoolCVMConcatOp)
+create_test_pooltype_class(TestFusionSeqPoolCVMConcatOpCase1)
+create_test_pooltype_class(TestFusionSeqPoolCVMConcatOpCase2)
+create_test_pooltype_class(TestFusionSeqPoolCVMConcatOpCase3)
+create_test_pooltype_class(TestFusionSeqPoolCVMConcatOpCase4)
+create_test_pooltype_class(TestFusionSeqPoolCVMConcatOpCase5)
 
 if __name__ == '__main__':
     unittest.main()
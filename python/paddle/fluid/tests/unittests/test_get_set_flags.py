@@ -35,6 +35,13 @@ class TestGetAndSetFlags(unittest.TestCase):
         self.assertTrue(res_list['FLAGS_check_nan_inf'], True)
         self.assertTrue(res['FLAGS_eager_delete_tensor_gb'], 1.0)
 
+    def test_cpu_conv_exhaustive_search(self):
+        flag = 'FLAGS_cpu_conv_exhaustive_search'
+        self.assertEqual(fluid.get_flags(flag)[flag], False)
+        fluid.set_flags({flag: True})
+        self.assertEqual(fluid.get_flags(flag)[flag], True)
+        fluid.set_flags({flag: False})
+
 
 class TestGetAndSetFlagsErrors(unittest.TestCase):
     def test_errors(self):
@@ -0,0 +1,79 @@
+#   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+import shutil
+import tempfile
+import unittest
+
+import numpy as np
+import paddle
+import paddle.fluid as fluid
+import paddle.fluid.core as core
+
+paddle.enable_static()
+
+
+class TestSaveStaticDictAsync(unittest.TestCase):
+    def setUp(self):
+        self.dirname = tempfile.mkdtemp()
+
+    def tearDown(self):
+        shutil.rmtree(self.dirname)
+
+    def test_save_and_load(self):
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        scope = fluid.Scope()
+        with fluid.program_guard(main_program, startup_program):
+            x = fluid.data(name='x', shape=[None, 8], dtype='float32')
+            fluid.layers.fc(x, size=4)
+        exe = fluid.Executor(fluid.CPUPlace())
+        with fluid.scope_guard(scope):
+            exe.run(startup_program)
+        params = main_program.all_parameters()
+        saved = {
+            p.name: np.array(scope.find_var(p.name).get_tensor())
+            for p in params
+        }
+
+        path = os.path.join(self.dirname, 'model', 'params')
+        task = core._save_static_dict_async(path, params, scope)
+        # the parameters are copied when the call returns
+        for p in params:
+            scope.find_var(p.name).get_tensor().set(
+                np.zeros_like(saved[p.name]), fluid.CPUPlace())
+        task.wait()
+        self.assertEqual(os.listdir(os.path.dirname(path)), ['params'])
+
+        core._load_static_dict(path, params, scope, exe._default_executor)
+        for p in params:
+            self.assertTrue(
+                np.array_equal(
+                    np.array(scope.find_var(p.name).get_tensor()), saved[
+                        p.name]))
+
+    def test_error(self):
+        scope = fluid.Scope()
+        var = fluid.default_main_program().global_block().create_var(
+            name='not_in_scope', shape=[1], dtype='float32')
+        with self.assertRaises(Exception):
+            core._save_static_dict_async(
+                os.path.join(self.dirname, 'params'), [var], scope)
+
+
+if __name__ == '__main__':
+    unittest.main()
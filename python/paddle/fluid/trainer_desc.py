@@ -175,6 +175,20 @@ class TrainerDesc(object):
     def _set_thread_barrier(self, thread_barrier):
         self.proto_desc.thread_barrier = thread_barrier
 
+    def _set_binding_cpu(self, binding_cpu):
+        self.proto_desc.binding_cpu = binding_cpu
+
+    def _set_numa_config(self, config_dict):
+        self.proto_desc.numa_config.enable = config_dict.get("enable", False)
+        for param in config_dict.get("replicated_params", []):
+            self.proto_desc.numa_config.replicated_params.append(param)
+
+    def _set_run_plan_config(self, config_dict):
+        self.proto_desc.run_plan_config.cache_runtime_context = \
+                config_dict.get("cache_runtime_context", False)
+        self.proto_desc.run_plan_config.op_thread_num = \
+                config_dict.get("op_thread_num", 1)
+
     def _set_check_nan_var_names(self, check_nan_var_names):
         for var in check_nan_var_names:
             self.proto_desc.check_nan_var_names.append(var)
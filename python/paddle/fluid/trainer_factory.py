@@ -84,6 +84,12 @@ class TrainerFactory(object):
                         "enable_random_dump"])
                 if opt_info.get("dump_interval") is not None:
                     trainer._set_dump_interval(opt_info["dump_interval"])
+                if opt_info.get("binding_cpu") is not None:
+                    trainer._set_binding_cpu(opt_info["binding_cpu"])
+                if opt_info.get("numa_config") is not None:
+                    trainer._set_numa_config(opt_info["numa_config"])
+                if opt_info.get("run_plan_config") is not None:
+                    trainer._set_run_plan_config(opt_info["run_plan_config"])
                 if opt_info.get("random_with_lineid") is not None:
                     trainer._set_random_with_lineid(opt_info[
                         "random_with_lineid"])